@@ -0,0 +1,221 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "error.h"
+#include "harness.h"
+#include "utility.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  MAX_COMPARE_LINE = 65536,
+  MAX_COMPARE_RESULT = 4096,
+  MAX_COMPARE_NAME = 127,
+  MAX_COMPARE_LOOP = 1000000
+};
+
+/* A slowdown is flagged when it is this likely not to be chance, and the
+ * median is at least this much slower. */
+static const double MAX_P_VALUE = 0.01;
+static const double MIN_SLOWDOWN = 0.05;
+
+/* The samples of one benchmark at one size. */
+struct compare_result {
+  char name[MAX_COMPARE_NAME + 1];
+  size_t row_count;
+  double samples[BENCH_SAMPLE_COUNT];
+  size_t sample_count;
+};
+
+/* Read the results with samples from a file of JSON lines, as
+ * put_bench_samples prints them. A benchmark that appears more than once
+ * keeps its last line, so that a file of appended runs compares with the
+ * latest. */
+static struct error read_compare_results(const char* filename, struct
+    compare_result* results, size_t max_result, size_t* result_count);
+
+/* Parse one line. Return false if it has no samples. */
+static bool parse_compare_result(const char* line, struct compare_result*);
+
+/* Get the probability that samples at least this much slower than the
+ * baseline come from the same distribution, by the one-sided Mann-Whitney U
+ * test with the normal approximation. */
+static double get_slowdown_p_value(const struct compare_result* baseline,
+    const struct compare_result* current);
+
+/* Get the median of the samples. */
+static double get_compare_median(const struct compare_result*);
+
+/* Compare doubles for qsort. */
+static int compare_samples(const void*, const void*);
+
+bool parse_compare_result(const char* const line, struct compare_result* const
+    result) {
+  const char* const name = strstr(line, "\"bench\":\"");
+  const char* const rows = strstr(line, "\"rows\":");
+  const char* samples = strstr(line, "\"samples_ns\":[");
+  if ((NULL == name) || (NULL == rows) || (NULL == samples)) {
+    return false;
+  }
+  size_t length = 0;
+  for (const char* c = name + strlen("\"bench\":\""); ('"' != *c) && ('\0' !=
+        *c) && (length < MAX_COMPARE_NAME); c++) {
+    result->name[length] = *c;
+    length++;
+  }
+  result->name[length] = '\0';
+  result->row_count = (size_t) strtoull(rows + strlen("\"rows\":"), NULL, 10);
+  samples += strlen("\"samples_ns\":[");
+  result->sample_count = 0;
+  while ((result->sample_count < BENCH_SAMPLE_COUNT) && (']' != *samples)) {
+    char* end;
+    result->samples[result->sample_count] = strtod(samples, &end);
+    if (end == samples) {
+      return false;
+    }
+    result->sample_count++;
+    samples = (',' == *end) ? end + 1 : end;
+  }
+  return 0 < result->sample_count;
+}
+
+struct error read_compare_results(const char* const filename, struct
+    compare_result* const results, const size_t max_result, size_t* const
+    result_count) {
+  struct error error;
+  FILE* const fp = fopen(filename, "r");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  static char line[MAX_COMPARE_LINE];
+  *result_count = 0;
+  for (size_t loop_num = 0; loop_num < MAX_COMPARE_LOOP; loop_num++) {
+    size_t bytes_read;
+    error = get_line(fp, line, MAX_COMPARE_LINE, &bytes_read);
+    if (ERROR_END_OF_FILE == error.code) {
+      break;
+    }
+    struct compare_result result;
+    if ((ERROR_NONE != error.code) || !parse_compare_result(line, &result)) {
+      continue;
+    }
+    size_t result_num = 0;
+    while ((result_num < *result_count) && ((0 != strcmp(result.name,
+              results[result_num].name)) || (result.row_count !=
+            results[result_num].row_count))) {
+      result_num++;
+    }
+    if (max_result <= result_num) {
+      continue;
+    }
+    results[result_num] = result;
+    if (result_num == *result_count) {
+      *result_count += 1;
+    }
+  }
+  fclose(fp);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+int compare_samples(const void* const first, const void* const second) {
+  const double a = *(const double*) first;
+  const double b = *(const double*) second;
+  return (a > b) - (a < b);
+}
+
+double get_compare_median(const struct compare_result* const result) {
+  double sorted[BENCH_SAMPLE_COUNT];
+  memcpy(sorted, result->samples, result->sample_count * sizeof(double));
+  qsort(sorted, result->sample_count, sizeof(double), compare_samples);
+  return get_bench_percentile(sorted, result->sample_count, 0.5);
+}
+
+double get_slowdown_p_value(const struct compare_result* const baseline,
+    const struct compare_result* const current) {
+  /* U counts the pairs where the current sample is the slower one, with
+   * ties counting half. */
+  const double n1 = (double) current->sample_count;
+  const double n2 = (double) baseline->sample_count;
+  double u = 0;
+  for (size_t current_num = 0; current_num < current->sample_count;
+      current_num++) {
+    for (size_t baseline_num = 0; baseline_num < baseline->sample_count;
+        baseline_num++) {
+      const double a = current->samples[current_num];
+      const double b = baseline->samples[baseline_num];
+      u += (a > b) ? 1 : ((a == b) ? 0.5 : 0);
+    }
+  }
+  const double mean = n1 * n2 / 2;
+  const double deviation = sqrt(n1 * n2 * (n1 + n2 + 1) / 12);
+  if (0 == deviation) {
+    return 1;
+  }
+  const double z = (u - mean - 0.5) / deviation;
+  return 0.5 * erfc(z / sqrt(2));
+}
+
+int
+main(int argc, char** argv) {
+  if (3 != argc) {
+    fprintf(stderr, "usage: %s <baseline.jsonl> <current.jsonl>\n", argv[0]);
+    return 2;
+  }
+  static struct compare_result baselines[MAX_COMPARE_RESULT];
+  static struct compare_result currents[MAX_COMPARE_RESULT];
+  size_t baseline_count;
+  size_t current_count;
+  if (ERROR_NONE != read_compare_results(argv[1], baselines,
+        MAX_COMPARE_RESULT, &baseline_count).code) {
+    fprintf(stderr, "could not read %s\n", argv[1]);
+    return 2;
+  }
+  if (ERROR_NONE != read_compare_results(argv[2], currents,
+        MAX_COMPARE_RESULT, &current_count).code) {
+    fprintf(stderr, "could not read %s\n", argv[2]);
+    return 2;
+  }
+
+  size_t slower_count = 0;
+  printf("%-32s %8s %12s %12s %8s %8s\n", "bench", "rows", "baseline ns",
+      "current ns", "change", "p");
+  for (size_t current_num = 0; current_num < current_count; current_num++) {
+    const struct compare_result* const current = &currents[current_num];
+    const struct compare_result* baseline = NULL;
+    for (size_t baseline_num = 0; baseline_num < baseline_count;
+        baseline_num++) {
+      if ((0 == strcmp(current->name, baselines[baseline_num].name)) &&
+          (current->row_count == baselines[baseline_num].row_count)) {
+        baseline = &baselines[baseline_num];
+      }
+    }
+    if (NULL == baseline) {
+      printf("%-32s %8zu %12s\n", current->name, current->row_count,
+          "no baseline");
+      continue;
+    }
+    const double baseline_median = get_compare_median(baseline);
+    const double current_median = get_compare_median(current);
+    const double change = (0 < baseline_median) ? current_median /
+      baseline_median - 1 : 0;
+    const double p_value = get_slowdown_p_value(baseline, current);
+    const bool is_slower = (p_value < MAX_P_VALUE) && (MIN_SLOWDOWN <=
+        change);
+    if (is_slower) {
+      slower_count++;
+    }
+    printf("%-32s %8zu %12.3f %12.3f %+7.1f%% %8.4f%s\n", current->name,
+        current->row_count, baseline_median, current_median, 100 * change,
+        p_value, is_slower ? " SLOWER" : "");
+  }
+  if (0 < slower_count) {
+    printf("%zu slower than the baseline\n", slower_count);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,152 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "harness.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+enum {
+  MAX_BENCH_LOOP = 1000000000
+};
+
+/* Compare doubles for qsort. */
+static int compare_doubles(const void*, const void*);
+
+/* Call the function call_count times and return the seconds it took. */
+static double time_bench_calls(bench_function, void* state, size_t
+    call_count, uint64_t* op_count);
+
+int compare_doubles(const void* const first, const void* const second) {
+  const double a = *(const double*) first;
+  const double b = *(const double*) second;
+  return (a > b) - (a < b);
+}
+
+double time_bench_calls(const bench_function function, void* const state,
+    const size_t call_count, uint64_t* const op_count) {
+  const double start = get_bench_seconds();
+  for (size_t call_num = 0; call_num < call_count; call_num++) {
+    *op_count += function(state);
+  }
+  return get_bench_seconds() - start;
+}
+
+double get_bench_seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+long get_peak_rss(void) {
+  struct rusage usage;
+  if (0 != getrusage(RUSAGE_SELF, &usage)) {
+    return -1;
+  }
+  return usage.ru_maxrss;
+}
+
+struct bench_result run_bench(const bench_function function, void* const
+    state) {
+  assert(NULL != function);
+
+  function(state);
+  struct bench_result result;
+  result.op_count = 0;
+  const double start = get_bench_seconds();
+  double now = start;
+  for (size_t loop_num = 0; (loop_num < MAX_BENCH_LOOP) && (now - start <
+        MIN_BENCH_MS / 1e3); loop_num++) {
+    result.op_count += function(state);
+    now = get_bench_seconds();
+  }
+  result.seconds = now - start;
+  return result;
+}
+
+void put_bench_result(FILE* const fp, const char* const name, const size_t
+    row_count, const struct bench_result* const result, const long
+    peak_rss) {
+  assert(NULL != fp);
+  assert(NULL != name);
+  assert(NULL != result);
+
+  const double ops_per_second = (0 < result->seconds) ? (double)
+    result->op_count / result->seconds : 0;
+  const double ns_per_op = (0 < result->op_count) ? result->seconds * 1e9 /
+    (double) result->op_count : 0;
+  fprintf(fp, "{\"bench\":\"%s\",\"rows\":%zu,\"ops\":%" PRIu64
+      ",\"seconds\":%.6f,\"ops_per_second\":%.1f,\"ns_per_op\":%.2f"
+      ",\"peak_rss_kb\":%ld}\n", name, row_count, result->op_count,
+      result->seconds, ops_per_second, ns_per_op, peak_rss);
+}
+
+void run_bench_samples(const bench_function function, void* const state,
+    struct bench_samples* const samples) {
+  assert(NULL != function);
+  assert(NULL != samples);
+
+  uint64_t op_count = 0;
+  samples->call_count = 1;
+  while ((samples->call_count < MAX_BENCH_LOOP) && (time_bench_calls(
+          function, state, samples->call_count, &op_count) < MIN_SAMPLE_MS /
+        1e3)) {
+    samples->call_count *= 2;
+  }
+  samples->op_count = 0;
+  for (size_t sample_num = 0; sample_num < BENCH_SAMPLE_COUNT;
+      sample_num++) {
+    op_count = 0;
+    const double seconds = time_bench_calls(function, state,
+        samples->call_count, &op_count);
+    samples->ns_per_op[sample_num] = (0 < op_count) ? seconds * 1e9 /
+      (double) op_count : 0;
+    samples->op_count += op_count;
+  }
+}
+
+double get_bench_percentile(const double* const sorted, const size_t count,
+    const double fraction) {
+  assert(NULL != sorted);
+
+  if (0 == count) {
+    return 0;
+  }
+  const double position = fraction * (double) (count - 1);
+  const size_t low = (size_t) position;
+  if (count - 1 <= low) {
+    return sorted[count - 1];
+  }
+  return sorted[low] + (position - (double) low) * (sorted[low + 1] -
+      sorted[low]);
+}
+
+void put_bench_samples(FILE* const fp, const char* const name, const size_t
+    row_count, const struct bench_samples* const samples) {
+  assert(NULL != fp);
+  assert(NULL != name);
+  assert(NULL != samples);
+
+  double sorted[BENCH_SAMPLE_COUNT];
+  for (size_t sample_num = 0; sample_num < BENCH_SAMPLE_COUNT;
+      sample_num++) {
+    sorted[sample_num] = samples->ns_per_op[sample_num];
+  }
+  qsort(sorted, BENCH_SAMPLE_COUNT, sizeof(double), compare_doubles);
+  fprintf(fp, "{\"bench\":\"%s\",\"rows\":%zu,\"ops\":%" PRIu64
+      ",\"median_ns\":%.3f,\"p5_ns\":%.3f,\"p25_ns\":%.3f,\"p75_ns\":%.3f"
+      ",\"p95_ns\":%.3f,\"samples_ns\":[", name, row_count,
+      samples->op_count, get_bench_percentile(sorted, BENCH_SAMPLE_COUNT,
+        0.5), get_bench_percentile(sorted, BENCH_SAMPLE_COUNT, 0.05),
+      get_bench_percentile(sorted, BENCH_SAMPLE_COUNT, 0.25),
+      get_bench_percentile(sorted, BENCH_SAMPLE_COUNT, 0.75),
+      get_bench_percentile(sorted, BENCH_SAMPLE_COUNT, 0.95));
+  for (size_t sample_num = 0; sample_num < BENCH_SAMPLE_COUNT;
+      sample_num++) {
+    fprintf(fp, "%s%.3f", (0 == sample_num) ? "" : ",",
+        samples->ns_per_op[sample_num]);
+  }
+  fputs("]}\n", fp);
+}
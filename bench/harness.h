@@ -0,0 +1,66 @@
+#ifndef _ebs_harness_h_
+#define _ebs_harness_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+enum {
+  /* How long a benchmark repeats its operation for at least, in
+   * milliseconds. */
+  MIN_BENCH_MS = 200,
+  /* How many times a sampled benchmark is timed, and how long each sample
+   * takes at least, in milliseconds. */
+  BENCH_SAMPLE_COUNT = 31,
+  MIN_SAMPLE_MS = 10
+};
+
+/* The work a benchmark repeats. It returns the number of operations it did,
+ * and anything it computes should go into state so that it is not optimized
+ * away. */
+typedef uint64_t (*bench_function)(void* state);
+
+struct bench_result {
+  uint64_t op_count;
+  double seconds;
+};
+
+/* The nanoseconds per operation of each sample, in the order they were
+ * taken. Every sample calls the function call_count times. */
+struct bench_samples {
+  double ns_per_op[BENCH_SAMPLE_COUNT];
+  size_t call_count;
+  uint64_t op_count;
+};
+
+/* Get the time of a clock that only goes forward, in seconds. */
+double get_bench_seconds(void);
+
+/* Get the peak resident set size of the process so far, in KiB. */
+long get_peak_rss(void);
+
+/* Call the function until MIN_BENCH_MS have passed, after one call to warm
+ * up that is not counted. */
+struct bench_result run_bench(bench_function, void* state);
+
+/* Call the function until a batch of calls takes MIN_SAMPLE_MS, doubling
+ * the batch each time, which also warms up the caches. Then time
+ * BENCH_SAMPLE_COUNT batches of that size. */
+void run_bench_samples(bench_function, void* state, struct bench_samples*);
+
+/* Get the value below which the given fraction of the sorted values lie,
+ * interpolating between the two closest ones. */
+double get_bench_percentile(const double* sorted, size_t count, double
+    fraction);
+
+/* Print samples as one line of JSON with the median, the 5th, 25th, 75th
+ * and 95th percentiles and every sample in nanoseconds per operation. */
+void put_bench_samples(FILE*, const char* name, size_t row_count, const
+    struct bench_samples*);
+
+/* Print a result as one line of JSON with the operations per second, the
+ * nanoseconds per operation and the peak resident set size. */
+void put_bench_result(FILE*, const char* name, size_t row_count, const struct
+    bench_result*, long peak_rss);
+
+#endif
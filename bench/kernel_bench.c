@@ -0,0 +1,334 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "error.h"
+#include "expression.h"
+#include "harness.h"
+#include "hash.h"
+#include "task.h"
+#include "utility.h"
+#include "workload.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+enum {
+  MAX_BENCH_PATH = 4096,
+  MAX_BENCH_LINE = 4096,
+  /* Keys that all start probing at the same entry. */
+  COLLIDING_KEY_COUNT = 64,
+  /* The longest haystack and line of the adversarial inputs. */
+  LONG_TEXT_LENGTH = 4000,
+  MAX_LONG_LINE = 1000,
+  MAX_READ_LINE = 1000000000,
+  MAX_TIME_STRING = 32
+};
+
+/* Keys hashed one after another. */
+struct murmur_state {
+  const char* key;
+  size_t length;
+  uint32_t sum;
+};
+
+/* A hash and the keys looked up in it, one after another. */
+struct find_state {
+  struct ebs_hash* hash;
+  char (*keys)[MAX_HASH_KEY + 1];
+  size_t key_count;
+  size_t key_num;
+  size_t found_count;
+};
+
+struct contains_state {
+  const char* haystack;
+  const char* needle;
+  size_t found_count;
+};
+
+struct time_state {
+  const char* string;
+  struct tm time;
+  size_t error_count;
+};
+
+struct format_state {
+  struct tm time;
+  char string[MAX_TIME_STRING];
+};
+
+struct task_state {
+  const char* row;
+  struct task task;
+  size_t error_count;
+};
+
+/* A file read line by line from the start. */
+struct line_state {
+  FILE* fp;
+  char line[MAX_BENCH_LINE];
+  size_t byte_count;
+};
+
+/* Hash one key. */
+static uint64_t bench_murmur3(void* state);
+
+/* Look up the next key. */
+static uint64_t bench_hash_find(void* state);
+
+/* Search the haystack for the needle. */
+static uint64_t bench_string_contains(void* state);
+
+/* Parse a time, valid or not. */
+static uint64_t bench_parse_time(void* state);
+
+/* Format a time. */
+static uint64_t bench_format_time(void* state);
+
+/* Parse a row of the task sheet, valid or not. */
+static uint64_t bench_parse_task(void* state);
+
+/* Read the whole file. An operation is a line. */
+static uint64_t bench_get_line(void* state);
+
+/* Fill the hash with key_count workload names, which are also the keys.
+ * Return the number of keys. */
+static size_t fill_name_hash(struct ebs_hash*, char (*keys)[MAX_HASH_KEY + 1],
+    size_t key_count);
+
+/* Fill the hash with keys that all start probing at the same entry, so that
+ * each one is found at the end of a longer chain. Return the number of
+ * keys. */
+static size_t fill_colliding_hash(struct ebs_hash*, char (*keys)[MAX_HASH_KEY
+    + 1]);
+
+/* Run the samples of a benchmark and print them. */
+static void run_kernel(const char* name, size_t row_count, bench_function,
+    void* state);
+
+uint64_t bench_murmur3(void* const state) {
+  struct murmur_state* const murmur = state;
+  murmur->sum += ebs_hash_murmur3(murmur->key, murmur->length, murmur->sum);
+  return 1;
+}
+
+uint64_t bench_hash_find(void* const state) {
+  struct find_state* const find = state;
+  size_t index;
+  if (ERROR_NONE == ebs_hash_find(find->hash, find->keys[find->key_num],
+        &index).code) {
+    find->found_count++;
+  }
+  find->key_num = (find->key_num + 1) % find->key_count;
+  return 1;
+}
+
+uint64_t bench_string_contains(void* const state) {
+  struct contains_state* const contains = state;
+  if (string_contains(contains->haystack, contains->needle)) {
+    contains->found_count++;
+  }
+  return 1;
+}
+
+uint64_t bench_parse_time(void* const state) {
+  struct time_state* const parse = state;
+  if (ERROR_NONE != parse_iso_8601_time(parse->string, &parse->time).code) {
+    parse->error_count++;
+  }
+  return 1;
+}
+
+uint64_t bench_format_time(void* const state) {
+  struct format_state* const format = state;
+  struct error error = format_iso_8601_time(&format->time, format->string,
+      sizeof(format->string));
+  assert(ERROR_NONE == error.code);
+  return 1;
+}
+
+uint64_t bench_parse_task(void* const state) {
+  struct task_state* const parse = state;
+  if (ERROR_NONE != parse_task(parse->row, &parse->task).code) {
+    parse->error_count++;
+  }
+  return 1;
+}
+
+uint64_t bench_get_line(void* const state) {
+  struct line_state* const read = state;
+  rewind(read->fp);
+  uint64_t line_count = 0;
+  for (size_t loop_num = 0; loop_num < MAX_READ_LINE; loop_num++) {
+    size_t bytes_read;
+    struct error error = get_line(read->fp, read->line, MAX_BENCH_LINE,
+        &bytes_read);
+    read->byte_count += bytes_read;
+    if (ERROR_END_OF_FILE == error.code) {
+      break;
+    }
+    line_count++;
+  }
+  return line_count;
+}
+
+size_t fill_name_hash(struct ebs_hash* const hash, char (*const keys)[
+    MAX_HASH_KEY + 1], const size_t key_count) {
+  ebs_hash_init(hash);
+  for (size_t key_num = 0; key_num < key_count; key_num++) {
+    get_workload_name(key_num, keys[key_num], MAX_HASH_KEY + 1);
+    struct error error = ebs_hash_add(hash, keys[key_num]);
+    assert(ERROR_NONE == error.code);
+  }
+  return key_count;
+}
+
+size_t fill_colliding_hash(struct ebs_hash* const hash, char (*const keys)[
+    MAX_HASH_KEY + 1]) {
+  /* In an empty hash, the entry a key is not found at is the one it starts
+   * at. The chain starts early enough that it does not run off the end. */
+  static struct ebs_hash empty;
+  ebs_hash_init(&empty);
+  ebs_hash_init(hash);
+  size_t first_entry;
+  ebs_hash_find(&empty, "web-login-0", &first_entry);
+  first_entry %= MAX_HASH_ENTRY - COLLIDING_KEY_COUNT;
+  size_t key_count = 0;
+  for (size_t name_num = 0; (key_count < COLLIDING_KEY_COUNT) && (name_num <
+        (size_t) MAX_HASH_ENTRY * COLLIDING_KEY_COUNT * 64); name_num++) {
+    char name[MAX_HASH_KEY + 1];
+    get_workload_name(name_num, name, sizeof(name));
+    size_t entry;
+    ebs_hash_find(&empty, name, &entry);
+    if (first_entry != entry) {
+      continue;
+    }
+    memcpy(keys[key_count], name, sizeof(name));
+    struct error error = ebs_hash_add(hash, name);
+    assert(ERROR_NONE == error.code);
+    key_count++;
+  }
+  return key_count;
+}
+
+void run_kernel(const char* const name, const size_t row_count, const
+    bench_function function, void* const state) {
+  struct bench_samples samples;
+  run_bench_samples(function, state, &samples);
+  put_bench_samples(stdout, name, row_count, &samples);
+}
+
+int
+main(int argc, char** argv) {
+  if (2 != argc) {
+    fprintf(stderr, "usage: %s <rows>\n", argv[0]);
+    return 1;
+  }
+  intmax_t row_count;
+  if ((ERROR_NONE != parse_int(argv[1], 10, &row_count).code) || (row_count
+        <= 0)) {
+    fprintf(stderr, "bad row count %s\n", argv[1]);
+    return 1;
+  }
+  const size_t rows = (size_t) row_count;
+
+  char directory[64];
+  char task_sheet[MAX_BENCH_PATH];
+  char long_sheet[MAX_BENCH_PATH];
+  snprintf(directory, sizeof(directory), "bench/data-%zu", rows);
+  snprintf(task_sheet, sizeof(task_sheet), "%s/task.tsv", directory);
+  snprintf(long_sheet, sizeof(long_sheet), "%s/long.tsv", directory);
+  struct stat status;
+  if (0 != stat(task_sheet, &status)) {
+    mkdir(directory, 0777);
+    if (ERROR_NONE != generate_workload(directory, rows, rows).code) {
+      fprintf(stderr, "could not write the workload to %s\n", directory);
+      return 1;
+    }
+  }
+
+  static char long_text[LONG_TEXT_LENGTH + 1];
+  memset(long_text, 'a', LONG_TEXT_LENGTH);
+
+  struct murmur_state murmur = { "web-login-42", strlen("web-login-42"), 0 };
+  run_kernel("ebs_hash_murmur3_name", rows, bench_murmur3, &murmur);
+  murmur.key = long_text;
+  murmur.length = MAX_HASH_KEY;
+  run_kernel("ebs_hash_murmur3_long", rows, bench_murmur3, &murmur);
+
+  /* Names at three quarters of the hash, then a chain of collisions. */
+  static struct ebs_hash hash;
+  static char keys[MAX_HASH_ENTRY][MAX_HASH_KEY + 1];
+  struct find_state find = { &hash, keys, 0, 0, 0 };
+  find.key_count = fill_name_hash(&hash, keys, MAX_HASH_ENTRY * 3 / 4);
+  run_kernel("ebs_hash_find_names", rows, bench_hash_find, &find);
+  find.key_num = 0;
+  find.key_count = fill_colliding_hash(&hash, keys);
+  assert(0 < find.key_count);
+  run_kernel("ebs_hash_find_collisions", rows, bench_hash_find, &find);
+
+  /* A filter word in a name, and the needle that makes a naive search look
+   * at every byte of the haystack for each one of its own. */
+  struct contains_state contains = { "billing-refactor-1234", "refactor", 0 };
+  run_kernel("string_contains_name", rows, bench_string_contains, &contains);
+  static char long_needle[65];
+  memset(long_needle, 'a', 63);
+  long_needle[63] = 'b';
+  contains.haystack = long_text;
+  contains.needle = long_needle;
+  run_kernel("string_contains_repetitive", rows, bench_string_contains,
+      &contains);
+
+  struct time_state parse_time;
+  memset(&parse_time, 0, sizeof(parse_time));
+  parse_time.string = "2024-05-14T09:30:00";
+  run_kernel("parse_iso_8601_time", rows, bench_parse_time, &parse_time);
+  parse_time.string = "2024-05-14 09:30";
+  run_kernel("parse_iso_8601_time_malformed", rows, bench_parse_time,
+      &parse_time);
+
+  struct format_state format;
+  memset(&format, 0, sizeof(format));
+  assert(ERROR_NONE == parse_iso_8601_time("2024-02-29T23:59:59",
+        &format.time).code);
+  run_kernel("format_iso_8601_time", rows, bench_format_time, &format);
+
+  /* A row as ebs writes it, and one as long as a line gets, with the
+   * longest name and an estimate padded with zeros. */
+  struct task_state parse;
+  memset(&parse, 0, sizeof(parse));
+  parse.row = "web-login-42\tACTIVE\t120\t0\tann";
+  run_kernel("parse_task", rows, bench_parse_task, &parse);
+  static char long_row[MAX_BENCH_LINE];
+  memset(long_row, '0', MAX_BENCH_LINE - 1);
+  memset(long_row, 'x', MAX_TASK_NAME);
+  memcpy(&long_row[MAX_TASK_NAME], "\tACTIVE\t", 8);
+  memcpy(&long_row[MAX_BENCH_LINE - 3], "\t0", 2);
+  parse.row = long_row;
+  run_kernel("parse_task_long", rows, bench_parse_task, &parse);
+
+  struct line_state read;
+  memset(&read, 0, sizeof(read));
+  read.fp = fopen(task_sheet, "r");
+  assert(NULL != read.fp);
+  run_kernel("get_line_task_sheet", rows, bench_get_line, &read);
+  fclose(read.fp);
+
+  /* Lines twice as long as the buffer. */
+  read.fp = fopen(long_sheet, "w+");
+  assert(NULL != read.fp);
+  const size_t long_line_count = (rows < MAX_LONG_LINE) ? rows :
+    MAX_LONG_LINE;
+  for (size_t line_num = 0; line_num < long_line_count; line_num++) {
+    for (size_t byte_num = 0; byte_num < 2 * MAX_BENCH_LINE; byte_num++) {
+      fputc('x', read.fp);
+    }
+    fputc('\n', read.fp);
+  }
+  run_kernel("get_line_long_lines", rows, bench_get_line, &read);
+  fclose(read.fp);
+  remove(long_sheet);
+  return 0;
+}
@@ -0,0 +1,18 @@
+echo "Running benchmarks:"
+
+for rows in $BENCHROWS
+do
+        for i in bench/*_bench
+        do
+                if test -f $i
+                then
+                        if ! ./$i $rows | tee -a bench/results.jsonl
+                        then
+                                echo "ERROR in benchmark $i"
+                                exit 1
+                        fi
+                fi
+        done
+done
+
+echo ""
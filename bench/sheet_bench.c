@@ -0,0 +1,293 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "calendar.h"
+#include "config.h"
+#include "error.h"
+#include "expression.h"
+#include "harness.h"
+#include "monte_carlo.h"
+#include "task.h"
+#include "task_load.h"
+#include "utility.h"
+#include "workload.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+enum {
+  MAX_BENCH_TASK = 1024,
+  MAX_BENCH_PATH = 4096,
+  SIMULATION_COUNT = 100,
+  SECONDS_OF_WORK = 1000 * 3600,
+  SECONDS_OF_WORK_PER_DAY = 8 * 3600
+};
+
+/* Filters as they are typed: a word, a choice of words and a regex. */
+static const char* const FILTERS[] = {
+  "login",
+  "web,api/!test",
+  "~^(infra|db)-.*-[0-9]+$"
+};
+
+static const char* const FILTER_BENCHES[] = {
+  "string_matches_word",
+  "string_matches_choice",
+  "string_matches_regex"
+};
+
+/* Every task of a directory, loaded as list --all does but into a buffer
+ * that holds the whole sheet. */
+struct load_state {
+  struct config config;
+  struct expression everything;
+  struct task* tasks;
+  size_t max_task;
+  size_t task_count;
+};
+
+/* The time sheet, replayed into the first tasks of the workload. */
+struct replay_state {
+  const char* time_sheet;
+  struct task* tasks;
+  size_t task_count;
+  size_t record_count;
+};
+
+struct parse_state {
+  const char* text;
+  size_t literal_count;
+};
+
+struct match_state {
+  const struct expression* expression;
+  char (*names)[MAX_TASK_NAME + 1];
+  size_t name_count;
+  size_t match_count;
+};
+
+struct simulate_state {
+  double velocities[MAX_BENCH_TASK];
+  size_t velocity_count;
+  double estimates[MAX_BENCH_TASK];
+  size_t estimate_count;
+  double simulated[SIMULATION_COUNT];
+};
+
+struct calendar_state {
+  struct tm start;
+  struct calendar calendar;
+  struct tm end;
+};
+
+/* Load the tasks of the directory once. */
+static uint64_t bench_load_tasks(void* state);
+
+/* Replay the whole time sheet once. An operation is a record. */
+static uint64_t bench_read_time_sheet(void* state);
+
+/* Parse a filter and free it. */
+static uint64_t bench_parse_expression(void* state);
+
+/* Match every name once. An operation is a name. */
+static uint64_t bench_string_matches(void* state);
+
+/* Run one forecast worth of simulations. */
+static uint64_t bench_simulate(void* state);
+
+/* Walk the calendar to the end of SECONDS_OF_WORK of work. */
+static uint64_t bench_compute_completion_date(void* state);
+
+/* Read the first tasks of the task sheet. */
+static size_t read_bench_tasks(const char* task_sheet, struct task* tasks,
+    size_t max_task);
+
+uint64_t bench_load_tasks(void* const state) {
+  struct load_state* const load = state;
+  struct error error = load_tasks("", &load->everything, NULL, true,
+      &load->config, load->tasks, load->max_task, &load->task_count);
+  assert(ERROR_NONE == error.code);
+  return 1;
+}
+
+uint64_t bench_read_time_sheet(void* const state) {
+  struct replay_state* const replay = state;
+  for (size_t task_num = 0; task_num < replay->task_count; task_num++) {
+    replay->tasks[task_num].actual_seconds = 0;
+  }
+  struct error error = read_time_sheet(replay->time_sheet, replay->tasks,
+      replay->task_count);
+  assert(ERROR_NONE == error.code);
+  return replay->record_count;
+}
+
+uint64_t bench_parse_expression(void* const state) {
+  struct parse_state* const parse = state;
+  struct expression expression;
+  struct error error = parse_expression(parse->text, &expression);
+  assert(ERROR_NONE == error.code);
+  parse->literal_count += expression.literal_count;
+  free_expression(&expression);
+  return 1;
+}
+
+uint64_t bench_string_matches(void* const state) {
+  struct match_state* const match = state;
+  for (size_t name_num = 0; name_num < match->name_count; name_num++) {
+    if (string_matches(match->names[name_num], match->expression)) {
+      match->match_count++;
+    }
+  }
+  return match->name_count;
+}
+
+uint64_t bench_simulate(void* const state) {
+  struct simulate_state* const simulation = state;
+  simulate(simulation->velocities, simulation->velocity_count,
+      simulation->estimates, simulation->estimate_count,
+      simulation->simulated, SIMULATION_COUNT);
+  return 1;
+}
+
+uint64_t bench_compute_completion_date(void* const state) {
+  struct calendar_state* const walk = state;
+  struct error error = compute_completion_date(&walk->start, &walk->calendar,
+      SECONDS_OF_WORK_PER_DAY, SECONDS_OF_WORK, &walk->end);
+  assert(ERROR_NONE == error.code);
+  return 1;
+}
+
+size_t read_bench_tasks(const char* const task_sheet, struct task* const
+    tasks, const size_t max_task) {
+  FILE* const fp = fopen(task_sheet, "r");
+  if (NULL == fp) {
+    return 0;
+  }
+  size_t task_count = 0;
+  while ((task_count < max_task) && (ERROR_NONE == read_task(fp,
+          &tasks[task_count]).code)) {
+    task_count++;
+  }
+  fclose(fp);
+  return task_count;
+}
+
+int
+main(int argc, char** argv) {
+  if (2 != argc) {
+    fprintf(stderr, "usage: %s <rows>\n", argv[0]);
+    return 1;
+  }
+  intmax_t row_count;
+  if ((ERROR_NONE != parse_int(argv[1], 10, &row_count).code) || (row_count
+        <= 0)) {
+    fprintf(stderr, "bad row count %s\n", argv[1]);
+    return 1;
+  }
+  const size_t rows = (size_t) row_count;
+
+  /* The workload is kept between runs, since it is the same for the same
+   * count. */
+  char directory[64];
+  char task_sheet[MAX_BENCH_PATH];
+  char time_sheet[MAX_BENCH_PATH];
+  snprintf(directory, sizeof(directory), "bench/data-%zu", rows);
+  snprintf(task_sheet, sizeof(task_sheet), "%s/task.tsv", directory);
+  snprintf(time_sheet, sizeof(time_sheet), "%s/time.tsv", directory);
+  struct stat status;
+  if (0 != stat(time_sheet, &status)) {
+    mkdir(directory, 0777);
+    if (ERROR_NONE != generate_workload(directory, rows, rows).code) {
+      fprintf(stderr, "could not write the workload to %s\n", directory);
+      return 1;
+    }
+  }
+
+  /* The result is labelled with the tasks that were loaded, in case the
+   * sheet has rows that don't parse. */
+  static struct load_state load;
+  load.config.base_path = directory;
+  load.config.base_paths[0] = directory;
+  load.config.path_count = 1;
+  struct error error = parse_expression("", &load.everything);
+  assert(ERROR_NONE == error.code);
+  load.max_task = rows;
+  load.tasks = malloc((rows + 1) * sizeof(struct task));
+  assert(NULL != load.tasks);
+  struct bench_result result = run_bench(bench_load_tasks, &load);
+  if (load.task_count != rows) {
+    fprintf(stderr, "loaded %zu of %zu tasks\n", load.task_count, rows);
+  }
+  put_bench_result(stdout, "load_tasks", load.task_count, &result,
+      get_peak_rss());
+  free(load.tasks);
+  free_expression(&load.everything);
+
+  static struct task tasks[MAX_BENCH_TASK];
+  const size_t task_count = read_bench_tasks(task_sheet, tasks,
+      MAX_BENCH_TASK);
+  struct replay_state replay = { time_sheet, tasks, task_count, rows };
+  result = run_bench(bench_read_time_sheet, &replay);
+  put_bench_result(stdout, "read_time_sheet", rows, &result,
+      get_peak_rss());
+
+  struct parse_state parse = { FILTERS[2], 0 };
+  result = run_bench(bench_parse_expression, &parse);
+  put_bench_result(stdout, "parse_expression", rows, &result,
+      get_peak_rss());
+
+  /* Names come from the whole workload, up to a million of them. */
+  const size_t name_count = (rows < 1000000) ? rows : 1000000;
+  char (*const names)[MAX_TASK_NAME + 1] = malloc(name_count *
+      sizeof(*names));
+  assert(NULL != names);
+  for (size_t name_num = 0; name_num < name_count; name_num++) {
+    get_workload_name(name_num * (rows / name_count), names[name_num],
+        MAX_TASK_NAME + 1);
+  }
+  for (size_t filter_num = 0; filter_num < sizeof(FILTERS) /
+      sizeof(FILTERS[0]); filter_num++) {
+    struct expression expression;
+    error = parse_expression(FILTERS[filter_num], &expression);
+    assert(ERROR_NONE == error.code);
+    struct match_state match = { &expression, names, name_count, 0 };
+    result = run_bench(bench_string_matches, &match);
+    put_bench_result(stdout, FILTER_BENCHES[filter_num], rows, &result,
+        get_peak_rss());
+    free_expression(&expression);
+  }
+  free(names);
+
+  /* The forecast of the workload's first tasks. */
+  static struct simulate_state simulation;
+  for (size_t task_num = 0; task_num < task_count; task_num++) {
+    const struct task* const task = &tasks[task_num];
+    if ((STATUS_DONE == task->status) && (0 < task->actual_seconds)) {
+      simulation.velocities[simulation.velocity_count] = (double)
+        task->estimated_seconds / (double) task->actual_seconds;
+      simulation.velocity_count++;
+    } else if (STATUS_ACTIVE == task->status) {
+      simulation.estimates[simulation.estimate_count] = (double)
+        task->estimated_seconds;
+      simulation.estimate_count++;
+    }
+  }
+  result = run_bench(bench_simulate, &simulation);
+  put_bench_result(stdout, "simulate", rows, &result, get_peak_rss());
+
+  struct calendar_state walk;
+  memset(&walk, 0, sizeof(walk));
+  walk.start.tm_year = 2024 - 1900;
+  walk.start.tm_mday = 1;
+  walk.start.tm_isdst = -1;
+  mktime(&walk.start);
+  init_calendar(&walk.calendar);
+  error = add_work_week(&walk.start, &walk.calendar);
+  assert(ERROR_NONE == error.code);
+  result = run_bench(bench_compute_completion_date, &walk);
+  put_bench_result(stdout, "compute_completion_date", rows, &result,
+      get_peak_rss());
+  free_calendar(&walk.calendar);
+  return 0;
+}
@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "workload.h"
+#include "error.h"
+#include "task.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+enum {
+  WORKLOAD_SEED = 20240101,
+  MAX_WORKLOAD_PATH = 4096,
+  MAX_TIME_STRING = 32
+};
+
+static const char* const AREAS[] = {
+  "web", "api", "infra", "dns", "db", "mobile", "billing", "search"
+};
+
+static const char* const VERBS[] = {
+  "login", "migrate", "fix", "cache", "deploy", "refactor", "test", "report"
+};
+
+static const char* const OWNERS[] = { "ann", "bo", "cy" };
+
+/* Write the task sheet of the workload. */
+static struct error write_workload_tasks(const char* task_sheet, size_t
+    task_count);
+
+/* Write the time sheet of the workload. */
+static struct error write_workload_times(const char* time_sheet, size_t
+    task_count, size_t record_count);
+
+uint32_t get_workload_random(uint64_t* const state) {
+  assert(NULL != state);
+
+  /* A 64 bit linear congruential generator, keeping the better high
+   * bits. */
+  *state = *state * UINT64_C(6364136223846793005) +
+    UINT64_C(1442695040888963407);
+  return (uint32_t) (*state >> 32);
+}
+
+void get_workload_name(const size_t task_num, char* const name, const size_t
+    max_name) {
+  assert(NULL != name);
+
+  const size_t area_count = sizeof(AREAS) / sizeof(AREAS[0]);
+  const size_t verb_count = sizeof(VERBS) / sizeof(VERBS[0]);
+  snprintf(name, max_name, "%s-%s-%zu", AREAS[task_num % area_count],
+      VERBS[task_num / area_count % verb_count], task_num);
+}
+
+struct error write_workload_tasks(const char* const task_sheet, const size_t
+    task_count) {
+  struct error error;
+  FILE* const fp = fopen(task_sheet, "w");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  uint64_t state = WORKLOAD_SEED;
+  for (size_t task_num = 0; task_num < task_count; task_num++) {
+    char name[MAX_TASK_NAME + 1];
+    get_workload_name(task_num, name, sizeof(name));
+    const uint32_t estimate = 15 * (1 + get_workload_random(&state) % 32);
+    const bool is_done = (get_workload_random(&state) % 5 < 2);
+    /* Actual times are a quarter to four times the estimate. */
+    const uint32_t actual = is_done ? estimate * (1 +
+        get_workload_random(&state) % 16) / 4 : 0;
+    fprintf(fp, "%s\t%s\t%u\t%u", name, get_task_status(is_done ?
+          STATUS_DONE : STATUS_ACTIVE), estimate, actual);
+    if (0 == get_workload_random(&state) % 4) {
+      fprintf(fp, "\t%s", OWNERS[get_workload_random(&state) % 3]);
+    }
+    fputc('\n', fp);
+  }
+  error.code = (0 != fclose(fp)) ? ERROR_FILE : ERROR_NONE;
+  return error;
+}
+
+struct error write_workload_times(const char* const time_sheet, const size_t
+    task_count, const size_t record_count) {
+  struct error error;
+  FILE* const fp = fopen(time_sheet, "w");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  struct tm start;
+  start.tm_year = 2020 - 1900;
+  start.tm_mon = 0;
+  start.tm_mday = 1;
+  start.tm_hour = 9;
+  start.tm_min = 0;
+  start.tm_sec = 0;
+  start.tm_isdst = -1;
+  time_t record_time = mktime(&start);
+  uint64_t state = WORKLOAD_SEED + 1;
+  for (size_t record_num = 0; (0 < task_count) && (record_num <
+        record_count); record_num++) {
+    char name[MAX_TASK_NAME + 1];
+    get_workload_name(get_workload_random(&state) % task_count, name,
+        sizeof(name));
+    struct tm local;
+    char time_string[MAX_TIME_STRING];
+    localtime_r(&record_time, &local);
+    strftime(time_string, sizeof(time_string), "%Y-%m-%dT%H:%M:%S", &local);
+    fprintf(fp, "%s\t%s\n", time_string, name);
+    record_time += 60 * (time_t) (1 + get_workload_random(&state) % 120);
+  }
+  error.code = (0 != fclose(fp)) ? ERROR_FILE : ERROR_NONE;
+  return error;
+}
+
+struct error generate_workload(const char* const directory, const size_t
+    task_count, const size_t record_count) {
+  assert(NULL != directory);
+
+  char path[MAX_WORKLOAD_PATH];
+  snprintf(path, sizeof(path), "%s/task.tsv", directory);
+  struct error error = write_workload_tasks(path, task_count);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  snprintf(path, sizeof(path), "%s/time.tsv", directory);
+  return write_workload_times(path, task_count, record_count);
+}
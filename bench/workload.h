@@ -0,0 +1,22 @@
+#ifndef _ebs_workload_h_
+#define _ebs_workload_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Get the next number of the generator whose state is given. The state
+ * starts at any value, and the same state gives the same numbers. */
+uint32_t get_workload_random(uint64_t* state);
+
+/* Get the name of a task of the workload, such as web-login-42. */
+void get_workload_name(size_t task_num, char* name, size_t max_name);
+
+/* Write task.tsv with task_count tasks and time.tsv with record_count
+ * records to the directory, which must exist. The same counts always give
+ * the same sheets: about two in five tasks are done, a quarter are
+ * assigned, and the records are in order a few minutes to two hours
+ * apart. */
+struct error generate_workload(const char* directory, size_t task_count,
+    size_t record_count);
+
+#endif
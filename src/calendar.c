@@ -1,13 +1,51 @@
 #include "calendar.h"
 #include "utility.h"
 #include "error.h"
+#include "profile.h"
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 enum {
-  MAX_BUFFER_LENGTH = 255
+  MAX_BUFFER_LENGTH = 255,
+  MIN_CAPACITY = 16,
+  MAX_LOOP = 1000000
 };
 
+/* Compare day numbers for qsort. */
+static int
+compare_day_numbers(const void*, const void*);
+
+/* Make room for at least the given number of dates. */
+static struct error
+reserve_date_set(struct date_set*, size_t);
+
+/* Sort the dates and drop duplicates. */
+static void
+sort_date_set(struct date_set*);
+
+/* Find the first index whose day is not less than the given day. */
+static size_t
+find_date(const struct date_set*, int32_t);
+
+/* Check if the day is in the set, moving the cursor forward. */
+static bool
+is_at_date_cursor(const struct date_set*, int32_t, size_t*);
+
+/* Append an event to a growable array of events. */
+static struct error
+add_event(const struct event*, struct event**, size_t*, size_t*);
+
+/* Return true if the period is a whole number of days. */
+static bool
+is_daily_period(const struct tm*);
+
+/* Check if the date is a work day. The cursors track the one-off dates; the
+ * dates asked for must not decrease between calls. */
+static bool
+is_work_day(const struct tm*, const struct calendar*, size_t*, size_t*);
+
 const struct tm DAY = {
   .tm_year = 0,
   .tm_mon = 0,
@@ -45,6 +83,7 @@ add_time(const struct tm* const first, const struct tm* const second,
   result->tm_isdst = -1;
   
   struct error error;
+  count_profile(COUNTER_MKTIME_CALLS, 1);
   if ((time_t) -1 == mktime(result)) {
     error.code = ERROR_INVALID_TIME;
     return error;
@@ -63,6 +102,7 @@ add_days(const struct tm* date, const int n, struct tm* const result) {
   result->tm_mday += n;
 
   struct error error;
+  count_profile(COUNTER_MKTIME_CALLS, 1);
   if (((time_t) -1) == mktime(result)) {
     error.code = ERROR_INVALID_TIME;
     return error;
@@ -150,6 +190,18 @@ is_in_event(const struct tm* date, const struct event* const event) {
   assert(NULL != date);
   assert(NULL != event);
 
+  /* Events repeating every N days are answered with day arithmetic. */
+  if (is_daily_period(&event->period)) {
+    const int64_t days_since_start = (int64_t) get_day_number(date) -
+      (int64_t) get_day_number(&event->start);
+    if (days_since_start < 0) {
+      return false;
+    }
+    const int64_t period_days = event->period.tm_mday;
+    return (0 == days_since_start % period_days) &&
+      ((uint64_t) (days_since_start / period_days) < event->repetition);
+  }
+
   struct tm iterating_date = event->start;
   uint64_t repetition;
 
@@ -166,34 +218,373 @@ is_in_event(const struct tm* date, const struct event* const event) {
   return false;
 }
 
+/* Get the number of days from 1970-01-01 to a normalized date. This avoids
+ * mktime, so it is cheap enough to call for every day visited. */
+int32_t
+get_day_number(const struct tm* const date) {
+  assert(NULL != date);
+
+  const int64_t month = date->tm_mon + 1;
+  const int64_t year = (int64_t) date->tm_year + 1900 - (month <= 2 ? 1 : 0);
+  const int64_t era = (0 <= year ? year : year - 399) / 400;
+  const int64_t year_of_era = year - era * 400;
+  const int64_t day_of_year = (153 * (month + (2 < month ? -3 : 9)) + 2) / 5 +
+    date->tm_mday - 1;
+  const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 -
+    year_of_era / 100 + day_of_year;
+  return (int32_t) (era * 146097 + day_of_era - 719468);
+}
+
+/* Compare day numbers for qsort. */
+int
+compare_day_numbers(const void* const first, const void* const second) {
+  const int32_t a = *(const int32_t*) first;
+  const int32_t b = *(const int32_t*) second;
+  return (a > b) - (a < b);
+}
+
+/* Make room for at least the given number of dates. */
+struct error
+reserve_date_set(struct date_set* const set, const size_t capacity) {
+  assert(NULL != set);
+
+  struct error error;
+  error.code = ERROR_NONE;
+  if (capacity <= set->capacity) {
+    return error;
+  }
+  size_t new_capacity = set->capacity < MIN_CAPACITY ? MIN_CAPACITY :
+    set->capacity;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+  int32_t* const days = realloc(set->days, new_capacity * sizeof(int32_t));
+  if (NULL == days) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  set->days = days;
+  set->capacity = new_capacity;
+  return error;
+}
+
+/* Sort the dates and drop duplicates. */
+void
+sort_date_set(struct date_set* const set) {
+  assert(NULL != set);
+
+  if (set->length < 2) {
+    return;
+  }
+  qsort(set->days, set->length, sizeof(int32_t), compare_day_numbers);
+  size_t unique_length = 1;
+  for (size_t index = 1; index < set->length; index++) {
+    if (set->days[index] != set->days[unique_length - 1]) {
+      set->days[unique_length] = set->days[index];
+      unique_length++;
+    }
+  }
+  set->length = unique_length;
+}
+
+/* Find the first index whose day is not less than the given day. */
+size_t
+find_date(const struct date_set* const set, const int32_t day_number) {
+  assert(NULL != set);
+
+  size_t low = 0;
+  size_t high = set->length;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (set->days[middle] < day_number) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/* Check if the day is in the set, moving the cursor forward. The days asked
+ * for must not decrease between calls, which makes a walk over consecutive
+ * days linear in the number of days plus the size of the set. */
+bool
+is_at_date_cursor(const struct date_set* const set, const int32_t day_number,
+    size_t* const cursor) {
+  assert(NULL != set);
+  assert(NULL != cursor);
+
+  while ((*cursor < set->length) && (set->days[*cursor] < day_number)) {
+    *cursor += 1;
+  }
+  return (*cursor < set->length) && (set->days[*cursor] == day_number);
+}
+
+/* Initialize an empty date set. */
+void
+init_date_set(struct date_set* const set) {
+  assert(NULL != set);
+  set->days = NULL;
+  set->length = 0;
+  set->capacity = 0;
+}
+
+/* Release the memory of a date set. */
+void
+free_date_set(struct date_set* const set) {
+  assert(NULL != set);
+  free(set->days);
+  init_date_set(set);
+}
+
+/* Add a date. Adding dates in increasing order is the fast path. */
+struct error
+add_date(const int32_t day_number, struct date_set* const set) {
+  assert(NULL != set);
+
+  struct error error;
+  const size_t index = find_date(set, day_number);
+  if ((index < set->length) && (set->days[index] == day_number)) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+  error = reserve_date_set(set, set->length + 1);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  memmove(&set->days[index + 1], &set->days[index],
+      (set->length - index) * sizeof(int32_t));
+  set->days[index] = day_number;
+  set->length += 1;
+  return error;
+}
+
+/* Add many dates in any order with a single sort. */
+struct error
+add_dates(const int32_t* const day_numbers, const size_t day_numbers_length,
+    struct date_set* const set) {
+  assert(NULL != day_numbers);
+  assert(NULL != set);
+
+  struct error error = reserve_date_set(set, set->length +
+      day_numbers_length);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  memcpy(&set->days[set->length], day_numbers, day_numbers_length *
+      sizeof(int32_t));
+  set->length += day_numbers_length;
+  sort_date_set(set);
+  return error;
+}
+
+/* Check if the day is in the set. */
+bool
+is_in_date_set(const int32_t day_number, const struct date_set* const set) {
+  assert(NULL != set);
+  const size_t index = find_date(set, day_number);
+  return (index < set->length) && (set->days[index] == day_number);
+}
+
+/* Read dates from a file with one YYYY-MM-DD date at the start of each line,
+ * optionally followed by the person the date applies to. Dates without a
+ * person apply to everyone. Dates for other people are skipped, and so are all
+ * personal dates if person is NULL. Malformed lines are reported and
+ * skipped. */
+struct error
+read_date_sheet(const char* const filename, const char* const person,
+    struct date_set* const set) {
+  assert(NULL != filename);
+  assert(NULL != set);
+
+  struct error error;
+  FILE* const fp = fopen(filename, "r");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    char buffer[MAX_BUFFER_LENGTH + 1];
+    size_t bytes_read;
+    error = get_line(fp, buffer, MAX_BUFFER_LENGTH + 1, &bytes_read);
+    if ((ERROR_END_OF_FILE == error.code) && (0 == bytes_read)) {
+      break;
+    }
+    if (0 == bytes_read) {
+      continue;
+    }
+    struct tm date;
+    memset(&date, 0, sizeof(struct tm));
+    char date_person[MAX_BUFFER_LENGTH + 1];
+    const int date_matches = 3;
+    const int matches = sscanf(buffer, "%4d-%2d-%2d %255s", &date.tm_year,
+        &date.tm_mon, &date.tm_mday, date_person);
+    if ((matches < date_matches) || (date.tm_mon < 1) || (12 < date.tm_mon) ||
+        (date.tm_mday < 1) || (31 < date.tm_mday)) {
+      error.code = ERROR_BAD_TIME_STRING;
+      print_error(&error);
+      continue;
+    }
+    if ((date_matches < matches) && ((NULL == person) || (0 != strcmp(person,
+              date_person)))) {
+      continue;
+    }
+    date.tm_year -= 1900;
+    date.tm_mon -= 1;
+    error = reserve_date_set(set, set->length + 1);
+    if (ERROR_NONE != error.code) {
+      fclose(fp);
+      return error;
+    }
+    set->days[set->length] = get_day_number(&date);
+    set->length += 1;
+  }
+
+  fclose(fp);
+  sort_date_set(set);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+/* Append an event to a growable array of events. */
+struct error
+add_event(const struct event* const event, struct event** const events,
+    size_t* const length, size_t* const capacity) {
+  assert(NULL != event);
+  assert(NULL != events);
+  assert(NULL != length);
+  assert(NULL != capacity);
+
+  struct error error;
+  if (*capacity <= *length) {
+    const size_t new_capacity = *capacity < MIN_CAPACITY ? MIN_CAPACITY :
+      *capacity * 2;
+    struct event* const new_events = realloc(*events, new_capacity *
+        sizeof(struct event));
+    if (NULL == new_events) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    *events = new_events;
+    *capacity = new_capacity;
+  }
+  (*events)[*length] = *event;
+  *length += 1;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+bool
+is_daily_period(const struct tm* const period) {
+  assert(NULL != period);
+  return (0 == period->tm_year) && (0 == period->tm_mon) &&
+    (0 < period->tm_mday) && (0 == period->tm_hour) && (0 == period->tm_min) &&
+    (0 == period->tm_sec);
+}
+
+bool
+is_work_day(const struct tm* const date, const struct calendar* const
+    calendar, size_t* const included_dates_cursor, size_t* const
+    excluded_dates_cursor) {
+  assert(NULL != date);
+  assert(NULL != calendar);
+  assert(NULL != included_dates_cursor);
+  assert(NULL != excluded_dates_cursor);
+
+  const int32_t day_number = get_day_number(date);
+
+  /* Check if it's normally a work day. */
+  bool is_normal_work_day = is_at_date_cursor(&calendar->included_dates,
+      day_number, included_dates_cursor);
+  size_t inclusion_index;
+  for (inclusion_index = 0; !is_normal_work_day &&
+      (inclusion_index < calendar->inclusions_length); inclusion_index++) {
+    if (is_in_event(date, &calendar->inclusions[inclusion_index])) {
+      is_normal_work_day = true;
+    }
+  }
+  /* Keep the cursor in step with the walk even on days off. */
+  const bool is_excluded_date = is_at_date_cursor(&calendar->excluded_dates,
+      day_number, excluded_dates_cursor);
+  if (!is_normal_work_day || is_excluded_date) {
+    return false;
+  }
+
+  /* Check if it's really a work day. */
+  size_t exclusion_index;
+  for (exclusion_index = 0; exclusion_index < calendar->exclusions_length;
+      exclusion_index++) {
+    if (is_in_event(date, &calendar->exclusions[exclusion_index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /* Initialize a calendar. */
 void
 init_calendar(struct calendar* calendar) {
   assert(NULL != calendar);
+  calendar->inclusions = NULL;
+  calendar->exclusions = NULL;
   calendar->inclusions_length = 0;
   calendar->exclusions_length = 0;
+  calendar->inclusions_capacity = 0;
+  calendar->exclusions_capacity = 0;
+  init_date_set(&calendar->included_dates);
+  init_date_set(&calendar->excluded_dates);
 }
 
-/* Add a work day rule. */
+/* Release the memory of a calendar. */
 void
+free_calendar(struct calendar* const calendar) {
+  assert(NULL != calendar);
+  free(calendar->inclusions);
+  free(calendar->exclusions);
+  free_date_set(&calendar->included_dates);
+  free_date_set(&calendar->excluded_dates);
+  init_calendar(calendar);
+}
+
+/* Add a work day rule. */
+struct error
 add_inclusion(const struct event* const inclusion,
     struct calendar* const calendar) {
   assert(NULL != inclusion);
   assert(NULL != calendar);
 
-  calendar->inclusions[calendar->inclusions_length] = *inclusion;
-  calendar->inclusions_length += 1;
+  return add_event(inclusion, &calendar->inclusions,
+      &calendar->inclusions_length, &calendar->inclusions_capacity);
 }
 
-/* Add a work day rule. */
-void
+/* Add a day off rule. */
+struct error
 add_exclusion(const struct event* const exclusion,
     struct calendar* const calendar) {
   assert(NULL != exclusion);
   assert(NULL != calendar);
 
-  calendar->exclusions[calendar->exclusions_length] = *exclusion;
-  calendar->exclusions_length += 1;
+  return add_event(exclusion, &calendar->exclusions,
+      &calendar->exclusions_length, &calendar->exclusions_capacity);
+}
+
+/* Add a one-off work day. */
+struct error
+add_included_date(const struct tm* const date,
+    struct calendar* const calendar) {
+  assert(NULL != date);
+  assert(NULL != calendar);
+  return add_date(get_day_number(date), &calendar->included_dates);
+}
+
+/* Add a one-off day off such as a holiday. */
+struct error
+add_excluded_date(const struct tm* const date,
+    struct calendar* const calendar) {
+  assert(NULL != date);
+  assert(NULL != calendar);
+  return add_date(get_day_number(date), &calendar->excluded_dates);
 }
 
 /* Compute the calendar time when the task will be completed. */
@@ -209,46 +600,27 @@ compute_completion_date(const struct tm* const start,
   *completion_date = *start;
 
   int64_t seconds_worked = 0;
+  size_t included_dates_cursor = 0;
+  size_t excluded_dates_cursor = 0;
   int64_t day;
   for (day = 0; day < MAX_CALENDAR_DAYS; day++) {
-    /* Check if it's normally a work day. */
-    bool is_normal_work_day = false;
-    size_t inclusion_index;
-    for (inclusion_index = 0; inclusion_index < calendar->inclusions_length;
-        inclusion_index++) {
-      if (is_in_event(completion_date,
-            &calendar->inclusions[inclusion_index])) {
-        is_normal_work_day = true;
-        break;
-      }
+    if (0 < day) {
+      add_days(completion_date, 1, completion_date);
     }
-    if (!is_normal_work_day) {
+    if (!is_work_day(completion_date, calendar, &included_dates_cursor,
+          &excluded_dates_cursor)) {
       continue;
     }
 
-    /* Check if it's really a work day. */
-    bool is_actual_work_day = true;
-    size_t exclusion_index;
-    for (exclusion_index = 0; exclusion_index < calendar->exclusions_length;
-        exclusion_index++) {
-      if (is_in_event(completion_date,
-            &calendar->exclusions[exclusion_index])) {
-        is_actual_work_day = false;
-        break;
-      }
-    }
-
-    if (is_actual_work_day) {
-      seconds_worked += seconds_of_work_per_day;
-    }
+    seconds_worked += seconds_of_work_per_day;
 
     if (seconds_to_work <= seconds_worked) {
       break;
     }
-
-    add_days(completion_date, 1, completion_date);
   }
 
+  count_profile(COUNTER_CALENDAR_DAYS, (uint64_t) (day < MAX_CALENDAR_DAYS ?
+        day + 1 : day));
   struct error error;
   if (seconds_worked < seconds_to_work) {
     error.code = ERROR_INCOMPLETE_TASK;
@@ -257,3 +629,73 @@ compute_completion_date(const struct tm* const start,
   error.code = ERROR_NONE;
   return error;
 }
+
+/* Compute the seconds worked by the end of each day starting from the given
+ * date. This is compute_completion_date for every amount of work at once, so
+ * that many amounts can be turned into dates with a binary search. */
+struct error
+compute_work_schedule(const struct tm* const start,
+  const struct calendar* const calendar,
+  const int64_t seconds_of_work_per_day, const size_t days_length,
+  int64_t* const seconds_worked_by_day) {
+  assert(NULL != start);
+  assert(NULL != calendar);
+  assert(NULL != seconds_worked_by_day);
+
+  struct error error;
+  struct tm date = *start;
+  int64_t seconds_worked = 0;
+  size_t included_dates_cursor = 0;
+  size_t excluded_dates_cursor = 0;
+  for (size_t day = 0; day < days_length; day++) {
+    if (0 < day) {
+      error = add_days(&date, 1, &date);
+      if (ERROR_NONE != error.code) {
+        return error;
+      }
+    }
+    if (is_work_day(&date, calendar, &included_dates_cursor,
+          &excluded_dates_cursor)) {
+      seconds_worked += seconds_of_work_per_day;
+    }
+    seconds_worked_by_day[day] = seconds_worked;
+  }
+  count_profile(COUNTER_CALENDAR_DAYS, days_length);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+/* Add the work week: every day from the start date except Saturdays and
+ * Sundays. */
+struct error
+add_work_week(const struct tm* const start, struct calendar* const calendar) {
+  assert(NULL != start);
+  assert(NULL != calendar);
+
+  struct event work;
+  work.start = *start;
+  work.period = DAY;
+  work.repetition = MAX_CALENDAR_DAYS;
+
+  struct error error = add_inclusion(&work, calendar);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+
+  const int weekend[] = { SATURDAY, SUNDAY };
+  for (size_t day_num = 0; day_num < sizeof(weekend) / sizeof(weekend[0]);
+      day_num++) {
+    struct event weekend_day;
+    error = get_next_week(start, weekend[day_num], &weekend_day.start);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    weekend_day.period = WEEK;
+    weekend_day.repetition = MAX_CALENDAR_DAYS;
+    error = add_exclusion(&weekend_day, calendar);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+  }
+  return error;
+}
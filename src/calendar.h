@@ -7,8 +7,6 @@
 
 enum {
   MAX_EVENT_NAME_LENGTH = 255,
-  MAX_CALENDAR_INCLUSIONS_LENGTH = 1023,
-  MAX_CALENDAR_EXCLUSIONS_LENGTH = 1023,
   MAX_CALENDAR_DAYS = 100000
 };
 
@@ -40,11 +38,26 @@ struct event {
   //char name[max_event_name_length];
 };
 
+/* A set of one-off dates such as holidays. The dates are kept as sorted,
+ * unique day numbers so that membership is a binary search. */
+struct date_set {
+  int32_t* days;
+  size_t length;
+  size_t capacity;
+};
+
+/* A calendar is made of repeating events and one-off dates. A day is a work
+ * day if it is in an inclusion and not in an exclusion. The calendar owns its
+ * memory and must be released with free_calendar. */
 struct calendar {
-  struct event inclusions[MAX_CALENDAR_INCLUSIONS_LENGTH];
-  struct event exclusions[MAX_CALENDAR_EXCLUSIONS_LENGTH];
+  struct event* inclusions;
+  struct event* exclusions;
   size_t inclusions_length;
   size_t exclusions_length;
+  size_t inclusions_capacity;
+  size_t exclusions_capacity;
+  struct date_set included_dates;
+  struct date_set excluded_dates;
 };
 
 /*
@@ -73,17 +86,54 @@ print_time(const struct tm*);
 bool
 is_in_event(const struct tm*, const struct event*);
 
+int32_t
+get_day_number(const struct tm*);
+
+void
+init_date_set(struct date_set*);
+
+void
+free_date_set(struct date_set*);
+
+struct error
+add_date(int32_t day_number, struct date_set*);
+
+struct error
+add_dates(const int32_t* day_numbers, size_t, struct date_set*);
+
+bool
+is_in_date_set(int32_t day_number, const struct date_set*);
+
+struct error
+read_date_sheet(const char* filename, const char* person, struct date_set*);
+
 void
 init_calendar(struct calendar* calendar);
 
 void
+free_calendar(struct calendar* calendar);
+
+struct error
 add_inclusion(const struct event*, struct calendar*);
 
-void
+struct error
 add_exclusion(const struct event*, struct calendar*);
 
+struct error
+add_included_date(const struct tm*, struct calendar*);
+
+struct error
+add_excluded_date(const struct tm*, struct calendar*);
+
 struct error
 compute_completion_date(const struct tm*, const struct calendar*,
     int64_t, int64_t, struct tm*);
 
+struct error
+compute_work_schedule(const struct tm*, const struct calendar*, int64_t,
+    size_t, int64_t*);
+
+struct error
+add_work_week(const struct tm*, struct calendar*);
+
 #endif
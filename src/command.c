@@ -12,7 +12,41 @@ static const char* const command_names[] = {
   "untick",
   "list",
   "predict",
-  "top"
+  "top",
+  "assign",
+  "batch",
+  "import",
+  "export",
+  "complete",
+  "rm",
+  "gc",
+  "report",
+  "velocity",
+  "log",
+  "stats"
+};
+
+static const enum lock_mode command_locks[] = {
+  LOCK_MODE_NONE,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_SHARED,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_EXCLUSIVE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_NONE,
+  LOCK_MODE_NONE
 };
 
 struct error parse_command_type(const char* const str, enum command_type* const
@@ -37,3 +71,9 @@ struct error parse_command_type(const char* const str, enum command_type* const
 const char* get_command_name(const enum command_type command_type) {
   return command_names[command_type];
 }
+
+enum lock_mode get_command_lock(const enum command_type command_type) {
+  assert(MAX_COMMAND == sizeof(command_locks) / sizeof(command_locks[0]));
+
+  return command_locks[command_type];
+}
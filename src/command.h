@@ -1,6 +1,8 @@
 #ifndef _ebs_command_h_
 #define _ebs_command_h_
 
+#include "lock.h"
+
 enum command_type {
   COMMAND_HELP,
   COMMAND_ADD,
@@ -11,6 +13,17 @@ enum command_type {
   COMMAND_LIST,
   COMMAND_PREDICT,
   COMMAND_TOP,
+  COMMAND_ASSIGN,
+  COMMAND_BATCH,
+  COMMAND_IMPORT,
+  COMMAND_EXPORT,
+  COMMAND_COMPLETE,
+  COMMAND_RM,
+  COMMAND_GC,
+  COMMAND_REPORT,
+  COMMAND_VELOCITY,
+  COMMAND_LOG,
+  COMMAND_STATS,
   MAX_COMMAND
 };
 
@@ -20,4 +33,7 @@ struct error parse_command_type(const char* str, enum command_type*
 
 /* Get the command type as a string. */
 const char* get_command_name(enum command_type);
+
+/* Get how the command holds the lock of the ebs directory. */
+enum lock_mode get_command_lock(enum command_type);
 #endif
@@ -4,8 +4,20 @@
 #include <stdio.h>
 #include <string.h>
 
+const char* TASK_SHEET = "task.tsv";
+const char* TIME_SHEET = "time.tsv";
+const char* HOLIDAY_SHEET = "holiday.tsv";
+const char* TASK_INDEX = "task.idx";
+const char* NAME_INDEX = "name.idx";
+const char* TIME_SNAPSHOT = "time.col";
+const char* TIME_INDEX = "time.idx";
+const char* CACHE_DIRECTORY = "cache";
+const char* CURRENT_TASK = "current";
+const char* LOCK_FILE = "lock";
+
 static const char* config_names[] = {
-  "--path"
+  "--path",
+  "--profile"
 };
 
 struct error parse_config_type(const char* const str, enum config_type* const
@@ -38,5 +50,7 @@ void print_config(const struct config* const config) {
     puts("path = (not set)");
     return;
   }
-  printf("path = %s\n", config->base_path);
+  for (size_t path_num = 0; path_num < config->path_count; path_num++) {
+    printf("path = %s\n", config->base_paths[path_num]);
+  }
 }
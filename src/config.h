@@ -1,13 +1,36 @@
 #ifndef _ebs_config_h_
 #define _ebs_config_h_
 
+#include <stddef.h>
+
 enum config_type {
   CONFIG_PATH,
+  CONFIG_PROFILE,
   MAX_CONFIG
 };
 
+enum {
+  MAX_WORKSPACE = 64
+};
+
+/* These files live under the ebs path. */
+extern const char* TASK_SHEET;
+extern const char* TIME_SHEET;
+extern const char* HOLIDAY_SHEET;
+extern const char* TASK_INDEX;
+extern const char* NAME_INDEX;
+extern const char* TIME_SNAPSHOT;
+extern const char* TIME_INDEX;
+extern const char* CACHE_DIRECTORY;
+extern const char* CURRENT_TASK;
+extern const char* LOCK_FILE;
+
 struct config {
+  /* The ebs directory commands act on: the first one given. */
   char* base_path;
+  /* Every ebs directory given. list and predict read them all. */
+  char* base_paths[MAX_WORKSPACE];
+  size_t path_count;
 };
 
 /* Parse config. Return ERROR_UNKNOWN_CONFIG if there is no
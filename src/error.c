@@ -1,54 +1,66 @@
 #include "error.h"
 #include <stdio.h>
 
-/* Print the error message. */
-void
-print_error(const struct error* const error) {
+const char*
+get_error_message(const struct error* const error) {
   switch (error->code) {
     case ERROR_NONE:
-      puts("none");
-      break;
+      return "none";
     case ERROR_FILE:
-      puts("file error");
-      break;
+      return "file error";
     case ERROR_TASK_LIMIT:
-      puts("task limit exceeded");
-      break;
+      return "task limit exceeded";
     case ERROR_BAD_TIME_STRING:
-      puts("input time overflowed");
-      break;
+      return "input time overflowed";
     case ERROR_INCOMPLETE_TASK:
-      puts("tasks can't be completed in the given schedule");
-      break;
+      return "tasks can't be completed in the given schedule";
     case ERROR_TIME_RECORD_MISSING_FIELDS:
-      puts("time record missing fields");
-      break;
+      return "time record missing fields";
     case ERROR_INVALID_TIME:
-      puts("time overflowed");
-      break;
+      return "time overflowed";
     case ERROR_TIME_UNAVAILABLE:
-      puts("couldn't get current time");
-      break;
+      return "couldn't get current time";
     case ERROR_END_OF_FILE:
-      puts("end of file");
-      break;
+      return "end of file";
     case ERROR_BUFFER_LIMIT:
-      puts("buffer limit reached");
-      break;
+      return "buffer limit reached";
     case ERROR_UNKNOWN_STATUS:
-      puts("unknown task status");
-      break;
+      return "unknown task status";
     case ERROR_TASK_MISSING_FIELDS:
-      puts("task is missing fields");
-      break;
+      return "task is missing fields";
     case ERROR_NO_SUCH_TASK:
-      puts("no such task");
-      break;
+      return "no such task";
     case ERROR_STRING_TO_INT:
-      puts("invalid int");
-      break;
+      return "invalid int";
+    case ERROR_OUT_OF_MEMORY:
+      return "out of memory";
+    case ERROR_PERSON_LIMIT:
+      return "too many people";
+    case ERROR_BAD_REGEX:
+      return "bad regex";
+    case ERROR_REGEX_TOO_COMPLEX:
+      return "regex too complex";
+    case ERROR_STALE_INDEX:
+      return "stale index";
+    case ERROR_UNKNOWN_COMMAND:
+      return "unknown command";
+    case ERROR_TASK_EXISTS:
+      return "task already exists";
+    case ERROR_BAD_ARGUMENTS:
+      return "bad arguments";
+    case ERROR_UNKNOWN_FORMAT:
+      return "unknown format";
+    case ERROR_MALFORMED_RECORD:
+      return "malformed record";
+    case ERROR_UNKNOWN_PERIOD:
+      return "unknown period";
     default:
-      puts("unknown error");
-      break;
+      return "unknown error";
   }
 }
+
+/* Print the error message. */
+void
+print_error(const struct error* const error) {
+  puts(get_error_message(error));
+}
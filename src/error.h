@@ -13,9 +13,6 @@ enum error_code {
 	ERROR_INCOMPLETE_TASK,
   ERROR_INVALID_TIME,
   ERROR_TIME_UNAVAILABLE,
-  ERROR_LITERAL_TOO_LONG,
-  ERROR_DISJUNCTION_TOO_LONG,
-  ERROR_CONJUNCTION_TOO_LONG,
   ERROR_HASH_NOT_FOUND,
   ERROR_HASH_FULL,
   ERROR_UNKNOWN_STATUS,
@@ -25,6 +22,16 @@ enum error_code {
   ERROR_UNKNOWN_CONFIG,
   ERROR_NO_SUCH_TASK,
   ERROR_STRING_TO_INT,
+  ERROR_OUT_OF_MEMORY,
+  ERROR_PERSON_LIMIT,
+  ERROR_BAD_REGEX,
+  ERROR_REGEX_TOO_COMPLEX,
+  ERROR_STALE_INDEX,
+  ERROR_TASK_EXISTS,
+  ERROR_BAD_ARGUMENTS,
+  ERROR_UNKNOWN_FORMAT,
+  ERROR_MALFORMED_RECORD,
+  ERROR_UNKNOWN_PERIOD,
   MAX_ERROR
 };
 
@@ -32,6 +39,9 @@ struct error {
 	enum error_code code;
 };
 
+/* Get the message of the error. */
+const char* get_error_message(const struct error*);
+
 void print_error(const struct error*);
 
 #endif
@@ -3,35 +3,47 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 enum {
   SYMBOL_NOT = '!',
   SYMBOL_OR = ',',
-  SYMBOL_AND = '/'
+  SYMBOL_AND = '/',
+  SYMBOL_REGEX = '~',
+#if defined(__AVX2__)
+  SIMD_BLOCK = 32
+#else
+  SIMD_BLOCK = 16
+#endif
 };
 
-/* Get a pointer to a literal by indices. */
-static struct literal* get_literal(struct literal* literals, size_t
-    disjunction_num, size_t literal_num);
-
-/* Get a const pointer to a literal by indices. */
-static const struct literal* get_const_literal(const struct literal* literals,
-    size_t disjuction_num, size_t literal_num);
+/* Get the first literal of a disjunction. */
+static size_t get_disjunction_start(const struct expression* expression,
+    size_t disjunction_num);
 
-/* Return true if the literal matches nothing. This is the empty, negative
- * literal. */
-static bool is_null_literal(const struct literal* lit);
+/* Give literals with the same name the same name_id, numbering the
+ * substrings before the regexes. */
+static void number_names(struct expression* expression);
 
-/* Return true if the literal matches everything. */
-static bool is_full_literal(const struct literal* lit);
+/* Build the matcher, the regexes and the masks of each disjunction. */
+static struct error compile_expression(struct expression* expression, const
+    char* cache_path);
 
-/* Return true if the disjunction matches everything. */
-static bool is_full_disjunction(const struct expression* expression, size_t
-    disjunction_num);
+/* Set the bit of every name found in the subject. found holds word_count
+ * words and is not cleared first. */
+static void find_names(const char* subject, size_t subject_length, const
+    struct expression* expression, uint64_t* found);
 
 /* Print a literal. */
-static void print_literal(const struct literal* lit);
+static void print_literal(const struct expression* expression, const struct
+    literal* lit);
 
 /* Print a disjunction. */
 static void print_disjunction(const struct expression* expression, size_t
@@ -40,213 +52,519 @@ static void print_disjunction(const struct expression* expression, size_t
 bool string_contains(const char* const haystack, const char* const needle) {
   assert(NULL != haystack);
   assert(NULL != needle);
+  return string_contains_length(haystack, strlen(haystack), needle,
+      strlen(needle));
+}
+
+bool string_contains_length(const char* const haystack, const size_t
+    haystack_length, const char* const needle, const size_t needle_length) {
+  assert(NULL != haystack);
+  assert(NULL != needle);
 
-  size_t haystack_length = strlen(haystack);
-  size_t needle_length = strlen(needle);
   if (haystack_length < needle_length) {
     return false;
   }
+  if (0 == needle_length) {
+    return true;
+  }
 
-  size_t haystack_index;
-  for (haystack_index = 0; haystack_index <= haystack_length - needle_length;
-      haystack_index++) {
-    size_t needle_index;
-    bool is_match = true;
-    for (needle_index = 0; needle_index < needle_length; needle_index++) {
-      if (haystack[haystack_index + needle_index] !=
-          needle[needle_index]) {
-        is_match = false;
-        break;
+  /* Find candidates where both the first and the last byte of the needle
+   * match, a block at a time, and compare only those. */
+  size_t haystack_index = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  const size_t last = needle_length - 1;
+#if defined(__AVX2__)
+  const __m256i first_bytes = _mm256_set1_epi8(needle[0]);
+  const __m256i last_bytes = _mm256_set1_epi8(needle[last]);
+  for (; haystack_index + last + SIMD_BLOCK <= haystack_length;
+      haystack_index += SIMD_BLOCK) {
+    const __m256i first_block = _mm256_loadu_si256((const __m256i*) (const
+          void*) &haystack[haystack_index]);
+    const __m256i last_block = _mm256_loadu_si256((const __m256i*) (const
+          void*) &haystack[haystack_index + last]);
+    uint32_t candidates = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(
+          _mm256_cmpeq_epi8(first_bytes, first_block),
+          _mm256_cmpeq_epi8(last_bytes, last_block)));
+#else
+  const __m128i first_bytes = _mm_set1_epi8(needle[0]);
+  const __m128i last_bytes = _mm_set1_epi8(needle[last]);
+  for (; haystack_index + last + SIMD_BLOCK <= haystack_length;
+      haystack_index += SIMD_BLOCK) {
+    const __m128i first_block = _mm_loadu_si128((const __m128i*) (const
+          void*) &haystack[haystack_index]);
+    const __m128i last_block = _mm_loadu_si128((const __m128i*) (const
+          void*) &haystack[haystack_index + last]);
+    uint32_t candidates = (uint32_t) _mm_movemask_epi8(_mm_and_si128(
+          _mm_cmpeq_epi8(first_bytes, first_block),
+          _mm_cmpeq_epi8(last_bytes, last_block)));
+#endif
+    while (0 != candidates) {
+      const size_t offset = (size_t) __builtin_ctz(candidates);
+      if (0 == memcmp(&haystack[haystack_index + offset + 1], &needle[1],
+            needle_length - 1)) {
+        return true;
       }
+      candidates &= candidates - 1;
     }
-    if (is_match) {
+  }
+#endif
+
+  /* Finish the tail a candidate first byte at a time. */
+  const char* const end = haystack + haystack_length - needle_length + 1;
+  const char* candidate = haystack + haystack_index;
+  while (candidate < end) {
+    candidate = memchr(candidate, needle[0], (size_t) (end - candidate));
+    if (NULL == candidate) {
+      return false;
+    }
+    if (0 == memcmp(candidate + 1, &needle[1], needle_length - 1)) {
       return true;
     }
+    candidate++;
   }
   return false;
 }
 
-struct literal* get_literal(struct literal* const literals, const size_t
-    disjunction_num, const size_t literal_num) {
-  assert(NULL != literals);
-  assert(disjunction_num <= MAX_DISJUNCTIONS);
-  assert(literal_num <= MAX_LITERALS);
-
-  return &literals[disjunction_num * MAX_LITERALS + literal_num];
-}
-
-const struct literal* get_const_literal(const struct literal* const literals,
-    const size_t disjunction_num, const size_t literal_num) {
-  assert(NULL != literals);
-  assert(disjunction_num <= MAX_DISJUNCTIONS);
-  assert(literal_num <= MAX_LITERALS);
-
-  return &literals[disjunction_num * MAX_LITERALS + literal_num];
+size_t get_disjunction_start(const struct expression* const expression,
+    const size_t disjunction_num) {
+  assert(NULL != expression);
+  assert(disjunction_num < expression->disjunction_count);
+  return (0 == disjunction_num) ? 0 :
+    expression->disjunction_ends[disjunction_num - 1];
 }
 
-bool is_null_literal(const struct literal* const lit) {
+const char* get_literal_name(const struct expression* const expression,
+    const struct literal* const lit) {
+  assert(NULL != expression);
   assert(NULL != lit);
-  return ((lit->is_negative) && (0 == strlen(lit->name)));
+  return &expression->names[lit->name_offset];
 }
 
-bool is_full_literal(const struct literal* const lit) {
-  assert(NULL != lit);
-  return ((!lit->is_negative) && (0 == strlen(lit->name)));
+struct error parse_expression(const char* const string, struct expression*
+    const expression) {
+  return parse_cached_expression(string, NULL, expression);
 }
 
-bool is_full_disjunction(const struct expression* const expression, const
-    size_t disjunction_num) {
+struct error parse_cached_expression(const char* const string, const char*
+    const cache_path, struct expression* const expression) {
+  assert(NULL != string);
   assert(NULL != expression);
-  assert(disjunction_num < MAX_DISJUNCTIONS);
 
-  for (size_t literal_num = 0; literal_num < MAX_LITERALS; literal_num++) {
-    const struct literal* lit = get_const_literal(expression->literals,
-        disjunction_num, literal_num);
-    if (!is_full_literal(lit)) {
-      return false;
+  struct error error;
+  const size_t string_len = strlen(string);
+  expression->literal_count = 0;
+  expression->disjunction_count = 0;
+  expression->name_count = 0;
+  expression->masks = NULL;
+  expression->mask_count = 0;
+  expression->word_count = 0;
+  expression->is_unsatisfiable = false;
+  expression->single_name = NULL;
+  expression->single_name_length = 0;
+  expression->regexes = NULL;
+  expression->regex_count = 0;
+  init_matcher(&expression->matcher);
+
+  /* Size everything from the separators and allocate it in one go. */
+  size_t max_literal = 1;
+  size_t max_disjunction = 1;
+  for (size_t string_pos = 0; string_pos < string_len; string_pos++) {
+    if (SYMBOL_OR == string[string_pos]) {
+      max_literal++;
+    } else if (SYMBOL_AND == string[string_pos]) {
+      max_literal++;
+      max_disjunction++;
     }
   }
-  return true;
+  if (UINT32_MAX <= string_len + max_literal) {
+    expression->disjunction_ends = NULL;
+    expression->literals = NULL;
+    expression->names = NULL;
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  char* const block = malloc(max_disjunction * sizeof(size_t) + max_literal *
+      sizeof(struct literal) + string_len + max_literal);
+  if (NULL == block) {
+    expression->disjunction_ends = NULL;
+    expression->literals = NULL;
+    expression->names = NULL;
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  expression->disjunction_ends = (size_t*) (void*) block;
+  expression->literals = (struct literal*) (void*) (block + max_disjunction *
+      sizeof(size_t));
+  expression->names = block + max_disjunction * sizeof(size_t) + max_literal *
+    sizeof(struct literal);
+
+  /* A literal ends at a separator or at the end of the string. A '!'
+   * anywhere in a literal negates it. */
+  size_t name_pos = 0;
+  struct literal lit = { 0, 0, 0, false, false };
+  for (size_t string_pos = 0; string_pos <= string_len; string_pos++) {
+    const char c = string[string_pos];
+    if (SYMBOL_NOT == c) {
+      lit.is_negative = true;
+      continue;
+    }
+    if ((SYMBOL_REGEX == c) && (0 == lit.name_length) && !lit.is_regex) {
+      lit.is_regex = true;
+      continue;
+    }
+    if ((SYMBOL_OR != c) && (SYMBOL_AND != c) && ('\0' != c)) {
+      expression->names[name_pos] = c;
+      name_pos++;
+      lit.name_length++;
+      continue;
+    }
+    expression->names[name_pos] = '\0';
+    name_pos++;
+    expression->literals[expression->literal_count] = lit;
+    expression->literal_count++;
+    lit.name_offset = (uint32_t) name_pos;
+    lit.name_length = 0;
+    lit.is_negative = false;
+    lit.is_regex = false;
+    if (SYMBOL_OR != c) {
+      expression->disjunction_ends[expression->disjunction_count] =
+        expression->literal_count;
+      expression->disjunction_count++;
+    }
+  }
+
+  number_names(expression);
+  return compile_expression(expression, cache_path);
 }
 
-struct error parse_expression(const char* const string, struct expression*
-    const expression) {
-  assert(NULL != string);
+void number_names(struct expression* const expression) {
   assert(NULL != expression);
-  memset(expression, 0, sizeof(struct expression));
-  const size_t string_len = strlen(string);
-  size_t name_length = 0;
-  size_t literal_num = 0;
-  size_t disjunction_num = 0;
-  struct error error;
 
-  for (size_t string_pos = 0; string_pos < string_len; string_pos++) {
-    if (SYMBOL_NOT == string[string_pos]) {
-      struct literal* lit = get_literal(expression->literals, disjunction_num,
-          literal_num);
-      lit->is_negative = true;
-    } else if (SYMBOL_OR == string[string_pos]) {
-      if (MAX_LITERALS <= literal_num) {
-        error.code = ERROR_DISJUNCTION_TOO_LONG;
-        return error;
-      }
-      literal_num++;
-      name_length = 0;
-    } else if (SYMBOL_AND == string[string_pos]) {
-      if (MAX_DISJUNCTIONS <= disjunction_num) {
-        error.code = ERROR_CONJUNCTION_TOO_LONG;
-        return error;
+  expression->name_count = 0;
+  expression->regex_count = 0;
+  for (size_t pass = 0; pass < 2; pass++) {
+    const bool is_regex = (1 == pass);
+    for (size_t literal_num = 0; literal_num < expression->literal_count;
+        literal_num++) {
+      struct literal* const lit = &expression->literals[literal_num];
+      if ((0 == lit->name_length) || (is_regex != lit->is_regex)) {
+        continue;
       }
-      literal_num++;
-      // Negate unused literals.
-      for (size_t unused_literal_num = literal_num; unused_literal_num <
-          MAX_LITERALS; unused_literal_num++) {
-        struct literal* const unused_lit = get_literal(expression->literals,
-            disjunction_num, unused_literal_num);
-        unused_lit->is_negative = true;
+      const char* const name = get_literal_name(expression, lit);
+      lit->name_id = (uint32_t) expression->name_count;
+      for (size_t other_num = 0; other_num < literal_num; other_num++) {
+        const struct literal* const other = &expression->literals[other_num];
+        if ((other->is_regex == is_regex) && (other->name_length ==
+              lit->name_length) && (0 == strcmp(name,
+                get_literal_name(expression, other)))) {
+          lit->name_id = other->name_id;
+          break;
+        }
       }
-      disjunction_num++;
-      literal_num = 0;
-      name_length = 0;
-    } else {
-      if (MAX_NAME < name_length) {
-        error.code = ERROR_LITERAL_TOO_LONG;
-        return error;
+      if (expression->name_count == lit->name_id) {
+        expression->name_count++;
+        expression->regex_count += is_regex ? 1 : 0;
       }
-      struct literal* const lit = get_literal(expression->literals,
-          disjunction_num, literal_num);
-      lit->name[name_length] = string[string_pos];
-      name_length++;
-      // Handle end of string.
-      if (string_pos == string_len - 1) {
-        literal_num++;
-        // Negate unused literals.
-        for (size_t unused_literal_num = literal_num; unused_literal_num <
-            MAX_LITERALS; unused_literal_num++) {
-          struct literal* const unused_lit = get_literal(expression->literals,
-              disjunction_num, unused_literal_num);
-          unused_lit->is_negative = true;
+    }
+  }
+}
+
+struct error compile_expression(struct expression* const expression, const
+    char* const cache_path) {
+  assert(NULL != expression);
+
+  struct error error;
+  const size_t word_count = get_matcher_words(expression->name_count);
+  const size_t substring_count = expression->name_count -
+    expression->regex_count;
+  expression->word_count = word_count;
+  expression->masks = calloc(2 * expression->disjunction_count * word_count +
+      1, sizeof(uint64_t));
+  expression->regexes = malloc((expression->regex_count + 1) * sizeof(struct
+        regex));
+  const char** const names = malloc((expression->name_count + 1) *
+      sizeof(const char*));
+  size_t* const name_lengths = malloc((expression->name_count + 1) *
+      sizeof(size_t));
+  if ((NULL == expression->masks) || (NULL == expression->regexes) || (NULL
+        == names) || (NULL == name_lengths)) {
+    free(names);
+    free(name_lengths);
+    expression->regex_count = 0;
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (size_t regex_num = 0; regex_num < expression->regex_count;
+      regex_num++) {
+    init_regex(&expression->regexes[regex_num]);
+  }
+
+  for (size_t literal_num = 0; literal_num < expression->literal_count;
+      literal_num++) {
+    const struct literal* const lit = &expression->literals[literal_num];
+    if (0 < lit->name_length) {
+      names[lit->name_id] = get_literal_name(expression, lit);
+      name_lengths[lit->name_id] = lit->name_length;
+    }
+  }
+
+  for (size_t disjunction_num = 0; disjunction_num <
+      expression->disjunction_count; disjunction_num++) {
+    uint64_t* const positive_mask = &expression->masks[2 * word_count *
+      expression->mask_count];
+    uint64_t* const negative_mask = positive_mask + word_count;
+    bool is_full = false;
+    bool is_null = true;
+    for (size_t literal_num = get_disjunction_start(expression,
+          disjunction_num); literal_num <
+        expression->disjunction_ends[disjunction_num]; literal_num++) {
+      const struct literal* const lit = &expression->literals[literal_num];
+      if (0 == lit->name_length) {
+        // The empty name is in everything.
+        if (!lit->is_negative) {
+          is_full = true;
+          break;
         }
+        continue;
       }
+      is_null = false;
+      uint64_t* const mask = lit->is_negative ? negative_mask : positive_mask;
+      mask[lit->name_id / MATCHER_WORD_BITS] |= (uint64_t) 1 <<
+        (lit->name_id % MATCHER_WORD_BITS);
+    }
+    if (is_full) {
+      memset(positive_mask, 0, 2 * word_count * sizeof(uint64_t));
+      continue;
     }
+    if (is_null) {
+      expression->is_unsatisfiable = true;
+    }
+    expression->mask_count++;
   }
+
   error.code = ERROR_NONE;
+  for (size_t name_num = substring_count; (ERROR_NONE == error.code) &&
+      (name_num < expression->name_count); name_num++) {
+    error = load_regex(names[name_num], name_lengths[name_num], cache_path,
+        &expression->regexes[name_num - substring_count]);
+  }
+
+  /* A single name is faster to find with string_contains. */
+  if ((ERROR_NONE == error.code) && (1 == substring_count)) {
+    expression->single_name = names[0];
+    expression->single_name_length = name_lengths[0];
+  } else if (ERROR_NONE == error.code) {
+    error = build_matcher(names, name_lengths, substring_count,
+        &expression->matcher);
+  }
+  free(names);
+  free(name_lengths);
   return error;
 }
 
-void print_literal(const struct literal* const lit) {
+void free_expression(struct expression* const expression) {
+  assert(NULL != expression);
+  // The literals and the names live in the block of the disjunction ends.
+  free(expression->disjunction_ends);
+  free(expression->masks);
+  free_matcher(&expression->matcher);
+  for (size_t regex_num = 0; regex_num < expression->regex_count;
+      regex_num++) {
+    free_regex(&expression->regexes[regex_num]);
+  }
+  free(expression->regexes);
+  expression->regexes = NULL;
+  expression->regex_count = 0;
+  expression->disjunction_ends = NULL;
+  expression->literals = NULL;
+  expression->names = NULL;
+  expression->masks = NULL;
+}
+
+void print_literal(const struct expression* const expression, const struct
+    literal* const lit) {
+  assert(NULL != expression);
   assert(NULL != lit);
   if (lit->is_negative) {
     printf("%s", "¬");
   }
-  printf("%s", lit->name);
+  if (lit->is_regex) {
+    printf("%c", SYMBOL_REGEX);
+  }
+  printf("%s", get_literal_name(expression, lit));
 }
 
 void print_disjunction(const struct expression* const expression, const size_t
     disjunction_num) {
   assert(NULL != expression);
 
-  const struct literal* const first_lit =
-    get_const_literal(expression->literals, disjunction_num, 0);
-  if (is_null_literal(first_lit)) {
-    return;
-  }
-  print_literal(first_lit);
-
-  for (size_t literal_num = 1; literal_num < MAX_LITERALS; literal_num++) {
-    const struct literal* const lit = get_const_literal(expression->literals,
-        disjunction_num, literal_num);
-    // Check if this is the last literal in the disjunction.
-    if (is_null_literal(lit)) {
-      break;
+  bool is_first = true;
+  for (size_t literal_num = get_disjunction_start(expression,
+        disjunction_num); literal_num <
+      expression->disjunction_ends[disjunction_num]; literal_num++) {
+    const struct literal* const lit = &expression->literals[literal_num];
+    // Skip literals that match nothing.
+    if (lit->is_negative && (0 == lit->name_length)) {
+      continue;
     }
-    printf("%s", " | ");
-    print_literal(lit);
+    if (!is_first) {
+      printf("%s", " | ");
+    }
+    print_literal(expression, lit);
+    is_first = false;
   }
 }
 
 void print_expression(const struct expression* const expression) {
   assert(NULL != expression);
 
-  if (is_full_disjunction(expression, 0)) {
-    return;
-  }
-  print_disjunction(expression, 0);
-
-  for (size_t disjunction_num = 1; disjunction_num < MAX_DISJUNCTIONS;
-      disjunction_num++) {
-    if (is_full_disjunction(expression, disjunction_num)) {
-      break;
+  for (size_t disjunction_num = 0; disjunction_num <
+      expression->disjunction_count; disjunction_num++) {
+    if (0 < disjunction_num) {
+      printf("%s", " & ");
     }
-    printf("%s", " & ");
     print_disjunction(expression, disjunction_num);
   }
   printf("%s", "\n");
 }
 
+void find_names(const char* const subject, const size_t subject_length,
+    const struct expression* const expression, uint64_t* const found) {
+  if (NULL != expression->single_name) {
+    found[0] |= string_contains_length(subject, subject_length,
+        expression->single_name, expression->single_name_length) ? 1 : 0;
+  } else {
+    scan_matcher(&expression->matcher, subject, found);
+  }
+  const size_t first_regex = expression->name_count - expression->regex_count;
+  for (size_t regex_num = 0; regex_num < expression->regex_count;
+      regex_num++) {
+    if (regex_matches(&expression->regexes[regex_num], subject,
+          subject_length)) {
+      const size_t name_id = first_regex + regex_num;
+      found[name_id / MATCHER_WORD_BITS] |= (uint64_t) 1 << (name_id %
+          MATCHER_WORD_BITS);
+    }
+  }
+}
+
 bool string_matches(const char* const subject, const struct expression* const
     expression) {
   assert(NULL != subject);
   assert(NULL != expression);
-  for (size_t disjunction_num = 0; disjunction_num < MAX_DISJUNCTIONS;
-      disjunction_num++) {
-    bool matched_disjunction = false;
-    for (size_t literal_num = 0; literal_num < MAX_LITERALS; literal_num++) {
-      const struct literal* const lit = get_const_literal(expression->literals,
-          disjunction_num, literal_num);
-      bool match = string_contains(subject, lit->name);
-      if (match && !lit->is_negative) {
-        matched_disjunction = true;
-        break;
-      }
-      if (!match && lit->is_negative) {
-        matched_disjunction = true;
-        break;
-      }
+
+  if (expression->is_unsatisfiable) {
+    return false;
+  }
+  if (0 == expression->mask_count) {
+    return true;
+  }
+
+  const size_t word_count = expression->word_count;
+  uint64_t found[word_count];
+  memset(found, 0, word_count * sizeof(uint64_t));
+  find_names(subject, strlen(subject), expression, found);
+  for (size_t mask_num = 0; mask_num < expression->mask_count; mask_num++) {
+    const uint64_t* const positive_mask = &expression->masks[2 * word_count *
+      mask_num];
+    const uint64_t* const negative_mask = positive_mask + word_count;
+    uint64_t satisfied = 0;
+    for (size_t word_num = 0; word_num < word_count; word_num++) {
+      satisfied |= (found[word_num] & positive_mask[word_num]) |
+        (~found[word_num] & negative_mask[word_num]);
     }
-    if (!matched_disjunction) {
+    if (0 == satisfied) {
       return false;
     }
   }
   return true;
 }
+
+struct error match_table(const char* const* const subjects, const size_t
+    subject_count, const struct expression* const expression, uint64_t* const
+    matches) {
+  assert(NULL != subjects);
+  assert(NULL != expression);
+  assert(NULL != matches);
+
+  struct error error;
+  const size_t subject_words = get_matcher_words(subject_count);
+  const uint64_t last_word = (0 == subject_count % MATCHER_WORD_BITS) ?
+    UINT64_MAX : ((uint64_t) 1 << (subject_count % MATCHER_WORD_BITS)) - 1;
+  const bool is_everything = !expression->is_unsatisfiable && (0 ==
+      expression->mask_count);
+  for (size_t word_num = 0; word_num < subject_words; word_num++) {
+    matches[word_num] = is_everything ? UINT64_MAX : 0;
+  }
+  if (is_everything && (0 < subject_words)) {
+    matches[subject_words - 1] = last_word;
+  }
+  if (expression->is_unsatisfiable || is_everything || (0 ==
+        subject_count)) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+
+  /* Find the names row by row and store them as one column of bits per
+   * name. */
+  const size_t word_count = expression->word_count;
+  uint64_t* const columns = calloc((expression->name_count + 1) *
+      subject_words, sizeof(uint64_t));
+  if (NULL == columns) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  uint64_t found[word_count];
+  for (size_t subject_num = 0; subject_num < subject_count; subject_num++) {
+    memset(found, 0, word_count * sizeof(uint64_t));
+    find_names(subjects[subject_num], strlen(subjects[subject_num]),
+        expression, found);
+    const uint64_t subject_bit = (uint64_t) 1 << (subject_num %
+        MATCHER_WORD_BITS);
+    for (size_t word_num = 0; word_num < word_count; word_num++) {
+      uint64_t names = found[word_num];
+      while (0 != names) {
+        const size_t name_id = word_num * MATCHER_WORD_BITS + (size_t)
+          __builtin_ctzll(names);
+        columns[name_id * subject_words + subject_num / MATCHER_WORD_BITS] |=
+          subject_bit;
+        names &= names - 1;
+      }
+    }
+  }
+
+  /* Evaluate each disjunction over whole words of subjects. */
+  for (size_t word_num = 0; word_num < subject_words; word_num++) {
+    matches[word_num] = UINT64_MAX;
+  }
+  matches[subject_words - 1] = last_word;
+  uint64_t* const satisfied = &columns[expression->name_count *
+    subject_words];
+  for (size_t mask_num = 0; mask_num < expression->mask_count; mask_num++) {
+    const uint64_t* const positive_mask = &expression->masks[2 * word_count *
+      mask_num];
+    const uint64_t* const negative_mask = positive_mask + word_count;
+    memset(satisfied, 0, subject_words * sizeof(uint64_t));
+    for (size_t name_id = 0; name_id < expression->name_count; name_id++) {
+      const uint64_t name_bit = (uint64_t) 1 << (name_id % MATCHER_WORD_BITS);
+      const uint64_t* const column = &columns[name_id * subject_words];
+      if (0 != (positive_mask[name_id / MATCHER_WORD_BITS] & name_bit)) {
+        for (size_t word_num = 0; word_num < subject_words; word_num++) {
+          satisfied[word_num] |= column[word_num];
+        }
+      }
+      if (0 != (negative_mask[name_id / MATCHER_WORD_BITS] & name_bit)) {
+        for (size_t word_num = 0; word_num < subject_words; word_num++) {
+          satisfied[word_num] |= ~column[word_num];
+        }
+      }
+    }
+    for (size_t word_num = 0; word_num < subject_words; word_num++) {
+      matches[word_num] &= satisfied[word_num];
+    }
+  }
+
+  free(columns);
+  error.code = ERROR_NONE;
+  return error;
+}
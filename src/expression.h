@@ -1,38 +1,87 @@
 #ifndef _ebs_expression_h_
 #define _ebs_expression_h_
 
+#include "matcher.h"
+#include "regex.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-enum {
-  MAX_NAME = 254,
-  MAX_LITERALS = 16,
-  MAX_DISJUNCTIONS = 16
-};
-
-/* Represent a literal in an expression. */
+/* Represent a literal in an expression. The name lives in the expression's
+ * name arena and is a regex if the literal starts with '~'. Literals with the
+ * same name share a name_id. */
 struct literal {
-  char name[MAX_NAME + 1];
+  uint32_t name_offset;
+  uint32_t name_length;
+  uint32_t name_id;
   bool is_negative;
+  bool is_regex;
 };
 
-/* Represent a pattern in conjunctive normal form. */
+/* Represent a pattern in conjunctive normal form. Disjunction d is made of the
+ * literals from disjunction_ends[d - 1] (or 0) up to disjunction_ends[d].
+ * The literals, the disjunction ends and the names share one allocation. */
 struct expression {
-  struct literal literals[MAX_LITERALS * MAX_DISJUNCTIONS];
+  struct literal* literals;
+  size_t literal_count;
+  size_t* disjunction_ends;
+  size_t disjunction_count;
+  char* names;
+  size_t name_count;
+  /* The compiled form. The matcher finds the distinct names in a subject, and
+   * a disjunction holds if the subject contains one of its positive names or
+   * lacks one of its negative names. Disjunctions that always hold are left
+   * out. masks holds the positive then the negative words of each. */
+  struct matcher matcher;
+  /* Set instead of the matcher if there is only one name. */
+  const char* single_name;
+  size_t single_name_length;
+  /* The regexes come after the other names, so regex r has name_id
+   * name_count - regex_count + r. */
+  struct regex* regexes;
+  size_t regex_count;
+  uint64_t* masks;
+  size_t mask_count;
+  size_t word_count;
+  bool is_unsatisfiable;
 };
 
 /* Check if the second string is contained in the first. */
 bool string_contains(const char* haystack, const char* needle);
 
-/* Parse a conjunctive expression. The characters '!', ',', and '/' are
- * reserved. The expression must end with /. 
- * @cleanup Don't require / at end of string. */
+/* Check if the needle is contained in the haystack given both lengths. This
+ * uses SSE2 or AVX2 when the compiler targets them. */
+bool string_contains_length(const char* haystack, size_t haystack_length,
+    const char* needle, size_t needle_length);
+
+/* Parse a conjunctive expression and compile it for matching. The characters
+ * '!', ',', and '/' are reserved, and a '~' at the start of a literal makes it
+ * a regex. The expression must be released with free_expression. */
 struct error parse_expression(const char* string, struct expression*
     expression);
 
+/* Parse an expression and keep its compiled regexes in the cache directory,
+ * see load_regex. */
+struct error parse_cached_expression(const char* string, const char*
+    cache_path, struct expression* expression);
+
+/* Release the memory of a parsed expression. */
+void free_expression(struct expression* expression);
+
+/* Get the name of a literal. */
+const char* get_literal_name(const struct expression*, const struct literal*);
+
 /* Pretty-print the expression. */
 void print_expression(const struct expression* expression);
 
 /* Check if the string matches the expression. */
 bool string_matches(const char* subject, const struct expression* expression);
 
+/* Match a table of subjects column by column: find one bitset over the
+ * subjects per distinct name, then evaluate the disjunctions a word of
+ * subjects at a time. Bit i of matches is set if subject i matches. matches
+ * holds get_matcher_words(subject_count) words. */
+struct error match_table(const char* const* subjects, size_t subject_count,
+    const struct expression* expression, uint64_t* matches);
+
 #endif
@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "filter_cache.h"
+#include "error.h"
+#include "hash.h"
+
+#include <assert.h>
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+enum {
+  FILTER_HASH_SEED = 7919,
+  MAX_CACHE_PATH = 4096,
+  /* Results of other filters for the current sheet are kept up to this many
+   * files, since a filter text is rarely given twice from a script. */
+  MAX_CACHE_FILE = 64,
+  MAX_CACHE_LOOP = 1000000
+};
+
+static const char CACHE_MAGIC[8] = {'e', 'b', 's', 'f', 'l', 't', '1', '\n'};
+
+/* The header of a cache file. It is followed by the filter text and the row
+ * offsets. */
+struct cache_header {
+  char magic[8];
+  uint64_t text_length;
+  uint64_t sheet_size;
+  int64_t sheet_modified;
+  uint64_t offset_count;
+};
+
+/* Get the name of the cache file of a filter. */
+static void get_cache_file(const char* cache_path, const char* filter_text,
+    char* filename);
+
+/* Check that a name in the cache directory is that of a cache file. */
+static bool is_cache_file(const char* name);
+
+/* Remove the cache files of other versions of the sheet, and the oldest
+ * other file once MAX_CACHE_FILE are kept, so that the directory does not
+ * grow with every filter. The file being written is left alone. */
+static void prune_filter_cache(const char* cache_path, const struct
+    sheet_stamp*, const char* filename);
+
+void get_cache_file(const char* const cache_path, const char* const
+    filter_text, char* const filename) {
+  snprintf(filename, MAX_CACHE_PATH, "%s/filter-%08lx.rows", cache_path,
+      (unsigned long) ebs_hash_murmur3(filter_text, strlen(filter_text),
+        FILTER_HASH_SEED));
+}
+
+bool is_cache_file(const char* const name) {
+  const size_t length = strlen(name);
+  const size_t suffix_length = strlen(".rows");
+  return (0 == strncmp(name, "filter-", strlen("filter-"))) && (suffix_length
+      < length) && (0 == strcmp(name + length - suffix_length, ".rows"));
+}
+
+void prune_filter_cache(const char* const cache_path, const struct
+    sheet_stamp* const stamp, const char* const filename) {
+  DIR* const dir = opendir(cache_path);
+  if (NULL == dir) {
+    return;
+  }
+  char oldest_filename[MAX_CACHE_PATH] = "";
+  time_t oldest_time = 0;
+  size_t kept_count = 0;
+  for (size_t loop_num = 0; loop_num < MAX_CACHE_LOOP; loop_num++) {
+    const struct dirent* const entry = readdir(dir);
+    if (NULL == entry) {
+      break;
+    }
+    char entry_filename[MAX_CACHE_PATH];
+    if (!is_cache_file(entry->d_name) || (MAX_CACHE_PATH <= (size_t)
+          snprintf(entry_filename, MAX_CACHE_PATH, "%s/%s", cache_path,
+            entry->d_name)) || (0 == strcmp(entry_filename, filename))) {
+      continue;
+    }
+    FILE* const fp = fopen(entry_filename, "rb");
+    if (NULL == fp) {
+      continue;
+    }
+    struct cache_header header;
+    const bool is_current = (1 == fread(&header, sizeof(header), 1, fp)) &&
+      (0 == memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC))) &&
+      (stamp->size == header.sheet_size) && (stamp->modified ==
+          header.sheet_modified);
+    fclose(fp);
+    struct stat status;
+    if (!is_current || (0 != stat(entry_filename, &status))) {
+      remove(entry_filename);
+      continue;
+    }
+    kept_count++;
+    if (('\0' == oldest_filename[0]) || (status.st_mtime < oldest_time)) {
+      strcpy(oldest_filename, entry_filename);
+      oldest_time = status.st_mtime;
+    }
+  }
+  closedir(dir);
+  if (MAX_CACHE_FILE <= kept_count) {
+    remove(oldest_filename);
+  }
+}
+
+struct error read_filter_cache(const char* const cache_path, const char*
+    const filter_text, const char* const sheet, uint64_t** const offsets,
+    size_t* const offset_count) {
+  assert(NULL != cache_path);
+  assert(NULL != filter_text);
+  assert(NULL != sheet);
+  assert(NULL != offsets);
+  assert(NULL != offset_count);
+
+  struct error error;
+  *offsets = NULL;
+  *offset_count = 0;
+  struct sheet_stamp stamp;
+  error = get_sheet_stamp(sheet, &stamp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+
+  char filename[MAX_CACHE_PATH];
+  get_cache_file(cache_path, filter_text, filename);
+  error.code = ERROR_STALE_INDEX;
+  FILE* const fp = fopen(filename, "rb");
+  if (NULL == fp) {
+    return error;
+  }
+  struct cache_header header;
+  const size_t text_length = strlen(filter_text);
+  if ((1 != fread(&header, sizeof(header), 1, fp)) || (0 !=
+        memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC))) ||
+      (text_length != header.text_length) || (stamp.size !=
+        header.sheet_size) || (stamp.modified != header.sheet_modified) ||
+      (stamp.size < header.offset_count)) {
+    fclose(fp);
+    return error;
+  }
+
+  /* A different filter with the same hash is a miss. */
+  char* const stored_text = malloc(text_length + 1);
+  uint64_t* const stored_offsets = malloc(((size_t) header.offset_count + 1) *
+      sizeof(uint64_t));
+  if ((NULL == stored_text) || (NULL == stored_offsets)) {
+    free(stored_text);
+    free(stored_offsets);
+    fclose(fp);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  const size_t count = (size_t) header.offset_count;
+  const bool is_valid = (text_length == fread(stored_text, 1, text_length,
+        fp)) && (0 == memcmp(stored_text, filter_text, text_length)) && (count
+        == fread(stored_offsets, sizeof(uint64_t), count, fp));
+  free(stored_text);
+  fclose(fp);
+  if (!is_valid) {
+    free(stored_offsets);
+    return error;
+  }
+  *offsets = stored_offsets;
+  *offset_count = count;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error write_filter_cache(const char* const cache_path, const char*
+    const filter_text, const struct sheet_stamp* const stamp, const uint64_t*
+    const offsets, const size_t offset_count) {
+  assert(NULL != cache_path);
+  assert(NULL != filter_text);
+  assert(NULL != stamp);
+  assert((NULL != offsets) || (0 == offset_count));
+
+  struct error error;
+  char filename[MAX_CACHE_PATH];
+  char temp_filename[MAX_CACHE_PATH + 8];
+  get_cache_file(cache_path, filter_text, filename);
+  snprintf(temp_filename, sizeof(temp_filename), "%s.tmp", filename);
+  mkdir(cache_path, 0777);
+  prune_filter_cache(cache_path, stamp, filename);
+  FILE* const fp = fopen(temp_filename, "wb");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+
+  struct cache_header header;
+  memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.text_length = strlen(filter_text);
+  header.sheet_size = stamp->size;
+  header.sheet_modified = stamp->modified;
+  header.offset_count = offset_count;
+  bool is_written = (1 == fwrite(&header, sizeof(header), 1, fp)) &&
+    (header.text_length == fwrite(filter_text, 1, (size_t)
+      header.text_length, fp)) && (offset_count == fwrite(offsets,
+        sizeof(uint64_t), offset_count, fp));
+  is_written = (0 == fclose(fp)) && is_written;
+  if (!is_written || (0 != rename(temp_filename, filename))) {
+    remove(temp_filename);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
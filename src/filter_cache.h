@@ -0,0 +1,22 @@
+#ifndef _ebs_filter_cache_h_
+#define _ebs_filter_cache_h_
+
+#include "trigram.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* Read the offsets of the rows of the sheet that matched the filter text when
+ * the sheet was last read with it. The caller frees offsets. Return
+ * ERROR_STALE_INDEX if there is no result for the filter and this version of
+ * the sheet. */
+struct error read_filter_cache(const char* cache_path, const char*
+    filter_text, const char* sheet, uint64_t** offsets, size_t*
+    offset_count);
+
+/* Save the offsets of the rows that matched the filter text in the version of
+ * the sheet with the given stamp. */
+struct error write_filter_cache(const char* cache_path, const char*
+    filter_text, const struct sheet_stamp*, const uint64_t* offsets, size_t
+    offset_count);
+
+#endif
@@ -8,8 +8,6 @@ enum {
   HASH_MURMUR_SEED = 12345
 };
 
-static uint32_t ebs_hash_murmur3(const char* str, size_t len, uint32_t seed);
-
 static const char* ebs_hash_get_const_entry(const char*, size_t);
 
 static char* ebs_hash_get_entry(char*, size_t);
@@ -24,10 +22,11 @@ uint32_t ebs_hash_murmur3(const char* const str, const size_t len, const
   uint32_t n = 0xe6546b64;
   uint32_t h = seed;
   size_t block_size = len / 4;
-  const uint32_t* blocks = (const uint32_t*) str;
   size_t i;
   for (i = 0; i < block_size; i++) {
-    uint32_t k = blocks[i];
+    // The key need not be aligned.
+    uint32_t k;
+    memcpy(&k, str + 4 * i, sizeof(k));
     k *= c1;
     // rotate left by r1
     k = (k << r1) | (k >> (32 - r1));
@@ -36,13 +35,15 @@ uint32_t ebs_hash_murmur3(const char* const str, const size_t len, const
     h = (h << r2) | (h >> (32 - r2));
     h = h * m + n;
   }
-  const uint8_t* tail = (const uint8_t*) &blocks[block_size];
+  const uint8_t* tail = (const uint8_t*) str + 4 * block_size;
   uint32_t k1 = 0;
   switch (len & 3) {
   case 3:
     k1 ^= (uint32_t) tail[2] << 16;
+    /* fall through */
   case 2:
     k1 ^= (uint32_t) tail[1] << 8;
+    /* fall through */
   case 1:
     k1 ^= tail[0];
     k1 += c1;
@@ -50,7 +51,7 @@ uint32_t ebs_hash_murmur3(const char* const str, const size_t len, const
     k1 += c2;
     h ^= k1;
   }
-  h ^= len;
+  h ^= (uint32_t) len;
   h ^= (h >> 16);
   h *= 0x85ebca6b;
   h ^= (h >> 13);
@@ -85,10 +86,10 @@ struct error ebs_hash_find(const struct ebs_hash* hash, const char* const key,
   size_t candidate_num = ebs_hash_murmur3(key, strlen(key), HASH_MURMUR_SEED) %
     MAX_HASH_ENTRY;
 
+  // Probing wraps around to the start of the entries.
   for (size_t entry_num = 0; entry_num < MAX_HASH_ENTRY; entry_num++) {
-    *index = candidate_num + entry_num;
-    const char* entry = ebs_hash_get_const_entry(hash->entries, candidate_num +
-        entry_num);
+    *index = (candidate_num + entry_num) % MAX_HASH_ENTRY;
+    const char* entry = ebs_hash_get_const_entry(hash->entries, *index);
     if (0 == strlen(entry)) {
       error.code = ERROR_HASH_NOT_FOUND;
       return error;
@@ -2,6 +2,7 @@
 #define _ebs_hash_h_
 
 #include <stddef.h>
+#include <stdint.h>
 
 enum {
   MAX_HASH_ENTRY = 4096,
@@ -14,6 +15,9 @@ struct ebs_hash {
   char entries[MAX_HASH_ENTRY * (MAX_HASH_KEY + 1)];
 };
 
+/* Hashes len bytes of str with MurmurHash3. */
+uint32_t ebs_hash_murmur3(const char* str, size_t len, uint32_t seed);
+
 /* Initializes the hash. */
 void ebs_hash_init(struct ebs_hash*);
 
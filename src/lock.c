@@ -0,0 +1,51 @@
+/* flock is not part of POSIX. */
+#define _DEFAULT_SOURCE
+
+#include "lock.h"
+#include "error.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+struct error acquire_lock(const char* const lock_file, const enum lock_mode
+    mode, int* const fd) {
+  assert(NULL != lock_file);
+  assert(NULL != fd);
+
+  struct error error;
+  *fd = -1;
+  if (LOCK_MODE_NONE == mode) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+  const int lock_fd = open(lock_file, O_RDWR | O_CREAT, 0666);
+  if (lock_fd < 0) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  const int operation = (LOCK_MODE_SHARED == mode) ? LOCK_SH : LOCK_EX;
+  int result = flock(lock_fd, operation);
+  while ((0 != result) && (EINTR == errno)) {
+    result = flock(lock_fd, operation);
+  }
+  if (0 != result) {
+    close(lock_fd);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  *fd = lock_fd;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void release_lock(const int fd) {
+  if (fd < 0) {
+    return;
+  }
+  flock(fd, LOCK_UN);
+  close(fd);
+}
@@ -0,0 +1,22 @@
+#ifndef _ebs_lock_h_
+#define _ebs_lock_h_
+
+/* How a command holds the lock of the ebs directory. Commands that only
+ * append share it, and commands that rewrite a sheet hold it alone so that no
+ * append is lost. Readers don't take it, since appends are single writes and
+ * rewrites are renamed into place. */
+enum lock_mode {
+  LOCK_MODE_NONE,
+  LOCK_MODE_SHARED,
+  LOCK_MODE_EXCLUSIVE
+};
+
+/* Take the lock on the lock file in the given mode, creating the file if
+ * needed and waiting while it is held in a conflicting mode. fd is set to the
+ * descriptor that holds the lock, or -1 for LOCK_MODE_NONE. */
+struct error acquire_lock(const char* lock_file, enum lock_mode, int* fd);
+
+/* Release a lock taken by acquire_lock. */
+void release_lock(int fd);
+
+#endif
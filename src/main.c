@@ -1,31 +1,137 @@
 #include "command.h"
+#include "calendar.h"
 #include "config.h"
 #include "error.h"
 #include "expression.h"
+#include "hash.h"
+#include "name_index.h"
+#include "profile.h"
+#include "report.h"
+#include "schedule.h"
+#include "stats.h"
 #include "task.h"
+#include "task_load.h"
+#include "task_table.h"
+#include "time_index.h"
+#include "time_snapshot.h"
+#include "transfer.h"
+#include "trigram.h"
 #include "utility.h"
+#include "velocity.h"
+#include "watch.h"
+#include "writer.h"
 #include <assert.h>
+#include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-/* These files live under the ebs path. */
-const char* TASK_SHEET = "task.tsv";
-const char* TIME_SHEET = "time.tsv";
-
 enum {
   MAX_TASK = 1024,
   MAX_RECORD = 1024,
   MAX_BUFFER = 4995,
   MAX_LOOP = 1000000,
+  MAX_BATCH_ARGUMENT = 4,
+  MAX_COMPLETION = 1024,
+  MAX_LOG_LINE = 1000000000,
+  /* How long the sheets must be quiet before a watched forecast is
+   * redrawn. */
+  WATCH_DEBOUNCE_MS = 200
 };
 
 /* Print help. */
 void print_help(void);
 
+/* Print the profile of the command to stderr. This runs at exit, so that
+ * every way out of a command is covered. */
+void print_profile(void);
+
 /* List tasks matching the given expression. */
-int list_tasks(const char* filter, bool list_all, const struct config* config);
+int list_tasks(const char* filter, bool list_all, enum output_format, const
+    struct config* config);
+
+/* Write a task as a row of name, status, estimate and actual time in minutes
+ * and owner, or as a JSON object for OUTPUT_JSON. */
+void put_task(struct writer*, enum output_format, const struct task*);
+
+/* Parse the value of the --format option at argv[*arg_num + 1] and advance
+ * arg_num past the option name. Print the error and return false if the
+ * value is missing or unknown. */
+bool parse_format_option(int argc, char* argv[], int* arg_num, enum
+    output_format*);
+
+/* Print the names of tasks that start with the prefix, active tasks first.
+ * Done tasks are only included with list_all. */
+int complete_task_name(const char* prefix, bool list_all, const struct
+    config* config);
+
+/* Remove the task with the given name, or if there is none, every task that
+ * matches the name as a filter. Print the names of the removed tasks. */
+int remove_tasks(const char* name_or_filter, const struct config* config);
+
+/* Drop the time records that don't change the time spent on tasks, such as
+ * the records of removed tasks. */
+int collect_time_sheet(const struct config* config);
+
+/* Print the time spent on the tasks that match the filter in each period,
+ * with the totals of each period and of each task. */
+int report_time(const char* filter, enum report_period, enum output_format,
+    const struct config* config);
+
+/* Print the report: a row for each period followed by its tasks, then the
+ * totals of the tasks. */
+void put_report(struct writer*, enum output_format, const struct report*);
+
+/* Print the time of a task in a period or over all periods, or with an empty
+ * name, of all the tasks in a period. A period_start of zero stands for all
+ * periods. */
+void put_report_entry(struct writer*, enum output_format, enum report_period,
+    const struct report_entry*);
+
+/* Print how fast the completed tasks that match the filter were done
+ * compared to their estimates, overall, by estimate size and by name
+ * token. */
+int print_velocity(const char* filter, enum output_format, const struct
+    config* config);
+
+/* Print the velocities of a group of tasks. */
+void put_velocity_summary(struct writer*, enum output_format, const struct
+    velocity_summary*);
+
+/* Print the time records from from up to to whose task matches the filter,
+ * each with the time until the record after it. */
+int print_time_log(const char* filter, time_t from, time_t to, enum
+    output_format, const struct config* config);
+
+/* Print a record of the log. seconds is negative if it is not known how long
+ * the record lasted. */
+void put_log_record(struct writer*, enum output_format, const struct
+    time_record*, intmax_t seconds);
+
+/* Parse the time of --from or --to. A date alone stands for the start of the
+ * day, or for its end if is_end. */
+struct error parse_log_time(const char* str, bool is_end, time_t* result);
+
+/* Print the sizes, counts and limits of the ebs directory as JSON. */
+int print_stats(const struct config* config);
+
+/* Index the task sheet again after its rows changed. */
+void rebuild_task_indexes(const struct config* config);
+
+/* Predict completion times of the tasks and print them. */
+struct error print_forecast(const struct task* tasks, size_t task_count,
+    const struct expression* filter, bool by_team, enum output_format, const
+    char* holiday_sheet);
+
+/* Print the prediction, then print it again whenever the sheets change. Only
+ * the lines appended to a sheet are read, unless it was rewritten. */
+int watch_prediction(const char* filter, bool by_team, enum output_format,
+    const struct config* config);
+
+/* Print the predicted completion dates. */
+void print_prediction(enum output_format, const struct prediction*);
 
 /* Append task to the time sheet. If the task does not exist, create a new task
  * with the given estimates.*/
@@ -42,15 +148,50 @@ int tick_task(const char* task_name, const struct config* config);
 /* Set the task status to incomplete. */
 int untick_task(const char* task_name, const struct config* config);
 
-/* Predict task completion times. */
-int predict(const char* filter, const struct config* config);
+/* Assign the task to a person. An empty person unassigns the task. */
+int assign_task(const char* task_name, const char* person, const struct
+    config* config);
 
-/* Print the current task being done. */
-int print_top_task(const struct config*);
+/* Predict task completion times. If by_team is set, the tasks are done in
+ * parallel by the people they are assigned to. */
+int predict(const char* filter, bool by_team, enum output_format, const struct
+    config* config);
 
-/* Load tasks into a buffer. */
-struct error load_tasks(const char* filter, bool load_completed_tasks, const
-    struct config* , struct task* tasks, size_t max_task, size_t* task_count);
+/* Print the current task being done, and how long it has been done for if
+ * show_elapsed is set. The task comes from the current-state file, or from
+ * the end of the time sheet if the state is stale. */
+int print_top_task(bool show_elapsed, enum output_format, const struct
+    config*);
+
+/* Run the commands of the batch file, or of stdin if it is NULL, on the tasks
+ * in memory and commit them with one write of each sheet. Print the result of
+ * each command with its line number. */
+int run_batch(const char* batch_file, const struct config* config);
+
+/* Run one add, do, tick, untick or assign command of a batch on the table.
+ * The time records of do commands are appended to records. */
+struct error run_batch_command(char* const* args, size_t arg_count, struct
+    task_table* table, struct time_record** records, size_t* record_count,
+    bool* is_table_changed);
+
+/* Import tasks, or time records if is_time is set, from the file or from
+ * stdin if it is NULL. Tasks whose names are taken are skipped. */
+int import_sheet(const char* file, enum transfer_format, bool is_time, const
+    struct config* config);
+
+/* Export all tasks, or all time records if is_time is set, to stdout. */
+int export_sheet(enum transfer_format, bool is_time, const struct config*
+    config);
+
+/* Parse the options of import and export, and the file to import from if
+ * file is not NULL. Return ERROR_BAD_ARGUMENTS for anything else. */
+struct error parse_transfer_options(char** args, int arg_count, enum
+    transfer_format* format, bool* is_time, const char** file);
+
+/* Split a line into whitespace separated arguments in place. Return
+ * ERROR_BAD_ARGUMENTS if there are more than max_arg. */
+struct error split_arguments(char* line, char** args, size_t max_arg, size_t*
+    arg_count);
 
 /* Search for a task with the given name. */
 struct error scan_task(const char* task_name, const struct config* config,
@@ -60,23 +201,61 @@ struct error scan_task(const char* task_name, const struct config* config,
 struct error set_task_status(const char* task_name, const enum task_status,
     const struct config*);
 
+/* Rewrite the task in the task sheet. The status and owner are left alone if
+ * they are NULL. */
+struct error update_task(const char* task_name, const enum task_status*
+    status, const char* owner, const struct config*);
+
 void print_help(void) {
   puts("ebs");
   puts("config:");
-  puts("--path <path>          - path to the ebs directory");
+  puts("--path <path>          - path to the ebs directory; list, predict and");
+  puts("                         velocity take several and merge their tasks");
+  puts("--profile              - print the time of each phase of the command");
+  puts("                         and counts of the work done to stderr");
   puts("commands:");
   puts("help                   - print this message");
   puts("add <task> <estimate>  - add a task"); 
   puts("config                 - print the configuration");
   puts("do <task> [estimate]   - start recording time for task");
-  puts("predict [filter]       - predict completion time of tasks");
-  puts("list [--all] [filter]  - list tasks");
+  puts("assign <task> [person] - assign a task to a person");
+  puts("predict [--team] [--watch] [--format text|tsv|json] [filter]");
+  puts("                       - predict completion time of tasks, and again");
+  puts("                         whenever the sheets change with --watch");
+  puts("list [--all] [--format text|tsv|json] [filter]");
+  puts("                       - list tasks");
   puts("tick <task>            - mark task as completed");
-  puts("top                    - print the current task");
+  puts("top [--elapsed] [--format text|tsv|json]");
+  puts("                       - print the current task");
+  puts("batch [file]           - run add, do, tick, untick and assign commands");
+  puts("                         from a file or stdin, one per line");
+  puts("import [--times] [--format tsv|csv|jsonl] [file]");
+  puts("                       - import tasks or time records");
+  puts("export [--times] [--format tsv|csv|jsonl]");
+  puts("                       - export tasks or time records");
+  puts("rm <task|filter>       - remove a task, or the tasks matching filter");
+  puts("gc                     - drop time records that don't count, such as");
+  puts("                         those of removed tasks");
+  puts("report [--by day|week|month] [--format text|tsv|json] [filter]");
+  puts("                       - print the time spent in each day, week or");
+  puts("                         month, by task");
+  puts("log [--from <time>] [--to <time>] [--format text|tsv|json] [filter]");
+  puts("                       - print the time records in a range of times");
+  puts("velocity [--format text|tsv|json] [filter]");
+  puts("                       - print how estimates compared to actual times");
+  puts("                         of completed tasks");
+  puts("complete [--all] [prefix]");
+  puts("                       - print task names that start with prefix");
+  puts("stats                  - print the sizes, errors and limits of the");
+  puts("                         sheets as JSON");
+}
+
+void print_profile(void) {
+  put_profile(stderr);
 }
 
-int list_tasks(const char* const filter, const bool list_all, const struct
-    config* const config) {
+int list_tasks(const char* const filter, const bool list_all, const enum
+    output_format format, const struct config* const config) {
   assert(NULL != filter);
   assert(NULL != config);
   assert(NULL != config->base_path);
@@ -85,78 +264,78 @@ int list_tasks(const char* const filter, const bool list_all, const struct
   struct task tasks[MAX_TASK];
   size_t task_count;
 
-  error = load_tasks(filter, list_all, config, tasks, MAX_TASK, &task_count);
+  char cache_path[MAX_BUFFER];
+  snprintf(cache_path, MAX_BUFFER, "%s/%s", config->base_path,
+      CACHE_DIRECTORY);
+  struct expression pattern;
+  set_profile_phase(PHASE_FILTER);
+  error = parse_cached_expression(filter, cache_path, &pattern);
   if (ERROR_NONE != error.code) {
+    free_expression(&pattern);
     print_error(&error);
     return 1;
   }
-
-  for (size_t task_num = 0; task_num < task_count; task_num++) {
-    char buffer[MAX_BUFFER];
-    format_task(&tasks[task_num], buffer, MAX_BUFFER);
-    printf("%s\n", buffer);
+  if (1 < config->path_count) {
+    error = load_workspace_tasks(&pattern, list_all, config, tasks, MAX_TASK,
+        &task_count);
+  } else {
+    error = load_tasks(filter, &pattern, NULL, list_all, config, tasks,
+        MAX_TASK, &task_count);
   }
-  return 0;
-}
-
-struct error load_tasks(const char* const filter, const bool
-    load_completed_tasks, const struct config* const config, struct task*
-    tasks, const size_t max_task, size_t* task_count) {
-  assert(NULL != filter);
-  assert(NULL != tasks);
-  assert(NULL != config);
-  assert(NULL != config->base_path);
-
-  struct error error;
-  char task_sheet[MAX_BUFFER];
-  char time_sheet[MAX_BUFFER];
-
-  struct expression pattern;
-  error = parse_expression(filter, &pattern);
+  free_expression(&pattern);
   if (ERROR_NONE != error.code) {
-    return error;
+    print_error(&error);
+    return 1;
   }
 
-  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
-
-  FILE* fp = fopen(task_sheet, "r");
-  if (NULL == fp) {
-    printf("no such file %s\n", task_sheet);
-    error.code = ERROR_FILE;
-    return error;
+  set_profile_phase(PHASE_OUTPUT);
+  struct writer writer;
+  init_writer(&writer, stdout);
+  for (size_t task_num = 0; task_num < task_count; task_num++) {
+    put_task(&writer, format, &tasks[task_num]);
+  }
+  error = flush_writer(&writer);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
   }
+  return 0;
+}
 
-  *task_count = 0;
-  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
-    if (max_task <= *task_count) {
-      break;
-    }
-    error = read_task(fp, &tasks[*task_count]);
-    if (ERROR_END_OF_FILE== error.code) {
-      break;
-    }
-    if (ERROR_NONE != error.code) {
-      print_error(&error);
-      continue;
-    }
-    if (!load_completed_tasks && (STATUS_DONE == tasks[*task_count].status)) {
-      continue;
-    }
-    if (string_matches(tasks[*task_count].name, &pattern)) {
-      *task_count += 1;
+void put_task(struct writer* const writer, const enum output_format format,
+    const struct task* const task) {
+  assert(NULL != writer);
+  assert(NULL != task);
+
+  const char* const status = get_task_status(task->status);
+  if (OUTPUT_JSON != format) {
+    put_string(writer, task->name);
+    put_char(writer, '\t');
+    put_string(writer, status);
+    put_char(writer, '\t');
+    put_int(writer, task->estimated_seconds / 60);
+    put_char(writer, '\t');
+    put_int(writer, task->actual_seconds / 60);
+    if ('\0' != task->owner[0]) {
+      put_char(writer, '\t');
+      put_string(writer, task->owner);
     }
+    put_char(writer, '\n');
+    return;
   }
-
-  snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
-  error = read_time_sheet(time_sheet, tasks, *task_count);
-  if (ERROR_NONE != error.code) {
-    fclose(fp);
-    return error;
+  put_string(writer, "{\"name\":");
+  put_json_string(writer, task->name);
+  put_string(writer, ",\"status\":\"");
+  put_string(writer, status);
+  put_string(writer, "\",\"estimate\":");
+  put_int(writer, task->estimated_seconds / 60);
+  put_string(writer, ",\"actual\":");
+  put_int(writer, task->actual_seconds / 60);
+  if ('\0' != task->owner[0]) {
+    put_string(writer, ",\"owner\":");
+    put_json_string(writer, task->owner);
   }
-
-  fclose(fp);
-  error.code = ERROR_NONE;
-  return error;
+  put_string(writer, "}\n");
 }
 
 struct error scan_task(const char* const task_name, const struct config* const
@@ -205,6 +384,8 @@ int do_task(const char* const task_name, const intmax_t estimated_minutes,
 
   struct error error;
   char time_sheet[MAX_BUFFER];
+  char current_task[MAX_BUFFER];
+  char time_index[MAX_BUFFER];
 
   bool task_exists = false;
   error = scan_task(task_name, config, &task_exists);
@@ -225,7 +406,11 @@ int do_task(const char* const task_name, const intmax_t estimated_minutes,
   }
 
   snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
-  error = append_time_sheet_entry(time_sheet, task_name);
+  snprintf(current_task, MAX_BUFFER, "%s/%s", config->base_path,
+      CURRENT_TASK);
+  snprintf(time_index, MAX_BUFFER, "%s/%s", config->base_path, TIME_INDEX);
+  error = append_time_sheet_entry(time_sheet, current_task, time_index,
+      task_name);
   if (ERROR_NONE != error.code) {
     print_error(&error);
     return 1;
@@ -246,6 +431,8 @@ int add_task(const char* const task_name, const intmax_t estimated_minutes,
 
   struct error error;
   char task_sheet[MAX_BUFFER];
+  char task_index[MAX_BUFFER];
+  char name_index[MAX_BUFFER];
 
   bool task_exists = false;
   error = scan_task(task_name, config, &task_exists);
@@ -261,20 +448,103 @@ int add_task(const char* const task_name, const intmax_t estimated_minutes,
   struct task task;
   task.estimated_seconds = estimated_minutes * 60;
   task.actual_seconds = 0;
+  task.owner[0] = '\0';
   strncpy(task.name, task_name, MAX_TASK_NAME);
   task.name[MAX_TASK_NAME] = '\0';
   task.status = STATUS_ACTIVE;
   snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
+  snprintf(task_index, MAX_BUFFER, "%s/%s", config->base_path, TASK_INDEX);
+  snprintf(name_index, MAX_BUFFER, "%s/%s", config->base_path, NAME_INDEX);
+
+  struct sheet_stamp previous;
+  const bool has_stamp = (ERROR_NONE == get_sheet_stamp(task_sheet,
+        &previous).code);
+  char row[MAX_BUFFER + 1];
+  error = format_task(&task, row, MAX_BUFFER);
+  size_t length = strlen(row);
+  row[length] = '\n';
+  length++;
+  uint64_t end_offset = 0;
+  if (ERROR_NONE == error.code) {
+    error = append_file(task_sheet, row, length, &end_offset);
+  }
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+
+  /* The index only speeds up reads, so it is rebuilt on the next one if it
+   * can't be updated now. */
+  if (has_stamp) {
+    error = append_trigram_index(task_index, task_sheet, &previous, task.name,
+        end_offset - length);
+    if (ERROR_STALE_INDEX == error.code) {
+      build_trigram_index(task_index, task_sheet);
+    }
+  }
+  if (has_stamp) {
+    error = append_name_index(name_index, task_sheet, &previous, &task);
+    if (ERROR_STALE_INDEX == error.code) {
+      build_name_index(name_index, task_sheet);
+    }
+  }
+  return 0;
+}
+
+void rebuild_task_indexes(const struct config* const config) {
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  char task_sheet[MAX_BUFFER];
+  char task_index[MAX_BUFFER];
+  char name_index[MAX_BUFFER];
+  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
+  snprintf(task_index, MAX_BUFFER, "%s/%s", config->base_path, TASK_INDEX);
+  snprintf(name_index, MAX_BUFFER, "%s/%s", config->base_path, NAME_INDEX);
+  /* The indexes only speed up reads, so failures are left for the next read
+   * to fix. */
+  build_trigram_index(task_index, task_sheet);
+  build_name_index(name_index, task_sheet);
+}
+
+int complete_task_name(const char* const prefix, const bool list_all, const
+    struct config* const config) {
+  assert(NULL != prefix);
+  assert(NULL != config);
+  assert(NULL != config->base_path);
 
-  FILE* fp = fopen(task_sheet, "a");
-  error = write_task(&task, fp);
+  char task_sheet[MAX_BUFFER];
+  char name_index[MAX_BUFFER];
+  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
+  snprintf(name_index, MAX_BUFFER, "%s/%s", config->base_path, NAME_INDEX);
+
+  static char names[MAX_COMPLETION][MAX_TASK_NAME + 1];
+  size_t name_count;
+  struct error error = find_name_completions(name_index, task_sheet, prefix,
+      !list_all, names, MAX_COMPLETION, &name_count);
+  if (ERROR_STALE_INDEX == error.code) {
+    error = build_name_index(name_index, task_sheet);
+    if (ERROR_NONE == error.code) {
+      error = find_name_completions(name_index, task_sheet, prefix,
+          !list_all, names, MAX_COMPLETION, &name_count);
+    }
+  }
   if (ERROR_NONE != error.code) {
-    fclose(fp);
     print_error(&error);
     return 1;
   }
 
-  fclose(fp);
+  struct writer writer;
+  init_writer(&writer, stdout);
+  for (size_t name_num = 0; name_num < name_count; name_num++) {
+    put_string(&writer, names[name_num]);
+    put_char(&writer, '\n');
+  }
+  error = flush_writer(&writer);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
   return 0;
 }
 
@@ -302,16 +572,49 @@ int untick_task(const char* const task_name, const struct config* config) {
   return 0;
 }
 
+int assign_task(const char* const task_name, const char* const person, const
+    struct config* config) {
+  assert(NULL != task_name);
+  assert(NULL != person);
+  assert(NULL != config);
+
+  if (MAX_PERSON_NAME < strlen(person)) {
+    printf("person name is longer than %d\n", MAX_PERSON_NAME);
+    return 1;
+  }
+  /* The owner is a field of the task sheet, which whitespace separates. */
+  for (const char* c = person; '\0' != *c; c++) {
+    if (isspace((unsigned char) *c)) {
+      puts("person name can't contain whitespace");
+      return 1;
+    }
+  }
+  struct error error = update_task(task_name, NULL, person, config);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
+
 struct error set_task_status(const char* const task_name, const enum
     task_status status, const struct config* const config) {
   assert(NULL != task_name);
   assert(NULL != config);
 
+  return update_task(task_name, &status, NULL, config);
+}
+
+struct error update_task(const char* const task_name, const enum task_status*
+    const status, const char* const owner, const struct config* const config) {
+  assert(NULL != task_name);
+  assert(NULL != config);
+
   struct error error;
   char task_sheet[MAX_BUFFER];
-  char task_backup[MAX_BUFFER];
+  char temp_sheet[MAX_BUFFER];
   snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
-  snprintf(task_backup, MAX_BUFFER, "%s/%s.bak", config->base_path,
+  snprintf(temp_sheet, MAX_BUFFER, "%s/%s.tmp", config->base_path,
       TASK_SHEET);
 
   FILE* const fin = fopen(task_sheet, "r");
@@ -319,8 +622,9 @@ struct error set_task_status(const char* const task_name, const enum
     error.code = ERROR_FILE;
     return error;
   }
-  FILE* const fout = fopen(task_backup, "w");
+  FILE* const fout = fopen(temp_sheet, "w");
   if (NULL == fout) {
+    fclose(fin);
     error.code = ERROR_FILE;
     return error;
   }
@@ -335,31 +639,37 @@ struct error set_task_status(const char* const task_name, const enum
     if (ERROR_NONE != error.code) {
       fclose(fin);
       fclose(fout);
+      remove(temp_sheet);
       return error;
     }
     if (0 == strcmp(task_name, task.name)) {
-      task.status = status;
+      if (NULL != status) {
+        task.status = *status;
+      }
+      if (NULL != owner) {
+        strncpy(task.owner, owner, MAX_PERSON_NAME);
+        task.owner[MAX_PERSON_NAME] = '\0';
+      }
       task_exists = true;
     }
     error = write_task(&task, fout);
     if (ERROR_NONE != error.code) {
       fclose(fin);
       fclose(fout);
+      remove(temp_sheet);
       return error;
     }
   }
 
   fclose(fin);
-  fclose(fout);
-  // Commit changes and delete the backup.
-  error = copy(task_backup, task_sheet);
-  if (ERROR_NONE != error.code) {
+  /* Readers see the old sheet or the new one, never a partial one. */
+  if ((0 != fclose(fout)) || (0 != rename(temp_sheet, task_sheet))) {
+    remove(temp_sheet);
+    error.code = ERROR_FILE;
     return error;
   }
-  if (0 != remove(task_backup)) {
-    // Report and carry on.
-    printf("remove(): %s\n", strerror(errno));
-  }
+  // Rows may have moved, so index them again.
+  rebuild_task_indexes(config);
   if (!task_exists) {
     error.code = ERROR_NO_SUCH_TASK;
     return error;
@@ -368,117 +678,1437 @@ struct error set_task_status(const char* const task_name, const enum
   return error;
 }
 
-int predict(const char* const filter, const struct config* const config) {
-  assert(NULL != filter);
+int remove_tasks(const char* const name_or_filter, const struct config* const
+    config) {
+  assert(NULL != name_or_filter);
   assert(NULL != config);
   assert(NULL != config->base_path);
 
   struct error error;
-  struct task tasks[MAX_TASK];
-  size_t task_count;
-
-  error = load_tasks(filter, true, config, tasks, MAX_TASK, &task_count);
+  char task_sheet[MAX_BUFFER];
+  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
+  struct task_table table;
+  init_task_table(&table);
+  error = read_task_table(task_sheet, &table);
+  bool* is_removed = NULL;
+  if (ERROR_NONE == error.code) {
+    is_removed = calloc(table.task_count + 1, sizeof(bool));
+    error.code = (NULL == is_removed) ? ERROR_OUT_OF_MEMORY : ERROR_NONE;
+  }
   if (ERROR_NONE != error.code) {
+    free_task_table(&table);
     print_error(&error);
     return 1;
   }
 
-  error = predict_completion_date(tasks, task_count, filter);
+  /* An exact name wins over the filter it would also be read as. */
+  size_t removed_count = 0;
+  struct task* task;
+  if (ERROR_NONE == find_table_task(&table, name_or_filter, &task).code) {
+    is_removed[task - table.tasks] = true;
+    removed_count = 1;
+  } else {
+    struct expression filter;
+    error = parse_expression(name_or_filter, &filter);
+    for (size_t task_num = 0; (ERROR_NONE == error.code) && (task_num <
+          table.task_count); task_num++) {
+      if (string_matches(table.tasks[task_num].name, &filter)) {
+        is_removed[task_num] = true;
+        removed_count++;
+      }
+    }
+    free_expression(&filter);
+  }
+  if ((ERROR_NONE == error.code) && (0 == removed_count)) {
+    error.code = ERROR_NO_SUCH_TASK;
+  }
+  if (ERROR_NONE == error.code) {
+    for (size_t task_num = 0; task_num < table.task_count; task_num++) {
+      if (is_removed[task_num]) {
+        printf("%s\n", table.tasks[task_num].name);
+      }
+    }
+    remove_table_tasks(&table, is_removed);
+    error = write_task_table(&table, task_sheet);
+  }
+  free(is_removed);
+  free_task_table(&table);
   if (ERROR_NONE != error.code) {
     print_error(&error);
     return 1;
   }
-
+  rebuild_task_indexes(config);
   return 0;
 }
 
-int print_top_task(const struct config* const config) {
+int collect_time_sheet(const struct config* const config) {
   assert(NULL != config);
   assert(NULL != config->base_path);
 
+  struct error error;
+  char task_sheet[MAX_BUFFER];
   char time_sheet[MAX_BUFFER];
+  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
   snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
-  FILE* fp = fopen(time_sheet, "r");
-  if (NULL == fp) {
-    printf("fopen(%s): %s\n", time_sheet, strerror(errno));
+  struct task_table table;
+  init_task_table(&table);
+  error = read_task_table(task_sheet, &table);
+  size_t removed_count = 0;
+  if (ERROR_NONE == error.code) {
+    error = compact_time_sheet(&table, time_sheet, &removed_count);
+  }
+  free_task_table(&table);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
     return 1;
   }
+  printf("removed %zu time records\n", removed_count);
+  return 0;
+}
+
+int report_time(const char* const filter, const enum report_period period,
+    const enum output_format format, const struct config* const config) {
+  assert(NULL != filter);
+  assert(NULL != config);
+  assert(NULL != config->base_path);
 
   struct error error;
-  struct time_record last_record;
-  bool task_exists = false;
+  char time_sheet[MAX_BUFFER];
+  char time_snapshot[MAX_BUFFER];
+  char cache_path[MAX_BUFFER];
+  snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
+  snprintf(time_snapshot, MAX_BUFFER, "%s/%s", config->base_path,
+      TIME_SNAPSHOT);
+  snprintf(cache_path, MAX_BUFFER, "%s/%s", config->base_path,
+      CACHE_DIRECTORY);
+  struct expression pattern;
+  set_profile_phase(PHASE_FILTER);
+  error = parse_cached_expression(filter, cache_path, &pattern);
+  if (ERROR_NONE != error.code) {
+    free_expression(&pattern);
+    print_error(&error);
+    return 1;
+  }
+  set_profile_phase(PHASE_REPLAY_TIMES);
+  struct report report;
+  init_report(&report, period);
+  struct time_columns columns;
+  init_time_columns(&columns);
+  error = load_time_columns(time_snapshot, time_sheet, &columns);
+  if (ERROR_NONE == error.code) {
+    error = add_report_columns(&report, &columns);
+  }
+  free_time_columns(&columns);
+  if (ERROR_NONE == error.code) {
+    set_profile_phase(PHASE_FILTER);
+    error = finish_report(&report, &pattern);
+  }
+  free_expression(&pattern);
+  if (ERROR_NONE == error.code) {
+    set_profile_phase(PHASE_OUTPUT);
+    struct writer writer;
+    init_writer(&writer, stdout);
+    put_report(&writer, format, &report);
+    error = flush_writer(&writer);
+  }
+  free_report(&report);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
 
-  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
-    struct time_record record;
-    error = read_time_record(fp, &record);
-    if (ERROR_END_OF_FILE == error.code) {
-      break;
+void put_report(struct writer* const writer, const enum output_format format,
+    const struct report* const report) {
+  assert(NULL != writer);
+  assert(NULL != report);
+
+  /* Cells and periods are both sorted by period, so they are walked
+   * together. */
+  size_t cell_num = 0;
+  for (size_t period_num = 0; period_num < report->periods.entry_count;
+      period_num++) {
+    const struct report_entry* const total =
+      &report->periods.entries[period_num];
+    put_report_entry(writer, format, report->period, total);
+    for (size_t first_num = cell_num; (cell_num <
+          report->cells.entry_count) && (report->cells.entries[cell_num]
+          .period_start == total->period_start); cell_num++) {
+      if ((OUTPUT_JSON == format) && (first_num < cell_num)) {
+        put_char(writer, ',');
+      }
+      put_report_entry(writer, format, report->period,
+          &report->cells.entries[cell_num]);
     }
-    if (ERROR_NONE != error.code) {
-      continue;
+    if (OUTPUT_JSON == format) {
+      put_string(writer, "]}\n");
     }
-    task_exists = true;
-    last_record = record;
   }
 
-  if (!task_exists) {
-    puts("no task found");
-    return 0;
+  struct report_entry total;
+  memset(&total, 0, sizeof(total));
+  for (size_t task_num = 0; task_num < report->tasks.entry_count;
+      task_num++) {
+    total.seconds += report->tasks.entries[task_num].seconds;
+  }
+  put_report_entry(writer, format, report->period, &total);
+  for (size_t task_num = 0; task_num < report->tasks.entry_count;
+      task_num++) {
+    if ((OUTPUT_JSON == format) && (0 < task_num)) {
+      put_char(writer, ',');
+    }
+    put_report_entry(writer, format, report->period,
+        &report->tasks.entries[task_num]);
+  }
+  if (OUTPUT_JSON == format) {
+    put_string(writer, "]}\n");
   }
-  printf("%s\n", last_record.name);
-  return 0;
 }
 
-int main(int argc, char** argv) {
-  struct config config;
-  config.base_path = NULL;
+void put_report_entry(struct writer* const writer, const enum output_format
+    format, const enum report_period period, const struct report_entry* const
+    entry) {
+  assert(NULL != writer);
+  assert(NULL != entry);
+
+  const bool is_total = ('\0' == entry->name[0]);
+  const bool is_all_periods = (0 == entry->period_start);
+  if (OUTPUT_JSON == format) {
+    if (!is_total) {
+      put_string(writer, "{\"name\":");
+      put_json_string(writer, entry->name);
+      put_string(writer, ",\"minutes\":");
+      put_int(writer, entry->seconds / 60);
+      put_char(writer, '}');
+      return;
+    }
+    put_char(writer, '{');
+    if (!is_all_periods) {
+      put_string(writer, "\"start\":");
+      put_int(writer, (intmax_t) entry->period_start);
+      put_char(writer, ',');
+    }
+    put_string(writer, "\"minutes\":");
+    put_int(writer, entry->seconds / 60);
+    put_string(writer, ",\"tasks\":[");
+    return;
+  }
+  if (OUTPUT_TSV == format) {
+    if (!is_all_periods) {
+      put_int(writer, (intmax_t) entry->period_start);
+    }
+    put_char(writer, '\t');
+    put_string(writer, entry->name);
+  } else if (is_total && is_all_periods) {
+    put_string(writer, "total");
+  } else if (is_total) {
+    char label[32];
+    strftime(label, sizeof(label), (REPORT_MONTH == period) ? "%Y-%m" :
+        "%Y-%m-%d", localtime(&entry->period_start));
+    put_string(writer, label);
+  } else {
+    put_char(writer, '\t');
+    put_string(writer, entry->name);
+  }
+  put_char(writer, '\t');
+  put_int(writer, entry->seconds / 60);
+  put_char(writer, '\n');
+}
 
-  for (int arg_num = 1; arg_num < argc; arg_num++) {
-    enum config_type config_type;
-    struct error error = parse_config_type(argv[arg_num], &config_type);
+int print_velocity(const char* const filter, const enum output_format
+    format, const struct config* const config) {
+  assert(NULL != filter);
+  assert(NULL != config);
+  assert(NULL != config->base_path);
 
-    // Parse configuration.
-    if (ERROR_NONE == error.code) {
-      if (CONFIG_PATH == config_type) {
-        if (argc <= arg_num + 1) {
-          printf("%s <path>\n", get_config_name(CONFIG_PATH));
-          return 1;
-        }
-        arg_num += 1;
-        config.base_path = argv[arg_num];
-        continue;
-      } else {
-        printf("%s is not supported\n", get_config_name(config_type));
-        return 1;
+  struct error error;
+  struct task tasks[MAX_TASK];
+  size_t task_count;
+  char cache_path[MAX_BUFFER];
+  snprintf(cache_path, MAX_BUFFER, "%s/%s", config->base_path,
+      CACHE_DIRECTORY);
+  struct expression pattern;
+  set_profile_phase(PHASE_FILTER);
+  error = parse_cached_expression(filter, cache_path, &pattern);
+  if ((ERROR_NONE == error.code) && (1 < config->path_count)) {
+    error = load_workspace_tasks(&pattern, true, config, tasks, MAX_TASK,
+        &task_count);
+  } else if (ERROR_NONE == error.code) {
+    error = load_tasks(filter, &pattern, NULL, true, config, tasks, MAX_TASK,
+        &task_count);
+  }
+  free_expression(&pattern);
+  set_profile_phase(PHASE_OUTPUT);
+  struct velocity_report report;
+  if (ERROR_NONE == error.code) {
+    error = compute_velocity_report(tasks, task_count, &report);
+  }
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+
+  struct writer writer;
+  init_writer(&writer, stdout);
+  if ((OUTPUT_TEXT == format) && (0 == report.summary_count)) {
+    put_string(&writer, "no completed tasks\n");
+  } else if (OUTPUT_TEXT == format) {
+    char line[MAX_BUFFER];
+    const int length = snprintf(line, sizeof(line),
+        "%-24s %6s %6s %6s %6s %6s %6s %6s\n", "group", "tasks", "gmean",
+        "p5", "p25", "p50", "p75", "p95");
+    put_bytes(&writer, line, (size_t) length);
+  }
+  for (size_t summary_num = 0; summary_num < report.summary_count;
+      summary_num++) {
+    put_velocity_summary(&writer, format, &report.summaries[summary_num]);
+  }
+  /* The histogram of all the tasks comes last for people. */
+  if ((OUTPUT_TEXT == format) && (0 < report.summary_count)) {
+    const struct velocity_summary* const all = &report.summaries[0];
+    put_string(&writer, "\nvelocity    tasks\n");
+    for (size_t bin_num = 0; bin_num < VELOCITY_BIN_COUNT; bin_num++) {
+      char line[MAX_BUFFER];
+      const int length = snprintf(line, sizeof(line), "%-10s %6zu",
+          get_velocity_bin_name(bin_num), all->histogram[bin_num]);
+      put_bytes(&writer, line, (size_t) length);
+      /* Scale the bars to at most 50 characters. */
+      const size_t bar_length = (all->histogram[bin_num] * 50 +
+          all->task_count - 1) / all->task_count;
+      if (0 < bar_length) {
+        put_char(&writer, ' ');
       }
+      for (size_t bar_num = 0; bar_num < bar_length; bar_num++) {
+        put_char(&writer, '#');
+      }
+      put_char(&writer, '\n');
     }
+  }
+  free_velocity_report(&report);
+  error = flush_writer(&writer);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
 
-    enum command_type command_type;
-    error = parse_command_type(argv[arg_num], &command_type);
-    if (ERROR_NONE != error.code) {
-      printf("unknown command or configuration %s\n", argv[arg_num]);
-      print_help();
-      return 1;
+void put_velocity_summary(struct writer* const writer, const enum
+    output_format format, const struct velocity_summary* const summary) {
+  assert(NULL != writer);
+  assert(NULL != summary);
+
+  if (OUTPUT_TEXT == format) {
+    char line[MAX_BUFFER];
+    int length = snprintf(line, sizeof(line), "%-24s %6zu %6.2f",
+        summary->group, summary->task_count, summary->geometric_mean);
+    for (size_t quantile_num = 0; quantile_num < VELOCITY_QUANTILE_COUNT;
+        quantile_num++) {
+      length += snprintf(&line[length], sizeof(line) - (size_t) length,
+          " %6.2f", summary->quantiles[quantile_num]);
     }
-    if (COMMAND_HELP == command_type) {
-      print_help();
-      return 0;
+    put_bytes(writer, line, (size_t) length);
+    put_char(writer, '\n');
+    return;
+  }
+  if (OUTPUT_TSV == format) {
+    put_string(writer, summary->group);
+    put_char(writer, '\t');
+    put_int(writer, (intmax_t) summary->task_count);
+    put_char(writer, '\t');
+    put_fixed(writer, summary->geometric_mean, 4);
+    for (size_t quantile_num = 0; quantile_num < VELOCITY_QUANTILE_COUNT;
+        quantile_num++) {
+      put_char(writer, '\t');
+      put_fixed(writer, summary->quantiles[quantile_num], 4);
     }
-    if (COMMAND_CONFIG == command_type) {
-      print_config(&config);
-      return 0;
+    for (size_t bin_num = 0; bin_num < VELOCITY_BIN_COUNT; bin_num++) {
+      put_char(writer, '\t');
+      put_int(writer, (intmax_t) summary->histogram[bin_num]);
     }
-
-    if (NULL == config.base_path) {
-      puts("specify path with --path <path>");
-      return 1;
+    put_char(writer, '\n');
+    return;
+  }
+  put_string(writer, "{\"group\":");
+  put_json_string(writer, summary->group);
+  put_string(writer, ",\"tasks\":");
+  put_int(writer, (intmax_t) summary->task_count);
+  put_string(writer, ",\"geometric_mean\":");
+  put_fixed(writer, summary->geometric_mean, 4);
+  put_string(writer, ",\"quantiles\":[");
+  for (size_t quantile_num = 0; quantile_num < VELOCITY_QUANTILE_COUNT;
+      quantile_num++) {
+    if (0 < quantile_num) {
+      put_char(writer, ',');
+    }
+    put_fixed(writer, summary->quantiles[quantile_num], 4);
+  }
+  put_string(writer, "],\"histogram\":[");
+  for (size_t bin_num = 0; bin_num < VELOCITY_BIN_COUNT; bin_num++) {
+    if (0 < bin_num) {
+      put_char(writer, ',');
+    }
+    put_int(writer, (intmax_t) summary->histogram[bin_num]);
+  }
+  put_string(writer, "]}\n");
+}
+
+int print_time_log(const char* const filter, const time_t from, const time_t
+    to, const enum output_format format, const struct config* const config) {
+  assert(NULL != filter);
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  struct error error;
+  char time_sheet[MAX_BUFFER];
+  char time_index[MAX_BUFFER];
+  char cache_path[MAX_BUFFER];
+  snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
+  snprintf(time_index, MAX_BUFFER, "%s/%s", config->base_path, TIME_INDEX);
+  snprintf(cache_path, MAX_BUFFER, "%s/%s", config->base_path,
+      CACHE_DIRECTORY);
+  struct expression pattern;
+  set_profile_phase(PHASE_FILTER);
+  error = parse_cached_expression(filter, cache_path, &pattern);
+  if (ERROR_NONE != error.code) {
+    free_expression(&pattern);
+    print_error(&error);
+    return 1;
+  }
+  set_profile_phase(PHASE_REPLAY_TIMES);
+  struct time_index index;
+  init_time_index(&index);
+  error = load_time_index(time_index, time_sheet, &index);
+  const uint64_t start_offset = find_time_index_offset(&index, (int64_t)
+      from);
+  const bool is_sorted = index.is_sorted;
+  free_time_index(&index);
+  FILE* fp = NULL;
+  if (ERROR_NONE == error.code) {
+    fp = fopen(time_sheet, "rb");
+    if ((NULL == fp) || (0 != fseek(fp, (long) start_offset, SEEK_SET))) {
+      error.code = ERROR_FILE;
+    }
+  }
+  if (ERROR_NONE != error.code) {
+    if (NULL != fp) {
+      fclose(fp);
+    }
+    free_expression(&pattern);
+    print_error(&error);
+    return 1;
+  }
+
+  /* A record is printed once the record after it is read. Once the sheet
+   * is past the range, that record is the last one needed. */
+  struct writer writer;
+  init_writer(&writer, stdout);
+  struct time_record pending;
+  bool has_pending = false;
+  for (size_t loop_num = 0; loop_num < MAX_LOG_LINE; loop_num++) {
+    char line[MAX_BUFFER];
+    size_t bytes_read;
+    error = get_line(fp, line, MAX_BUFFER, &bytes_read);
+    if (ERROR_END_OF_FILE == error.code) {
+      break;
+    }
+    struct time_record record;
+    if ((ERROR_NONE != error.code) || (ERROR_NONE != parse_time_record(line,
+            &record).code)) {
+      continue;
+    }
+    if (has_pending) {
+      put_log_record(&writer, format, &pending, (intmax_t) difftime(
+            record.time, pending.time));
+      has_pending = false;
+    }
+    if (is_sorted && (to <= record.time)) {
+      break;
+    }
+    if ((from <= record.time) && (record.time < to) &&
+        string_matches(record.name, &pattern)) {
+      pending = record;
+      has_pending = true;
+    }
+  }
+  if (has_pending) {
+    put_log_record(&writer, format, &pending, -1);
+  }
+  fclose(fp);
+  free_expression(&pattern);
+  set_profile_phase(PHASE_OUTPUT);
+  error = flush_writer(&writer);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
+
+void put_log_record(struct writer* const writer, const enum output_format
+    format, const struct time_record* const record, const intmax_t seconds) {
+  assert(NULL != writer);
+  assert(NULL != record);
+
+  if (OUTPUT_JSON == format) {
+    put_string(writer, "{\"name\":");
+    put_json_string(writer, record->name);
+    put_string(writer, ",\"start\":");
+    put_int(writer, (intmax_t) record->time);
+    if (0 <= seconds) {
+      put_string(writer, ",\"duration\":");
+      put_int(writer, seconds);
+    }
+    put_string(writer, "}\n");
+    return;
+  }
+  if (OUTPUT_TSV == format) {
+    put_string(writer, record->name);
+    put_char(writer, '\t');
+    put_int(writer, (intmax_t) record->time);
+    put_char(writer, '\t');
+    if (0 <= seconds) {
+      put_int(writer, seconds);
+    }
+    put_char(writer, '\n');
+    return;
+  }
+  put_iso_8601_time(writer, localtime(&record->time));
+  put_char(writer, '\t');
+  put_string(writer, record->name);
+  if (0 <= seconds) {
+    char duration[64];
+    snprintf(duration, sizeof(duration), "\t%jdh %02jdm", seconds / 3600,
+        seconds / 60 % 60);
+    put_string(writer, duration);
+  }
+  put_char(writer, '\n');
+}
+
+struct error parse_log_time(const char* const str, const bool is_end, time_t*
+    const result) {
+  assert(NULL != str);
+  assert(NULL != result);
+
+  struct error error;
+  struct tm time;
+  error = parse_iso_8601_time(str, &time);
+  if (ERROR_BAD_TIME_STRING == error.code) {
+    char with_time[64];
+    snprintf(with_time, sizeof(with_time), "%.32sT00:00:00", str);
+    error = parse_iso_8601_time(with_time, &time);
+    if ((ERROR_NONE == error.code) && is_end) {
+      time.tm_mday += 1;
+      time.tm_isdst = -1;
+    }
+  }
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  count_profile(COUNTER_MKTIME_CALLS, 1);
+  *result = mktime(&time);
+  if (((time_t) -1) == *result) {
+    error.code = ERROR_INVALID_TIME;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+int print_stats(const struct config* const config) {
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  const char* const files[] = {
+    TASK_SHEET, TIME_SHEET, HOLIDAY_SHEET, TASK_INDEX, NAME_INDEX,
+    TIME_SNAPSHOT, TIME_INDEX
+  };
+  char paths[sizeof(files) / sizeof(files[0])][MAX_BUFFER];
+  for (size_t file_num = 0; file_num < sizeof(files) / sizeof(files[0]);
+      file_num++) {
+    snprintf(paths[file_num], MAX_BUFFER, "%s/%s", config->base_path,
+        files[file_num]);
+  }
+  static struct workspace_stats stats;
+  struct error error = scan_workspace_stats(paths[0], paths[1], &stats);
+  if (ERROR_FILE == error.code) {
+    printf("no such file %s\n", paths[0]);
+    return 1;
+  }
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  for (size_t file_num = 0; file_num < sizeof(files) / sizeof(files[0]);
+      file_num++) {
+    add_file_stats(&stats, files[file_num], paths[file_num]);
+  }
+
+  /* Past these, commands read less than the sheets hold without saying
+   * so. */
+  const intmax_t name_count = (intmax_t) (stats.task_sheet.row_count -
+      stats.duplicate_count);
+  add_limit_stats(&stats, "max_task", MAX_TASK, (intmax_t)
+      stats.task_sheet.row_count);
+  add_limit_stats(&stats, "max_loop", MAX_LOOP, (intmax_t)
+      stats.task_sheet.line_count);
+  add_limit_stats(&stats, "max_completion", MAX_COMPLETION, name_count);
+  add_limit_stats(&stats, "max_hash_entry", MAX_HASH_ENTRY, name_count);
+  add_limit_stats(&stats, "max_task_name", MAX_TASK_NAME, (intmax_t)
+      strlen(stats.longest_name));
+  add_limit_stats(&stats, "max_line", MAX_STATS_LINE - 1, (intmax_t)
+      ((stats.task_sheet.longest_line < stats.time_sheet.longest_line) ?
+       stats.time_sheet.longest_line : stats.task_sheet.longest_line));
+  add_limit_stats(&stats, "max_log_line", MAX_LOG_LINE, (intmax_t)
+      stats.time_sheet.line_count);
+
+  struct writer writer;
+  init_writer(&writer, stdout);
+  put_workspace_stats(&writer, &stats);
+  error = flush_writer(&writer);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
+
+int predict(const char* const filter, const bool by_team, const enum
+    output_format format, const struct config* const config) {
+  assert(NULL != filter);
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  struct error error;
+  struct task tasks[MAX_TASK];
+  size_t task_count;
+
+  char cache_path[MAX_BUFFER];
+  snprintf(cache_path, MAX_BUFFER, "%s/%s", config->base_path,
+      CACHE_DIRECTORY);
+  struct expression pattern;
+  set_profile_phase(PHASE_FILTER);
+  error = parse_cached_expression(filter, cache_path, &pattern);
+  if ((ERROR_NONE == error.code) && (1 < config->path_count)) {
+    error = load_workspace_tasks(&pattern, true, config, tasks, MAX_TASK,
+        &task_count);
+  } else if (ERROR_NONE == error.code) {
+    error = load_tasks(filter, &pattern, NULL, true, config, tasks, MAX_TASK,
+        &task_count);
+  }
+  if (ERROR_NONE != error.code) {
+    free_expression(&pattern);
+    print_error(&error);
+    return 1;
+  }
+
+  char holiday_sheet[MAX_BUFFER];
+  snprintf(holiday_sheet, MAX_BUFFER, "%s/%s", config->base_path,
+      HOLIDAY_SHEET);
+  error = print_forecast(tasks, task_count, &pattern, by_team, format,
+      holiday_sheet);
+  free_expression(&pattern);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
+
+struct error print_forecast(const struct task* const tasks, const size_t
+    task_count, const struct expression* const filter, const bool by_team,
+    const enum output_format format, const char* const holiday_sheet) {
+  assert(NULL != tasks);
+  assert(NULL != filter);
+  assert(NULL != holiday_sheet);
+
+  struct error error;
+  if (!by_team) {
+    struct prediction prediction;
+    error = predict_completion_date(tasks, task_count, filter, holiday_sheet,
+        &prediction);
+    if (ERROR_NONE == error.code) {
+      set_profile_phase(PHASE_OUTPUT);
+      print_prediction(format, &prediction);
+    }
+    return error;
+  }
+  struct team_forecast forecast;
+  error = forecast_team(tasks, task_count, holiday_sheet, &forecast);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  set_profile_phase(PHASE_OUTPUT);
+  if (OUTPUT_TEXT == format) {
+    print_team_forecast(&forecast);
+    return error;
+  }
+  struct writer writer;
+  init_writer(&writer, stdout);
+  put_team_forecast(&writer, format, &forecast);
+  return flush_writer(&writer);
+}
+
+int watch_prediction(const char* const filter, const bool by_team, const enum
+    output_format format, const struct config* const config) {
+  assert(NULL != filter);
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  struct error error;
+  char task_sheet[MAX_BUFFER];
+  char time_sheet[MAX_BUFFER];
+  char holiday_sheet[MAX_BUFFER];
+  char cache_path[MAX_BUFFER];
+  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
+  snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
+  snprintf(holiday_sheet, MAX_BUFFER, "%s/%s", config->base_path,
+      HOLIDAY_SHEET);
+  snprintf(cache_path, MAX_BUFFER, "%s/%s", config->base_path,
+      CACHE_DIRECTORY);
+
+  struct expression pattern;
+  error = parse_cached_expression(filter, cache_path, &pattern);
+  if (ERROR_NONE != error.code) {
+    free_expression(&pattern);
+    print_error(&error);
+    return 1;
+  }
+  struct directory_watch watch;
+  error = init_directory_watch(&watch, config->base_path);
+  if (ERROR_NONE != error.code) {
+    free_expression(&pattern);
+    print_error(&error);
+    return 1;
+  }
+
+  const char* const watched[] = { TASK_SHEET, TIME_SHEET, HOLIDAY_SHEET };
+  struct live_sheets live;
+  init_live_sheets(&live);
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    error = update_live_sheets(&live, task_sheet, time_sheet);
+    struct task* tasks = NULL;
+    size_t task_count = 0;
+    if (ERROR_NONE == error.code) {
+      error = get_live_tasks(&live, &pattern, &tasks, &task_count);
+    }
+    if (OUTPUT_TEXT == format) {
+      clear_screen();
+    }
+    if (ERROR_NONE == error.code) {
+      error = print_forecast(tasks, task_count, &pattern, by_team, format,
+          holiday_sheet);
+    }
+    free(tasks);
+    /* The sheets may be fixed by the next change, so keep watching. */
+    if (ERROR_NONE != error.code) {
+      print_error(&error);
+    }
+    fflush(stdout);
+    error = wait_for_change(&watch, watched, sizeof(watched) /
+        sizeof(watched[0]), WATCH_DEBOUNCE_MS);
+    if (ERROR_NONE != error.code) {
+      break;
+    }
+  }
+  free_live_sheets(&live);
+  free_directory_watch(&watch);
+  free_expression(&pattern);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
+
+bool parse_format_option(const int argc, char* argv[], int* const arg_num,
+    enum output_format* const format) {
+  assert(NULL != argv);
+  assert(NULL != arg_num);
+  assert(NULL != format);
+
+  struct error error;
+  if (*arg_num + 2 >= argc) {
+    error.code = ERROR_BAD_ARGUMENTS;
+    print_error(&error);
+    return false;
+  }
+  *arg_num += 1;
+  error = parse_output_format(argv[*arg_num + 1], format);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return false;
+  }
+  return true;
+}
+
+void print_prediction(const enum output_format format, const struct
+    prediction* const prediction) {
+  assert(NULL != prediction);
+
+  if (OUTPUT_TEXT == format) {
+    printf("%s", "mean completion time: ");
+    print_time(&prediction->mean_date);
+    printf("%s", "5% time: ");
+    print_time(&prediction->five_percent_date);
+    printf("%s", "95% time: ");
+    print_time(&prediction->ninety_five_percent_date);
+    return;
+  }
+
+  /* The same columns as the team forecast, with the mean in the middle. */
+  struct writer writer;
+  init_writer(&writer, stdout);
+  if (OUTPUT_JSON == format) {
+    put_string(&writer, "{\"tasks\":");
+    put_int(&writer, (intmax_t) prediction->task_count);
+    put_string(&writer, ",\"p5\":");
+    put_epoch_time(&writer, &prediction->five_percent_date);
+    put_string(&writer, ",\"mean\":");
+    put_epoch_time(&writer, &prediction->mean_date);
+    put_string(&writer, ",\"p95\":");
+    put_epoch_time(&writer, &prediction->ninety_five_percent_date);
+    put_string(&writer, "}\n");
+  } else {
+    put_int(&writer, (intmax_t) prediction->task_count);
+    put_char(&writer, '\t');
+    put_epoch_time(&writer, &prediction->five_percent_date);
+    put_char(&writer, '\t');
+    put_epoch_time(&writer, &prediction->mean_date);
+    put_char(&writer, '\t');
+    put_epoch_time(&writer, &prediction->ninety_five_percent_date);
+    put_char(&writer, '\n');
+  }
+  flush_writer(&writer);
+}
+
+int print_top_task(const bool show_elapsed, const enum output_format format,
+    const struct config* const config) {
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  char time_sheet[MAX_BUFFER];
+  char current_task[MAX_BUFFER];
+  snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
+  snprintf(current_task, MAX_BUFFER, "%s/%s", config->base_path,
+      CURRENT_TASK);
+
+  struct time_record record;
+  struct error error = read_current_task(current_task, time_sheet, &record);
+  if (ERROR_STALE_INDEX == error.code) {
+    uint64_t sheet_size;
+    error = read_last_time_record(time_sheet, &record, &sheet_size);
+    if (ERROR_NONE == error.code) {
+      write_current_task(current_task, &record, sheet_size);
+    }
+  }
+  if ((ERROR_END_OF_FILE == error.code) && (OUTPUT_TEXT != format)) {
+    return 0;
+  }
+  if (ERROR_END_OF_FILE == error.code) {
+    puts("no task found");
+    return 0;
+  }
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+
+  if ((OUTPUT_TEXT == format) && !show_elapsed) {
+    printf("%s\n", record.name);
+    return 0;
+  }
+  const time_t now = time(NULL);
+  if (-1 == now) {
+    error.code = ERROR_TIME_UNAVAILABLE;
+    print_error(&error);
+    return 1;
+  }
+  const intmax_t elapsed_seconds = (intmax_t) difftime(now, record.time);
+  if (OUTPUT_TEXT == format) {
+    printf("%s\t%jdh %02jdm\n", record.name, elapsed_seconds / 3600,
+        elapsed_seconds / 60 % 60);
+    return 0;
+  }
+
+  struct writer writer;
+  init_writer(&writer, stdout);
+  if (OUTPUT_JSON == format) {
+    put_string(&writer, "{\"name\":");
+    put_json_string(&writer, record.name);
+    put_string(&writer, ",\"start\":");
+    put_int(&writer, (intmax_t) record.time);
+    put_string(&writer, ",\"elapsed\":");
+    put_int(&writer, elapsed_seconds);
+    put_string(&writer, "}\n");
+  } else {
+    put_string(&writer, record.name);
+    put_char(&writer, '\t');
+    put_int(&writer, (intmax_t) record.time);
+    put_char(&writer, '\t');
+    put_int(&writer, elapsed_seconds);
+    put_char(&writer, '\n');
+  }
+  flush_writer(&writer);
+  return 0;
+}
+
+int import_sheet(const char* const file, const enum transfer_format format,
+    const bool is_time, const struct config* const config) {
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  struct error error;
+  char task_sheet[MAX_BUFFER];
+  char time_sheet[MAX_BUFFER];
+  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
+  snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
+
+  FILE* const fp = (NULL == file) ? stdin : fopen(file, "r");
+  if (NULL == fp) {
+    printf("fopen(%s): %s\n", file, strerror(errno));
+    return 1;
+  }
+  struct task_table table;
+  init_task_table(&table);
+  if (!is_time) {
+    error = read_task_table(task_sheet, &table);
+    if (ERROR_NONE != error.code) {
+      if (stdin != fp) {
+        fclose(fp);
+      }
+      free_task_table(&table);
+      print_error(&error);
+      return 1;
+    }
+  }
+
+  /* Bad lines are reported and skipped. */
+  struct time_record* records = NULL;
+  size_t record_count = 0;
+  size_t imported_count = 0;
+  size_t line_num = 0;
+  int result = 0;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    if (is_time) {
+      if (0 == (record_count & (record_count - 1))) {
+        struct time_record* const grown = realloc(records, 2 * (record_count
+              + 1) * sizeof(struct time_record));
+        if (NULL == grown) {
+          error.code = ERROR_OUT_OF_MEMORY;
+          break;
+        }
+        records = grown;
+      }
+      error = read_transfer_record(fp, format, &line_num,
+          &records[record_count]);
+      if (ERROR_NONE == error.code) {
+        record_count++;
+      }
+    } else {
+      struct task task;
+      error = read_transfer_task(fp, format, &line_num, &task);
+      if (ERROR_NONE == error.code) {
+        error = add_table_task(&table, &task);
+      }
+      if (ERROR_NONE == error.code) {
+        imported_count++;
+      }
+    }
+    if (ERROR_END_OF_FILE == error.code) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    if (ERROR_OUT_OF_MEMORY == error.code) {
+      break;
+    }
+    if (ERROR_NONE != error.code) {
+      printf("%zu\t%s\n", line_num, get_error_message(&error));
+      result = 1;
+    }
+  }
+  if (stdin != fp) {
+    fclose(fp);
+  }
+
+  if (ERROR_NONE == error.code) {
+    if (is_time) {
+      error = merge_time_records(time_sheet, records, record_count,
+          &imported_count);
+    } else if (0 < imported_count) {
+      error = write_task_table(&table, task_sheet);
+      if (ERROR_NONE == error.code) {
+        rebuild_task_indexes(config);
+      }
+    }
+  }
+  free(records);
+  free_task_table(&table);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  printf("imported %zu %s\n", imported_count, is_time ? "time records" :
+      "tasks");
+  return result;
+}
+
+int export_sheet(const enum transfer_format format, const bool is_time, const
+    struct config* const config) {
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  struct error error;
+  char sheet[MAX_BUFFER];
+  snprintf(sheet, MAX_BUFFER, "%s/%s", config->base_path, is_time ?
+      TIME_SHEET : TASK_SHEET);
+  FILE* const fp = fopen(sheet, "r");
+  if (NULL == fp) {
+    printf("fopen(%s): %s\n", sheet, strerror(errno));
+    return 1;
+  }
+
+  write_transfer_header(stdout, format, is_time);
+  error.code = ERROR_NONE;
+  size_t line_num = 0;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    if (is_time) {
+      struct time_record record;
+      error = read_transfer_record(fp, FORMAT_TSV, &line_num, &record);
+      if (ERROR_NONE == error.code) {
+        error = write_transfer_record(stdout, format, &record);
+      }
+    } else {
+      struct task task;
+      error = read_transfer_task(fp, FORMAT_TSV, &line_num, &task);
+      if (ERROR_NONE == error.code) {
+        error = write_transfer_task(stdout, format, &task);
+      }
+    }
+    if (ERROR_END_OF_FILE == error.code) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    if (ERROR_FILE == error.code) {
+      break;
+    }
+    /* Rows the sheet can't parse are reported on stderr so that they don't
+     * end up in the export. */
+    if (ERROR_NONE != error.code) {
+      fprintf(stderr, "%s:%zu: %s\n", sheet, line_num,
+          get_error_message(&error));
+    }
+  }
+  fclose(fp);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return 0;
+}
+
+struct error parse_transfer_options(char** const args, const int arg_count,
+    enum transfer_format* const format, bool* const is_time, const char**
+    const file) {
+  assert(NULL != args);
+  assert(NULL != format);
+  assert(NULL != is_time);
+
+  struct error error;
+  *format = FORMAT_TSV;
+  *is_time = false;
+  for (int arg_num = 0; arg_num < arg_count; arg_num++) {
+    if (0 == strcmp("--times", args[arg_num])) {
+      *is_time = true;
+      continue;
+    }
+    if (0 == strcmp("--format", args[arg_num])) {
+      if (arg_count <= arg_num + 1) {
+        error.code = ERROR_BAD_ARGUMENTS;
+        return error;
+      }
+      arg_num += 1;
+      error = parse_transfer_format(args[arg_num], format);
+      if (ERROR_NONE != error.code) {
+        return error;
+      }
+      continue;
+    }
+    if ((NULL == file) || (NULL != *file) || ('-' == args[arg_num][0] &&
+          '\0' != args[arg_num][1])) {
+      error.code = ERROR_BAD_ARGUMENTS;
+      return error;
+    }
+    if (0 != strcmp("-", args[arg_num])) {
+      *file = args[arg_num];
+    }
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error split_arguments(char* const line, char** const args, const
+    size_t max_arg, size_t* const arg_count) {
+  assert(NULL != line);
+  assert(NULL != args);
+  assert(NULL != arg_count);
+
+  struct error error;
+  *arg_count = 0;
+  char* c = line;
+  while ('\0' != *c) {
+    if (isspace((unsigned char) *c)) {
+      *c = '\0';
+      c++;
+      continue;
+    }
+    if (max_arg <= *arg_count) {
+      error.code = ERROR_BAD_ARGUMENTS;
+      return error;
+    }
+    args[*arg_count] = c;
+    *arg_count += 1;
+    while (('\0' != *c) && !isspace((unsigned char) *c)) {
+      c++;
+    }
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error run_batch_command(char* const* const args, const size_t
+    arg_count, struct task_table* const table, struct time_record** const
+    records, size_t* const record_count, bool* const is_table_changed) {
+  assert(NULL != args);
+  assert(0 < arg_count);
+  assert(NULL != table);
+  assert(NULL != records);
+  assert(NULL != record_count);
+  assert(NULL != is_table_changed);
+
+  struct error error;
+  enum command_type command_type;
+  error = parse_command_type(args[0], &command_type);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  if (arg_count < 2) {
+    error.code = ERROR_BAD_ARGUMENTS;
+    return error;
+  }
+  const char* const task_name = args[1];
+  intmax_t estimated_minutes = -1;
+  struct task* task;
+
+  if ((COMMAND_ADD == command_type) || (COMMAND_DO == command_type)) {
+    if ((COMMAND_ADD == command_type) && (3 != arg_count)) {
+      error.code = ERROR_BAD_ARGUMENTS;
+      return error;
+    }
+    if (3 < arg_count) {
+      error.code = ERROR_BAD_ARGUMENTS;
+      return error;
+    }
+    if (3 == arg_count) {
+      error = parse_int(args[2], 10, &estimated_minutes);
+      if (ERROR_NONE != error.code) {
+        return error;
+      }
+      if (estimated_minutes <= 0) {
+        error.code = ERROR_BAD_ARGUMENTS;
+        return error;
+      }
+    }
+    error = find_table_task(table, task_name, &task);
+    if ((ERROR_NONE == error.code) && (COMMAND_ADD == command_type)) {
+      error.code = ERROR_TASK_EXISTS;
+      return error;
+    }
+    if ((ERROR_NO_SUCH_TASK == error.code) && (0 < estimated_minutes)) {
+      struct task new_task;
+      new_task.estimated_seconds = estimated_minutes * 60;
+      new_task.actual_seconds = 0;
+      new_task.owner[0] = '\0';
+      strncpy(new_task.name, task_name, MAX_TASK_NAME);
+      new_task.name[MAX_TASK_NAME] = '\0';
+      new_task.status = STATUS_ACTIVE;
+      error = add_table_task(table, &new_task);
+      if (ERROR_NONE != error.code) {
+        return error;
+      }
+      *is_table_changed = true;
+    }
+    if ((ERROR_NONE != error.code) || (COMMAND_ADD == command_type)) {
+      return error;
+    }
+
+    /* Grow the records by doubling whenever the count reaches a power of
+     * two. */
+    if (0 == (*record_count & (*record_count - 1))) {
+      struct time_record* const grown = realloc(*records, 2 * (*record_count
+            + 1) * sizeof(struct time_record));
+      if (NULL == grown) {
+        error.code = ERROR_OUT_OF_MEMORY;
+        return error;
+      }
+      *records = grown;
+    }
+    struct time_record* const record = &(*records)[*record_count];
+    record->time = time(NULL);
+    if (-1 == record->time) {
+      error.code = ERROR_TIME_UNAVAILABLE;
+      return error;
+    }
+    strncpy(record->name, task_name, MAX_TASK_NAME);
+    record->name[MAX_TASK_NAME] = '\0';
+    *record_count += 1;
+    error.code = ERROR_NONE;
+    return error;
+  }
+
+  if ((COMMAND_TICK == command_type) || (COMMAND_UNTICK == command_type)) {
+    if (2 != arg_count) {
+      error.code = ERROR_BAD_ARGUMENTS;
+      return error;
+    }
+    error = find_table_task(table, task_name, &task);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    task->status = (COMMAND_TICK == command_type) ? STATUS_DONE :
+      STATUS_ACTIVE;
+    *is_table_changed = true;
+    return error;
+  }
+
+  if (COMMAND_ASSIGN == command_type) {
+    const char* const person = (3 == arg_count) ? args[2] : "";
+    if ((3 < arg_count) || (MAX_PERSON_NAME < strlen(person))) {
+      error.code = ERROR_BAD_ARGUMENTS;
+      return error;
+    }
+    error = find_table_task(table, task_name, &task);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    strcpy(task->owner, person);
+    *is_table_changed = true;
+    return error;
+  }
+
+  error.code = ERROR_UNKNOWN_COMMAND;
+  return error;
+}
+
+int run_batch(const char* const batch_file, const struct config* const
+    config) {
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  struct error error;
+  char task_sheet[MAX_BUFFER];
+  char time_sheet[MAX_BUFFER];
+  snprintf(task_sheet, MAX_BUFFER, "%s/%s", config->base_path, TASK_SHEET);
+  snprintf(time_sheet, MAX_BUFFER, "%s/%s", config->base_path, TIME_SHEET);
+  char current_task[MAX_BUFFER];
+  snprintf(current_task, MAX_BUFFER, "%s/%s", config->base_path,
+      CURRENT_TASK);
+  char time_index[MAX_BUFFER];
+  snprintf(time_index, MAX_BUFFER, "%s/%s", config->base_path, TIME_INDEX);
+
+  FILE* const fp = (NULL == batch_file) ? stdin : fopen(batch_file, "r");
+  if (NULL == fp) {
+    printf("fopen(%s): %s\n", batch_file, strerror(errno));
+    return 1;
+  }
+  struct task_table table;
+  init_task_table(&table);
+  error = read_task_table(task_sheet, &table);
+  if (ERROR_NONE != error.code) {
+    if (stdin != fp) {
+      fclose(fp);
+    }
+    free_task_table(&table);
+    print_error(&error);
+    return 1;
+  }
+
+  /* Failed commands are reported and skipped; the rest are committed. */
+  struct time_record* records = NULL;
+  size_t record_count = 0;
+  bool is_table_changed = false;
+  int result = 0;
+  for (size_t line_num = 1; line_num < MAX_LOOP; line_num++) {
+    char line[MAX_BUFFER];
+    size_t bytes_read;
+    error = get_line(fp, line, MAX_BUFFER, &bytes_read);
+    if ((ERROR_END_OF_FILE == error.code) && (0 == bytes_read)) {
+      break;
+    }
+    if (ERROR_BUFFER_LIMIT != error.code) {
+      char* args[MAX_BATCH_ARGUMENT];
+      size_t arg_count;
+      error = split_arguments(line, args, MAX_BATCH_ARGUMENT, &arg_count);
+      /* Skip blank lines and comments. */
+      if ((ERROR_NONE == error.code) && ((0 == arg_count) || ('#' ==
+              args[0][0]))) {
+        continue;
+      }
+      if (ERROR_NONE == error.code) {
+        error = run_batch_command(args, arg_count, &table, &records,
+            &record_count, &is_table_changed);
+      }
+    }
+    if (ERROR_NONE != error.code) {
+      result = 1;
+    }
+    printf("%zu\t%s\n", line_num, (ERROR_NONE == error.code) ? "ok" :
+        get_error_message(&error));
+  }
+  if (stdin != fp) {
+    fclose(fp);
+  }
+
+  /* Commit the tasks first so that the time records refer to tasks that
+   * exist. */
+  error.code = ERROR_NONE;
+  if (is_table_changed) {
+    error = write_task_table(&table, task_sheet);
+    if (ERROR_NONE == error.code) {
+      rebuild_task_indexes(config);
+    }
+  }
+  if ((ERROR_NONE == error.code) && (0 < record_count)) {
+    /* All the records go out in one append. A line is a time, a tab, a
+     * name and a new line. */
+    const size_t max_line = MAX_TASK_NAME + 64;
+    char* const lines = malloc(record_count * max_line);
+    size_t length = 0;
+    if (NULL == lines) {
+      error.code = ERROR_OUT_OF_MEMORY;
+    }
+    for (size_t record_num = 0; (ERROR_NONE == error.code) && (record_num <
+          record_count); record_num++) {
+      error = format_time_record(&records[record_num], &lines[length],
+          max_line - 1);
+      length += strlen(&lines[length]);
+      lines[length] = '\n';
+      length++;
+    }
+    uint64_t sheet_size;
+    if (ERROR_NONE == error.code) {
+      error = append_file(time_sheet, lines, length, &sheet_size);
+    }
+    free(lines);
+    if (ERROR_NONE == error.code) {
+      write_current_task(current_task, &records[record_count - 1],
+          sheet_size);
+      append_time_index(time_index, time_sheet, sheet_size - length,
+          sheet_size);
+    }
+  }
+  free(records);
+  free_task_table(&table);
+  if (ERROR_NONE != error.code) {
+    print_error(&error);
+    return 1;
+  }
+  return result;
+}
+
+int main(int argc, char** argv) {
+  struct config config;
+  config.base_path = NULL;
+  config.path_count = 0;
+
+  for (int arg_num = 1; arg_num < argc; arg_num++) {
+    enum config_type config_type;
+    struct error error = parse_config_type(argv[arg_num], &config_type);
+
+    // Parse configuration.
+    if (ERROR_NONE == error.code) {
+      if (CONFIG_PATH == config_type) {
+        if (argc <= arg_num + 1) {
+          printf("%s <path>\n", get_config_name(CONFIG_PATH));
+          return 1;
+        }
+        if (MAX_WORKSPACE <= config.path_count) {
+          printf("at most %d %s\n", MAX_WORKSPACE,
+              get_config_name(CONFIG_PATH));
+          return 1;
+        }
+        arg_num += 1;
+        config.base_paths[config.path_count] = argv[arg_num];
+        config.path_count++;
+        config.base_path = config.base_paths[0];
+        continue;
+      } else if (CONFIG_PROFILE == config_type) {
+        if (!is_profiling()) {
+          start_profile();
+          atexit(print_profile);
+        }
+        continue;
+      } else {
+        printf("%s is not supported\n", get_config_name(config_type));
+        return 1;
+      }
+    }
+
+    enum command_type command_type;
+    error = parse_command_type(argv[arg_num], &command_type);
+    if (ERROR_NONE != error.code) {
+      printf("unknown command or configuration %s\n", argv[arg_num]);
+      print_help();
+      return 1;
+    }
+    if (COMMAND_HELP == command_type) {
+      print_help();
+      return 0;
+    }
+    if (COMMAND_CONFIG == command_type) {
+      print_config(&config);
+      return 0;
+    }
+
+    if (NULL == config.base_path) {
+      puts("specify path with --path <path>");
+      return 1;
+    }
+    if ((1 < config.path_count) && (COMMAND_LIST != command_type) &&
+        (COMMAND_PREDICT != command_type) && (COMMAND_VELOCITY !=
+          command_type)) {
+      printf("%s takes a single --path\n", get_command_name(command_type));
+      return 1;
+    }
+
+    /* do only appends to the time sheet, unless it adds the task too. The
+     * lock is held until the process exits. */
+    enum lock_mode lock_mode = get_command_lock(command_type);
+    if ((COMMAND_DO == command_type) && (arg_num + 2 < argc)) {
+      lock_mode = LOCK_MODE_EXCLUSIVE;
+    }
+    char lock_file[MAX_BUFFER];
+    snprintf(lock_file, MAX_BUFFER, "%s/%s", config.base_path, LOCK_FILE);
+    int lock_fd;
+    error = acquire_lock(lock_file, lock_mode, &lock_fd);
+    if (ERROR_NONE != error.code) {
+      print_error(&error);
+      return 1;
     }
 
     if (COMMAND_LIST == command_type) {
       bool list_all = false;
-      if (arg_num + 1 < argc) {
+      enum output_format format = OUTPUT_TEXT;
+      while (arg_num + 1 < argc) {
         if (0 == strcmp("--all", argv[arg_num + 1])) {
           list_all = true;
+        } else if (0 == strcmp("--format", argv[arg_num + 1])) {
+          if (!parse_format_option(argc, argv, &arg_num, &format)) {
+            return 1;
+          }
+        } else {
+          break;
         }
         arg_num += 1;
       }
@@ -487,7 +2117,7 @@ int main(int argc, char** argv) {
         arg_num += 1;
         filter = argv[arg_num];
       }
-      return list_tasks(filter, list_all, &config);
+      return list_tasks(filter, list_all, format, &config);
     }
 
     if (COMMAND_DO == command_type) {
@@ -547,17 +2177,216 @@ int main(int argc, char** argv) {
       return untick_task(task_name, &config);
     }
 
+    if (COMMAND_ASSIGN == command_type) {
+      if (argc <= arg_num + 1) {
+        puts("usage: assign <task> [person]");
+        return 1;
+      }
+      arg_num += 1;
+      const char* const task_name = argv[arg_num];
+      const char* person = "";
+      if (arg_num + 1 < argc) {
+        arg_num += 1;
+        person = argv[arg_num];
+      }
+      return assign_task(task_name, person, &config);
+    }
+
     if (COMMAND_PREDICT == command_type) {
+      bool by_team = false;
+      bool is_watched = false;
+      enum output_format format = OUTPUT_TEXT;
+      while (arg_num + 1 < argc) {
+        if (0 == strcmp("--team", argv[arg_num + 1])) {
+          by_team = true;
+        } else if (0 == strcmp("--watch", argv[arg_num + 1])) {
+          is_watched = true;
+        } else if (0 == strcmp("--format", argv[arg_num + 1])) {
+          if (!parse_format_option(argc, argv, &arg_num, &format)) {
+            return 1;
+          }
+        } else {
+          break;
+        }
+        arg_num += 1;
+      }
       const char* filter = "";
       if (arg_num + 1 < argc) {
         arg_num += 1;
         filter = argv[arg_num];
       }
-      return predict(filter, &config);
+      if (is_watched && (1 < config.path_count)) {
+        puts("predict --watch takes a single --path");
+        return 1;
+      }
+      if (is_watched) {
+        return watch_prediction(filter, by_team, format, &config);
+      }
+      return predict(filter, by_team, format, &config);
+    }
+
+    if (COMMAND_COMPLETE == command_type) {
+      bool list_all = false;
+      if ((arg_num + 1 < argc) && (0 == strcmp("--all", argv[arg_num + 1]))) {
+        list_all = true;
+        arg_num += 1;
+      }
+      const char* prefix = "";
+      if (arg_num + 1 < argc) {
+        arg_num += 1;
+        prefix = argv[arg_num];
+      }
+      return complete_task_name(prefix, list_all, &config);
     }
 
     if (COMMAND_TOP == command_type) {
-      return print_top_task(&config);
+      bool show_elapsed = false;
+      enum output_format format = OUTPUT_TEXT;
+      while (arg_num + 1 < argc) {
+        if (0 == strcmp("--elapsed", argv[arg_num + 1])) {
+          show_elapsed = true;
+        } else if (0 == strcmp("--format", argv[arg_num + 1])) {
+          if (!parse_format_option(argc, argv, &arg_num, &format)) {
+            return 1;
+          }
+        } else {
+          break;
+        }
+        arg_num += 1;
+      }
+      return print_top_task(show_elapsed, format, &config);
+    }
+
+    if (COMMAND_BATCH == command_type) {
+      const char* batch_file = NULL;
+      if ((arg_num + 1 < argc) && (0 != strcmp("-", argv[arg_num + 1]))) {
+        batch_file = argv[arg_num + 1];
+      }
+      return run_batch(batch_file, &config);
+    }
+
+    if ((COMMAND_IMPORT == command_type) || (COMMAND_EXPORT ==
+          command_type)) {
+      enum transfer_format format;
+      bool is_time;
+      const char* file = NULL;
+      error = parse_transfer_options(&argv[arg_num + 1], argc - arg_num - 1,
+          &format, &is_time, (COMMAND_IMPORT == command_type) ? &file :
+          NULL);
+      if (ERROR_NONE != error.code) {
+        print_error(&error);
+        printf("usage: %s [--times] [--format tsv|csv|jsonl]%s\n",
+            get_command_name(command_type), (COMMAND_IMPORT == command_type)
+            ? " [file]" : "");
+        return 1;
+      }
+      if (COMMAND_IMPORT == command_type) {
+        return import_sheet(file, format, is_time, &config);
+      }
+      return export_sheet(format, is_time, &config);
+    }
+
+    if (COMMAND_RM == command_type) {
+      if ((argc <= arg_num + 1) || ('\0' == argv[arg_num + 1][0])) {
+        puts("usage: rm <task|filter>");
+        return 1;
+      }
+      arg_num += 1;
+      return remove_tasks(argv[arg_num], &config);
+    }
+
+    if (COMMAND_GC == command_type) {
+      return collect_time_sheet(&config);
+    }
+
+    if (COMMAND_VELOCITY == command_type) {
+      enum output_format format = OUTPUT_TEXT;
+      while ((arg_num + 1 < argc) && (0 == strcmp("--format", argv[arg_num +
+              1]))) {
+        if (!parse_format_option(argc, argv, &arg_num, &format)) {
+          return 1;
+        }
+        arg_num += 1;
+      }
+      const char* filter = "";
+      if (arg_num + 1 < argc) {
+        arg_num += 1;
+        filter = argv[arg_num];
+      }
+      return print_velocity(filter, format, &config);
+    }
+
+    if (COMMAND_REPORT == command_type) {
+      enum report_period period = REPORT_WEEK;
+      enum output_format format = OUTPUT_TEXT;
+      while (arg_num + 1 < argc) {
+        if (0 == strcmp("--by", argv[arg_num + 1])) {
+          if (arg_num + 2 >= argc) {
+            puts("usage: report [--by day|week|month] [--format text|tsv|json]"
+                " [filter]");
+            return 1;
+          }
+          arg_num += 1;
+          error = parse_report_period(argv[arg_num + 1], &period);
+          if (ERROR_NONE != error.code) {
+            print_error(&error);
+            return 1;
+          }
+        } else if (0 == strcmp("--format", argv[arg_num + 1])) {
+          if (!parse_format_option(argc, argv, &arg_num, &format)) {
+            return 1;
+          }
+        } else {
+          break;
+        }
+        arg_num += 1;
+      }
+      const char* filter = "";
+      if (arg_num + 1 < argc) {
+        arg_num += 1;
+        filter = argv[arg_num];
+      }
+      return report_time(filter, period, format, &config);
+    }
+
+    if (COMMAND_LOG == command_type) {
+      time_t from = 0;
+      time_t to = (time_t) INT64_MAX;
+      enum output_format format = OUTPUT_TEXT;
+      while (arg_num + 1 < argc) {
+        const bool is_from = (0 == strcmp("--from", argv[arg_num + 1]));
+        if (is_from || (0 == strcmp("--to", argv[arg_num + 1]))) {
+          if (arg_num + 2 >= argc) {
+            puts("usage: log [--from <time>] [--to <time>] [--format"
+                " text|tsv|json] [filter]");
+            return 1;
+          }
+          arg_num += 1;
+          error = parse_log_time(argv[arg_num + 1], !is_from, is_from ? &from
+              : &to);
+          if (ERROR_NONE != error.code) {
+            print_error(&error);
+            return 1;
+          }
+        } else if (0 == strcmp("--format", argv[arg_num + 1])) {
+          if (!parse_format_option(argc, argv, &arg_num, &format)) {
+            return 1;
+          }
+        } else {
+          break;
+        }
+        arg_num += 1;
+      }
+      const char* filter = "";
+      if (arg_num + 1 < argc) {
+        arg_num += 1;
+        filter = argv[arg_num];
+      }
+      return print_time_log(filter, from, to, format, &config);
+    }
+
+    if (COMMAND_STATS == command_type) {
+      return print_stats(&config);
     }
 
     printf("unsupported command %s\n", get_command_name(command_type));
@@ -0,0 +1,255 @@
+#include "matcher.h"
+#include "error.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Marks a transition that is not in the trie yet. */
+static const uint32_t MISSING_STATE = UINT32_MAX;
+
+/* Build the trie of the patterns. Return the number of states. */
+static size_t build_trie(const char* const* patterns, const size_t*
+    pattern_lengths, size_t pattern_count, struct matcher*, uint32_t*
+    terminal_patterns);
+
+/* Fold the failure links into the transitions and collect the outputs. */
+static struct error link_trie(struct matcher*, const uint32_t*
+    terminal_patterns);
+
+size_t get_matcher_words(const size_t pattern_count) {
+  return (pattern_count + MATCHER_WORD_BITS - 1) / MATCHER_WORD_BITS;
+}
+
+void init_matcher(struct matcher* const matcher) {
+  assert(NULL != matcher);
+  matcher->pattern_count = 0;
+  matcher->state_count = 0;
+  matcher->class_count = 0;
+  memset(matcher->classes, 0, sizeof(matcher->classes));
+  matcher->transitions = NULL;
+  matcher->output_offsets = NULL;
+  matcher->outputs = NULL;
+}
+
+void free_matcher(struct matcher* const matcher) {
+  assert(NULL != matcher);
+  free(matcher->transitions);
+  free(matcher->output_offsets);
+  free(matcher->outputs);
+  init_matcher(matcher);
+}
+
+size_t build_trie(const char* const* const patterns, const size_t* const
+    pattern_lengths, const size_t pattern_count, struct matcher* const
+    matcher, uint32_t* const terminal_patterns) {
+  size_t state_count = 1;
+  terminal_patterns[0] = MISSING_STATE;
+  for (size_t pattern_num = 0; pattern_num < pattern_count; pattern_num++) {
+    size_t state = 0;
+    for (size_t char_num = 0; char_num < pattern_lengths[pattern_num];
+        char_num++) {
+      const size_t byte_class = matcher->classes[(unsigned char)
+        patterns[pattern_num][char_num]];
+      uint32_t* const next = &matcher->transitions[state *
+        matcher->class_count + byte_class];
+      if (MISSING_STATE == *next) {
+        *next = (uint32_t) state_count;
+        terminal_patterns[state_count] = MISSING_STATE;
+        state_count++;
+      }
+      state = *next;
+    }
+    // Patterns are distinct, so each ends at its own state.
+    assert(MISSING_STATE == terminal_patterns[state]);
+    terminal_patterns[state] = (uint32_t) pattern_num;
+  }
+  return state_count;
+}
+
+struct error link_trie(struct matcher* const matcher, const uint32_t* const
+    terminal_patterns) {
+  struct error error;
+  const size_t class_count = matcher->class_count;
+  uint32_t* const transitions = matcher->transitions;
+  uint32_t* const failures = malloc(matcher->state_count * sizeof(uint32_t));
+  uint32_t* const queue = malloc(matcher->state_count * sizeof(uint32_t));
+  uint32_t* const output_counts = malloc(matcher->state_count *
+      sizeof(uint32_t));
+  matcher->output_offsets = malloc((matcher->state_count + 1) *
+      sizeof(uint32_t));
+  if ((NULL == failures) || (NULL == queue) || (NULL == output_counts) ||
+      (NULL == matcher->output_offsets)) {
+    free(failures);
+    free(queue);
+    free(output_counts);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+
+  /* Visit the states breadth first so that failures are done before the
+   * states that fail to them. */
+  size_t queue_length = 0;
+  failures[0] = 0;
+  for (size_t byte_class = 0; byte_class < class_count; byte_class++) {
+    uint32_t* const next = &transitions[byte_class];
+    if (MISSING_STATE == *next) {
+      *next = 0;
+      continue;
+    }
+    failures[*next] = 0;
+    queue[queue_length] = *next;
+    queue_length++;
+  }
+  for (size_t queue_num = 0; queue_num < queue_length; queue_num++) {
+    const size_t state = queue[queue_num];
+    const size_t failure = failures[state];
+    for (size_t byte_class = 0; byte_class < class_count; byte_class++) {
+      uint32_t* const next = &transitions[state * class_count + byte_class];
+      const uint32_t failure_next = transitions[failure * class_count +
+        byte_class];
+      if (MISSING_STATE == *next) {
+        *next = failure_next;
+        continue;
+      }
+      failures[*next] = failure_next;
+      queue[queue_length] = *next;
+      queue_length++;
+    }
+  }
+
+  /* A state outputs its own pattern and everything its failure outputs. */
+  size_t output_count = 0;
+  output_counts[0] = 0;
+  for (size_t queue_num = 0; queue_num < queue_length; queue_num++) {
+    const size_t state = queue[queue_num];
+    output_counts[state] = output_counts[failures[state]] +
+      ((MISSING_STATE == terminal_patterns[state]) ? 0 : 1);
+  }
+  for (size_t state = 0; state < matcher->state_count; state++) {
+    matcher->output_offsets[state] = (uint32_t) output_count;
+    output_count += output_counts[state];
+  }
+  matcher->output_offsets[matcher->state_count] = (uint32_t) output_count;
+  matcher->outputs = malloc((0 == output_count ? 1 : output_count) *
+      sizeof(uint32_t));
+  if ((NULL == matcher->outputs) || (UINT32_MAX <= output_count)) {
+    free(failures);
+    free(queue);
+    free(output_counts);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (size_t queue_num = 0; queue_num < queue_length; queue_num++) {
+    const size_t state = queue[queue_num];
+    const size_t failure = failures[state];
+    size_t offset = matcher->output_offsets[state];
+    if (MISSING_STATE != terminal_patterns[state]) {
+      matcher->outputs[offset] = terminal_patterns[state];
+      offset++;
+    }
+    memcpy(&matcher->outputs[offset],
+        &matcher->outputs[matcher->output_offsets[failure]],
+        output_counts[failure] * sizeof(uint32_t));
+  }
+
+  free(failures);
+  free(queue);
+  free(output_counts);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error build_matcher(const char* const* const patterns, const size_t*
+    const pattern_lengths, const size_t pattern_count, struct matcher* const
+    matcher) {
+  assert(NULL != patterns);
+  assert(NULL != pattern_lengths);
+  assert(NULL != matcher);
+
+  struct error error;
+  free_matcher(matcher);
+  matcher->pattern_count = pattern_count;
+  if (0 == pattern_count) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+
+  /* Number the bytes used by the patterns. Class 0 is every other byte. */
+  size_t max_state = 1;
+  matcher->class_count = 1;
+  for (size_t pattern_num = 0; pattern_num < pattern_count; pattern_num++) {
+    assert(0 < pattern_lengths[pattern_num]);
+    max_state += pattern_lengths[pattern_num];
+    for (size_t char_num = 0; char_num < pattern_lengths[pattern_num];
+        char_num++) {
+      uint8_t* const byte_class = &matcher->classes[(unsigned char)
+        patterns[pattern_num][char_num]];
+      if (0 == *byte_class) {
+        *byte_class = (uint8_t) matcher->class_count;
+        matcher->class_count++;
+      }
+    }
+  }
+  if (UINT32_MAX <= max_state) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+
+  matcher->transitions = malloc(max_state * matcher->class_count *
+      sizeof(uint32_t));
+  uint32_t* const terminal_patterns = malloc(max_state * sizeof(uint32_t));
+  if ((NULL == matcher->transitions) || (NULL == terminal_patterns)) {
+    free(terminal_patterns);
+    free_matcher(matcher);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (size_t transition_num = 0; transition_num < max_state *
+      matcher->class_count; transition_num++) {
+    matcher->transitions[transition_num] = MISSING_STATE;
+  }
+
+  matcher->state_count = build_trie(patterns, pattern_lengths, pattern_count,
+      matcher, terminal_patterns);
+  error = link_trie(matcher, terminal_patterns);
+  free(terminal_patterns);
+  if (ERROR_NONE != error.code) {
+    free_matcher(matcher);
+    return error;
+  }
+
+  /* Give back the states that shared prefixes saved. */
+  uint32_t* const transitions = realloc(matcher->transitions,
+      matcher->state_count * matcher->class_count * sizeof(uint32_t));
+  if (NULL != transitions) {
+    matcher->transitions = transitions;
+  }
+  return error;
+}
+
+void scan_matcher(const struct matcher* const matcher, const char* const
+    subject, uint64_t* const found) {
+  assert(NULL != matcher);
+  assert(NULL != subject);
+  assert(NULL != found);
+
+  if (0 == matcher->pattern_count) {
+    return;
+  }
+  const uint32_t* const transitions = matcher->transitions;
+  const uint32_t* const output_offsets = matcher->output_offsets;
+  const size_t class_count = matcher->class_count;
+  size_t state = 0;
+  for (const char* c = subject; '\0' != *c; c++) {
+    state = transitions[state * class_count +
+      matcher->classes[(unsigned char) *c]];
+    for (uint32_t output_num = output_offsets[state]; output_num <
+        output_offsets[state + 1]; output_num++) {
+      const uint32_t pattern = matcher->outputs[output_num];
+      found[pattern / MATCHER_WORD_BITS] |= (uint64_t) 1 << (pattern %
+          MATCHER_WORD_BITS);
+    }
+  }
+}
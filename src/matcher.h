@@ -0,0 +1,46 @@
+#ifndef _ebs_matcher_h_
+#define _ebs_matcher_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+  MATCHER_WORD_BITS = 64
+};
+
+/* An Aho-Corasick automaton that finds which of a set of patterns occur in a
+ * subject in a single pass. Bytes that appear in no pattern share one class
+ * so that the transition table stays small. */
+struct matcher {
+  size_t pattern_count;
+  size_t state_count;
+  size_t class_count;
+  uint8_t classes[256];
+  /* state_count * class_count transitions, with failures folded in. */
+  uint32_t* transitions;
+  /* The patterns ending at state s are outputs[output_offsets[s]] up to
+   * outputs[output_offsets[s + 1]]. */
+  uint32_t* output_offsets;
+  uint32_t* outputs;
+};
+
+/* Get the number of words in a bitmask over the patterns. */
+size_t get_matcher_words(size_t pattern_count);
+
+/* Initialize an empty matcher that matches nothing. */
+void init_matcher(struct matcher*);
+
+/* Release the memory of a matcher. */
+void free_matcher(struct matcher*);
+
+/* Build the automaton for the patterns. The patterns must not be empty.
+ * Return ERROR_OUT_OF_MEMORY if the automaton doesn't fit in memory. */
+struct error build_matcher(const char* const* patterns, const size_t*
+    pattern_lengths, size_t pattern_count, struct matcher*);
+
+/* Set bit i of found for every pattern i contained in the subject. found must
+ * hold get_matcher_words(pattern_count) words and is not cleared first. */
+void scan_matcher(const struct matcher*, const char* subject, uint64_t*
+    found);
+
+#endif
@@ -20,15 +20,15 @@ double simulate_completion_time(const double* velocities, const size_t
 	for (estimated_times_index = 0;
 			estimated_times_index < estimated_times_length;
 			estimated_times_index++) {
-		size_t random_velocities_index = (size_t) random_from_range(0,
-        (int) velocities_length);
-
     // If we don't have data, use the estimate directly.
     if (0 == velocities_length) {
       predicted_completion_time += estimated_times[estimated_times_index];
       continue;
     }
 
+		size_t random_velocities_index = (size_t) random_from_range(0,
+        (int) velocities_length - 1);
+
 		predicted_completion_time += estimated_times[estimated_times_index] /
 			velocities[random_velocities_index];
 	}
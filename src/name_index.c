@@ -0,0 +1,434 @@
+#include "name_index.h"
+#include "error.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  MAX_INDEX_PATH = 4096,
+  MAX_LOOP = 1000000
+};
+
+static const char NAME_INDEX_MAGIC[8] = {'e', 'b', 's', 'n', 'a', 'm', '1',
+  '\n'};
+
+/* The header of the index file. It is followed by name_count entries sorted
+ * by status and name, the pool_size bytes of the names, and delta_count names
+ * appended since the index was built. */
+struct name_header {
+  char magic[8];
+  uint64_t sheet_size;
+  int64_t sheet_modified;
+  uint64_t name_count;
+  uint64_t pool_size;
+  uint64_t delta_count;
+};
+
+/* A name in the sorted part of the index. start is its offset in the pool. */
+struct name_entry {
+  uint64_t start;
+  uint32_t length;
+  uint32_t status;
+};
+
+/* A name with its status. This is how appended names are stored, and how
+ * names are returned by queries. */
+struct name_delta {
+  uint32_t status;
+  char name[MAX_TASK_NAME + 1];
+};
+
+/* An entry and its name while the index is built. */
+struct build_entry {
+  struct name_entry entry;
+  const char* name;
+};
+
+/* An open index. */
+struct name_reader {
+  FILE* fp;
+  struct name_header header;
+};
+
+/* Compare entries by status and then by name for qsort. */
+static int compare_build_entries(const void*, const void*);
+
+/* Compare names by status and then by name for qsort. */
+static int compare_name_deltas(const void*, const void*);
+
+/* Open an index and check that it is up to date with the sheet. */
+static struct error open_name_index(const char* index_file, const char* sheet,
+    struct name_reader*);
+
+/* Read the name of the entry at the given position of the sorted part. */
+static struct error read_name_entry(struct name_reader*, uint64_t entry_num,
+    struct name_delta*);
+
+/* Add the names with the status and prefix from the sorted part to names,
+ * stopping once name_count reaches max_name. */
+static struct error find_status_completions(struct name_reader*, enum
+    task_status, const char* prefix, struct name_delta* names, size_t
+    max_name, size_t* name_count);
+
+int compare_build_entries(const void* const first, const void* const second) {
+  const struct build_entry* const first_entry = first;
+  const struct build_entry* const second_entry = second;
+  if (first_entry->entry.status != second_entry->entry.status) {
+    return (first_entry->entry.status > second_entry->entry.status) ? 1 : -1;
+  }
+  const uint32_t first_length = first_entry->entry.length;
+  const uint32_t second_length = second_entry->entry.length;
+  const int order = memcmp(first_entry->name, second_entry->name,
+      (first_length < second_length) ? first_length : second_length);
+  if (0 != order) {
+    return order;
+  }
+  return (first_length > second_length) - (first_length < second_length);
+}
+
+int compare_name_deltas(const void* const first, const void* const second) {
+  const struct name_delta* const first_name = first;
+  const struct name_delta* const second_name = second;
+  if (first_name->status != second_name->status) {
+    return (first_name->status > second_name->status) ? 1 : -1;
+  }
+  return strcmp(first_name->name, second_name->name);
+}
+
+struct error build_name_index(const char* const index_file, const char* const
+    sheet) {
+  assert(NULL != index_file);
+  assert(NULL != sheet);
+
+  struct error error;
+  struct sheet_stamp stamp;
+  error = get_sheet_stamp(sheet, &stamp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  FILE* const fp = fopen(sheet, "r");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+
+  /* Names are collected in a pool and only pointed to once it stops
+   * growing. */
+  size_t pool_size = 0;
+  size_t pool_capacity = 4096;
+  char* pool = malloc(pool_capacity);
+  size_t entry_count = 0;
+  size_t entry_capacity = 256;
+  struct build_entry* entries = malloc(entry_capacity * sizeof(struct
+        build_entry));
+  error.code = ((NULL == pool) || (NULL == entries)) ? ERROR_OUT_OF_MEMORY :
+    ERROR_NONE;
+  for (size_t loop_num = 0; (ERROR_NONE == error.code) && (loop_num <
+        MAX_LOOP); loop_num++) {
+    struct task task;
+    error = read_task(fp, &task);
+    if (ERROR_END_OF_FILE == error.code) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    if (ERROR_NONE != error.code) {
+      // Rows that don't parse are skipped by readers too.
+      error.code = ERROR_NONE;
+      continue;
+    }
+    const size_t length = strlen(task.name);
+    if (pool_capacity < pool_size + length) {
+      pool_capacity = 2 * pool_capacity + length;
+      char* const grown = realloc(pool, pool_capacity);
+      if (NULL == grown) {
+        error.code = ERROR_OUT_OF_MEMORY;
+        break;
+      }
+      pool = grown;
+    }
+    if (entry_capacity == entry_count) {
+      entry_capacity = 2 * entry_capacity;
+      struct build_entry* const grown = realloc(entries, entry_capacity *
+          sizeof(struct build_entry));
+      if (NULL == grown) {
+        error.code = ERROR_OUT_OF_MEMORY;
+        break;
+      }
+      entries = grown;
+    }
+    memcpy(&pool[pool_size], task.name, length);
+    entries[entry_count].entry.start = pool_size;
+    entries[entry_count].entry.length = (uint32_t) length;
+    entries[entry_count].entry.status = (uint32_t) task.status;
+    entry_count++;
+    pool_size += length;
+  }
+  fclose(fp);
+  if (ERROR_NONE != error.code) {
+    free(pool);
+    free(entries);
+    return error;
+  }
+  for (size_t entry_num = 0; entry_num < entry_count; entry_num++) {
+    entries[entry_num].name = &pool[entries[entry_num].entry.start];
+  }
+  qsort(entries, entry_count, sizeof(struct build_entry),
+      compare_build_entries);
+
+  struct name_header header;
+  memcpy(header.magic, NAME_INDEX_MAGIC, sizeof(NAME_INDEX_MAGIC));
+  header.sheet_size = stamp.size;
+  header.sheet_modified = stamp.modified;
+  header.name_count = entry_count;
+  header.pool_size = pool_size;
+  header.delta_count = 0;
+
+  char temp_file[MAX_INDEX_PATH + 8];
+  snprintf(temp_file, sizeof(temp_file), "%s.tmp", index_file);
+  FILE* const out = fopen(temp_file, "wb");
+  if (NULL == out) {
+    free(pool);
+    free(entries);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  bool is_written = (1 == fwrite(&header, sizeof(header), 1, out));
+  for (size_t entry_num = 0; is_written && (entry_num < entry_count);
+      entry_num++) {
+    is_written = (1 == fwrite(&entries[entry_num].entry, sizeof(struct
+            name_entry), 1, out));
+  }
+  is_written = is_written && (pool_size == fwrite(pool, 1, pool_size, out));
+  is_written = (0 == fclose(out)) && is_written;
+  free(pool);
+  free(entries);
+  if (!is_written || (0 != rename(temp_file, index_file))) {
+    remove(temp_file);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error append_name_index(const char* const index_file, const char*
+    const sheet, const struct sheet_stamp* const previous, const struct task*
+    const task) {
+  assert(NULL != index_file);
+  assert(NULL != sheet);
+  assert(NULL != previous);
+  assert(NULL != task);
+
+  struct error error;
+  error.code = ERROR_STALE_INDEX;
+  FILE* const fp = fopen(index_file, "r+b");
+  if (NULL == fp) {
+    return error;
+  }
+  struct name_header header;
+  struct sheet_stamp stamp;
+  if ((1 != fread(&header, sizeof(header), 1, fp)) || (0 !=
+        memcmp(header.magic, NAME_INDEX_MAGIC, sizeof(NAME_INDEX_MAGIC))) ||
+      (previous->size != header.sheet_size) || (previous->modified !=
+        header.sheet_modified) || (MAX_NAME_DELTA <= header.delta_count) ||
+      (previous->size < header.name_count) || (previous->size <
+        header.pool_size) || (ERROR_NONE != get_sheet_stamp(sheet,
+            &stamp).code)) {
+    fclose(fp);
+    return error;
+  }
+
+  /* Write the name before the header that makes it count. */
+  struct name_delta delta;
+  memset(&delta, 0, sizeof(delta));
+  delta.status = (uint32_t) task->status;
+  strncpy(delta.name, task->name, MAX_TASK_NAME);
+  const long delta_start = (long) (sizeof(struct name_header) +
+      header.name_count * sizeof(struct name_entry) + header.pool_size +
+      header.delta_count * sizeof(struct name_delta));
+  bool is_written = (0 == fseek(fp, delta_start, SEEK_SET)) && (1 ==
+      fwrite(&delta, sizeof(delta), 1, fp));
+  header.sheet_size = stamp.size;
+  header.sheet_modified = stamp.modified;
+  header.delta_count++;
+  is_written = is_written && (0 == fflush(fp)) && (0 == fseek(fp, 0,
+        SEEK_SET)) && (1 == fwrite(&header, sizeof(header), 1, fp));
+  is_written = (0 == fclose(fp)) && is_written;
+  error.code = is_written ? ERROR_NONE : ERROR_STALE_INDEX;
+  return error;
+}
+
+struct error open_name_index(const char* const index_file, const char* const
+    sheet, struct name_reader* const reader) {
+  struct error error;
+  struct sheet_stamp stamp;
+  error = get_sheet_stamp(sheet, &stamp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  error.code = ERROR_STALE_INDEX;
+  reader->fp = fopen(index_file, "rb");
+  if (NULL == reader->fp) {
+    return error;
+  }
+  const struct name_header* const header = &reader->header;
+  if ((1 != fread(&reader->header, sizeof(reader->header), 1, reader->fp)) ||
+      (0 != memcmp(header->magic, NAME_INDEX_MAGIC,
+                   sizeof(NAME_INDEX_MAGIC))) || (stamp.size !=
+        header->sheet_size) || (stamp.modified != header->sheet_modified) ||
+      (MAX_NAME_DELTA < header->delta_count) || (stamp.size <
+        header->name_count) || (stamp.size < header->pool_size)) {
+    fclose(reader->fp);
+    reader->fp = NULL;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error read_name_entry(struct name_reader* const reader, const uint64_t
+    entry_num, struct name_delta* const name) {
+  struct error error;
+  error.code = ERROR_STALE_INDEX;
+  struct name_entry entry;
+  const long entry_start = (long) (sizeof(struct name_header) + entry_num *
+      sizeof(struct name_entry));
+  if ((0 != fseek(reader->fp, entry_start, SEEK_SET)) || (1 != fread(&entry,
+          sizeof(entry), 1, reader->fp)) || (MAX_TASK_NAME < entry.length) ||
+      (reader->header.pool_size < entry.start + entry.length) || (MAX_STATUS
+        <= entry.status)) {
+    return error;
+  }
+  const long name_start = (long) (sizeof(struct name_header) +
+      reader->header.name_count * sizeof(struct name_entry) + entry.start);
+  if ((0 != fseek(reader->fp, name_start, SEEK_SET)) || (entry.length !=
+        fread(name->name, 1, entry.length, reader->fp))) {
+    return error;
+  }
+  name->name[entry.length] = '\0';
+  name->status = entry.status;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error find_status_completions(struct name_reader* const reader, const
+    enum task_status status, const char* const prefix, struct name_delta*
+    const names, const size_t max_name, size_t* const name_count) {
+  struct error error;
+  error.code = ERROR_NONE;
+
+  /* Find the first name of the status that isn't before the prefix. */
+  uint64_t low = 0;
+  uint64_t high = reader->header.name_count;
+  while (low < high) {
+    const uint64_t middle = low + (high - low) / 2;
+    struct name_delta name;
+    error = read_name_entry(reader, middle, &name);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    int order = strcmp(name.name, prefix);
+    if (name.status != (uint32_t) status) {
+      order = (name.status < (uint32_t) status) ? -1 : 1;
+    }
+    if (order < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  const size_t prefix_length = strlen(prefix);
+  for (uint64_t entry_num = low; (*name_count < max_name) && (entry_num <
+        reader->header.name_count); entry_num++) {
+    struct name_delta* const name = &names[*name_count];
+    error = read_name_entry(reader, entry_num, name);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    if ((status != name->status) || (0 != strncmp(prefix, name->name,
+            prefix_length))) {
+      break;
+    }
+    (*name_count)++;
+  }
+  return error;
+}
+
+struct error find_name_completions(const char* const index_file, const char*
+    const sheet, const char* const prefix, const bool active_only, char
+    (* const names)[MAX_TASK_NAME + 1], const size_t max_name, size_t* const
+    name_count) {
+  assert(NULL != index_file);
+  assert(NULL != sheet);
+  assert(NULL != prefix);
+  assert(NULL != names);
+  assert(NULL != name_count);
+
+  struct error error;
+  *name_count = 0;
+  struct name_reader reader;
+  error = open_name_index(index_file, sheet, &reader);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+
+  /* Take up to max_name names of each status from the sorted part and every
+   * appended name that matches, then rank them together. */
+  const size_t delta_count = (size_t) reader.header.delta_count;
+  struct name_delta* const candidates = malloc((2 * max_name + delta_count +
+        1) * sizeof(struct name_delta));
+  if (NULL == candidates) {
+    fclose(reader.fp);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  size_t candidate_count = 0;
+  const enum task_status last_status = active_only ? STATUS_ACTIVE :
+    STATUS_DONE;
+  for (enum task_status status = STATUS_ACTIVE; (ERROR_NONE == error.code) &&
+      (status <= last_status); status++) {
+    size_t status_count = 0;
+    error = find_status_completions(&reader, status, prefix,
+        &candidates[candidate_count], max_name, &status_count);
+    candidate_count += status_count;
+  }
+  const long delta_start = (long) (sizeof(struct name_header) +
+      reader.header.name_count * sizeof(struct name_entry) +
+      reader.header.pool_size);
+  if ((ERROR_NONE == error.code) && (0 != fseek(reader.fp, delta_start,
+          SEEK_SET))) {
+    error.code = ERROR_STALE_INDEX;
+  }
+  const size_t prefix_length = strlen(prefix);
+  for (size_t delta_num = 0; (ERROR_NONE == error.code) && (delta_num <
+        delta_count); delta_num++) {
+    struct name_delta* const delta = &candidates[candidate_count];
+    if (1 != fread(delta, sizeof(*delta), 1, reader.fp)) {
+      error.code = ERROR_STALE_INDEX;
+      break;
+    }
+    delta->name[MAX_TASK_NAME] = '\0';
+    if ((delta->status <= (uint32_t) last_status) && (0 == strncmp(prefix,
+            delta->name, prefix_length))) {
+      candidate_count++;
+    }
+  }
+  fclose(reader.fp);
+  if (ERROR_NONE != error.code) {
+    free(candidates);
+    return error;
+  }
+
+  qsort(candidates, candidate_count, sizeof(struct name_delta),
+      compare_name_deltas);
+  for (size_t name_num = 0; (name_num < candidate_count) && (name_num <
+        max_name); name_num++) {
+    strcpy(names[name_num], candidates[name_num].name);
+    (*name_count)++;
+  }
+  free(candidates);
+  return error;
+}
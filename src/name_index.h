@@ -0,0 +1,34 @@
+#ifndef _ebs_name_index_h_
+#define _ebs_name_index_h_
+
+#include "task.h"
+#include "trigram.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+  /* Appended names allowed before the index is rebuilt. */
+  MAX_NAME_DELTA = 4096
+};
+
+/* Index the task names in the sheet sorted by status and then by name, so
+ * that the names with a prefix are found by binary search. The index is
+ * written whole. */
+struct error build_name_index(const char* index_file, const char* sheet);
+
+/* Add a task appended to the sheet. previous is the stamp of the sheet before
+ * the append. Return ERROR_STALE_INDEX if the index is missing, was not up to
+ * date or has too many appended names, in which case it should be rebuilt. */
+struct error append_name_index(const char* index_file, const char* sheet,
+    const struct sheet_stamp* previous, const struct task*);
+
+/* Find up to max_name task names that start with the prefix, active tasks
+ * first and each status in byte order. Done tasks are left out if
+ * active_only is set. Return ERROR_STALE_INDEX if the index is missing or not
+ * up to date. */
+struct error find_name_completions(const char* index_file, const char* sheet,
+    const char* prefix, bool active_only, char (*names)[MAX_TASK_NAME + 1],
+    size_t max_name, size_t* name_count);
+
+#endif
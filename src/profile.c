@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "profile.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <time.h>
+
+static const char* const phase_names[] = {
+  "open",
+  "parse tasks",
+  "replay time sheet",
+  "filter",
+  "simulate",
+  "resolve dates",
+  "output"
+};
+
+static const char* const counter_names[] = {
+  "lines read",
+  "mktime calls",
+  "find_task comparisons",
+  "calendar days visited"
+};
+
+/* The profile of the process. */
+static struct {
+  bool is_enabled;
+  enum profile_phase phase;
+  double phase_start;
+  double seconds[MAX_PHASE];
+  uint64_t counts[MAX_COUNTER];
+} profile;
+
+/* Get the time of a clock that only goes forward, in seconds. */
+static double get_profile_clock(void);
+
+double get_profile_clock(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+void start_profile(void) {
+  assert(MAX_PHASE == sizeof(phase_names) / sizeof(phase_names[0]));
+  assert(MAX_COUNTER == sizeof(counter_names) / sizeof(counter_names[0]));
+
+  for (enum profile_phase phase = 0; phase < MAX_PHASE; phase++) {
+    profile.seconds[phase] = 0;
+  }
+  for (enum profile_counter counter = 0; counter < MAX_COUNTER; counter++) {
+    profile.counts[counter] = 0;
+  }
+  profile.phase = PHASE_OPEN;
+  profile.phase_start = get_profile_clock();
+  profile.is_enabled = true;
+}
+
+bool is_profiling(void) {
+  return profile.is_enabled;
+}
+
+enum profile_phase set_profile_phase(const enum profile_phase phase) {
+  assert(phase < MAX_PHASE);
+
+  const enum profile_phase previous = profile.phase;
+  if (!profile.is_enabled) {
+    return previous;
+  }
+  const double now = get_profile_clock();
+  profile.seconds[previous] += now - profile.phase_start;
+  profile.phase_start = now;
+  profile.phase = phase;
+  return previous;
+}
+
+void count_profile(const enum profile_counter counter, const uint64_t count) {
+  assert(counter < MAX_COUNTER);
+
+  if (profile.is_enabled) {
+    profile.counts[counter] += count;
+  }
+}
+
+double get_profile_seconds(const enum profile_phase phase) {
+  assert(phase < MAX_PHASE);
+  return profile.seconds[phase];
+}
+
+uint64_t get_profile_count(const enum profile_counter counter) {
+  assert(counter < MAX_COUNTER);
+  return profile.counts[counter];
+}
+
+void put_profile(FILE* const fp) {
+  assert(NULL != fp);
+
+  set_profile_phase(profile.phase);
+  double total = 0;
+  for (enum profile_phase phase = 0; phase < MAX_PHASE; phase++) {
+    total += profile.seconds[phase];
+  }
+  for (enum profile_phase phase = 0; phase < MAX_PHASE; phase++) {
+    if (0 < profile.seconds[phase]) {
+      fprintf(fp, "profile %-22s %10.3f ms %5.1f%%\n", phase_names[phase],
+          profile.seconds[phase] * 1e3, 100 * profile.seconds[phase] /
+          total);
+    }
+  }
+  fprintf(fp, "profile %-22s %10.3f ms\n", "total", total * 1e3);
+  for (enum profile_counter counter = 0; counter < MAX_COUNTER; counter++) {
+    fprintf(fp, "profile %-22s %10" PRIu64 "\n", counter_names[counter],
+        profile.counts[counter]);
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef _ebs_profile_h_
+#define _ebs_profile_h_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* The phases of a command. The time of the process is always charged to
+ * exactly one of them, so they add up to the whole. */
+enum profile_phase {
+  PHASE_OPEN,
+  PHASE_PARSE_TASKS,
+  PHASE_REPLAY_TIMES,
+  PHASE_FILTER,
+  PHASE_SIMULATE,
+  PHASE_RESOLVE_DATES,
+  PHASE_OUTPUT,
+  MAX_PHASE
+};
+
+/* The work counted while profiling. */
+enum profile_counter {
+  COUNTER_LINES_READ,
+  COUNTER_MKTIME_CALLS,
+  COUNTER_FIND_TASK_COMPARISONS,
+  COUNTER_CALENDAR_DAYS,
+  MAX_COUNTER
+};
+
+/* Start profiling in PHASE_OPEN with every time and count at zero. Until
+ * this is called, the other functions only return. Profiling is not
+ * thread safe, so work that would run on threads runs on the calling thread
+ * while is_profiling is true. */
+void start_profile(void);
+
+/* Return true after start_profile. */
+bool is_profiling(void);
+
+/* Charge the time since the last change to the current phase and make the
+ * given phase current. Return the phase that was current, so that a nested
+ * phase can give the time back to it when it ends. */
+enum profile_phase set_profile_phase(enum profile_phase);
+
+/* Add to a counter. */
+void count_profile(enum profile_counter, uint64_t count);
+
+/* Get the seconds charged to a phase so far, not counting the current
+ * stretch of the current phase. */
+double get_profile_seconds(enum profile_phase);
+
+/* Get the value of a counter. */
+uint64_t get_profile_count(enum profile_counter);
+
+/* Charge the current phase and print the milliseconds of each phase that
+ * took any time, the total and the counters, one per line. */
+void put_profile(FILE*);
+
+#endif
@@ -0,0 +1,1019 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "regex.h"
+#include "error.h"
+#include "hash.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+enum {
+  SET_WORDS = 256 / 64,
+  /* Open addressing table of the DFA states, at most half full. */
+  STATE_TABLE_SIZE = 2 * MAX_REGEX_STATES,
+  REGEX_HASH_SEED = 31337,
+  MAX_CACHE_PATH = 4096
+};
+
+static const char CACHE_MAGIC[8] = {'e', 'b', 's', 'd', 'f', 'a', '1', '\n'};
+
+static const uint32_t MISSING_STATE = UINT32_MAX;
+
+/* A state of the NFA. SET states consume a byte of their set, SPLIT states
+ * go to out and out1, EMPTY states go to out. BEGIN and END states go to out
+ * only at the start and at the end of the subject. */
+enum nfa_type {
+  NFA_SET,
+  NFA_SPLIT,
+  NFA_EMPTY,
+  NFA_BEGIN,
+  NFA_END,
+  NFA_MATCH
+};
+
+struct nfa_state {
+  enum nfa_type type;
+  uint32_t out;
+  uint32_t out1;
+  uint32_t set;
+};
+
+struct symbol_set {
+  uint64_t words[SET_WORDS];
+};
+
+struct nfa {
+  struct nfa_state* states;
+  size_t state_count;
+  size_t state_capacity;
+  struct symbol_set* sets;
+  size_t set_count;
+  size_t set_capacity;
+};
+
+/* A piece of the NFA. end is an EMPTY state whose out is patched later. */
+struct fragment {
+  uint32_t start;
+  uint32_t end;
+};
+
+struct parser {
+  const char* pattern;
+  size_t length;
+  size_t pos;
+  struct nfa* nfa;
+};
+
+/* The sets of NFA states that make up the DFA while it is built. */
+struct subsets {
+  uint32_t* items;
+  size_t item_count;
+  size_t item_capacity;
+  size_t* offsets;
+  uint32_t* table;
+};
+
+/* Add a state to the NFA. */
+static struct error add_nfa_state(struct nfa*, enum nfa_type, uint32_t out,
+    uint32_t out1, uint32_t set, uint32_t* state);
+
+/* Add an empty symbol set to the NFA. */
+static struct error add_symbol_set(struct nfa*, uint32_t* set);
+
+/* Add a byte to a set. */
+static void add_symbol(struct symbol_set*, size_t symbol);
+
+/* Check if a set has a byte. */
+static bool has_symbol(const struct symbol_set*, size_t symbol);
+
+/* Add the bytes of an escape to a set. */
+static void add_escape(struct symbol_set*, char c);
+
+/* Add a fragment that consumes one byte of a new set. */
+static struct error add_set_fragment(struct parser*, struct fragment*,
+    struct symbol_set** set);
+
+/* Parse alternatives separated by '|'. */
+static struct error parse_alternation(struct parser*, struct fragment*);
+
+/* Parse a sequence of repetitions. */
+static struct error parse_concatenation(struct parser*, struct fragment*);
+
+/* Parse an atom followed by '*', '+' or '?'. */
+static struct error parse_repetition(struct parser*, struct fragment*);
+
+/* Parse a character, a class, a group or an anchor. */
+static struct error parse_atom(struct parser*, struct fragment*);
+
+/* Parse a bracket class after its '['. */
+static struct error parse_class(struct parser*, struct symbol_set*);
+
+/* Build the NFA of a pattern that searches the subject. */
+static struct error build_nfa(const char* pattern, size_t pattern_length,
+    struct nfa*, uint32_t* start);
+
+/* Find the SET and MATCH states reachable from the seeds without consuming
+ * a byte, and the END states that wait for the end of the subject. Return
+ * their number and leave them sorted in closure. */
+static size_t find_closure(const struct nfa*, uint32_t* seeds, size_t
+    seed_count, bool is_begin, bool is_end, uint32_t* marks, uint32_t mark,
+    uint32_t* closure);
+
+/* Group the bytes that every set treats the same. */
+static void find_classes(const struct nfa*, struct regex*);
+
+/* Find the DFA state of a subset or add it. The start state is never shared
+ * since only it can see the start of the subject. */
+static struct error find_subset(struct subsets*, struct regex*, size_t*
+    state_capacity, const uint32_t* subset, size_t subset_length, bool
+    is_start, uint32_t* state);
+
+/* Turn the NFA into a DFA by subset construction. */
+static struct error build_dfa(const struct nfa*, uint32_t start, struct
+    regex*);
+
+/* Flag the states from which the subject can't match anymore. */
+static struct error find_dead_states(struct regex*);
+
+/* Read a compiled pattern from a cache file. */
+static struct error read_regex(const char* filename, const char* pattern,
+    size_t pattern_length, struct regex*);
+
+/* Write a compiled pattern to a cache file. */
+static struct error write_regex(const char* filename, const char* pattern,
+    size_t pattern_length, const struct regex*);
+
+/* Compare two NFA states for qsort. */
+static int compare_states(const void*, const void*);
+
+void init_regex(struct regex* const regex) {
+  assert(NULL != regex);
+  regex->class_count = 0;
+  regex->state_count = 0;
+  regex->start = 0;
+  memset(regex->classes, 0, sizeof(regex->classes));
+  regex->flags = NULL;
+  regex->transitions = NULL;
+}
+
+void free_regex(struct regex* const regex) {
+  assert(NULL != regex);
+  free(regex->flags);
+  free(regex->transitions);
+  init_regex(regex);
+}
+
+struct error add_nfa_state(struct nfa* const nfa, const enum nfa_type type,
+    const uint32_t out, const uint32_t out1, const uint32_t set, uint32_t*
+    const state) {
+  struct error error;
+  if (nfa->state_count == nfa->state_capacity) {
+    const size_t capacity = 2 * nfa->state_capacity;
+    if (UINT32_MAX <= capacity) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    struct nfa_state* const states = realloc(nfa->states, capacity *
+        sizeof(struct nfa_state));
+    if (NULL == states) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    nfa->states = states;
+    nfa->state_capacity = capacity;
+  }
+  struct nfa_state* const nfa_state = &nfa->states[nfa->state_count];
+  nfa_state->type = type;
+  nfa_state->out = out;
+  nfa_state->out1 = out1;
+  nfa_state->set = set;
+  *state = (uint32_t) nfa->state_count;
+  nfa->state_count++;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error add_symbol_set(struct nfa* const nfa, uint32_t* const set) {
+  struct error error;
+  if (nfa->set_count == nfa->set_capacity) {
+    const size_t capacity = 2 * nfa->set_capacity;
+    struct symbol_set* const sets = realloc(nfa->sets, capacity *
+        sizeof(struct symbol_set));
+    if (NULL == sets) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    nfa->sets = sets;
+    nfa->set_capacity = capacity;
+  }
+  memset(&nfa->sets[nfa->set_count], 0, sizeof(struct symbol_set));
+  *set = (uint32_t) nfa->set_count;
+  nfa->set_count++;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void add_symbol(struct symbol_set* const set, const size_t symbol) {
+  set->words[symbol / 64] |= (uint64_t) 1 << (symbol % 64);
+}
+
+bool has_symbol(const struct symbol_set* const set, const size_t symbol) {
+  return 0 != (set->words[symbol / 64] & ((uint64_t) 1 << (symbol % 64)));
+}
+
+void add_escape(struct symbol_set* const set, const char c) {
+  switch (c) {
+    case 'd':
+      for (size_t symbol = '0'; symbol <= '9'; symbol++) {
+        add_symbol(set, symbol);
+      }
+      break;
+    case 'w':
+      for (size_t symbol = 1; symbol < 256; symbol++) {
+        if ((('a' <= symbol) && (symbol <= 'z')) || (('A' <= symbol) &&
+              (symbol <= 'Z')) || (('0' <= symbol) && (symbol <= '9')) ||
+            ('_' == symbol)) {
+          add_symbol(set, symbol);
+        }
+      }
+      break;
+    case 's':
+      add_symbol(set, ' ');
+      add_symbol(set, '\t');
+      add_symbol(set, '\n');
+      add_symbol(set, '\r');
+      add_symbol(set, '\f');
+      add_symbol(set, '\v');
+      break;
+    default:
+      add_symbol(set, (unsigned char) c);
+      break;
+  }
+}
+
+struct error add_set_fragment(struct parser* const parser, struct fragment*
+    const fragment, struct symbol_set** const set) {
+  struct error error;
+  uint32_t set_num;
+  error = add_symbol_set(parser->nfa, &set_num);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  error = add_nfa_state(parser->nfa, NFA_EMPTY, MISSING_STATE, MISSING_STATE,
+      0, &fragment->end);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  error = add_nfa_state(parser->nfa, NFA_SET, fragment->end, MISSING_STATE,
+      set_num, &fragment->start);
+  *set = &parser->nfa->sets[set_num];
+  return error;
+}
+
+struct error parse_alternation(struct parser* const parser, struct fragment*
+    const fragment) {
+  struct error error;
+  error = parse_concatenation(parser, fragment);
+  while ((ERROR_NONE == error.code) && (parser->pos < parser->length) &&
+      ('|' == parser->pattern[parser->pos])) {
+    parser->pos++;
+    struct fragment other;
+    error = parse_concatenation(parser, &other);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    uint32_t end;
+    uint32_t split;
+    error = add_nfa_state(parser->nfa, NFA_EMPTY, MISSING_STATE,
+        MISSING_STATE, 0, &end);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    error = add_nfa_state(parser->nfa, NFA_SPLIT, fragment->start,
+        other.start, 0, &split);
+    parser->nfa->states[fragment->end].out = end;
+    parser->nfa->states[other.end].out = end;
+    fragment->start = split;
+    fragment->end = end;
+  }
+  return error;
+}
+
+struct error parse_concatenation(struct parser* const parser, struct
+    fragment* const fragment) {
+  struct error error;
+  error = add_nfa_state(parser->nfa, NFA_EMPTY, MISSING_STATE, MISSING_STATE,
+      0, &fragment->start);
+  fragment->end = fragment->start;
+  while ((ERROR_NONE == error.code) && (parser->pos < parser->length) &&
+      ('|' != parser->pattern[parser->pos]) && (')' !=
+        parser->pattern[parser->pos])) {
+    struct fragment next;
+    error = parse_repetition(parser, &next);
+    if (ERROR_NONE == error.code) {
+      parser->nfa->states[fragment->end].out = next.start;
+      fragment->end = next.end;
+    }
+  }
+  return error;
+}
+
+struct error parse_repetition(struct parser* const parser, struct fragment*
+    const fragment) {
+  struct error error;
+  error = parse_atom(parser, fragment);
+  while ((ERROR_NONE == error.code) && (parser->pos < parser->length)) {
+    const char c = parser->pattern[parser->pos];
+    if (('*' != c) && ('+' != c) && ('?' != c)) {
+      break;
+    }
+    parser->pos++;
+    uint32_t end;
+    uint32_t split;
+    error = add_nfa_state(parser->nfa, NFA_EMPTY, MISSING_STATE,
+        MISSING_STATE, 0, &end);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    error = add_nfa_state(parser->nfa, NFA_SPLIT, fragment->start, end, 0,
+        &split);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    /* '*' may skip the atom and repeat it, '+' may repeat it and '?' may
+     * skip it. */
+    parser->nfa->states[fragment->end].out = ('?' == c) ? end : split;
+    if ('+' != c) {
+      fragment->start = split;
+    }
+    fragment->end = end;
+  }
+  return error;
+}
+
+struct error parse_atom(struct parser* const parser, struct fragment* const
+    fragment) {
+  struct error error;
+  const char c = parser->pattern[parser->pos];
+  parser->pos++;
+  if (('*' == c) || ('+' == c) || ('?' == c)) {
+    error.code = ERROR_BAD_REGEX;
+    return error;
+  }
+  if (('^' == c) || ('$' == c)) {
+    error = add_nfa_state(parser->nfa, NFA_EMPTY, MISSING_STATE,
+        MISSING_STATE, 0, &fragment->end);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    return add_nfa_state(parser->nfa, ('^' == c) ? NFA_BEGIN : NFA_END,
+        fragment->end, MISSING_STATE, 0, &fragment->start);
+  }
+  if ('(' == c) {
+    error = parse_alternation(parser, fragment);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    if ((parser->length <= parser->pos) || (')' !=
+          parser->pattern[parser->pos])) {
+      error.code = ERROR_BAD_REGEX;
+      return error;
+    }
+    parser->pos++;
+    return error;
+  }
+
+  struct symbol_set* set;
+  error = add_set_fragment(parser, fragment, &set);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  switch (c) {
+    case '.':
+      for (size_t symbol = 1; symbol < 256; symbol++) {
+        add_symbol(set, symbol);
+      }
+      break;
+    case '[':
+      error = parse_class(parser, set);
+      break;
+    case '\\':
+      if (parser->length <= parser->pos) {
+        error.code = ERROR_BAD_REGEX;
+        break;
+      }
+      add_escape(set, parser->pattern[parser->pos]);
+      parser->pos++;
+      break;
+    default:
+      add_symbol(set, (unsigned char) c);
+      break;
+  }
+  return error;
+}
+
+struct error parse_class(struct parser* const parser, struct symbol_set*
+    const set) {
+  struct error error;
+  struct symbol_set members;
+  memset(&members, 0, sizeof(members));
+  bool is_negative = false;
+  if ((parser->pos < parser->length) && ('^' ==
+        parser->pattern[parser->pos])) {
+    is_negative = true;
+    parser->pos++;
+  }
+
+  /* A ']' right after the '[' is a member. */
+  bool is_first = true;
+  while (true) {
+    if (parser->length <= parser->pos) {
+      error.code = ERROR_BAD_REGEX;
+      return error;
+    }
+    char c = parser->pattern[parser->pos];
+    parser->pos++;
+    if ((']' == c) && !is_first) {
+      break;
+    }
+    is_first = false;
+    if ('\\' == c) {
+      if (parser->length <= parser->pos) {
+        error.code = ERROR_BAD_REGEX;
+        return error;
+      }
+      c = parser->pattern[parser->pos];
+      parser->pos++;
+      if (('d' == c) || ('w' == c) || ('s' == c)) {
+        add_escape(&members, c);
+        continue;
+      }
+    }
+    unsigned char last = (unsigned char) c;
+    if ((parser->pos + 1 < parser->length) && ('-' ==
+          parser->pattern[parser->pos]) && (']' !=
+          parser->pattern[parser->pos + 1])) {
+      last = (unsigned char) parser->pattern[parser->pos + 1];
+      parser->pos += 2;
+      if (last < (unsigned char) c) {
+        error.code = ERROR_BAD_REGEX;
+        return error;
+      }
+    }
+    for (size_t symbol = (unsigned char) c; symbol <= last; symbol++) {
+      add_symbol(&members, symbol);
+    }
+  }
+
+  for (size_t symbol = 1; symbol < 256; symbol++) {
+    if (has_symbol(&members, symbol) != is_negative) {
+      add_symbol(set, symbol);
+    }
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error build_nfa(const char* const pattern, const size_t
+    pattern_length, struct nfa* const nfa, uint32_t* const start) {
+  struct error error;
+  struct parser parser = { pattern, pattern_length, 0, nfa };
+  struct fragment fragment;
+  error = parse_alternation(&parser, &fragment);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  // Only an unmatched ')' stops the parse early.
+  if (parser.pos < parser.length) {
+    error.code = ERROR_BAD_REGEX;
+    return error;
+  }
+
+  /* Search by letting any bytes come before the match. */
+  uint32_t match;
+  uint32_t any_set;
+  uint32_t any;
+  error = add_nfa_state(nfa, NFA_MATCH, MISSING_STATE, MISSING_STATE, 0,
+      &match);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  nfa->states[fragment.end].out = match;
+  error = add_symbol_set(nfa, &any_set);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  for (size_t symbol = 0; symbol < 256; symbol++) {
+    add_symbol(&nfa->sets[any_set], symbol);
+  }
+  error = add_nfa_state(nfa, NFA_SET, MISSING_STATE, MISSING_STATE, any_set,
+      &any);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  error = add_nfa_state(nfa, NFA_SPLIT, fragment.start, any, 0, start);
+  nfa->states[any].out = *start;
+  return error;
+}
+
+int compare_states(const void* const first, const void* const second) {
+  const uint32_t first_state = *(const uint32_t*) first;
+  const uint32_t second_state = *(const uint32_t*) second;
+  return (first_state > second_state) - (first_state < second_state);
+}
+
+size_t find_closure(const struct nfa* const nfa, uint32_t* const seeds,
+    const size_t seed_count, const bool is_begin, const bool is_end, uint32_t*
+    const marks, const uint32_t mark, uint32_t* const closure) {
+  /* The seeds double as the stack. Every state is pushed once, so the stack
+   * fits in state_count entries. */
+  size_t closure_length = 0;
+  size_t stack_length = 0;
+  for (size_t seed_num = 0; seed_num < seed_count; seed_num++) {
+    if (mark != marks[seeds[seed_num]]) {
+      marks[seeds[seed_num]] = mark;
+      seeds[stack_length] = seeds[seed_num];
+      stack_length++;
+    }
+  }
+  while (0 < stack_length) {
+    stack_length--;
+    const uint32_t state = seeds[stack_length];
+    const struct nfa_state* const nfa_state = &nfa->states[state];
+    if ((NFA_SET == nfa_state->type) || (NFA_MATCH == nfa_state->type) ||
+        ((NFA_END == nfa_state->type) && !is_end)) {
+      closure[closure_length] = state;
+      closure_length++;
+      continue;
+    }
+    if ((NFA_BEGIN == nfa_state->type) && !is_begin) {
+      continue;
+    }
+    const uint32_t outs[2] = { nfa_state->out, nfa_state->out1 };
+    for (size_t out_num = 0; out_num < 2; out_num++) {
+      if ((MISSING_STATE != outs[out_num]) && (mark != marks[outs[out_num]])) {
+        marks[outs[out_num]] = mark;
+        seeds[stack_length] = outs[out_num];
+        stack_length++;
+      }
+    }
+  }
+  qsort(closure, closure_length, sizeof(uint32_t), compare_states);
+  return closure_length;
+}
+
+void find_classes(const struct nfa* const nfa, struct regex* const regex) {
+  size_t representatives[256];
+  regex->class_count = 0;
+  for (size_t symbol = 0; symbol < 256; symbol++) {
+    size_t class_num = 0;
+    for (; class_num < regex->class_count; class_num++) {
+      bool is_same = true;
+      for (size_t set_num = 0; is_same && (set_num < nfa->set_count);
+          set_num++) {
+        is_same = has_symbol(&nfa->sets[set_num], symbol) ==
+          has_symbol(&nfa->sets[set_num], representatives[class_num]);
+      }
+      if (is_same) {
+        break;
+      }
+    }
+    if (class_num == regex->class_count) {
+      representatives[class_num] = symbol;
+      regex->class_count++;
+    }
+    regex->classes[symbol] = (uint8_t) class_num;
+  }
+}
+
+struct error find_subset(struct subsets* const subsets, struct regex* const
+    regex, size_t* const state_capacity, const uint32_t* const subset, const
+    size_t subset_length, const bool is_start, uint32_t* const state) {
+  struct error error;
+  const uint32_t hash = ebs_hash_murmur3((const char*) (const void*) subset,
+      subset_length * sizeof(uint32_t), REGEX_HASH_SEED);
+  size_t slot = hash % STATE_TABLE_SIZE;
+  while (!is_start && (MISSING_STATE != subsets->table[slot])) {
+    const uint32_t other = subsets->table[slot];
+    const size_t other_length = subsets->offsets[other + 1] -
+      subsets->offsets[other];
+    if ((other_length == subset_length) && (0 == memcmp(subset,
+            &subsets->items[subsets->offsets[other]], subset_length *
+            sizeof(uint32_t)))) {
+      *state = other;
+      error.code = ERROR_NONE;
+      return error;
+    }
+    slot = (slot + 1) % STATE_TABLE_SIZE;
+  }
+
+  if (MAX_REGEX_STATES <= regex->state_count) {
+    error.code = ERROR_REGEX_TOO_COMPLEX;
+    return error;
+  }
+  if (*state_capacity == regex->state_count) {
+    const size_t capacity = 2 * *state_capacity;
+    uint32_t* const transitions = realloc(regex->transitions, capacity *
+        regex->class_count * sizeof(uint32_t));
+    if (NULL == transitions) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    regex->transitions = transitions;
+    uint8_t* const flags = realloc(regex->flags, capacity);
+    if (NULL == flags) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    regex->flags = flags;
+    *state_capacity = capacity;
+  }
+  if (subsets->item_capacity < subsets->item_count + subset_length) {
+    size_t capacity = 2 * subsets->item_capacity;
+    while (capacity < subsets->item_count + subset_length) {
+      capacity *= 2;
+    }
+    uint32_t* const items = realloc(subsets->items, capacity *
+        sizeof(uint32_t));
+    if (NULL == items) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    subsets->items = items;
+    subsets->item_capacity = capacity;
+  }
+
+  *state = (uint32_t) regex->state_count;
+  memcpy(&subsets->items[subsets->item_count], subset, subset_length *
+      sizeof(uint32_t));
+  subsets->item_count += subset_length;
+  subsets->offsets[regex->state_count + 1] = subsets->item_count;
+  regex->flags[regex->state_count] = 0;
+  regex->state_count++;
+  if (!is_start) {
+    subsets->table[slot] = *state;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error build_dfa(const struct nfa* const nfa, const uint32_t start,
+    struct regex* const regex) {
+  struct error error;
+  find_classes(nfa, regex);
+
+  size_t state_capacity = 16;
+  struct subsets subsets;
+  subsets.item_count = 0;
+  subsets.item_capacity = 64;
+  subsets.items = malloc(subsets.item_capacity * sizeof(uint32_t));
+  subsets.offsets = malloc((MAX_REGEX_STATES + 1) * sizeof(size_t));
+  subsets.table = malloc(STATE_TABLE_SIZE * sizeof(uint32_t));
+  uint32_t* const marks = calloc(nfa->state_count, sizeof(uint32_t));
+  uint32_t* const seeds = malloc(nfa->state_count * sizeof(uint32_t));
+  uint32_t* const closure = malloc(nfa->state_count * sizeof(uint32_t));
+  regex->transitions = malloc(state_capacity * regex->class_count *
+      sizeof(uint32_t));
+  regex->flags = malloc(state_capacity);
+  uint32_t mark = 0;
+  if ((NULL == subsets.items) || (NULL == subsets.offsets) || (NULL ==
+        subsets.table) || (NULL == marks) || (NULL == seeds) || (NULL ==
+          closure) || (NULL == regex->transitions) || (NULL ==
+            regex->flags)) {
+    error.code = ERROR_OUT_OF_MEMORY;
+  } else {
+    for (size_t slot = 0; slot < STATE_TABLE_SIZE; slot++) {
+      subsets.table[slot] = MISSING_STATE;
+    }
+    subsets.offsets[0] = 0;
+    seeds[0] = start;
+    mark++;
+    const size_t start_length = find_closure(nfa, seeds, 1, true, false,
+        marks, mark, closure);
+    error = find_subset(&subsets, regex, &state_capacity, closure,
+        start_length, true, &regex->start);
+  }
+
+  /* States are numbered in the order they are found, so visiting them in
+   * order visits each once. */
+  for (size_t state = 0; (ERROR_NONE == error.code) && (state <
+        regex->state_count); state++) {
+    /* Finish the END states to see if the subject can end here. Only the
+     * start state is still at the start of the subject. */
+    size_t seed_count = 0;
+    for (size_t item_num = subsets.offsets[state]; item_num <
+        subsets.offsets[state + 1]; item_num++) {
+      const struct nfa_state* const nfa_state =
+        &nfa->states[subsets.items[item_num]];
+      if (NFA_MATCH == nfa_state->type) {
+        regex->flags[state] = REGEX_STATE_ACCEPT;
+      } else if (NFA_END == nfa_state->type) {
+        seeds[seed_count] = nfa_state->out;
+        seed_count++;
+      }
+    }
+    mark++;
+    const size_t end_length = find_closure(nfa, seeds, seed_count,
+        regex->start == state, true, marks, mark, closure);
+    for (size_t item_num = 0; (0 == regex->flags[state]) && (item_num <
+          end_length); item_num++) {
+      if (NFA_MATCH == nfa->states[closure[item_num]].type) {
+        regex->flags[state] = REGEX_STATE_ACCEPT_AT_END;
+      }
+    }
+
+    for (size_t class_num = 0; (ERROR_NONE == error.code) && (class_num <
+          regex->class_count); class_num++) {
+      // Accepting states stay accepting.
+      if (REGEX_STATE_ACCEPT == regex->flags[state]) {
+        regex->transitions[state * regex->class_count + class_num] =
+          (uint32_t) state;
+        continue;
+      }
+      size_t symbol = 0;
+      while (class_num != regex->classes[symbol]) {
+        symbol++;
+      }
+      seed_count = 0;
+      for (size_t item_num = subsets.offsets[state]; item_num <
+          subsets.offsets[state + 1]; item_num++) {
+        const struct nfa_state* const nfa_state =
+          &nfa->states[subsets.items[item_num]];
+        if ((NFA_SET == nfa_state->type) &&
+            has_symbol(&nfa->sets[nfa_state->set], symbol)) {
+          seeds[seed_count] = nfa_state->out;
+          seed_count++;
+        }
+      }
+      mark++;
+      const size_t closure_length = find_closure(nfa, seeds, seed_count,
+          false, false, marks, mark, closure);
+      uint32_t next;
+      error = find_subset(&subsets, regex, &state_capacity, closure,
+          closure_length, false, &next);
+      if (ERROR_NONE == error.code) {
+        regex->transitions[state * regex->class_count + class_num] = next;
+      }
+    }
+  }
+  if (ERROR_NONE == error.code) {
+    error = find_dead_states(regex);
+  }
+
+  free(subsets.items);
+  free(subsets.offsets);
+  free(subsets.table);
+  free(marks);
+  free(seeds);
+  free(closure);
+  return error;
+}
+
+struct error find_dead_states(struct regex* const regex) {
+  struct error error;
+  const size_t state_count = regex->state_count;
+  const size_t class_count = regex->class_count;
+  const size_t transition_count = state_count * class_count;
+  /* Walk the transitions backwards from the accepting states. */
+  size_t* const offsets = calloc(state_count + 1, sizeof(size_t));
+  uint32_t* const sources = malloc(transition_count * sizeof(uint32_t));
+  uint32_t* const queue = malloc(state_count * sizeof(uint32_t));
+  if ((NULL == offsets) || (NULL == sources) || (NULL == queue)) {
+    free(offsets);
+    free(sources);
+    free(queue);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (size_t transition_num = 0; transition_num < transition_count;
+      transition_num++) {
+    offsets[regex->transitions[transition_num] + 1]++;
+  }
+  for (size_t state = 0; state < state_count; state++) {
+    offsets[state + 1] += offsets[state];
+  }
+  for (size_t transition_num = 0; transition_num < transition_count;
+      transition_num++) {
+    const uint32_t target = regex->transitions[transition_num];
+    sources[offsets[target]] = (uint32_t) (transition_num / class_count);
+    offsets[target]++;
+  }
+  // Filling moved each offset to the next one, so shift them back.
+  for (size_t state = state_count; 0 < state; state--) {
+    offsets[state] = offsets[state - 1];
+  }
+  offsets[0] = 0;
+
+  size_t queue_length = 0;
+  for (size_t state = 0; state < state_count; state++) {
+    if (0 != regex->flags[state]) {
+      queue[queue_length] = (uint32_t) state;
+      queue_length++;
+    } else {
+      regex->flags[state] = REGEX_STATE_DEAD;
+    }
+  }
+  for (size_t queue_num = 0; queue_num < queue_length; queue_num++) {
+    const uint32_t state = queue[queue_num];
+    for (size_t source_num = offsets[state]; source_num < offsets[state + 1];
+        source_num++) {
+      const uint32_t source = sources[source_num];
+      if (REGEX_STATE_DEAD == regex->flags[source]) {
+        regex->flags[source] = 0;
+        queue[queue_length] = source;
+        queue_length++;
+      }
+    }
+  }
+
+  free(offsets);
+  free(sources);
+  free(queue);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error compile_regex(const char* const pattern, const size_t
+    pattern_length, struct regex* const regex) {
+  assert(NULL != pattern);
+  assert(NULL != regex);
+
+  struct error error;
+  free_regex(regex);
+  struct nfa nfa;
+  nfa.state_count = 0;
+  nfa.state_capacity = 16;
+  nfa.states = malloc(nfa.state_capacity * sizeof(struct nfa_state));
+  nfa.set_count = 0;
+  nfa.set_capacity = 4;
+  nfa.sets = malloc(nfa.set_capacity * sizeof(struct symbol_set));
+  if ((NULL == nfa.states) || (NULL == nfa.sets)) {
+    error.code = ERROR_OUT_OF_MEMORY;
+  } else {
+    uint32_t start;
+    error = build_nfa(pattern, pattern_length, &nfa, &start);
+    if (ERROR_NONE == error.code) {
+      error = build_dfa(&nfa, start, regex);
+    }
+  }
+  free(nfa.states);
+  free(nfa.sets);
+  if (ERROR_NONE != error.code) {
+    free_regex(regex);
+  }
+  return error;
+}
+
+struct error read_regex(const char* const filename, const char* const
+    pattern, const size_t pattern_length, struct regex* const regex) {
+  struct error error;
+  error.code = ERROR_FILE;
+  FILE* const file = fopen(filename, "rb");
+  if (NULL == file) {
+    return error;
+  }
+
+  char magic[sizeof(CACHE_MAGIC)];
+  uint32_t header[4];
+  if ((1 != fread(magic, sizeof(magic), 1, file)) || (0 != memcmp(magic,
+          CACHE_MAGIC, sizeof(magic))) || (1 != fread(header,
+            sizeof(header), 1, file))) {
+    fclose(file);
+    return error;
+  }
+  const size_t class_count = header[1];
+  const size_t state_count = header[2];
+  if ((header[0] != pattern_length) || (0 == class_count) || (256 <
+        class_count) || (0 == state_count) || (MAX_REGEX_STATES <
+          state_count) || (state_count <= header[3])) {
+    fclose(file);
+    return error;
+  }
+
+  /* A different pattern with the same hash is a miss. */
+  char* const stored_pattern = malloc(pattern_length + 1);
+  regex->flags = malloc(state_count);
+  regex->transitions = malloc(state_count * class_count * sizeof(uint32_t));
+  if ((NULL == stored_pattern) || (NULL == regex->flags) || (NULL ==
+        regex->transitions)) {
+    free(stored_pattern);
+    free_regex(regex);
+    fclose(file);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  bool is_valid = (pattern_length == fread(stored_pattern, 1, pattern_length,
+        file)) && (0 == memcmp(stored_pattern, pattern, pattern_length)) &&
+    (1 == fread(regex->classes, sizeof(regex->classes), 1, file)) &&
+    (state_count == fread(regex->flags, 1, state_count, file)) &&
+    (state_count * class_count == fread(regex->transitions,
+      sizeof(uint32_t), state_count * class_count, file)) && (EOF ==
+        fgetc(file));
+  free(stored_pattern);
+  fclose(file);
+  for (size_t symbol = 0; is_valid && (symbol < 256); symbol++) {
+    is_valid = regex->classes[symbol] < class_count;
+  }
+  for (size_t transition_num = 0; is_valid && (transition_num < state_count *
+        class_count); transition_num++) {
+    is_valid = regex->transitions[transition_num] < state_count;
+  }
+  if (!is_valid) {
+    free_regex(regex);
+    return error;
+  }
+  regex->class_count = class_count;
+  regex->state_count = state_count;
+  regex->start = header[3];
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error write_regex(const char* const filename, const char* const
+    pattern, const size_t pattern_length, const struct regex* const regex) {
+  struct error error;
+  char temp_filename[MAX_CACHE_PATH];
+  snprintf(temp_filename, MAX_CACHE_PATH, "%s.tmp", filename);
+  FILE* const file = fopen(temp_filename, "wb");
+  if (NULL == file) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  const uint32_t header[4] = { (uint32_t) pattern_length, (uint32_t)
+    regex->class_count, (uint32_t) regex->state_count, regex->start };
+  const size_t transition_count = regex->state_count * regex->class_count;
+  bool is_written = (1 == fwrite(CACHE_MAGIC, sizeof(CACHE_MAGIC), 1, file))
+    && (1 == fwrite(header, sizeof(header), 1, file)) && (pattern_length ==
+        fwrite(pattern, 1, pattern_length, file)) && (1 ==
+          fwrite(regex->classes, sizeof(regex->classes), 1, file)) &&
+    (regex->state_count == fwrite(regex->flags, 1, regex->state_count,
+      file)) && (transition_count == fwrite(regex->transitions,
+        sizeof(uint32_t), transition_count, file));
+  is_written = (0 == fclose(file)) && is_written;
+  // Renaming makes the new file appear whole to other readers.
+  if (!is_written || (0 != rename(temp_filename, filename))) {
+    remove(temp_filename);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error load_regex(const char* const pattern, const size_t
+    pattern_length, const char* const cache_path, struct regex* const regex) {
+  assert(NULL != pattern);
+  assert(NULL != regex);
+
+  struct error error;
+  free_regex(regex);
+  if ((NULL == cache_path) || (UINT32_MAX <= pattern_length)) {
+    return compile_regex(pattern, pattern_length, regex);
+  }
+
+  char filename[MAX_CACHE_PATH];
+  snprintf(filename, MAX_CACHE_PATH, "%s/regex-%08lx.dfa", cache_path,
+      (unsigned long) ebs_hash_murmur3(pattern, pattern_length,
+        REGEX_HASH_SEED));
+  error = read_regex(filename, pattern, pattern_length, regex);
+  if (ERROR_OUT_OF_MEMORY == error.code) {
+    return error;
+  }
+  if (ERROR_NONE == error.code) {
+    return error;
+  }
+
+  error = compile_regex(pattern, pattern_length, regex);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  /* The cache only saves time, so failing to write it is fine. */
+  mkdir(cache_path, 0777);
+  write_regex(filename, pattern, pattern_length, regex);
+  return error;
+}
+
+bool regex_matches(const struct regex* const regex, const char* const
+    subject, const size_t subject_length) {
+  assert(NULL != regex);
+  assert(NULL != subject);
+  assert(0 < regex->state_count);
+
+  const uint32_t* const transitions = regex->transitions;
+  const uint8_t* const flags = regex->flags;
+  const size_t class_count = regex->class_count;
+  size_t state = regex->start;
+  for (size_t char_num = 0; char_num < subject_length; char_num++) {
+    if (0 != (flags[state] & (REGEX_STATE_ACCEPT | REGEX_STATE_DEAD))) {
+      return REGEX_STATE_ACCEPT == flags[state];
+    }
+    state = transitions[state * class_count + regex->classes[(unsigned char)
+      subject[char_num]]];
+  }
+  return 0 != (flags[state] & (REGEX_STATE_ACCEPT |
+        REGEX_STATE_ACCEPT_AT_END));
+}
@@ -0,0 +1,55 @@
+#ifndef _ebs_regex_h_
+#define _ebs_regex_h_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+  MAX_REGEX_STATES = 4096,
+  /* The subject matches once this state is reached. */
+  REGEX_STATE_ACCEPT = 1,
+  /* The subject can't match once this state is reached. */
+  REGEX_STATE_DEAD = 2,
+  /* The subject matches if it ends in this state. */
+  REGEX_STATE_ACCEPT_AT_END = 4
+};
+
+/* A regular expression compiled into a DFA that searches a subject in one
+ * pass. Bytes that behave the same share a class. */
+struct regex {
+  size_t class_count;
+  size_t state_count;
+  uint32_t start;
+  uint8_t classes[256];
+  /* The REGEX_STATE_* flags of each state. */
+  uint8_t* flags;
+  /* state_count * class_count transitions. */
+  uint32_t* transitions;
+};
+
+/* Initialize an empty regex. */
+void init_regex(struct regex*);
+
+/* Release the memory of a regex. */
+void free_regex(struct regex*);
+
+/* Compile a pattern. The syntax is the usual one: '.', '[...]', '[^...]',
+ * '*', '+', '?', '|', '(...)', '^', '$' and '\' to escape. The regex matches
+ * subjects that contain a match, so anchor it with '^' and '$' as needed.
+ * Return ERROR_BAD_REGEX if the pattern is malformed and
+ * ERROR_REGEX_TOO_COMPLEX if the DFA has more than MAX_REGEX_STATES states. */
+struct error compile_regex(const char* pattern, size_t pattern_length, struct
+    regex*);
+
+/* Load the compiled pattern from the cache directory, or compile it and save
+ * it there. The cache file is named after a hash of the pattern and also
+ * holds the pattern, so collisions are detected. cache_path may be NULL. */
+struct error load_regex(const char* pattern, size_t pattern_length, const char*
+    cache_path, struct regex*);
+
+/* Check if the subject contains a match. */
+bool regex_matches(const struct regex*, const char* subject, size_t
+    subject_length);
+
+#endif
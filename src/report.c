@@ -0,0 +1,327 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "report.h"
+#include "error.h"
+#include "expression.h"
+#include "hash.h"
+#include "profile.h"
+#include "time_snapshot.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  REPORT_HASH_SEED = 3581,
+  MIN_REPORT_ENTRY = 64,
+  MAX_LOOP = 100000000
+};
+
+static const char* const report_period_names[] = {
+  "day",
+  "week",
+  "month"
+};
+
+/* Initialize empty totals. */
+static void init_report_totals(struct report_totals*);
+
+/* Free the memory of the totals. */
+static void free_report_totals(struct report_totals*);
+
+/* Find the slot of the key: the one holding it or the empty one where it
+ * would go. */
+static size_t find_report_slot(const struct report_totals*, time_t
+    period_start, const char* name);
+
+/* Make room for at least one more entry, growing the entries and the slots
+ * together so that at most half of the slots are used. */
+static struct error grow_report_totals(struct report_totals*);
+
+/* Add seconds to the entry of the key, adding the entry if there is none. */
+static struct error add_report_seconds(struct report_totals*, time_t
+    period_start, const char* name, intmax_t seconds);
+
+/* Sort the entries by period and then by name, and index them again. */
+static void sort_report_totals(struct report_totals*);
+
+/* Order entries by period and then by name for qsort. */
+static int compare_report_entries(const void*, const void*);
+
+struct error parse_report_period(const char* const str, enum report_period*
+    const period) {
+  assert(MAX_REPORT_PERIOD == sizeof(report_period_names) /
+      sizeof(report_period_names[0]));
+  assert(NULL != str);
+  assert(NULL != period);
+
+  struct error error;
+  for (enum report_period period_num = 0; period_num < MAX_REPORT_PERIOD;
+      period_num++) {
+    if (0 == strcmp(str, report_period_names[period_num])) {
+      *period = period_num;
+      error.code = ERROR_NONE;
+      return error;
+    }
+  }
+  error.code = ERROR_UNKNOWN_PERIOD;
+  return error;
+}
+
+void get_period_bounds(const enum report_period period, const time_t time,
+    time_t* const start, time_t* const end) {
+  assert(NULL != start);
+  assert(NULL != end);
+
+  struct tm day;
+  localtime_r(&time, &day);
+  day.tm_hour = 0;
+  day.tm_min = 0;
+  day.tm_sec = 0;
+  day.tm_isdst = -1;
+  struct tm next = day;
+  if (REPORT_DAY == period) {
+    next.tm_mday += 1;
+  } else if (REPORT_WEEK == period) {
+    day.tm_mday -= (day.tm_wday + 6) % 7;
+    next = day;
+    next.tm_mday += 7;
+  } else {
+    day.tm_mday = 1;
+    next = day;
+    next.tm_mon += 1;
+  }
+  /* mktime normalizes the day of the month and daylight saving time. */
+  count_profile(COUNTER_MKTIME_CALLS, 2);
+  *start = mktime(&day);
+  *end = mktime(&next);
+}
+
+void init_report_totals(struct report_totals* const totals) {
+  totals->entries = NULL;
+  totals->entry_count = 0;
+  totals->max_entry = 0;
+  totals->slots = NULL;
+  totals->slot_count = 0;
+}
+
+void free_report_totals(struct report_totals* const totals) {
+  free(totals->entries);
+  free(totals->slots);
+  init_report_totals(totals);
+}
+
+void init_report(struct report* const report, const enum report_period
+    period) {
+  assert(NULL != report);
+
+  report->period = period;
+  init_report_totals(&report->cells);
+  init_report_totals(&report->periods);
+  init_report_totals(&report->tasks);
+}
+
+void free_report(struct report* const report) {
+  assert(NULL != report);
+
+  free_report_totals(&report->cells);
+  free_report_totals(&report->periods);
+  free_report_totals(&report->tasks);
+}
+
+size_t find_report_slot(const struct report_totals* const totals, const
+    time_t period_start, const char* const name) {
+  const size_t mask = totals->slot_count - 1;
+  const uint32_t seed = REPORT_HASH_SEED ^ (uint32_t) period_start;
+  size_t slot = ebs_hash_murmur3(name, strlen(name), seed) & mask;
+  while (0 != totals->slots[slot]) {
+    const struct report_entry* const entry =
+      &totals->entries[totals->slots[slot] - 1];
+    if ((period_start == entry->period_start) && (0 == strcmp(name,
+            entry->name))) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+struct error grow_report_totals(struct report_totals* const totals) {
+  struct error error;
+  if (totals->entry_count < totals->max_entry) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+
+  const size_t max_entry = (0 == totals->max_entry) ? MIN_REPORT_ENTRY : 2 *
+    totals->max_entry;
+  struct report_entry* const entries = realloc(totals->entries, max_entry *
+      sizeof(struct report_entry));
+  if (NULL == entries) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  totals->entries = entries;
+  size_t* const slots = calloc(2 * max_entry, sizeof(size_t));
+  if (NULL == slots) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  free(totals->slots);
+  totals->slots = slots;
+  totals->slot_count = 2 * max_entry;
+  totals->max_entry = max_entry;
+  for (size_t entry_num = 0; entry_num < totals->entry_count; entry_num++) {
+    const struct report_entry* const entry = &totals->entries[entry_num];
+    totals->slots[find_report_slot(totals, entry->period_start, entry->name)]
+      = entry_num + 1;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error add_report_seconds(struct report_totals* const totals, const
+    time_t period_start, const char* const name, const intmax_t seconds) {
+  struct error error;
+  if (0 < totals->slot_count) {
+    const size_t slot = find_report_slot(totals, period_start, name);
+    if (0 != totals->slots[slot]) {
+      totals->entries[totals->slots[slot] - 1].seconds += seconds;
+      error.code = ERROR_NONE;
+      return error;
+    }
+  }
+  error = grow_report_totals(totals);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  struct report_entry* const entry = &totals->entries[totals->entry_count];
+  entry->period_start = period_start;
+  entry->seconds = seconds;
+  strncpy(entry->name, name, MAX_TASK_NAME);
+  entry->name[MAX_TASK_NAME] = '\0';
+  totals->slots[find_report_slot(totals, period_start, entry->name)] =
+    totals->entry_count + 1;
+  totals->entry_count++;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error add_report_time(struct report* const report, const char* const
+    name, const time_t start, const time_t end) {
+  assert(NULL != report);
+  assert(NULL != name);
+
+  struct error error;
+  error.code = ERROR_NONE;
+  time_t time = start;
+  for (size_t loop_num = 0; (loop_num < MAX_LOOP) && (time < end);
+      loop_num++) {
+    time_t period_start;
+    time_t period_end;
+    get_period_bounds(report->period, time, &period_start, &period_end);
+    const time_t split = (end < period_end) ? end : period_end;
+    error = add_report_seconds(&report->cells, period_start, name, (intmax_t)
+        (split - time));
+    if (ERROR_NONE != error.code) {
+      break;
+    }
+    time = split;
+  }
+  return error;
+}
+
+struct error add_report_columns(struct report* const report, const struct
+    time_columns* const columns) {
+  assert(NULL != report);
+  assert(NULL != columns);
+
+  struct error error;
+  error.code = ERROR_NONE;
+  /* Most intervals fall in the period of the one before, so its bounds are
+   * kept to skip the calendar arithmetic. */
+  time_t period_start = 0;
+  time_t period_end = 0;
+  for (size_t record_num = 1; record_num < columns->record_count;
+      record_num++) {
+    const time_t start = (time_t) columns->times[record_num - 1];
+    const time_t end = (time_t) columns->times[record_num];
+    if (end <= start) {
+      continue;
+    }
+    const char* const name = get_time_column_name(columns,
+        columns->name_ids[record_num - 1]);
+    if ((start < period_start) || (period_end <= start)) {
+      get_period_bounds(report->period, start, &period_start, &period_end);
+    }
+    if (end <= period_end) {
+      error = add_report_seconds(&report->cells, period_start, name,
+          (intmax_t) (end - start));
+    } else {
+      error = add_report_time(report, name, start, end);
+    }
+    if (ERROR_NONE != error.code) {
+      break;
+    }
+  }
+  return error;
+}
+
+int compare_report_entries(const void* const a, const void* const b) {
+  const struct report_entry* const entry_a = a;
+  const struct report_entry* const entry_b = b;
+  if (entry_a->period_start != entry_b->period_start) {
+    return (entry_a->period_start < entry_b->period_start) ? -1 : 1;
+  }
+  return strcmp(entry_a->name, entry_b->name);
+}
+
+void sort_report_totals(struct report_totals* const totals) {
+  if (0 == totals->slot_count) {
+    return;
+  }
+  qsort(totals->entries, totals->entry_count, sizeof(struct report_entry),
+      compare_report_entries);
+  memset(totals->slots, 0, totals->slot_count * sizeof(size_t));
+  for (size_t entry_num = 0; entry_num < totals->entry_count; entry_num++) {
+    const struct report_entry* const entry = &totals->entries[entry_num];
+    totals->slots[find_report_slot(totals, entry->period_start, entry->name)]
+      = entry_num + 1;
+  }
+}
+
+struct error finish_report(struct report* const report, const struct
+    expression* const filter) {
+  assert(NULL != report);
+  assert(NULL != filter);
+
+  struct error error;
+  error.code = ERROR_NONE;
+  /* The filter is matched once per cell rather than once per record. */
+  struct report_totals* const cells = &report->cells;
+  size_t kept_count = 0;
+  for (size_t entry_num = 0; entry_num < cells->entry_count; entry_num++) {
+    if (string_matches(cells->entries[entry_num].name, filter)) {
+      cells->entries[kept_count] = cells->entries[entry_num];
+      kept_count++;
+    }
+  }
+  cells->entry_count = kept_count;
+  sort_report_totals(cells);
+
+  for (size_t entry_num = 0; entry_num < cells->entry_count; entry_num++) {
+    const struct report_entry* const cell = &cells->entries[entry_num];
+    error = add_report_seconds(&report->periods, cell->period_start, "",
+        cell->seconds);
+    if (ERROR_NONE == error.code) {
+      error = add_report_seconds(&report->tasks, 0, cell->name,
+          cell->seconds);
+    }
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+  }
+  sort_report_totals(&report->periods);
+  sort_report_totals(&report->tasks);
+  return error;
+}
@@ -0,0 +1,78 @@
+#ifndef _ebs_report_h_
+#define _ebs_report_h_
+
+#include "task.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+struct expression;
+struct time_columns;
+
+/* The calendar periods a report adds time up by. Weeks start on Monday, and
+ * all periods start at local midnight. */
+enum report_period {
+  REPORT_DAY,
+  REPORT_WEEK,
+  REPORT_MONTH,
+  MAX_REPORT_PERIOD
+};
+
+/* The time spent on a task in a period. A total over all tasks has an empty
+ * name, and a total over all periods a period_start of zero. */
+struct report_entry {
+  time_t period_start;
+  intmax_t seconds;
+  char name[MAX_TASK_NAME + 1];
+};
+
+/* Time spent, indexed by period and name. */
+struct report_totals {
+  struct report_entry* entries;
+  size_t entry_count;
+  size_t max_entry;
+  /* Open addressing over the keys. A slot holds the entry's position plus
+   * one, or zero if it is empty. */
+  size_t* slots;
+  size_t slot_count;
+};
+
+struct report {
+  enum report_period period;
+  /* The time of each task in each period. */
+  struct report_totals cells;
+  /* The time of all the tasks in each period. */
+  struct report_totals periods;
+  /* The time of each task over all periods. */
+  struct report_totals tasks;
+};
+
+/* Parse the name of a period. Return ERROR_UNKNOWN_PERIOD if there is no
+ * match. */
+struct error parse_report_period(const char* str, enum report_period*);
+
+/* Get the start and end of the period that time is in. */
+void get_period_bounds(enum report_period, time_t time, time_t* start,
+    time_t* end);
+
+/* Initialize an empty report. */
+void init_report(struct report*, enum report_period);
+
+/* Free the memory of the report. */
+void free_report(struct report*);
+
+/* Add the time from start to end to the task, split over the periods it
+ * spans. The period and task totals are not updated until finish_report. */
+struct error add_report_time(struct report*, const char* name, time_t start,
+    time_t end);
+
+/* Add up the records of a time sheet in one pass. The time between two
+ * records goes to the task of the first, as in read_time_sheet, and time that
+ * goes back is left out. */
+struct error add_report_columns(struct report*, const struct time_columns*);
+
+/* Keep the cells of the tasks that match the filter, add up the period and
+ * task totals from them, and sort all three by period and then by name. */
+struct error finish_report(struct report*, const struct expression* filter);
+
+#endif
@@ -0,0 +1,538 @@
+#include "schedule.h"
+#include "calendar.h"
+#include "error.h"
+#include "monte_carlo.h"
+#include "profile.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  // @cleanup These can be configuration.
+  MAX_SIMULATION_LENGTH = 100,
+  SECONDS_OF_WORK_PER_DAY = 8 * 60 * 60,
+  MIN_SCHEDULE_DAYS = 64
+};
+
+const double PERCENTILES[MAX_PERCENTILE] = { 0.05, 0.5, 0.95 };
+
+/* A person doing tasks. The work schedule is the seconds worked by the end of
+ * each day and grows on demand. */
+struct worker {
+  struct calendar calendar;
+  int64_t* seconds_worked_by_day;
+  size_t days_length;
+  /* Ranges of the shared velocity and estimate arrays. */
+  size_t velocities_offset;
+  size_t velocities_length;
+  size_t estimates_offset;
+  size_t estimates_length;
+};
+
+/* The working memory of a forecast. */
+struct schedule {
+  struct worker workers[MAX_PERSON];
+  size_t workers_length;
+  double* velocities;
+  double* estimates;
+  double* team_velocities;
+  double* unassigned_estimates;
+  /* The simulated seconds of work of each person in each simulation. */
+  double* loads;
+  /* The finish days of each person in each simulation, then of the team. */
+  size_t* finish_days;
+};
+
+/* Allocate the working memory. */
+static struct error init_schedule(size_t task_length, size_t people_length,
+    struct schedule*);
+
+/* Release the working memory. */
+static void free_schedule(struct schedule*);
+
+/* Run the simulations and fill in the forecast. */
+static struct error run_schedule(const struct task*, size_t, const char*
+    holiday_sheet, const struct tm* today, struct schedule*, struct
+    team_forecast*);
+
+/* Find the person by name. Add the person if they are new. */
+static struct error find_person(const char* name, struct forecast* people,
+    size_t* people_length, size_t* index);
+
+/* Compute the velocity of a completed task. Return false if there is no
+ * evidence. */
+static bool get_velocity(const struct task*, double* velocity);
+
+/* Get the first day by which the worker has done the given seconds of work,
+ * growing the work schedule as needed. */
+static struct error find_finish_day(struct worker*, const struct tm* today,
+    double seconds, size_t* day);
+
+/* Compare estimates for sorting from largest to smallest. */
+static int compare_estimates(const void*, const void*);
+
+/* Compare days for sorting. */
+static int compare_days(const void*, const void*);
+
+/* Turn simulated finish days into dates at each percentile. The days are
+ * sorted as a side-effect. */
+static struct error fill_forecast(size_t* days, size_t days_length, const
+    struct tm* today, struct forecast*);
+
+struct error find_person(const char* const name, struct forecast* const
+    people, size_t* const people_length, size_t* const index) {
+  assert(NULL != name);
+  assert(NULL != people);
+  assert(NULL != people_length);
+  assert(NULL != index);
+
+  struct error error;
+  for (size_t person_num = 0; person_num < *people_length; person_num++) {
+    if (0 == strcmp(name, people[person_num].name)) {
+      *index = person_num;
+      error.code = ERROR_NONE;
+      return error;
+    }
+  }
+  if (MAX_PERSON <= *people_length) {
+    error.code = ERROR_PERSON_LIMIT;
+    return error;
+  }
+  *index = *people_length;
+  strncpy(people[*index].name, name, MAX_PERSON_NAME);
+  people[*index].name[MAX_PERSON_NAME] = '\0';
+  people[*index].task_count = 0;
+  *people_length += 1;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+bool get_velocity(const struct task* const task, double* const velocity) {
+  assert(NULL != task);
+  assert(NULL != velocity);
+  *velocity = ((double) task->estimated_seconds) / (double)
+    task->actual_seconds;
+  return !isnan(*velocity);
+}
+
+struct error find_finish_day(struct worker* const worker, const struct tm*
+    const today, const double seconds, size_t* const day) {
+  assert(NULL != worker);
+  assert(NULL != today);
+  assert(NULL != day);
+
+  struct error error;
+  while ((0 == worker->days_length) ||
+      ((double) worker->seconds_worked_by_day[worker->days_length - 1] <
+       seconds)) {
+    if (MAX_CALENDAR_DAYS <= worker->days_length) {
+      error.code = ERROR_INCOMPLETE_TASK;
+      return error;
+    }
+    size_t days_length = worker->days_length < MIN_SCHEDULE_DAYS ?
+      MIN_SCHEDULE_DAYS : worker->days_length * 2;
+    if (MAX_CALENDAR_DAYS < days_length) {
+      days_length = MAX_CALENDAR_DAYS;
+    }
+    int64_t* const seconds_worked_by_day = realloc(
+        worker->seconds_worked_by_day, days_length * sizeof(int64_t));
+    if (NULL == seconds_worked_by_day) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    worker->seconds_worked_by_day = seconds_worked_by_day;
+    error = compute_work_schedule(today, &worker->calendar,
+        SECONDS_OF_WORK_PER_DAY, days_length, seconds_worked_by_day);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    worker->days_length = days_length;
+  }
+
+  size_t low = 0;
+  size_t high = worker->days_length - 1;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if ((double) worker->seconds_worked_by_day[middle] < seconds) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  *day = low;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+int compare_estimates(const void* const first, const void* const second) {
+  const double a = *(const double*) first;
+  const double b = *(const double*) second;
+  return (a < b) - (a > b);
+}
+
+int compare_days(const void* const first, const void* const second) {
+  const size_t a = *(const size_t*) first;
+  const size_t b = *(const size_t*) second;
+  return (a > b) - (a < b);
+}
+
+struct error fill_forecast(size_t* const days, const size_t days_length,
+    const struct tm* const today, struct forecast* const forecast) {
+  assert(NULL != days);
+  assert(0 < days_length);
+  assert(NULL != today);
+  assert(NULL != forecast);
+
+  struct error error;
+  qsort(days, days_length, sizeof(size_t), compare_days);
+  for (size_t percentile_num = 0; percentile_num < MAX_PERCENTILE;
+      percentile_num++) {
+    const size_t index = (size_t) (PERCENTILES[percentile_num] * (double)
+        (days_length - 1) + 0.5);
+    error = add_days(today, (int) days[index],
+        &forecast->completion_dates[percentile_num]);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error init_schedule(const size_t task_length, const size_t
+    people_length, struct schedule* const schedule) {
+  assert(NULL != schedule);
+  assert(people_length <= MAX_PERSON);
+
+  struct error error;
+  schedule->workers_length = people_length;
+  for (size_t person_num = 0; person_num < people_length; person_num++) {
+    init_calendar(&schedule->workers[person_num].calendar);
+    schedule->workers[person_num].seconds_worked_by_day = NULL;
+    schedule->workers[person_num].days_length = 0;
+    schedule->workers[person_num].velocities_length = 0;
+    schedule->workers[person_num].estimates_length = 0;
+  }
+
+  const size_t array_length = (0 == task_length) ? 1 : task_length;
+  schedule->velocities = malloc(array_length * sizeof(double));
+  schedule->estimates = malloc(array_length * sizeof(double));
+  schedule->team_velocities = malloc(array_length * sizeof(double));
+  schedule->unassigned_estimates = malloc(array_length * sizeof(double));
+  schedule->loads = malloc(people_length * MAX_SIMULATION_LENGTH *
+      sizeof(double));
+  schedule->finish_days = malloc((people_length + 1) * MAX_SIMULATION_LENGTH
+      * sizeof(size_t));
+  if ((NULL == schedule->velocities) || (NULL == schedule->estimates) ||
+      (NULL == schedule->team_velocities) || (NULL ==
+        schedule->unassigned_estimates) || (NULL == schedule->loads) || (NULL
+        == schedule->finish_days)) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void free_schedule(struct schedule* const schedule) {
+  assert(NULL != schedule);
+
+  for (size_t person_num = 0; person_num < schedule->workers_length;
+      person_num++) {
+    free_calendar(&schedule->workers[person_num].calendar);
+    free(schedule->workers[person_num].seconds_worked_by_day);
+  }
+  free(schedule->velocities);
+  free(schedule->estimates);
+  free(schedule->team_velocities);
+  free(schedule->unassigned_estimates);
+  free(schedule->loads);
+  free(schedule->finish_days);
+}
+
+struct error forecast_team(const struct task* const tasks, const size_t
+    task_length, const char* const holiday_sheet, struct team_forecast* const
+    result) {
+  assert(NULL != tasks);
+  assert(NULL != result);
+
+  struct error error;
+
+  /* Find the people. Unassigned tasks need someone to do them. */
+  result->people_length = 0;
+  for (size_t task_num = 0; task_num < task_length; task_num++) {
+    if ('\0' == tasks[task_num].owner[0]) {
+      continue;
+    }
+    size_t person_num;
+    error = find_person(tasks[task_num].owner, result->people,
+        &result->people_length, &person_num);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+  }
+  if (0 == result->people_length) {
+    size_t person_num;
+    find_person("", result->people, &result->people_length, &person_num);
+  }
+
+  /* Try to get the current time. */
+  time_t current_time = time(NULL);
+  if ((time_t) (-1) == current_time) {
+    error.code = ERROR_TIME_UNAVAILABLE;
+    return error;
+  }
+  const struct tm today = *localtime(&current_time);
+
+  struct schedule schedule;
+  error = init_schedule(task_length, result->people_length, &schedule);
+  if (ERROR_NONE == error.code) {
+    error = run_schedule(tasks, task_length, holiday_sheet, &today, &schedule,
+        result);
+  }
+  free_schedule(&schedule);
+  return error;
+}
+
+struct error run_schedule(const struct task* const tasks, const size_t
+    task_length, const char* const holiday_sheet, const struct tm* const
+    today, struct schedule* const schedule, struct team_forecast* const
+    result) {
+  assert(NULL != tasks);
+  assert(NULL != today);
+  assert(NULL != schedule);
+  assert(NULL != result);
+
+  struct error error;
+  const size_t people_length = result->people_length;
+  struct worker* const workers = schedule->workers;
+  double* const velocities = schedule->velocities;
+  double* const estimates = schedule->estimates;
+  double* const team_velocities = schedule->team_velocities;
+  double* const unassigned_estimates = schedule->unassigned_estimates;
+  double* const loads = schedule->loads;
+  size_t* const finish_days = schedule->finish_days;
+
+  /* Count the evidence and the work of each person. */
+  size_t team_velocities_length = 0;
+  size_t unassigned_count = 0;
+  for (size_t task_num = 0; task_num < task_length; task_num++) {
+    const struct task* const task = &tasks[task_num];
+    size_t person_num = people_length;
+    if ('\0' != task->owner[0]) {
+      find_person(task->owner, result->people, &result->people_length,
+          &person_num);
+    }
+    if (STATUS_ACTIVE == task->status) {
+      if (people_length == person_num) {
+        unassigned_estimates[unassigned_count] = (double)
+          task->estimated_seconds;
+        unassigned_count++;
+      } else {
+        workers[person_num].estimates_length++;
+      }
+      continue;
+    }
+    double velocity;
+    if (!get_velocity(task, &velocity)) {
+      continue;
+    }
+    team_velocities[team_velocities_length] = velocity;
+    team_velocities_length++;
+    if (people_length != person_num) {
+      workers[person_num].velocities_length++;
+    }
+  }
+
+  /* Lay out each person's velocities and estimates contiguously. */
+  size_t velocities_offset = 0;
+  size_t estimates_offset = 0;
+  for (size_t person_num = 0; person_num < people_length; person_num++) {
+    workers[person_num].velocities_offset = velocities_offset;
+    workers[person_num].estimates_offset = estimates_offset;
+    velocities_offset += workers[person_num].velocities_length;
+    estimates_offset += workers[person_num].estimates_length;
+    workers[person_num].velocities_length = 0;
+    workers[person_num].estimates_length = 0;
+  }
+  for (size_t task_num = 0; task_num < task_length; task_num++) {
+    const struct task* const task = &tasks[task_num];
+    if ('\0' == task->owner[0]) {
+      continue;
+    }
+    size_t person_num;
+    find_person(task->owner, result->people, &result->people_length,
+        &person_num);
+    struct worker* const worker = &workers[person_num];
+    if (STATUS_ACTIVE == task->status) {
+      estimates[worker->estimates_offset + worker->estimates_length] =
+        (double) task->estimated_seconds;
+      worker->estimates_length++;
+      continue;
+    }
+    double velocity;
+    if (get_velocity(task, &velocity)) {
+      velocities[worker->velocities_offset + worker->velocities_length] =
+        velocity;
+      worker->velocities_length++;
+    }
+  }
+  qsort(unassigned_estimates, unassigned_count, sizeof(double),
+      compare_estimates);
+
+  /* Set up each calendar and simulate the assigned work. People without
+   * evidence of their own borrow the team's. */
+  for (size_t person_num = 0; person_num < people_length; person_num++) {
+    struct worker* const worker = &workers[person_num];
+    result->people[person_num].task_count = worker->estimates_length;
+    set_profile_phase(PHASE_RESOLVE_DATES);
+    error = add_work_week(today, &worker->calendar);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    if (NULL != holiday_sheet) {
+      const char* const name = result->people[person_num].name;
+      error = read_date_sheet(holiday_sheet, ('\0' == name[0]) ? NULL : name,
+          &worker->calendar.excluded_dates);
+      if ((ERROR_NONE != error.code) && (ERROR_FILE != error.code)) {
+        return error;
+      }
+    }
+    const bool has_evidence = 0 < worker->velocities_length;
+    set_profile_phase(PHASE_SIMULATE);
+    simulate(has_evidence ? &velocities[worker->velocities_offset] :
+        team_velocities, has_evidence ? worker->velocities_length :
+        team_velocities_length, &estimates[worker->estimates_offset],
+        worker->estimates_length, &loads[person_num * MAX_SIMULATION_LENGTH],
+        MAX_SIMULATION_LENGTH);
+  }
+
+  /* Hand out the unassigned tasks, largest first, to whoever would finish
+   * them earliest. */
+  for (size_t simulation_num = 0; simulation_num < MAX_SIMULATION_LENGTH;
+      simulation_num++) {
+    for (size_t task_num = 0; task_num < unassigned_count; task_num++) {
+      double simulated_time;
+      set_profile_phase(PHASE_SIMULATE);
+      simulate(team_velocities, team_velocities_length,
+          &unassigned_estimates[task_num], 1, &simulated_time, 1);
+      set_profile_phase(PHASE_RESOLVE_DATES);
+      size_t best_person_num = 0;
+      size_t best_day = 0;
+      for (size_t person_num = 0; person_num < people_length; person_num++) {
+        const double load = loads[person_num * MAX_SIMULATION_LENGTH +
+          simulation_num];
+        size_t day;
+        error = find_finish_day(&workers[person_num], today, load +
+            simulated_time, &day);
+        if (ERROR_NONE != error.code) {
+          return error;
+        }
+        const double best_load = loads[best_person_num * MAX_SIMULATION_LENGTH
+          + simulation_num];
+        if ((0 == person_num) || (day < best_day) || ((day == best_day) &&
+              (load < best_load))) {
+          best_person_num = person_num;
+          best_day = day;
+        }
+      }
+      loads[best_person_num * MAX_SIMULATION_LENGTH + simulation_num] +=
+        simulated_time;
+    }
+
+    /* The team is done when the last person is done. */
+    set_profile_phase(PHASE_RESOLVE_DATES);
+    size_t* const team_finish_days = &finish_days[people_length *
+      MAX_SIMULATION_LENGTH];
+    team_finish_days[simulation_num] = 0;
+    for (size_t person_num = 0; person_num < people_length; person_num++) {
+      size_t day;
+      error = find_finish_day(&workers[person_num], today,
+          loads[person_num * MAX_SIMULATION_LENGTH + simulation_num], &day);
+      if (ERROR_NONE != error.code) {
+        return error;
+      }
+      finish_days[person_num * MAX_SIMULATION_LENGTH + simulation_num] = day;
+      if (team_finish_days[simulation_num] < day) {
+        team_finish_days[simulation_num] = day;
+      }
+    }
+  }
+
+  for (size_t person_num = 0; person_num <= people_length; person_num++) {
+    struct forecast* const forecast = (people_length == person_num) ?
+      &result->team : &result->people[person_num];
+    error = fill_forecast(&finish_days[person_num * MAX_SIMULATION_LENGTH],
+        MAX_SIMULATION_LENGTH, today, forecast);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+  }
+  /* Without people, anyone does all the tasks. */
+  if ('\0' == result->people[0].name[0]) {
+    result->people[0].task_count = unassigned_count;
+  }
+  strncpy(result->team.name, "team", MAX_PERSON_NAME);
+  result->team.task_count = estimates_offset + unassigned_count;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void print_team_forecast(const struct team_forecast* const forecast) {
+  assert(NULL != forecast);
+
+  for (size_t person_num = 0; person_num <= forecast->people_length;
+      person_num++) {
+    const struct forecast* const person = (0 == person_num) ?
+      &forecast->team : &forecast->people[person_num - 1];
+    printf("%s (%zu tasks)\n", ('\0' == person->name[0]) ? "anyone" :
+        person->name, person->task_count);
+    for (size_t percentile_num = 0; percentile_num < MAX_PERCENTILE;
+        percentile_num++) {
+      printf("  %d%% time: ", (int) (PERCENTILES[percentile_num] * 100.0 +
+            0.5));
+      print_time(&person->completion_dates[percentile_num]);
+    }
+  }
+}
+
+void put_team_forecast(struct writer* const writer, const enum output_format
+    format, const struct team_forecast* const forecast) {
+  assert(NULL != writer);
+  assert(NULL != forecast);
+
+  for (size_t person_num = 0; person_num <= forecast->people_length;
+      person_num++) {
+    const struct forecast* const person = (0 == person_num) ?
+      &forecast->team : &forecast->people[person_num - 1];
+    const char* const name = ('\0' == person->name[0]) ? "anyone" :
+      person->name;
+    if (OUTPUT_JSON == format) {
+      put_string(writer, "{\"person\":");
+      put_json_string(writer, name);
+      put_string(writer, ",\"tasks\":");
+    } else {
+      put_string(writer, name);
+      put_char(writer, '\t');
+    }
+    put_int(writer, (intmax_t) person->task_count);
+    for (size_t percentile_num = 0; percentile_num < MAX_PERCENTILE;
+        percentile_num++) {
+      if (OUTPUT_JSON == format) {
+        put_string(writer, ",\"p");
+        put_int(writer, (intmax_t) (PERCENTILES[percentile_num] * 100.0 +
+              0.5));
+        put_string(writer, "\":");
+      } else {
+        put_char(writer, '\t');
+      }
+      put_epoch_time(writer, &person->completion_dates[percentile_num]);
+    }
+    put_string(writer, (OUTPUT_JSON == format) ? "}\n" : "\n");
+  }
+}
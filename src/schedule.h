@@ -0,0 +1,48 @@
+#ifndef _ebs_schedule_h_
+#define _ebs_schedule_h_
+
+#include "task.h"
+#include "writer.h"
+#include <stddef.h>
+#include <time.h>
+
+enum {
+  MAX_PERSON = 64,
+  MAX_PERCENTILE = 3
+};
+
+/* The percentiles reported in a forecast, from 0 to 1. */
+extern const double PERCENTILES[MAX_PERCENTILE];
+
+/* The predicted completion dates of one person or of the whole team. */
+struct forecast {
+  char name[MAX_PERSON_NAME + 1];
+  size_t task_count;
+  struct tm completion_dates[MAX_PERCENTILE];
+};
+
+/* The forecast for a team and for each person on it. */
+struct team_forecast {
+  struct forecast team;
+  struct forecast people[MAX_PERSON];
+  size_t people_length;
+};
+
+/* Simulate the team working on the active tasks in parallel. Each person does
+ * the tasks assigned to them at their own velocity and on their own calendar.
+ * Unassigned tasks go to whoever would finish them first (list scheduling).
+ * The holiday sheet may be NULL. Return ERROR_PERSON_LIMIT if there are more
+ * than MAX_PERSON people and ERROR_INCOMPLETE_TASK if the tasks cannot be
+ * completed within the calendar. */
+struct error forecast_team(const struct task*, size_t, const char*
+    holiday_sheet, struct team_forecast*);
+
+/* Print the team forecast. */
+void print_team_forecast(const struct team_forecast*);
+
+/* Write the team forecast for tools, one line per person with the team
+ * first. The completion dates are given in epoch seconds. */
+void put_team_forecast(struct writer*, enum output_format, const struct
+    team_forecast*);
+
+#endif
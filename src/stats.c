@@ -0,0 +1,327 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+#include "error.h"
+#include "task_table.h"
+#include "utility.h"
+#include "writer.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+enum {
+  MAX_LOOP = 1000000000
+};
+
+/* Get the time of a clock that only goes forward, in seconds. */
+static double get_stats_clock(void);
+
+/* Start a pass over a sheet. */
+static void init_sheet_stats(struct sheet_stats*);
+
+/* Read the next line of the sheet and count it. Return ERROR_END_OF_FILE at
+ * the end of the sheet and ERROR_BUFFER_LIMIT for a line that is too long to
+ * parse. */
+static struct error read_stats_line(FILE*, char* line, struct sheet_stats*);
+
+/* Read the rows of the task sheet into the table. */
+static struct error scan_task_sheet(const char* task_sheet, struct
+    task_table*, struct workspace_stats*);
+
+/* Read the records of the time sheet, looking their tasks up in the
+ * table. */
+static struct error scan_time_sheet(const char* time_sheet, const struct
+    task_table*, struct workspace_stats*);
+
+/* Print the counts of a pass over a sheet as the members of a JSON
+ * object. */
+static void put_sheet_stats(struct writer*, const struct sheet_stats*);
+
+double get_stats_clock(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+void init_sheet_stats(struct sheet_stats* const sheet) {
+  sheet->byte_count = 0;
+  sheet->line_count = 0;
+  sheet->row_count = 0;
+  sheet->error_count = 0;
+  sheet->long_line_count = 0;
+  sheet->longest_line = 0;
+  sheet->scan_seconds = 0;
+}
+
+struct error read_stats_line(FILE* const fp, char* const line, struct
+    sheet_stats* const sheet) {
+  /* get_line reads on to the new line after the buffer is full, so the
+   * offsets give the whole length of a long line. */
+  const long start = ftell(fp);
+  size_t bytes_read;
+  struct error error = get_line(fp, line, MAX_STATS_LINE, &bytes_read);
+  const long end = ftell(fp);
+  if ((ERROR_END_OF_FILE == error.code) && (0 == bytes_read)) {
+    return error;
+  }
+  sheet->byte_count += (uint64_t) (end - start);
+  sheet->line_count++;
+  /* The last line may have no new line. */
+  const size_t length = (size_t) (end - start) - ((ERROR_END_OF_FILE ==
+        error.code) ? 0 : 1);
+  if (sheet->longest_line < length) {
+    sheet->longest_line = length;
+  }
+  if (MAX_STATS_LINE - 1 < length) {
+    sheet->long_line_count++;
+    sheet->error_count++;
+    error.code = ERROR_BUFFER_LIMIT;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error scan_task_sheet(const char* const task_sheet, struct task_table*
+    const table, struct workspace_stats* const stats) {
+  struct error error;
+  FILE* const fp = fopen(task_sheet, "r");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  char line[MAX_STATS_LINE];
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    error = read_stats_line(fp, line, &stats->task_sheet);
+    if (ERROR_END_OF_FILE == error.code) {
+      break;
+    }
+    if (ERROR_NONE != error.code) {
+      continue;
+    }
+    struct task task;
+    if (ERROR_NONE != parse_task(line, &task).code) {
+      stats->task_sheet.error_count++;
+      continue;
+    }
+    stats->task_sheet.row_count++;
+    if (STATUS_DONE == task.status) {
+      stats->done_count++;
+    }
+    if (strlen(stats->longest_name) < strlen(task.name)) {
+      strcpy(stats->longest_name, task.name);
+    }
+    error = add_table_task(table, &task);
+    if (ERROR_TASK_EXISTS == error.code) {
+      stats->duplicate_count++;
+    } else if (ERROR_NONE != error.code) {
+      fclose(fp);
+      return error;
+    }
+  }
+  fclose(fp);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error scan_time_sheet(const char* const time_sheet, const struct
+    task_table* const table, struct workspace_stats* const stats) {
+  struct error error;
+  FILE* const fp = fopen(time_sheet, "r");
+  if (NULL == fp) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+  char line[MAX_STATS_LINE];
+  struct time_record last_record;
+  bool has_last_record = false;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    error = read_stats_line(fp, line, &stats->time_sheet);
+    if (ERROR_END_OF_FILE == error.code) {
+      break;
+    }
+    if (ERROR_NONE != error.code) {
+      continue;
+    }
+    struct time_record record;
+    if (ERROR_NONE != parse_time_record(line, &record).code) {
+      stats->time_sheet.error_count++;
+      continue;
+    }
+    stats->time_sheet.row_count++;
+    if (has_last_record && (record.time < last_record.time)) {
+      stats->out_of_order_count++;
+    }
+    struct task* task;
+    if (ERROR_NONE != find_table_task(table, record.name, &task).code) {
+      stats->unknown_task_count++;
+    }
+    last_record = record;
+    has_last_record = true;
+  }
+  fclose(fp);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error scan_workspace_stats(const char* const task_sheet, const char*
+    const time_sheet, struct workspace_stats* const stats) {
+  assert(NULL != task_sheet);
+  assert(NULL != time_sheet);
+  assert(NULL != stats);
+
+  init_sheet_stats(&stats->task_sheet);
+  init_sheet_stats(&stats->time_sheet);
+  stats->done_count = 0;
+  stats->duplicate_count = 0;
+  stats->longest_name[0] = '\0';
+  stats->out_of_order_count = 0;
+  stats->unknown_task_count = 0;
+  stats->file_count = 0;
+  stats->limit_count = 0;
+
+  struct task_table table;
+  init_task_table(&table);
+  double start = get_stats_clock();
+  struct error error = scan_task_sheet(task_sheet, &table, stats);
+  double end = get_stats_clock();
+  stats->task_sheet.scan_seconds = end - start;
+  if (ERROR_NONE == error.code) {
+    start = end;
+    error = scan_time_sheet(time_sheet, &table, stats);
+    stats->time_sheet.scan_seconds = get_stats_clock() - start;
+  }
+  stats->slot_count = table.slot_count;
+  stats->max_probe = count_table_probes(&table, stats->probe_histogram,
+      PROBE_HISTOGRAM_LENGTH);
+  free_task_table(&table);
+  return error;
+}
+
+void add_file_stats(struct workspace_stats* const stats, const char* const
+    name, const char* const path) {
+  assert(NULL != stats);
+  assert(NULL != name);
+  assert(NULL != path);
+  assert(stats->file_count < MAX_STATS_FILE);
+
+  struct stat status;
+  struct file_stats* const file = &stats->files[stats->file_count];
+  file->name = name;
+  file->size = (0 == stat(path, &status)) ? (intmax_t) status.st_size : -1;
+  stats->file_count++;
+}
+
+void add_limit_stats(struct workspace_stats* const stats, const char* const
+    name, const intmax_t limit, const intmax_t used) {
+  assert(NULL != stats);
+  assert(NULL != name);
+  assert(stats->limit_count < MAX_STATS_LIMIT);
+
+  struct limit_stats* const entry = &stats->limits[stats->limit_count];
+  entry->name = name;
+  entry->limit = limit;
+  entry->used = used;
+  stats->limit_count++;
+}
+
+void put_sheet_stats(struct writer* const writer, const struct sheet_stats*
+    const sheet) {
+  put_string(writer, "\"bytes\":");
+  put_int(writer, (intmax_t) sheet->byte_count);
+  put_string(writer, ",\"lines\":");
+  put_int(writer, (intmax_t) sheet->line_count);
+  put_string(writer, ",\"rows\":");
+  put_int(writer, (intmax_t) sheet->row_count);
+  put_string(writer, ",\"errors\":");
+  put_int(writer, (intmax_t) sheet->error_count);
+  put_string(writer, ",\"long_lines\":");
+  put_int(writer, (intmax_t) sheet->long_line_count);
+  put_string(writer, ",\"longest_line\":");
+  put_int(writer, (intmax_t) sheet->longest_line);
+  put_string(writer, ",\"scan_ms\":");
+  put_fixed(writer, sheet->scan_seconds * 1e3, 3);
+}
+
+void put_workspace_stats(struct writer* const writer, const struct
+    workspace_stats* const stats) {
+  assert(NULL != writer);
+  assert(NULL != stats);
+
+  put_string(writer, "{\"task_sheet\":{");
+  put_sheet_stats(writer, &stats->task_sheet);
+  put_string(writer, ",\"done\":");
+  put_int(writer, (intmax_t) stats->done_count);
+  put_string(writer, ",\"duplicates\":");
+  put_int(writer, (intmax_t) stats->duplicate_count);
+  put_string(writer, ",\"longest_name\":");
+  put_json_string(writer, stats->longest_name);
+  put_string(writer, ",\"longest_name_length\":");
+  put_int(writer, (intmax_t) strlen(stats->longest_name));
+
+  put_string(writer, "},\"time_sheet\":{");
+  put_sheet_stats(writer, &stats->time_sheet);
+  put_string(writer, ",\"out_of_order\":");
+  put_int(writer, (intmax_t) stats->out_of_order_count);
+  put_string(writer, ",\"unknown_tasks\":");
+  put_int(writer, (intmax_t) stats->unknown_task_count);
+
+  const size_t name_count = stats->task_sheet.row_count -
+    stats->duplicate_count;
+  put_string(writer, "},\"task_hash\":{\"names\":");
+  put_int(writer, (intmax_t) name_count);
+  put_string(writer, ",\"slots\":");
+  put_int(writer, (intmax_t) stats->slot_count);
+  put_string(writer, ",\"load_factor\":");
+  put_fixed(writer, (0 < stats->slot_count) ? (double) name_count / (double)
+      stats->slot_count : 0, 3);
+  put_string(writer, ",\"max_probe\":");
+  put_int(writer, (intmax_t) stats->max_probe);
+  put_string(writer, ",\"probe_histogram\":[");
+  for (size_t bucket_num = 0; bucket_num < PROBE_HISTOGRAM_LENGTH;
+      bucket_num++) {
+    if (0 < bucket_num) {
+      put_char(writer, ',');
+    }
+    put_int(writer, (intmax_t) stats->probe_histogram[bucket_num]);
+  }
+
+  put_string(writer, "]},\"files\":{");
+  for (size_t file_num = 0; file_num < stats->file_count; file_num++) {
+    const struct file_stats* const file = &stats->files[file_num];
+    if (0 < file_num) {
+      put_char(writer, ',');
+    }
+    put_json_string(writer, file->name);
+    put_char(writer, ':');
+    if (file->size < 0) {
+      put_string(writer, "null");
+    } else {
+      put_int(writer, file->size);
+    }
+  }
+
+  put_string(writer, "},\"limits\":{");
+  for (size_t limit_num = 0; limit_num < stats->limit_count; limit_num++) {
+    const struct limit_stats* const limit = &stats->limits[limit_num];
+    if (0 < limit_num) {
+      put_char(writer, ',');
+    }
+    put_json_string(writer, limit->name);
+    put_string(writer, ":{\"limit\":");
+    put_int(writer, limit->limit);
+    put_string(writer, ",\"used\":");
+    put_int(writer, limit->used);
+    put_string(writer, ",\"near\":");
+    put_string(writer, (9 * limit->limit <= 10 * limit->used) ? "true" :
+        "false");
+    put_char(writer, '}');
+  }
+  put_string(writer, "},\"estimated_load_ms\":");
+  put_fixed(writer, (stats->task_sheet.scan_seconds +
+        stats->time_sheet.scan_seconds) * 1e3, 3);
+  put_string(writer, "}\n");
+}
@@ -0,0 +1,85 @@
+#ifndef _ebs_stats_h_
+#define _ebs_stats_h_
+
+#include "task.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct writer;
+
+enum {
+  /* Lookups of up to this many slots are counted one by one, longer ones
+   * together. */
+  PROBE_HISTOGRAM_LENGTH = 16,
+  MAX_STATS_FILE = 16,
+  MAX_STATS_LIMIT = 16,
+  /* The lines of the sheets are read into buffers of this size, so longer
+   * lines are cut short and don't parse. */
+  MAX_STATS_LINE = 4095
+};
+
+/* What one pass over a sheet found. */
+struct sheet_stats {
+  uint64_t byte_count;
+  size_t line_count;
+  /* The lines that parsed. */
+  size_t row_count;
+  size_t error_count;
+  size_t long_line_count;
+  size_t longest_line;
+  double scan_seconds;
+};
+
+/* The size of a file of the ebs directory, or -1 if it is missing. */
+struct file_stats {
+  const char* name;
+  intmax_t size;
+};
+
+/* How close a count is to a limit after which ebs silently reads less. */
+struct limit_stats {
+  const char* name;
+  intmax_t limit;
+  intmax_t used;
+};
+
+struct workspace_stats {
+  struct sheet_stats task_sheet;
+  size_t done_count;
+  size_t duplicate_count;
+  char longest_name[MAX_TASK_NAME + 1];
+  struct sheet_stats time_sheet;
+  /* Records whose time is before the time of the record above them. */
+  size_t out_of_order_count;
+  /* Records of tasks that are not in the task sheet. */
+  size_t unknown_task_count;
+  /* The table the tasks are looked up in by name. */
+  size_t slot_count;
+  size_t probe_histogram[PROBE_HISTOGRAM_LENGTH];
+  size_t max_probe;
+  struct file_stats files[MAX_STATS_FILE];
+  size_t file_count;
+  struct limit_stats limits[MAX_STATS_LIMIT];
+  size_t limit_count;
+};
+
+/* Read the task sheet and then the time sheet once each. A missing time
+ * sheet has no records. */
+struct error scan_workspace_stats(const char* task_sheet, const char*
+    time_sheet, struct workspace_stats*);
+
+/* Add the size of a file. The name is not copied. */
+void add_file_stats(struct workspace_stats*, const char* name, const char*
+    path);
+
+/* Add a limit and how much of it is used. The name is not copied. */
+void add_limit_stats(struct workspace_stats*, const char* name, intmax_t
+    limit, intmax_t used);
+
+/* Print the stats as one JSON object. A limit is near when at least nine
+ * tenths of it are used. The estimated load time is the time of the scan,
+ * which reads the sheets as a command does without its indexes. */
+void put_workspace_stats(struct writer*, const struct workspace_stats*);
+
+#endif
@@ -4,13 +4,17 @@
 #include "expression.h"
 #include "utility.h"
 #include "monte_carlo.h"
+#include "profile.h"
+#include "time_index.h"
 
 #include <assert.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 enum {
   MAX_STATUS_NAME = 31,
@@ -96,40 +100,170 @@ struct error read_time_record(FILE* const fp, struct time_record* const record)
 }
 
 struct error append_time_sheet_entry(const char* const filename, const char*
-    const task_name) {
+    const state_file, const char* const index_file, const char* const
+    task_name) {
   assert(NULL != filename);
   assert(NULL != task_name);
 
   struct error error;
-  FILE *fp = fopen(filename, "a");
+  struct time_record record;
+  record.time = time(NULL);
+  if (-1 == record.time) {
+    error.code = ERROR_TIME_UNAVAILABLE;
+    return error;
+  }
+  strncpy(record.name, task_name, MAX_TASK_NAME);
+  record.name[MAX_TASK_NAME] = '\0';
+
+  /* The whole line goes out in one write so that concurrent appends can't
+   * split it. */
+  char line[MAX_BUFFER + 1];
+  error = format_time_record(&record, line, MAX_BUFFER);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  size_t length = strlen(line);
+  line[length] = '\n';
+  length++;
+  uint64_t sheet_size;
+  error = append_file(filename, line, length, &sheet_size);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  /* The state and the index are only shortcuts: top falls back to the sheet
+   * without the state, and log catches the index up. */
+  if (NULL != state_file) {
+    write_current_task(state_file, &record, sheet_size);
+  }
+  if (NULL != index_file) {
+    append_time_index(index_file, filename, sheet_size - length, sheet_size);
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error write_current_task(const char* const state_file, const struct
+    time_record* const record, const uint64_t sheet_size) {
+  assert(NULL != state_file);
+  assert(NULL != record);
+
+  struct error error;
+  char buffer[MAX_BUFFER];
+  error = format_time_record(record, buffer, MAX_BUFFER);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  char temp_file[MAX_BUFFER + 8];
+  snprintf(temp_file, sizeof(temp_file), "%s.tmp", state_file);
+  FILE* const fp = fopen(temp_file, "w");
   if (NULL == fp) {
     error.code = ERROR_FILE;
     return error;
   }
-  {
-    char time_buffer[MAX_BUFFER + 1];
-    time_t now = time(NULL);
-    if (-1 == now) {
-      error.code = ERROR_TIME_UNAVAILABLE;
-      fclose(fp);
-      return error;
-    }
-    // This is not thread-safe.
-    const struct tm* structured_now = localtime(&now);
-    if (NULL == structured_now) {
-      error.code = ERROR_TIME_UNAVAILABLE;
-      fclose(fp);
-      return error;
-    }
-    format_iso_8601_time(structured_now, time_buffer, MAX_BUFFER);
-    fprintf(fp, "%s\t", time_buffer);
+  fprintf(fp, "%" PRIu64 "\t%s\n", sheet_size, buffer);
+  if ((0 != fclose(fp)) || (0 != rename(temp_file, state_file))) {
+    remove(temp_file);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error read_current_task(const char* const state_file, const char*
+    const time_sheet, struct time_record* const record) {
+  assert(NULL != state_file);
+  assert(NULL != time_sheet);
+  assert(NULL != record);
+
+  struct error error;
+  error.code = ERROR_STALE_INDEX;
+  FILE* const fp = fopen(state_file, "r");
+  if (NULL == fp) {
+    return error;
   }
-  fprintf(fp, "%s\n", task_name);
+  char buffer[MAX_BUFFER];
+  size_t bytes_read;
+  const bool is_read = (ERROR_NONE == get_line(fp, buffer, MAX_BUFFER,
+        &bytes_read).code);
   fclose(fp);
+  char* tab = NULL;
+  const uintmax_t sheet_size = strtoumax(buffer, &tab, 10);
+  if (!is_read || ('\t' != *tab) || (ERROR_NONE != parse_time_record(tab + 1,
+          record).code)) {
+    return error;
+  }
+
+  struct stat sheet_stat;
+  if ((0 != stat(time_sheet, &sheet_stat)) || ((uintmax_t) sheet_stat.st_size
+        != sheet_size)) {
+    return error;
+  }
   error.code = ERROR_NONE;
   return error;
 }
 
+struct error read_last_time_record(const char* const time_sheet, struct
+    time_record* const record, uint64_t* const sheet_size) {
+  assert(NULL != time_sheet);
+  assert(NULL != record);
+  assert(NULL != sheet_size);
+
+  struct error error;
+  FILE* const fp = fopen(time_sheet, "r");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  if (0 != fseek(fp, 0, SEEK_END)) {
+    fclose(fp);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  const long size = ftell(fp);
+  if (size < 0) {
+    fclose(fp);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  *sheet_size = (uint64_t) size;
+
+  /* A record is much shorter than the buffer, so the last one is in the last
+   * buffer of the sheet. */
+  char buffer[MAX_BUFFER + 1];
+  const long start = (MAX_BUFFER < size) ? size - MAX_BUFFER : 0;
+  const size_t length = (size_t) (size - start);
+  if ((0 != fseek(fp, start, SEEK_SET)) || (length != fread(buffer, 1,
+          length, fp))) {
+    fclose(fp);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  fclose(fp);
+  buffer[length] = '\0';
+
+  /* Skip the trailing new lines, then find the start of the last line. */
+  size_t end = length;
+  while ((0 < end) && (('\n' == buffer[end - 1]) || ('\r' == buffer[end -
+            1]))) {
+    end--;
+  }
+  if (0 == end) {
+    error.code = ERROR_END_OF_FILE;
+    return error;
+  }
+  buffer[end] = '\0';
+  size_t line_start = end;
+  while ((0 < line_start) && ('\n' != buffer[line_start - 1])) {
+    line_start--;
+  }
+  if ((0 == line_start) && (0 < start)) {
+    error.code = ERROR_TIME_RECORD_MISSING_FIELDS;
+    return error;
+  }
+  return parse_time_record(&buffer[line_start], record);
+}
+
 struct error parse_time_record(const char* const str, struct time_record* const
     record) {
   assert(NULL != str);
@@ -139,7 +273,7 @@ struct error parse_time_record(const char* const str, struct time_record* const
   char time_buffer[MAX_BUFFER + 1];
   struct error error;
 
-  int matches = sscanf(str, "%255s\t%255s", time_buffer, record->name);
+  int matches = sscanf(str, "%255s\t%127s", time_buffer, record->name);
   if (expected_matches != matches) {
     error.code = ERROR_TIME_RECORD_MISSING_FIELDS;
     return error;
@@ -150,6 +284,7 @@ struct error parse_time_record(const char* const str, struct time_record* const
   if (ERROR_NONE != error.code) {
     return error;
   }
+  count_profile(COUNTER_MKTIME_CALLS, 1);
   time_t t = mktime(&time);
   if ((time_t)(-1) == t) {
     error.code = ERROR_INVALID_TIME;
@@ -213,10 +348,11 @@ struct error parse_task(const char* const str, struct task* const result) {
   char status_buffer[MAX_STATUS_NAME + 1];
   struct error error;
   const int expected_matches = 4;
-  int matches = sscanf(str, "%127s\t%31s\t%jd\t%jd",
+  result->owner[0] = '\0';
+  int matches = sscanf(str, "%127s\t%31s\t%jd\t%jd\t%31s",
       result->name, status_buffer, &result->estimated_seconds,
-      &result->actual_seconds);
-  if (expected_matches != matches) {
+      &result->actual_seconds, result->owner);
+  if (matches < expected_matches) {
     error.code = ERROR_TASK_MISSING_FIELDS;
     return error;
   }
@@ -238,9 +374,10 @@ struct error format_task(const struct task* const task, char* const buffer,
 
   struct error error;
 
-  int bytes_num = snprintf(buffer, max_buffer, "%s\t%s\t%jd\t%jd",
+  int bytes_num = snprintf(buffer, max_buffer, "%s\t%s\t%jd\t%jd%s%s",
       task->name, get_task_status(task->status), task->estimated_seconds / 60,
-      task->actual_seconds / 60);
+      task->actual_seconds / 60, ('\0' == task->owner[0]) ? "" : "\t",
+      task->owner);
 
   if (max_buffer <= (size_t) bytes_num) {
     error.code = ERROR_BUFFER_LIMIT;
@@ -286,15 +423,13 @@ struct error write_task(const struct task* const task, FILE* const fp) {
 }
 
 struct error predict_completion_date(const struct task* const tasks, const
-    size_t task_length, const char* const filter) {
+    size_t task_length, const struct expression* const filter, const char*
+    const holiday_sheet, struct prediction* const prediction) {
   assert(NULL != tasks);
   assert(NULL != filter);
+  assert(NULL != prediction);
 
-  struct expression expression;
-  struct error error = parse_expression(filter, &expression);
-  if (ERROR_NONE != error.code) {
-    return error;
-  }
+  struct error error;
 
   /* Compute the velocities and sum up the estimated work time in seconds. */
   double velocities[MAX_TASK_LENGTH];
@@ -306,9 +441,31 @@ struct error predict_completion_date(const struct task* const tasks, const
   size_t velocity_index = 0;
   size_t estimated_times_index = 0;
 
+  /* Match all the names at once rather than one task at a time. */
+  set_profile_phase(PHASE_FILTER);
+  const char** const names = malloc((task_length + 1) * sizeof(const char*));
+  uint64_t* const matches = malloc((get_matcher_words(task_length) + 1) *
+      sizeof(uint64_t));
+  if ((NULL == names) || (NULL == matches)) {
+    free(names);
+    free(matches);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (task_index = 0; task_index < task_length; task_index++) {
+    names[task_index] = tasks[task_index].name;
+  }
+  error = match_table(names, task_length, filter, matches);
+  free(names);
+  if (ERROR_NONE != error.code) {
+    free(matches);
+    return error;
+  }
+
   for (task_index = 0; task_index < task_length; task_index++) {
     if (STATUS_ACTIVE == tasks[task_index].status) {
-      if (!string_matches(tasks[task_index].name, &expression)) {
+      if (0 == (matches[task_index / MATCHER_WORD_BITS] & ((uint64_t) 1 <<
+              (task_index % MATCHER_WORD_BITS)))) {
         continue;
       }
       seconds_to_work += tasks[task_index].estimated_seconds;
@@ -325,11 +482,13 @@ struct error predict_completion_date(const struct task* const tasks, const
     }
     velocity_index++;
   }
+  free(matches);
 
   const size_t velocities_length = velocity_index;
   const size_t estimated_times_length = estimated_times_index;
 
   /* Run simulations. */
+  set_profile_phase(PHASE_SIMULATE);
   simulate(velocities, velocities_length, estimated_times,
       estimated_times_length, simulated_times, MAX_SIMULATION_LENGTH);
 
@@ -343,6 +502,7 @@ struct error predict_completion_date(const struct task* const tasks, const
       (SIGMA_LEVEL * standard_deviation));
   const intmax_t ninety_five_percent_seconds_to_work = (intmax_t) (mean +
       (SIGMA_LEVEL * standard_deviation));
+  set_profile_phase(PHASE_RESOLVE_DATES);
 
   /* Try to get the current time. */
   time_t current_time = time(NULL);
@@ -355,60 +515,44 @@ struct error predict_completion_date(const struct task* const tasks, const
   /* Hard-code a 9 to 5 weekday. */
   struct calendar calendar;
   init_calendar(&calendar);
-
-  struct event work;
-  work.start = today;
-  work.period = DAY;
-  work.repetition = MAX_CALENDAR_DAYS;
-
-  add_inclusion(&work, &calendar);
-
-  struct event saturday;
-  error = get_next_week(&today, SATURDAY, &saturday.start);
+  error = add_work_week(&today, &calendar);
   if (ERROR_NONE != error.code) {
+    free_calendar(&calendar);
     return error;
   }
-  saturday.period = WEEK;
-  saturday.repetition = MAX_CALENDAR_DAYS;
-  add_exclusion(&saturday, &calendar);
 
-  struct event sunday;
-  error = get_next_week(&today, SUNDAY, &sunday.start);
-  if (ERROR_NONE != error.code) {
-    return error;
+  /* The holiday sheet is optional. */
+  if (NULL != holiday_sheet) {
+    error = read_date_sheet(holiday_sheet, NULL,
+        &calendar.excluded_dates);
+    if ((ERROR_NONE != error.code) && (ERROR_FILE != error.code)) {
+      free_calendar(&calendar);
+      return error;
+    }
   }
-  sunday.period = WEEK;
-  sunday.repetition = MAX_CALENDAR_DAYS;
-  add_exclusion(&sunday, &calendar);
 
-  struct tm mean_completion_date;
   error = compute_completion_date(&today, &calendar, SECONDS_OF_WORK_PER_DAY,
-      mean_seconds_to_work, &mean_completion_date);
+      mean_seconds_to_work, &prediction->mean_date);
   if (ERROR_NONE != error.code) {
+    free_calendar(&calendar);
     return error;
   }
 
-  struct tm five_percent_completion_date;
   error = compute_completion_date(&today, &calendar, SECONDS_OF_WORK_PER_DAY,
-      five_percent_seconds_to_work, &five_percent_completion_date);
+      five_percent_seconds_to_work, &prediction->five_percent_date);
   if (ERROR_NONE != error.code) {
+    free_calendar(&calendar);
     return error;
   }
 
-  struct tm ninety_five_percent_completion_date;
   error = compute_completion_date(&today, &calendar, SECONDS_OF_WORK_PER_DAY,
       ninety_five_percent_seconds_to_work,
-      &ninety_five_percent_completion_date);
+      &prediction->ninety_five_percent_date);
+  free_calendar(&calendar);
   if (ERROR_NONE != error.code) {
     return error;
   }
-
-  printf("%s", "mean completion time: ");
-  print_time(&mean_completion_date);
-  printf("%s", "5% time: ");
-  print_time(&five_percent_completion_date);
-  printf("%s", "95% time: ");
-  print_time(&ninety_five_percent_completion_date);
+  prediction->task_count = estimated_times_length;
 
   error.code = ERROR_NONE;
   return error;
@@ -419,11 +563,15 @@ struct task* find_task(const char* const name, struct task* tasks, size_t
   assert(NULL != name);
   assert(NULL != tasks);
 
+  /* The comparisons are counted once, since this is the inner loop of
+   * replaying the time sheet. */
   for (size_t task_num = 0; task_num < max_task; task_num++) {
     if (0 != strcmp(name, tasks[task_num].name)) {
       continue;
     }
+    count_profile(COUNTER_FIND_TASK_COMPARISONS, task_num + 1);
     return &tasks[task_num];
   }
+  count_profile(COUNTER_FIND_TASK_COMPARISONS, max_task);
   return NULL;
 }
@@ -6,8 +6,11 @@
 #include <stdio.h>
 #include <time.h>
 
+struct expression;
+
 enum {
-  MAX_TASK_NAME = 127
+  MAX_TASK_NAME = 127,
+  MAX_PERSON_NAME = 31
 };
 
 enum task_status {
@@ -20,6 +23,8 @@ struct task {
   intmax_t estimated_seconds;
   intmax_t actual_seconds;
   char name[MAX_TASK_NAME + 1];
+  /* The person the task is assigned to. Empty if anyone can do it. */
+  char owner[MAX_PERSON_NAME + 1];
   enum task_status status;
 };
 
@@ -39,9 +44,27 @@ struct error format_time_record(const struct time_record*, char* buffer, size_t
 struct error read_time_record(FILE* fp, struct time_record*);
 
 /* Append an entry with the current time and the task name to the time sheet.
- * */
+ * If state_file is not NULL, the entry is also written there as the current
+ * task, and if index_file is not NULL, it is added to the time index there. */
 struct error append_time_sheet_entry(const char* filename, const char*
-    task_name);
+    state_file, const char* index_file, const char* task_name);
+
+/* Save the last record of the time sheet and the size of the sheet once it
+ * was written, so that the current task can be found without reading the
+ * sheet. */
+struct error write_current_task(const char* state_file, const struct
+    time_record*, uint64_t sheet_size);
+
+/* Read the current task from the state file. Return ERROR_STALE_INDEX if the
+ * file is missing or the time sheet changed since it was written. */
+struct error read_current_task(const char* state_file, const char*
+    time_sheet, struct time_record*);
+
+/* Read the last record of the time sheet by seeking back from the end, and
+ * get the size of the sheet. Return ERROR_END_OF_FILE if the sheet has no
+ * records. */
+struct error read_last_time_record(const char* time_sheet, struct
+    time_record*, uint64_t* sheet_size);
 
 /* Parse a time sheet entry. */
 struct error parse_time_record(const char* str, struct time_record*);
@@ -51,8 +74,9 @@ struct error read_time_sheet(const char* filename, struct task* tasks, size_t
     max_task);
 
 /* Parse a task. The format is <task_name> TAB <status> TAB <estimate> TAB
- * <actual>. Return ERROR_TASK_MISSING_FIELDS if some fields are missing.
- * Return ERROR_UNKNOWN_STATUS if the status field is invalid. */
+ * <actual>, optionally followed by TAB <owner>. Return
+ * ERROR_TASK_MISSING_FIELDS if some fields are missing. Return
+ * ERROR_UNKNOWN_STATUS if the status field is invalid. */
 struct error parse_task(const char* str, struct task* result);
 
 /* Format a task and put up to max_buffer bytes into result. The terminating
@@ -70,11 +94,21 @@ struct error write_task(const struct task*, FILE* fp);
 struct task* find_task(const char* name, struct task* tasks, size_t
     max_task);
 
+/* The predicted completion dates of a set of tasks. */
+struct prediction {
+  size_t task_count;
+  struct tm mean_date;
+  struct tm five_percent_date;
+  struct tm ninety_five_percent_date;
+};
+
 /* Predict completion date for the filtered, active tasks. Completed tasks are
- * not filtered. Possible errors are ERROR_TIME_UNAVAILABLE and
+ * not filtered. Dates listed in the holiday sheet are days off; the sheet is
+ * optional and may be NULL. Possible errors are ERROR_TIME_UNAVAILABLE and
  * ERROR_INCOMPLETE_TASK if the tasks cannot be completed with the (currently
  * hard-coded) calendar. */
 struct error predict_completion_date(const struct task*, const size_t, const
-    char* filter); 
+    struct expression* filter, const char* holiday_sheet, struct
+    prediction*);
 
 #endif
@@ -0,0 +1,437 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "task_load.h"
+#include "error.h"
+#include "filter_cache.h"
+#include "matcher.h"
+#include "profile.h"
+#include "time_snapshot.h"
+#include "trigram.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  MAX_LOAD_PATH = 4995,
+  MAX_LOOP = 1000000000
+};
+
+/* The tasks of one workspace, loaded on a thread of its own. */
+struct workspace_load {
+  struct config config;
+  /* What the task names are qualified with. */
+  char name[MAX_TASK_NAME + 1];
+  const struct expression* filter;
+  bool load_completed_tasks;
+  struct task* tasks;
+  size_t max_task;
+  size_t task_count;
+  struct error error;
+};
+
+/* Load the tasks of a workspace_load. This is the start of its thread. */
+static void* run_workspace_load(void* workspace_load);
+
+/* Keep the rows from task_count up to row_count whose names, qualified with
+ * workspace_name if it is not NULL, match the filter, moving them down to
+ * task_count. The offsets of all matching rows, done or not, are appended to
+ * matched for the filter cache. */
+static struct error keep_matching_rows(const struct expression* filter, const
+    char* workspace_name, bool load_completed_tasks, struct task* tasks, const
+    uint64_t* row_offsets, size_t row_count, size_t* task_count, uint64_t**
+    matched, size_t* matched_count);
+
+struct error load_tasks(const char* const filter_text, const struct
+    expression* const filter, const char* const workspace_name, const bool
+    load_completed_tasks, const struct config* const config, struct task*
+    tasks, const size_t max_task, size_t* task_count) {
+  assert(NULL != filter_text);
+  assert(NULL != filter);
+  assert(NULL != tasks);
+  assert(NULL != config);
+  assert(NULL != config->base_path);
+
+  struct error error;
+  char task_sheet[MAX_LOAD_PATH];
+  char task_index[MAX_LOAD_PATH];
+  char time_sheet[MAX_LOAD_PATH];
+  char cache_path[MAX_LOAD_PATH];
+  set_profile_phase(PHASE_OPEN);
+
+  snprintf(task_sheet, MAX_LOAD_PATH, "%s/%s", config->base_path, TASK_SHEET);
+  snprintf(task_index, MAX_LOAD_PATH, "%s/%s", config->base_path, TASK_INDEX);
+  snprintf(cache_path, MAX_LOAD_PATH, "%s/%s", config->base_path,
+      CACHE_DIRECTORY);
+
+  FILE* fp = fopen(task_sheet, "r");
+  if (NULL == fp) {
+    printf("no such file %s\n", task_sheet);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  struct sheet_stamp stamp;
+  const bool is_stamped = (ERROR_NONE == get_sheet_stamp(task_sheet,
+        &stamp).code);
+
+  /* Rows that matched the same filter text before are read directly, other
+   * filters are narrowed down by the trigram index. Without candidates every
+   * row is read. */
+  uint64_t* candidates = NULL;
+  size_t candidate_count = 0;
+  bool is_cached = false;
+  if (NULL == workspace_name) {
+    error = read_filter_cache(cache_path, filter_text, task_sheet,
+        &candidates, &candidate_count);
+    is_cached = (ERROR_NONE == error.code);
+    if (!is_cached) {
+      error = find_trigram_candidates(task_index, task_sheet, filter,
+          &candidates, &candidate_count);
+    }
+  }
+  if ((NULL == workspace_name) && (ERROR_STALE_INDEX == error.code)) {
+    error = build_trigram_index(task_index, task_sheet);
+    if (ERROR_NONE == error.code) {
+      error = find_trigram_candidates(task_index, task_sheet, filter,
+          &candidates, &candidate_count);
+    }
+  }
+
+  uint64_t* const row_offsets = malloc((max_task + 1) * sizeof(uint64_t));
+  if (NULL == row_offsets) {
+    free(candidates);
+    fclose(fp);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+
+  /* Read the rows in batches that fill the free part of tasks, and keep the
+   * matching ones of each batch. */
+  set_profile_phase(PHASE_PARSE_TASKS);
+  uint64_t* matched = NULL;
+  size_t matched_count = 0;
+  bool is_complete = false;
+  *task_count = 0;
+  size_t row_count = 0;
+  size_t candidate_num = 0;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    if (max_task <= row_count) {
+      error = keep_matching_rows(filter, workspace_name,
+          load_completed_tasks, tasks, row_offsets, row_count, task_count,
+          &matched, &matched_count);
+      row_count = *task_count;
+      if ((ERROR_NONE != error.code) || (max_task <= row_count)) {
+        break;
+      }
+    }
+    if (NULL != candidates) {
+      if (candidate_count <= candidate_num) {
+        is_complete = true;
+        break;
+      }
+      if (0 != fseek(fp, (long) candidates[candidate_num], SEEK_SET)) {
+        break;
+      }
+      candidate_num++;
+    }
+    const long offset = ftell(fp);
+    error = read_task(fp, &tasks[row_count]);
+    if (ERROR_END_OF_FILE== error.code) {
+      is_complete = true;
+      break;
+    }
+    if (ERROR_NONE != error.code) {
+      print_error(&error);
+      continue;
+    }
+    row_offsets[row_count] = (uint64_t) offset;
+    row_count++;
+  }
+  error = keep_matching_rows(filter, workspace_name, load_completed_tasks,
+      tasks, row_offsets, row_count, task_count, &matched, &matched_count);
+
+  /* Only a whole pass over the sheet says which rows match. */
+  if ((ERROR_NONE == error.code) && is_complete && !is_cached && is_stamped &&
+      (0 < filter->mask_count) && (NULL == workspace_name)) {
+    write_filter_cache(cache_path, filter_text, &stamp, matched,
+        matched_count);
+  }
+  free(matched);
+  free(row_offsets);
+  free(candidates);
+  if (ERROR_NONE != error.code) {
+    fclose(fp);
+    return error;
+  }
+
+  fclose(fp);
+  set_profile_phase(PHASE_REPLAY_TIMES);
+  snprintf(time_sheet, MAX_LOAD_PATH, "%s/%s", config->base_path, TIME_SHEET);
+  char time_snapshot[MAX_LOAD_PATH];
+  snprintf(time_snapshot, MAX_LOAD_PATH, "%s/%s", config->base_path,
+      TIME_SNAPSHOT);
+  struct time_columns columns;
+  init_time_columns(&columns);
+  error = load_time_columns(time_snapshot, time_sheet, &columns);
+  if (ERROR_NONE == error.code) {
+    error = add_column_times(&columns, tasks, *task_count);
+  }
+  free_time_columns(&columns);
+  return error;
+}
+
+struct error load_workspace_tasks(const struct expression* const filter,
+    const bool load_completed_tasks, const struct config* const config, struct
+    task* const tasks, const size_t max_task, size_t* const task_count) {
+  assert(NULL != filter);
+  assert(NULL != config);
+  assert(NULL != tasks);
+  assert(NULL != task_count);
+
+  static char names[MAX_WORKSPACE][MAX_TASK_NAME + 1];
+  struct error error = get_workspace_names(config, names);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  /* Each workspace loads one task more than fits, so that a merge that
+   * leaves some out can tell. */
+  struct workspace_load loads[MAX_WORKSPACE];
+  pthread_t threads[MAX_WORKSPACE];
+  bool is_started[MAX_WORKSPACE];
+  for (size_t path_num = 0; path_num < config->path_count; path_num++) {
+    struct workspace_load* const load = &loads[path_num];
+    load->config.base_path = config->base_paths[path_num];
+    load->config.base_paths[0] = load->config.base_path;
+    load->config.path_count = 1;
+    strcpy(load->name, names[path_num]);
+    load->filter = filter;
+    load->load_completed_tasks = load_completed_tasks;
+    load->tasks = malloc((max_task + 2) * sizeof(struct task));
+    load->max_task = max_task + 1;
+    load->task_count = 0;
+    load->error.code = (NULL == load->tasks) ? ERROR_OUT_OF_MEMORY :
+      ERROR_NONE;
+    is_started[path_num] = (ERROR_NONE == load->error.code) &&
+      !is_profiling() && (0 == pthread_create(&threads[path_num], NULL,
+            run_workspace_load, load));
+  }
+
+  /* A workspace whose thread could not be started is loaded here, as is
+   * every workspace while profiling. */
+  *task_count = 0;
+  size_t matched_count = 0;
+  for (size_t path_num = 0; path_num < config->path_count; path_num++) {
+    struct workspace_load* const load = &loads[path_num];
+    if (is_started[path_num]) {
+      pthread_join(threads[path_num], NULL);
+    } else if (ERROR_NONE == load->error.code) {
+      run_workspace_load(load);
+    }
+    if (ERROR_NONE == error.code) {
+      error = load->error;
+    }
+    for (size_t task_num = 0; (ERROR_NONE == error.code) && (task_num <
+          load->task_count); task_num++) {
+      matched_count++;
+      if (max_task <= *task_count) {
+        continue;
+      }
+      tasks[*task_count] = load->tasks[task_num];
+      qualify_task_name(load->name, load->tasks[task_num].name,
+          tasks[*task_count].name);
+      *task_count += 1;
+    }
+    free(load->tasks);
+  }
+  if ((ERROR_NONE == error.code) && (*task_count < matched_count)) {
+    fprintf(stderr, "only the first %zu matching tasks of the workspaces are "
+        "loaded\n", *task_count);
+  }
+  return error;
+}
+
+void* run_workspace_load(void* const workspace_load) {
+  assert(NULL != workspace_load);
+
+  struct workspace_load* const load = workspace_load;
+  load->error = load_tasks("", load->filter, load->name,
+      load->load_completed_tasks, &load->config, load->tasks, load->max_task,
+      &load->task_count);
+  return NULL;
+}
+
+struct error get_workspace_names(const struct config* const config, char
+    (*const names)[MAX_TASK_NAME + 1]) {
+  assert(NULL != config);
+  assert(NULL != names);
+
+  /* Paths whose names are the same as another's take one more part until
+   * they all differ. */
+  struct error error;
+  size_t part_counts[MAX_WORKSPACE];
+  bool is_whole[MAX_WORKSPACE];
+  for (size_t path_num = 0; path_num < config->path_count; path_num++) {
+    part_counts[path_num] = 1;
+  }
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    for (size_t path_num = 0; path_num < config->path_count; path_num++) {
+      const char* const path = config->base_paths[path_num];
+      /* Trailing slashes don't start a part. */
+      size_t end = strlen(path);
+      while ((1 < end) && ('/' == path[end - 1])) {
+        end--;
+      }
+      size_t start = end;
+      for (size_t part_num = 0; part_num < part_counts[path_num];
+          part_num++) {
+        while ((0 < start) && ('/' == path[start - 1])) {
+          start--;
+        }
+        while ((0 < start) && ('/' != path[start - 1])) {
+          start--;
+        }
+      }
+      /* The first part of an absolute path is empty. */
+      is_whole[path_num] = true;
+      for (size_t byte_num = 0; byte_num < start; byte_num++) {
+        is_whole[path_num] = is_whole[path_num] && ('/' == path[byte_num]);
+      }
+      while ((start < end) && ('/' == path[start])) {
+        start++;
+      }
+      size_t length = 0;
+      for (size_t byte_num = start; (byte_num < end) && (length <
+            MAX_TASK_NAME); byte_num++) {
+        names[path_num][length] = ('/' == path[byte_num]) ? '.' :
+          path[byte_num];
+        length++;
+      }
+      names[path_num][length] = '\0';
+    }
+
+    bool is_distinct = true;
+    bool can_grow = false;
+    for (size_t path_num = 0; path_num < config->path_count; path_num++) {
+      for (size_t other_num = path_num + 1; other_num < config->path_count;
+          other_num++) {
+        if (0 != strcmp(names[path_num], names[other_num])) {
+          continue;
+        }
+        is_distinct = false;
+        part_counts[path_num]++;
+        part_counts[other_num]++;
+        can_grow = can_grow || !is_whole[path_num] || !is_whole[other_num];
+      }
+    }
+    if (is_distinct) {
+      error.code = ERROR_NONE;
+      return error;
+    }
+    if (!can_grow) {
+      break;
+    }
+  }
+  fputs("the ebs directories must have different names\n", stderr);
+  error.code = ERROR_BAD_ARGUMENTS;
+  return error;
+}
+
+void qualify_task_name(const char* const workspace_name, const char* const
+    task_name, char* const qualified_name) {
+  assert(NULL != workspace_name);
+  assert(NULL != task_name);
+  assert(NULL != qualified_name);
+
+  char name[MAX_TASK_NAME + 1];
+  size_t length = 0;
+  for (const char* c = workspace_name; ('\0' != *c) && (length <
+        MAX_TASK_NAME); c++) {
+    name[length] = *c;
+    length++;
+  }
+  if (length < MAX_TASK_NAME) {
+    name[length] = ':';
+    length++;
+  }
+  for (const char* c = task_name; ('\0' != *c) && (length < MAX_TASK_NAME);
+      c++) {
+    name[length] = *c;
+    length++;
+  }
+  name[length] = '\0';
+  memcpy(qualified_name, name, length + 1);
+}
+
+struct error keep_matching_rows(const struct expression* const filter, const
+    char* const workspace_name, const bool load_completed_tasks, struct task*
+    const tasks, const uint64_t* const row_offsets, const size_t row_count,
+    size_t* const task_count, uint64_t** const matched, size_t* const
+    matched_count) {
+  assert(NULL != filter);
+  assert(NULL != tasks);
+  assert(NULL != row_offsets);
+  assert(NULL != task_count);
+  assert(NULL != matched);
+  assert(NULL != matched_count);
+
+  struct error error;
+  const enum profile_phase phase = set_profile_phase(PHASE_FILTER);
+  const size_t first_row = *task_count;
+  const size_t batch_count = row_count - first_row;
+  const char** const names = malloc((batch_count + 1) * sizeof(const char*));
+  uint64_t* const matches = malloc((get_matcher_words(batch_count) + 1) *
+      sizeof(uint64_t));
+  char (*const qualified_names)[MAX_TASK_NAME + 1] = (NULL == workspace_name)
+    ? NULL : malloc((batch_count + 1) * sizeof(*qualified_names));
+  uint64_t* const grown = realloc(*matched, (*matched_count + batch_count + 1)
+      * sizeof(uint64_t));
+  if (NULL != grown) {
+    *matched = grown;
+  }
+  if ((NULL == names) || (NULL == matches) || (NULL == grown) || ((NULL !=
+          workspace_name) && (NULL == qualified_names))) {
+    free(names);
+    free(matches);
+    free(qualified_names);
+    set_profile_phase(phase);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+
+  for (size_t row_num = 0; row_num < batch_count; row_num++) {
+    names[row_num] = tasks[first_row + row_num].name;
+    if (NULL != workspace_name) {
+      qualify_task_name(workspace_name, names[row_num],
+          qualified_names[row_num]);
+      names[row_num] = qualified_names[row_num];
+    }
+  }
+  error = match_table(names, batch_count, filter, matches);
+  free(names);
+  free(qualified_names);
+  if (ERROR_NONE != error.code) {
+    free(matches);
+    set_profile_phase(phase);
+    return error;
+  }
+  for (size_t row_num = 0; row_num < batch_count; row_num++) {
+    if (0 == (matches[row_num / MATCHER_WORD_BITS] & ((uint64_t) 1 << (row_num
+              % MATCHER_WORD_BITS)))) {
+      continue;
+    }
+    (*matched)[*matched_count] = row_offsets[first_row + row_num];
+    *matched_count += 1;
+    if (!load_completed_tasks && (STATUS_DONE == tasks[first_row +
+          row_num].status)) {
+      continue;
+    }
+    tasks[*task_count] = tasks[first_row + row_num];
+    *task_count += 1;
+  }
+  free(matches);
+  set_profile_phase(phase);
+  error.code = ERROR_NONE;
+  return error;
+}
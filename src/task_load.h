@@ -0,0 +1,38 @@
+#ifndef _ebs_task_load_h_
+#define _ebs_task_load_h_
+
+#include "config.h"
+#include "expression.h"
+#include "task.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Load tasks matching the filter into a buffer. Selective filters only read
+ * the rows the trigram index points to. If workspace_name is not NULL, the
+ * filter is matched against the names qualified with it, and every row is
+ * read, since the index and the filter cache know the names as they are. */
+struct error load_tasks(const char* filter_text, const struct expression*
+    filter, const char* workspace_name, bool load_completed_tasks, const
+    struct config*, struct task* tasks, size_t max_task, size_t*
+    task_count);
+
+/* Load the tasks of every workspace of the config, each on a thread of its
+ * own, and merge them with the names qualified by workspace. Each workspace
+ * keeps the tasks whose qualified names match the filter, and only the
+ * merged tasks are cut to max_task, with a message if any are left out. */
+struct error load_workspace_tasks(const struct expression* filter, bool
+    load_completed_tasks, const struct config* config, struct task* tasks,
+    size_t max_task, size_t* task_count);
+
+/* Name the workspaces of the config by the last part of their paths, or by
+ * as many parts as it takes to tell them apart, joined with dots. Return
+ * ERROR_BAD_ARGUMENTS if two paths can't be told apart. */
+struct error get_workspace_names(const struct config*, char
+    (*names)[MAX_TASK_NAME + 1]);
+
+/* Put the name of the workspace and a colon in front of the task name. Names
+ * that get too long are cut short like any other. */
+void qualify_task_name(const char* workspace_name, const char* task_name,
+    char* qualified_name);
+
+#endif
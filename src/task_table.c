@@ -0,0 +1,329 @@
+#include "task_table.h"
+#include "error.h"
+#include "hash.h"
+#include "utility.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  TASK_HASH_SEED = 2749,
+  MIN_TABLE_TASK = 64,
+  MAX_SHEET_PATH = 4096,
+  MAX_LINE = 4096,
+  MAX_LOOP = 100000000
+};
+
+/* Find the slot of the name: the one holding it or the empty one where it
+ * would go. */
+static size_t find_slot(const struct task_table*, const char* name);
+
+/* Make room for at least one more task, growing the tasks and the slots
+ * together so that at most half of the slots are used. */
+static struct error grow_task_table(struct task_table*);
+
+/* Index the task at the given position unless its name is taken. */
+static bool index_task(struct task_table*, size_t task_num);
+
+void init_task_table(struct task_table* const table) {
+  assert(NULL != table);
+
+  table->tasks = NULL;
+  table->task_count = 0;
+  table->max_task = 0;
+  table->slots = NULL;
+  table->slot_count = 0;
+}
+
+void free_task_table(struct task_table* const table) {
+  assert(NULL != table);
+
+  free(table->tasks);
+  free(table->slots);
+  init_task_table(table);
+}
+
+size_t find_slot(const struct task_table* const table, const char* const name)
+{
+  const size_t mask = table->slot_count - 1;
+  size_t slot = ebs_hash_murmur3(name, strlen(name), TASK_HASH_SEED) & mask;
+  while (0 != table->slots[slot]) {
+    if (0 == strcmp(name, table->tasks[table->slots[slot] - 1].name)) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+bool index_task(struct task_table* const table, const size_t task_num) {
+  const size_t slot = find_slot(table, table->tasks[task_num].name);
+  if (0 != table->slots[slot]) {
+    return false;
+  }
+  table->slots[slot] = task_num + 1;
+  return true;
+}
+
+struct error grow_task_table(struct task_table* const table) {
+  struct error error;
+  if (table->task_count < table->max_task) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+
+  const size_t max_task = (0 == table->max_task) ? MIN_TABLE_TASK : 2 *
+    table->max_task;
+  struct task* const tasks = realloc(table->tasks, max_task * sizeof(struct
+        task));
+  if (NULL == tasks) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  table->tasks = tasks;
+  size_t* const slots = calloc(2 * max_task, sizeof(size_t));
+  if (NULL == slots) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  free(table->slots);
+  table->slots = slots;
+  table->slot_count = 2 * max_task;
+  table->max_task = max_task;
+  for (size_t task_num = 0; task_num < table->task_count; task_num++) {
+    index_task(table, task_num);
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error read_task_table(const char* const sheet, struct task_table* const
+    table) {
+  assert(NULL != sheet);
+  assert(NULL != table);
+  assert(0 == table->task_count);
+
+  struct error error;
+  FILE* const fp = fopen(sheet, "r");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    error = grow_task_table(table);
+    if (ERROR_NONE != error.code) {
+      fclose(fp);
+      return error;
+    }
+    error = read_task(fp, &table->tasks[table->task_count]);
+    if (ERROR_END_OF_FILE == error.code) {
+      break;
+    }
+    /* A row that can't be parsed would be lost when the table is written. */
+    if (ERROR_NONE != error.code) {
+      fclose(fp);
+      return error;
+    }
+    index_task(table, table->task_count);
+    table->task_count++;
+  }
+  fclose(fp);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error find_table_task(const struct task_table* const table, const char*
+    const name, struct task** const task) {
+  assert(NULL != table);
+  assert(NULL != name);
+  assert(NULL != task);
+
+  struct error error;
+  *task = NULL;
+  if (0 == table->slot_count) {
+    error.code = ERROR_NO_SUCH_TASK;
+    return error;
+  }
+  const size_t slot = find_slot(table, name);
+  if (0 == table->slots[slot]) {
+    error.code = ERROR_NO_SUCH_TASK;
+    return error;
+  }
+  *task = &table->tasks[table->slots[slot] - 1];
+  error.code = ERROR_NONE;
+  return error;
+}
+
+size_t count_table_probes(const struct task_table* const table, size_t* const
+    histogram, const size_t histogram_length) {
+  assert(NULL != table);
+  assert(NULL != histogram);
+  assert(0 < histogram_length);
+
+  for (size_t bucket_num = 0; bucket_num < histogram_length; bucket_num++) {
+    histogram[bucket_num] = 0;
+  }
+  size_t max_probe = 0;
+  const size_t mask = table->slot_count - 1;
+  for (size_t slot = 0; slot < table->slot_count; slot++) {
+    if (0 == table->slots[slot]) {
+      continue;
+    }
+    const char* const name = table->tasks[table->slots[slot] - 1].name;
+    const size_t home = ebs_hash_murmur3(name, strlen(name), TASK_HASH_SEED) &
+      mask;
+    const size_t probe_count = ((slot - home) & mask) + 1;
+    histogram[(probe_count < histogram_length ? probe_count :
+        histogram_length) - 1]++;
+    if (max_probe < probe_count) {
+      max_probe = probe_count;
+    }
+  }
+  return max_probe;
+}
+
+struct error add_table_task(struct task_table* const table, const struct task*
+    const task) {
+  assert(NULL != table);
+  assert(NULL != task);
+
+  struct error error = grow_task_table(table);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  table->tasks[table->task_count] = *task;
+  if (!index_task(table, table->task_count)) {
+    error.code = ERROR_TASK_EXISTS;
+    return error;
+  }
+  table->task_count++;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void remove_table_tasks(struct task_table* const table, const bool* const
+    is_removed) {
+  assert(NULL != table);
+  assert(NULL != is_removed);
+
+  size_t task_count = 0;
+  for (size_t task_num = 0; task_num < table->task_count; task_num++) {
+    if (!is_removed[task_num]) {
+      table->tasks[task_count] = table->tasks[task_num];
+      task_count++;
+    }
+  }
+  table->task_count = task_count;
+  /* Positions moved, so index the rest again. */
+  if (0 < table->slot_count) {
+    memset(table->slots, 0, table->slot_count * sizeof(size_t));
+  }
+  for (size_t task_num = 0; task_num < task_count; task_num++) {
+    index_task(table, task_num);
+  }
+}
+
+struct error write_task_table(const struct task_table* const table, const
+    char* const sheet) {
+  assert(NULL != table);
+  assert(NULL != sheet);
+
+  struct error error;
+  char temp_sheet[MAX_SHEET_PATH + 8];
+  snprintf(temp_sheet, sizeof(temp_sheet), "%s.tmp", sheet);
+  FILE* const fp = fopen(temp_sheet, "w");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  for (size_t task_num = 0; task_num < table->task_count; task_num++) {
+    error = write_task(&table->tasks[task_num], fp);
+    if (ERROR_NONE != error.code) {
+      fclose(fp);
+      remove(temp_sheet);
+      return error;
+    }
+  }
+  if ((0 != fclose(fp)) || (0 != rename(temp_sheet, sheet))) {
+    remove(temp_sheet);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error compact_time_sheet(const struct task_table* const table, const
+    char* const time_sheet, size_t* const removed_count) {
+  assert(NULL != table);
+  assert(NULL != time_sheet);
+  assert(NULL != removed_count);
+
+  struct error error;
+  *removed_count = 0;
+  FILE* const fin = fopen(time_sheet, "r");
+  if (NULL == fin) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  char temp_sheet[MAX_SHEET_PATH + 8];
+  snprintf(temp_sheet, sizeof(temp_sheet), "%s.tmp", time_sheet);
+  FILE* const fout = fopen(temp_sheet, "w");
+  if (NULL == fout) {
+    fclose(fin);
+    error.code = ERROR_FILE;
+    return error;
+  }
+
+  /* The time between a record and the next goes to the task of the first, so
+   * only records that change the task, or stop time going to one, count.
+   * last_task is NULL while time goes to no task. */
+  bool has_kept = false;
+  const struct task* last_task = NULL;
+  bool is_last = false;
+  for (size_t loop_num = 0; !is_last && (loop_num < MAX_LOOP); loop_num++) {
+    char line[MAX_LINE];
+    size_t length;
+    error = get_line(fin, line, MAX_LINE, &length);
+    /* The last line may not end with a new line. */
+    is_last = (ERROR_END_OF_FILE == error.code);
+    if (is_last) {
+      error.code = ERROR_NONE;
+    }
+    if (ERROR_NONE != error.code) {
+      break;
+    }
+    if (0 == length) {
+      continue;
+    }
+    struct time_record record;
+    if (ERROR_NONE == parse_time_record(line, &record).code) {
+      struct task* task;
+      find_table_task(table, record.name, &task);
+      if ((has_kept || (NULL == task)) && (task == last_task)) {
+        (*removed_count)++;
+        continue;
+      }
+      has_kept = true;
+      last_task = task;
+    }
+    if (0 > fprintf(fout, "%s\n", line)) {
+      error.code = ERROR_FILE;
+      break;
+    }
+  }
+  fclose(fin);
+  if ((0 != fclose(fout)) && (ERROR_NONE == error.code)) {
+    error.code = ERROR_FILE;
+  }
+  if ((ERROR_NONE == error.code) && (0 != rename(temp_sheet, time_sheet))) {
+    error.code = ERROR_FILE;
+  }
+  if (ERROR_NONE != error.code) {
+    remove(temp_sheet);
+  }
+  return error;
+}
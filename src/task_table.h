@@ -0,0 +1,62 @@
+#ifndef _ebs_task_table_h_
+#define _ebs_task_table_h_
+
+#include "task.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* The tasks of a task sheet in memory, in sheet order and indexed by name. */
+struct task_table {
+  struct task* tasks;
+  size_t task_count;
+  size_t max_task;
+  /* Open addressing over the task names. A slot holds the task's position
+   * plus one, or zero if it is empty. */
+  size_t* slots;
+  size_t slot_count;
+};
+
+/* Initialize an empty table. */
+void init_task_table(struct task_table*);
+
+/* Free the memory of the table. */
+void free_task_table(struct task_table*);
+
+/* Read all the tasks of the sheet into an empty table. Rows with a name that
+ * is already in the table are kept but can't be looked up. */
+struct error read_task_table(const char* sheet, struct task_table*);
+
+/* Find the task with the given name. Return ERROR_NO_SUCH_TASK if there is
+ * none. The task stays valid until the next task is added. */
+struct error find_table_task(const struct task_table*, const char* name,
+    struct task** task);
+
+/* Count how many slots a lookup of each indexed task looks at, in
+ * histogram[probes - 1], with longer lookups counted in the last entry.
+ * Return the longest lookup. */
+size_t count_table_probes(const struct task_table*, size_t* histogram,
+    size_t histogram_length);
+
+/* Add a task at the end of the table. Return ERROR_TASK_EXISTS if a task has
+ * the same name. */
+struct error add_table_task(struct task_table*, const struct task*);
+
+/* Remove the tasks whose entries in is_removed are set, keeping the order of
+ * the others. */
+void remove_table_tasks(struct task_table*, const bool* is_removed);
+
+/* Replace the sheet with the tasks of the table. The tasks are written to a
+ * temporary file that is renamed over the sheet, so readers see either the
+ * old sheet or the new one. */
+struct error write_task_table(const struct task_table*, const char* sheet);
+
+/* Rewrite the time sheet in one pass, leaving out the records that don't
+ * change the time spent on the tasks of the table: a record for the same task
+ * as the record before it, a record for a task that isn't in the table after
+ * another such record, and such records at the start of the sheet. Lines that
+ * aren't records are kept. removed_count is set to the number of records left
+ * out. */
+struct error compact_time_sheet(const struct task_table*, const char*
+    time_sheet, size_t* removed_count);
+
+#endif
@@ -0,0 +1,359 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "time_index.h"
+#include "error.h"
+#include "hash.h"
+#include "task.h"
+#include "utility.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+enum {
+  TAIL_HASH_SEED = 6037,
+  MIN_INDEX_ENTRY = 256,
+  /* Bytes before the end of the index's part of the sheet that are checked
+   * to tell an append from an edit. */
+  TAIL_CHECK_SIZE = 64,
+  MAX_INDEX_PATH = 4096,
+  MAX_LINE = 4096,
+  MAX_LOOP = 100000000
+};
+
+static const char TIME_INDEX_MAGIC[8] = {'e', 'b', 's', 't', 'i', 'x', '1',
+  '\n'};
+
+/* The header of the index file. It is followed by entry_count entries. */
+struct index_header {
+  char magic[8];
+  uint64_t sheet_inode;
+  uint64_t sheet_size;
+  uint64_t tail_hash;
+  uint64_t record_count;
+  uint64_t entry_count;
+  int64_t last_time;
+  uint64_t is_sorted;
+};
+
+/* Hash the bytes of the sheet just before size, so that an edit of the lines
+ * already indexed is noticed. */
+static struct error hash_sheet_tail(FILE* sheet, uint64_t size, uint64_t*
+    tail_hash);
+
+/* Read the index file into an empty index if it is up to date with a prefix
+ * of the sheet. Return ERROR_STALE_INDEX if it is not. */
+static struct error read_time_index(const char* index_file, FILE* sheet,
+    const struct stat* status, struct time_index*);
+
+/* Index the complete lines of the sheet from the end of the index up to
+ * end_offset. */
+static struct error read_index_tail(FILE* sheet, uint64_t end_offset, struct
+    time_index*);
+
+void init_time_index(struct time_index* const index) {
+  assert(NULL != index);
+
+  index->entries = NULL;
+  index->entry_count = 0;
+  index->max_entry = 0;
+  index->record_count = 0;
+  index->last_time = 0;
+  index->is_sorted = true;
+  index->sheet_inode = 0;
+  index->sheet_size = 0;
+}
+
+void free_time_index(struct time_index* const index) {
+  assert(NULL != index);
+
+  free(index->entries);
+  init_time_index(index);
+}
+
+struct error add_time_index_record(struct time_index* const index, const
+    int64_t time, const uint64_t offset) {
+  assert(NULL != index);
+
+  struct error error;
+  if ((0 < index->record_count) && (time < index->last_time)) {
+    index->is_sorted = false;
+  }
+  if (0 == index->record_count % TIME_INDEX_STRIDE) {
+    if (index->entry_count == index->max_entry) {
+      const size_t max_entry = (0 == index->max_entry) ? MIN_INDEX_ENTRY : 2
+        * index->max_entry;
+      struct time_index_entry* const entries = realloc(index->entries,
+          max_entry * sizeof(struct time_index_entry));
+      if (NULL == entries) {
+        error.code = ERROR_OUT_OF_MEMORY;
+        return error;
+      }
+      index->entries = entries;
+      index->max_entry = max_entry;
+    }
+    index->entries[index->entry_count].time = time;
+    index->entries[index->entry_count].offset = offset;
+    index->entry_count++;
+  }
+  index->last_time = time;
+  index->record_count++;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error hash_sheet_tail(FILE* const sheet, const uint64_t size, uint64_t*
+    const tail_hash) {
+  struct error error;
+  char bytes[TAIL_CHECK_SIZE];
+  const size_t length = (size < TAIL_CHECK_SIZE) ? (size_t) size :
+    TAIL_CHECK_SIZE;
+  if ((0 != fseek(sheet, (long) (size - length), SEEK_SET)) || (length !=
+        fread(bytes, 1, length, sheet))) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  *tail_hash = ebs_hash_murmur3(bytes, length, TAIL_HASH_SEED);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error read_time_index(const char* const index_file, FILE* const sheet,
+    const struct stat* const status, struct time_index* const index) {
+  struct error error;
+  error.code = ERROR_STALE_INDEX;
+  FILE* const fp = fopen(index_file, "rb");
+  if (NULL == fp) {
+    return error;
+  }
+  struct index_header header;
+  uint64_t tail_hash;
+  struct stat index_status;
+  /* The entry count is checked against the size of the file before it is
+   * used to allocate. */
+  if ((1 != fread(&header, sizeof(header), 1, fp)) || (0 !=
+        memcmp(header.magic, TIME_INDEX_MAGIC, sizeof(TIME_INDEX_MAGIC))) ||
+      (0 != fstat(fileno(fp), &index_status)) || ((uint64_t) status->st_ino
+        != header.sheet_inode) || ((uint64_t) status->st_size <
+          header.sheet_size) || (header.record_count < header.entry_count) ||
+      ((uint64_t) index_status.st_size != sizeof(header) + header.entry_count
+       * sizeof(struct time_index_entry)) || (ERROR_NONE !=
+         hash_sheet_tail(sheet, header.sheet_size, &tail_hash).code) ||
+      (tail_hash != header.tail_hash)) {
+    fclose(fp);
+    return error;
+  }
+  index->entry_count = (size_t) header.entry_count;
+  index->max_entry = index->entry_count;
+  index->entries = malloc((index->entry_count + 1) * sizeof(struct
+        time_index_entry));
+  if (NULL == index->entries) {
+    fclose(fp);
+    free_time_index(index);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  bool is_read = (index->entry_count == fread(index->entries, sizeof(struct
+          time_index_entry), index->entry_count, fp));
+  fclose(fp);
+  /* Entries must follow each other within the indexed part of the sheet. */
+  for (size_t entry_num = 0; is_read && (entry_num < index->entry_count);
+      entry_num++) {
+    is_read = (index->entries[entry_num].offset < header.sheet_size) && ((0
+          == entry_num) || (index->entries[entry_num - 1].offset <
+            index->entries[entry_num].offset));
+  }
+  if (!is_read) {
+    free_time_index(index);
+    return error;
+  }
+  index->record_count = header.record_count;
+  index->last_time = header.last_time;
+  index->is_sorted = (0 != header.is_sorted);
+  index->sheet_inode = header.sheet_inode;
+  index->sheet_size = header.sheet_size;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error read_index_tail(FILE* const sheet, const uint64_t end_offset,
+    struct time_index* const index) {
+  struct error error;
+  if (0 != fseek(sheet, (long) index->sheet_size, SEEK_SET)) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  for (size_t loop_num = 0; (loop_num < MAX_LOOP) && (index->sheet_size <
+        end_offset); loop_num++) {
+    char line[MAX_LINE];
+    size_t length;
+    error = get_line(sheet, line, MAX_LINE, &length);
+    if (ERROR_END_OF_FILE == error.code) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    const long offset = ftell(sheet);
+    if (offset < 0) {
+      error.code = ERROR_FILE;
+      break;
+    }
+    const uint64_t line_offset = index->sheet_size;
+    index->sheet_size = (uint64_t) offset;
+    struct time_record record;
+    if ((ERROR_NONE != error.code) || (ERROR_NONE != parse_time_record(line,
+            &record).code)) {
+      error.code = ERROR_NONE;
+      continue;
+    }
+    error = add_time_index_record(index, (int64_t) record.time, line_offset);
+    if (ERROR_NONE != error.code) {
+      break;
+    }
+  }
+  return error;
+}
+
+struct error load_time_index(const char* const index_file, const char* const
+    time_sheet, struct time_index* const index) {
+  assert(NULL != index_file);
+  assert(NULL != time_sheet);
+  assert(NULL != index);
+  assert(0 == index->record_count);
+
+  struct error error;
+  FILE* const sheet = fopen(time_sheet, "rb");
+  if (NULL == sheet) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  struct stat status;
+  if (0 != fstat(fileno(sheet), &status)) {
+    fclose(sheet);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error = read_time_index(index_file, sheet, &status, index);
+  const bool is_stale = (ERROR_NONE != error.code);
+  if (is_stale) {
+    free_time_index(index);
+    index->sheet_inode = (uint64_t) status.st_ino;
+  }
+  const uint64_t index_size = index->sheet_size;
+  error = read_index_tail(sheet, UINT64_MAX, index);
+  fclose(sheet);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  /* The index is only a shortcut, so failing to write it is not an
+   * error. */
+  if (is_stale || (index_size != index->sheet_size)) {
+    write_time_index(index_file, time_sheet, index);
+  }
+  return error;
+}
+
+struct error write_time_index(const char* const index_file, const char* const
+    time_sheet, const struct time_index* const index) {
+  assert(NULL != index_file);
+  assert(NULL != time_sheet);
+  assert(NULL != index);
+
+  struct error error;
+  struct index_header header;
+  memcpy(header.magic, TIME_INDEX_MAGIC, sizeof(TIME_INDEX_MAGIC));
+  header.sheet_inode = index->sheet_inode;
+  header.sheet_size = index->sheet_size;
+  header.record_count = index->record_count;
+  header.entry_count = index->entry_count;
+  header.last_time = index->last_time;
+  header.is_sorted = index->is_sorted ? 1 : 0;
+  FILE* const sheet = fopen(time_sheet, "rb");
+  if (NULL == sheet) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error = hash_sheet_tail(sheet, index->sheet_size, &header.tail_hash);
+  fclose(sheet);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+
+  char temp_file[MAX_INDEX_PATH + 8];
+  snprintf(temp_file, sizeof(temp_file), "%s.tmp", index_file);
+  FILE* const out = fopen(temp_file, "wb");
+  if (NULL == out) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  bool is_written = (1 == fwrite(&header, sizeof(header), 1, out)) &&
+    (index->entry_count == fwrite(index->entries, sizeof(struct
+          time_index_entry), index->entry_count, out));
+  is_written = (0 == fclose(out)) && is_written;
+  if (!is_written || (0 != rename(temp_file, index_file))) {
+    remove(temp_file);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error append_time_index(const char* const index_file, const char*
+    const time_sheet, const uint64_t start_offset, const uint64_t
+    end_offset) {
+  assert(NULL != index_file);
+  assert(NULL != time_sheet);
+  assert(start_offset <= end_offset);
+
+  struct error error;
+  FILE* const sheet = fopen(time_sheet, "rb");
+  if (NULL == sheet) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  struct stat status;
+  if (0 != fstat(fileno(sheet), &status)) {
+    fclose(sheet);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  struct time_index index;
+  init_time_index(&index);
+  error = read_time_index(index_file, sheet, &status, &index);
+  if ((ERROR_NONE == error.code) && (start_offset != index.sheet_size)) {
+    error.code = ERROR_STALE_INDEX;
+  }
+  if (ERROR_NONE == error.code) {
+    error = read_index_tail(sheet, end_offset, &index);
+  }
+  fclose(sheet);
+  if (ERROR_NONE == error.code) {
+    error = write_time_index(index_file, time_sheet, &index);
+  }
+  free_time_index(&index);
+  return error;
+}
+
+uint64_t find_time_index_offset(const struct time_index* const index, const
+    int64_t time) {
+  assert(NULL != index);
+
+  if (!index->is_sorted || (0 == index->entry_count)) {
+    return 0;
+  }
+  /* Every record before the last entry earlier than time is earlier too. */
+  size_t low = 0;
+  size_t high = index->entry_count;
+  while (low + 1 < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (index->entries[middle].time < time) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return index->entries[low].offset;
+}
@@ -0,0 +1,67 @@
+#ifndef _ebs_time_index_h_
+#define _ebs_time_index_h_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+  /* Records of the time sheet per entry of the index. */
+  TIME_INDEX_STRIDE = 256
+};
+
+/* The time of a record and the offset of its line in the sheet. */
+struct time_index_entry {
+  int64_t time;
+  uint64_t offset;
+};
+
+/* A sparse index of a time sheet: an entry for the first record and every
+ * TIME_INDEX_STRIDE-th record after it. */
+struct time_index {
+  struct time_index_entry* entries;
+  size_t entry_count;
+  size_t max_entry;
+  uint64_t record_count;
+  int64_t last_time;
+  /* Whether no record has a time before the time of the record before it.
+   * The entries can only be searched if so. */
+  bool is_sorted;
+  /* The sheet the index was read from, and the bytes of it read. */
+  uint64_t sheet_inode;
+  uint64_t sheet_size;
+};
+
+/* Initialize an empty index. */
+void init_time_index(struct time_index*);
+
+/* Free the memory of the index. */
+void free_time_index(struct time_index*);
+
+/* Add the record that starts at offset to the end of the index. */
+struct error add_time_index_record(struct time_index*, int64_t time, uint64_t
+    offset);
+
+/* Read the index of the time sheet into an empty index, and add the lines
+ * appended to the sheet since it was written. The index is built again if
+ * it is missing or the sheet was rewritten, and written if it changed.
+ * Malformed lines and a last line without a new line are left out. */
+struct error load_time_index(const char* index_file, const char* time_sheet,
+    struct time_index*);
+
+/* Write the index. The time sheet must still start with the lines it was
+ * read from. */
+struct error write_time_index(const char* index_file, const char* time_sheet,
+    const struct time_index*);
+
+/* Add the lines appended to the sheet from start_offset to end_offset to the
+ * index. Return ERROR_STALE_INDEX without changing it if the index does not
+ * end at start_offset, so that the next load catches up instead. */
+struct error append_time_index(const char* index_file, const char*
+    time_sheet, uint64_t start_offset, uint64_t end_offset);
+
+/* Get the offset to read the sheet from to find every record at or after
+ * time. That is the start of the sheet if the sheet is not sorted. */
+uint64_t find_time_index_offset(const struct time_index*, int64_t time);
+
+#endif
@@ -0,0 +1,553 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "time_snapshot.h"
+#include "error.h"
+#include "hash.h"
+#include "utility.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+enum {
+  NAME_HASH_SEED = 4177,
+  MIN_COLUMN_RECORD = 1024,
+  MIN_COLUMN_NAME = 64,
+  MIN_COLUMN_POOL = 4096,
+  /* Bytes before the end of the snapshot's part of the sheet that are
+   * checked to tell an append from an edit. */
+  TAIL_CHECK_SIZE = 64,
+  MAX_VARINT_BYTES = 10,
+  MAX_SNAPSHOT_PATH = 4096,
+  MAX_LINE = 4096,
+  MAX_LOOP = 100000000
+};
+
+static const char TIME_SNAPSHOT_MAGIC[8] = {'e', 'b', 's', 't', 'i', 'm',
+  '1', '\n'};
+
+/* The header of the snapshot. It is followed by name_count name starts, the
+ * pool_size bytes of the names, record_count name ids, and the epoch_size
+ * bytes of the times. Each time is stored as the zigzag varint of its
+ * difference from the time before. */
+struct snapshot_header {
+  char magic[8];
+  uint64_t sheet_inode;
+  uint64_t sheet_size;
+  uint64_t tail_hash;
+  uint64_t record_count;
+  uint64_t name_count;
+  uint64_t pool_size;
+  uint64_t epoch_size;
+};
+
+/* Find the slot of the name: the one holding it or the empty one where it
+ * would go. */
+static size_t find_name_slot(const struct time_columns*, const char* name);
+
+/* Get the id of the name, adding it to the dictionary if it is new. */
+static struct error intern_name(struct time_columns*, const char* name,
+    uint32_t* name_id);
+
+/* Make room for at least one more name and length more bytes of names. */
+static struct error grow_names(struct time_columns*, size_t length);
+
+/* Index all the names of the dictionary again. */
+static struct error index_names(struct time_columns*);
+
+/* Hash the bytes of the sheet just before size, so that an edit of the lines
+ * already read is noticed. */
+static struct error hash_sheet_tail(FILE* sheet, uint64_t size, uint64_t*
+    tail_hash);
+
+/* Read the snapshot into empty columns if it is up to date with a prefix of
+ * the sheet. Return ERROR_STALE_INDEX if it is not. */
+static struct error read_time_snapshot(const char* snapshot_file, FILE*
+    sheet, const struct stat* status, struct time_columns*);
+
+/* Read the complete lines of the sheet from the end of the columns. */
+static struct error read_time_tail(FILE* sheet, struct time_columns*);
+
+void init_time_columns(struct time_columns* const columns) {
+  assert(NULL != columns);
+
+  columns->times = NULL;
+  columns->name_ids = NULL;
+  columns->record_count = 0;
+  columns->max_record = 0;
+  columns->pool = NULL;
+  columns->pool_size = 0;
+  columns->max_pool = 0;
+  columns->name_starts = NULL;
+  columns->name_count = 0;
+  columns->max_name = 0;
+  columns->slots = NULL;
+  columns->slot_count = 0;
+  columns->sheet_inode = 0;
+  columns->sheet_size = 0;
+}
+
+void free_time_columns(struct time_columns* const columns) {
+  assert(NULL != columns);
+
+  free(columns->times);
+  free(columns->name_ids);
+  free(columns->pool);
+  free(columns->name_starts);
+  free(columns->slots);
+  init_time_columns(columns);
+}
+
+const char* get_time_column_name(const struct time_columns* const columns,
+    const uint32_t name_id) {
+  assert(NULL != columns);
+  assert(name_id < columns->name_count);
+
+  return &columns->pool[columns->name_starts[name_id]];
+}
+
+size_t find_name_slot(const struct time_columns* const columns, const char*
+    const name) {
+  const size_t mask = columns->slot_count - 1;
+  size_t slot = ebs_hash_murmur3(name, strlen(name), NAME_HASH_SEED) & mask;
+  while (0 != columns->slots[slot]) {
+    if (0 == strcmp(name, get_time_column_name(columns, (uint32_t)
+            (columns->slots[slot] - 1)))) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+struct error index_names(struct time_columns* const columns) {
+  struct error error;
+  size_t slot_count = 2 * MIN_COLUMN_NAME;
+  while (slot_count < 2 * columns->max_name) {
+    slot_count *= 2;
+  }
+  size_t* const slots = calloc(slot_count, sizeof(size_t));
+  if (NULL == slots) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  free(columns->slots);
+  columns->slots = slots;
+  columns->slot_count = slot_count;
+  for (size_t name_num = 0; name_num < columns->name_count; name_num++) {
+    const size_t slot = find_name_slot(columns,
+        get_time_column_name(columns, (uint32_t) name_num));
+    columns->slots[slot] = name_num + 1;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error grow_names(struct time_columns* const columns, const size_t
+    length) {
+  struct error error;
+  if (columns->max_pool < columns->pool_size + length) {
+    size_t max_pool = (0 == columns->max_pool) ? MIN_COLUMN_POOL :
+      columns->max_pool;
+    while (max_pool < columns->pool_size + length) {
+      max_pool *= 2;
+    }
+    char* const pool = realloc(columns->pool, max_pool);
+    if (NULL == pool) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    columns->pool = pool;
+    columns->max_pool = max_pool;
+  }
+  if (columns->name_count < columns->max_name) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+  const size_t max_name = (0 == columns->max_name) ? MIN_COLUMN_NAME : 2 *
+    columns->max_name;
+  uint32_t* const name_starts = realloc(columns->name_starts, max_name *
+      sizeof(uint32_t));
+  if (NULL == name_starts) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  columns->name_starts = name_starts;
+  columns->max_name = max_name;
+  return index_names(columns);
+}
+
+struct error intern_name(struct time_columns* const columns, const char* const
+    name, uint32_t* const name_id) {
+  struct error error;
+  if (0 < columns->slot_count) {
+    const size_t slot = find_name_slot(columns, name);
+    if (0 != columns->slots[slot]) {
+      *name_id = (uint32_t) (columns->slots[slot] - 1);
+      error.code = ERROR_NONE;
+      return error;
+    }
+  }
+  const size_t length = strlen(name) + 1;
+  error = grow_names(columns, length);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  memcpy(&columns->pool[columns->pool_size], name, length);
+  columns->name_starts[columns->name_count] = (uint32_t) columns->pool_size;
+  columns->pool_size += length;
+  *name_id = (uint32_t) columns->name_count;
+  columns->name_count++;
+  columns->slots[find_name_slot(columns, name)] = columns->name_count;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error add_time_column(struct time_columns* const columns, const struct
+    time_record* const record) {
+  assert(NULL != columns);
+  assert(NULL != record);
+
+  struct error error;
+  if (columns->record_count == columns->max_record) {
+    const size_t max_record = (0 == columns->max_record) ? MIN_COLUMN_RECORD
+      : 2 * columns->max_record;
+    int64_t* const times = realloc(columns->times, max_record *
+        sizeof(int64_t));
+    if (NULL == times) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    columns->times = times;
+    uint32_t* const name_ids = realloc(columns->name_ids, max_record *
+        sizeof(uint32_t));
+    if (NULL == name_ids) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    columns->name_ids = name_ids;
+    columns->max_record = max_record;
+  }
+  uint32_t name_id;
+  error = intern_name(columns, record->name, &name_id);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  columns->times[columns->record_count] = (int64_t) record->time;
+  columns->name_ids[columns->record_count] = name_id;
+  columns->record_count++;
+  return error;
+}
+
+struct error hash_sheet_tail(FILE* const sheet, const uint64_t size, uint64_t*
+    const tail_hash) {
+  struct error error;
+  char bytes[TAIL_CHECK_SIZE];
+  const size_t length = (size < TAIL_CHECK_SIZE) ? (size_t) size :
+    TAIL_CHECK_SIZE;
+  if ((0 != fseek(sheet, (long) (size - length), SEEK_SET)) || (length !=
+        fread(bytes, 1, length, sheet))) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  *tail_hash = ebs_hash_murmur3(bytes, length, NAME_HASH_SEED);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error read_time_snapshot(const char* const snapshot_file, FILE* const
+    sheet, const struct stat* const status, struct time_columns* const
+    columns) {
+  struct error error;
+  error.code = ERROR_STALE_INDEX;
+  FILE* const fp = fopen(snapshot_file, "rb");
+  if (NULL == fp) {
+    return error;
+  }
+  struct snapshot_header header;
+  uint64_t tail_hash;
+  struct stat snapshot_status;
+  /* Every count is checked against the size of the snapshot before it is
+   * used to allocate. */
+  if ((1 != fread(&header, sizeof(header), 1, fp)) || (0 !=
+        memcmp(header.magic, TIME_SNAPSHOT_MAGIC,
+          sizeof(TIME_SNAPSHOT_MAGIC))) || (0 != fstat(fileno(fp),
+            &snapshot_status)) || ((uint64_t) status->st_ino !=
+          header.sheet_inode) || ((uint64_t) status->st_size <
+            header.sheet_size) || (header.sheet_size < header.name_count) ||
+      (header.sheet_size < header.record_count) || (UINT32_MAX <
+        header.pool_size) ||
+      ((uint64_t) snapshot_status.st_size != sizeof(header) +
+       header.name_count * sizeof(uint32_t) + header.pool_size +
+       header.record_count * sizeof(uint32_t) + header.epoch_size) ||
+      (ERROR_NONE !=
+        hash_sheet_tail(sheet, header.sheet_size, &tail_hash).code) ||
+      (tail_hash != header.tail_hash)) {
+    fclose(fp);
+    return error;
+  }
+
+  columns->name_count = (size_t) header.name_count;
+  columns->max_name = columns->name_count;
+  columns->pool_size = (size_t) header.pool_size;
+  columns->max_pool = columns->pool_size;
+  columns->record_count = (size_t) header.record_count;
+  columns->max_record = columns->record_count;
+  columns->name_starts = malloc((columns->name_count + 1) *
+      sizeof(uint32_t));
+  columns->pool = malloc(columns->pool_size + 1);
+  columns->name_ids = malloc((columns->record_count + 1) * sizeof(uint32_t));
+  columns->times = malloc((columns->record_count + 1) * sizeof(int64_t));
+  unsigned char* const epochs = malloc((size_t) header.epoch_size + 1);
+  if ((NULL == columns->name_starts) || (NULL == columns->pool) || (NULL ==
+        columns->name_ids) || (NULL == columns->times) || (NULL == epochs)) {
+    free(epochs);
+    fclose(fp);
+    free_time_columns(columns);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  bool is_read = (columns->name_count == fread(columns->name_starts,
+        sizeof(uint32_t), columns->name_count, fp)) && (columns->pool_size ==
+        fread(columns->pool, 1, columns->pool_size, fp)) &&
+    (columns->record_count == fread(columns->name_ids, sizeof(uint32_t),
+        columns->record_count, fp)) && (header.epoch_size == fread(epochs, 1,
+          (size_t) header.epoch_size, fp));
+  fclose(fp);
+
+  /* A name must end within the pool, and an id must name one. */
+  is_read = is_read && ((0 == columns->pool_size) || ('\0' ==
+        columns->pool[columns->pool_size - 1]));
+  for (size_t name_num = 0; is_read && (name_num < columns->name_count);
+      name_num++) {
+    is_read = (columns->name_starts[name_num] < columns->pool_size);
+  }
+  for (size_t record_num = 0; is_read && (record_num <
+        columns->record_count); record_num++) {
+    is_read = (columns->name_ids[record_num] < columns->name_count);
+  }
+
+  /* Decode the times in one pass. */
+  size_t byte_num = 0;
+  uint64_t time = 0;
+  for (size_t record_num = 0; is_read && (record_num <
+        columns->record_count); record_num++) {
+    uint64_t zigzag = 0;
+    unsigned shift = 0;
+    unsigned char byte;
+    do {
+      if ((header.epoch_size <= byte_num) || (64 <= shift)) {
+        is_read = false;
+        break;
+      }
+      byte = epochs[byte_num];
+      byte_num++;
+      zigzag |= (uint64_t) (byte & 0x7f) << shift;
+      shift += 7;
+    } while (0 != (byte & 0x80));
+    time += (zigzag >> 1) ^ ((uint64_t) 0 - (zigzag & 1));
+    columns->times[record_num] = (int64_t) time;
+  }
+  free(epochs);
+  if (!is_read || (ERROR_NONE != index_names(columns).code)) {
+    free_time_columns(columns);
+    return error;
+  }
+  columns->sheet_inode = header.sheet_inode;
+  columns->sheet_size = header.sheet_size;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error read_time_tail(FILE* const sheet, struct time_columns* const
+    columns) {
+  struct error error;
+  if (0 != fseek(sheet, (long) columns->sheet_size, SEEK_SET)) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    char line[MAX_LINE];
+    size_t length;
+    error = get_line(sheet, line, MAX_LINE, &length);
+    if (ERROR_END_OF_FILE == error.code) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    const long offset = ftell(sheet);
+    if (offset < 0) {
+      error.code = ERROR_FILE;
+      break;
+    }
+    columns->sheet_size = (uint64_t) offset;
+    struct time_record record;
+    if ((ERROR_NONE != error.code) || (ERROR_NONE != parse_time_record(line,
+            &record).code)) {
+      error.code = ERROR_NONE;
+      continue;
+    }
+    error = add_time_column(columns, &record);
+    if (ERROR_NONE != error.code) {
+      break;
+    }
+  }
+  return error;
+}
+
+struct error load_time_columns(const char* const snapshot_file, const char*
+    const time_sheet, struct time_columns* const columns) {
+  assert(NULL != snapshot_file);
+  assert(NULL != time_sheet);
+  assert(NULL != columns);
+  assert(0 == columns->record_count);
+
+  struct error error;
+  FILE* const sheet = fopen(time_sheet, "rb");
+  if (NULL == sheet) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  struct stat status;
+  if (0 != fstat(fileno(sheet), &status)) {
+    fclose(sheet);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error = read_time_snapshot(snapshot_file, sheet, &status, columns);
+  const bool is_stale = (ERROR_NONE != error.code);
+  if (is_stale) {
+    free_time_columns(columns);
+    columns->sheet_inode = (uint64_t) status.st_ino;
+  }
+  const uint64_t snapshot_size = columns->sheet_size;
+  error = read_time_tail(sheet, columns);
+  fclose(sheet);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  /* The snapshot is only a cache, so failing to write it is not an error. */
+  if (is_stale || (MAX_SNAPSHOT_TAIL < columns->sheet_size -
+        snapshot_size)) {
+    write_time_snapshot(snapshot_file, time_sheet, columns);
+  }
+  return error;
+}
+
+struct error write_time_snapshot(const char* const snapshot_file, const char*
+    const time_sheet, const struct time_columns* const columns) {
+  assert(NULL != snapshot_file);
+  assert(NULL != time_sheet);
+  assert(NULL != columns);
+
+  struct error error;
+  struct snapshot_header header;
+  memcpy(header.magic, TIME_SNAPSHOT_MAGIC, sizeof(TIME_SNAPSHOT_MAGIC));
+  header.sheet_inode = columns->sheet_inode;
+  header.sheet_size = columns->sheet_size;
+  header.record_count = columns->record_count;
+  header.name_count = columns->name_count;
+  header.pool_size = columns->pool_size;
+  FILE* const sheet = fopen(time_sheet, "rb");
+  if (NULL == sheet) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error = hash_sheet_tail(sheet, columns->sheet_size, &header.tail_hash);
+  fclose(sheet);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+
+  unsigned char* const epochs = malloc(columns->record_count *
+      MAX_VARINT_BYTES + 1);
+  if (NULL == epochs) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  size_t epoch_size = 0;
+  uint64_t previous = 0;
+  for (size_t record_num = 0; record_num < columns->record_count;
+      record_num++) {
+    const uint64_t time = (uint64_t) columns->times[record_num];
+    const uint64_t delta = time - previous;
+    /* Move the sign to the lowest bit so that small steps back are short
+     * too. */
+    uint64_t zigzag = (delta << 1) ^ ((uint64_t) 0 - (delta >> 63));
+    previous = time;
+    while (0x80 <= zigzag) {
+      epochs[epoch_size] = (unsigned char) (zigzag | 0x80);
+      epoch_size++;
+      zigzag >>= 7;
+    }
+    epochs[epoch_size] = (unsigned char) zigzag;
+    epoch_size++;
+  }
+  header.epoch_size = epoch_size;
+
+  char temp_file[MAX_SNAPSHOT_PATH + 8];
+  snprintf(temp_file, sizeof(temp_file), "%s.tmp", snapshot_file);
+  FILE* const out = fopen(temp_file, "wb");
+  if (NULL == out) {
+    free(epochs);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  bool is_written = (1 == fwrite(&header, sizeof(header), 1, out)) &&
+    (columns->name_count == fwrite(columns->name_starts, sizeof(uint32_t),
+        columns->name_count, out)) && (columns->pool_size ==
+        fwrite(columns->pool, 1, columns->pool_size, out)) &&
+    (columns->record_count == fwrite(columns->name_ids, sizeof(uint32_t),
+        columns->record_count, out)) && (epoch_size == fwrite(epochs, 1,
+          epoch_size, out));
+  is_written = (0 == fclose(out)) && is_written;
+  free(epochs);
+  if (!is_written || (0 != rename(temp_file, snapshot_file))) {
+    remove(temp_file);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error add_column_times(const struct time_columns* const columns,
+    struct task* const tasks, const size_t task_count) {
+  assert(NULL != columns);
+  assert(NULL != tasks);
+
+  struct error error;
+  /* Look each task up once, so that the records are summed in a loop over
+   * the integer columns. */
+  size_t* const task_nums = malloc((columns->name_count + 1) *
+      sizeof(size_t));
+  if (NULL == task_nums) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (size_t name_num = 0; name_num < columns->name_count; name_num++) {
+    task_nums[name_num] = task_count;
+  }
+  for (size_t task_num = task_count; (0 < columns->slot_count) && (0 <
+        task_num); task_num--) {
+    /* Going backwards leaves the first of tasks with the same name. */
+    const size_t slot = find_name_slot(columns, tasks[task_num - 1].name);
+    if (0 != columns->slots[slot]) {
+      task_nums[columns->slots[slot] - 1] = task_num - 1;
+    }
+  }
+  for (size_t record_num = 1; record_num < columns->record_count;
+      record_num++) {
+    const size_t task_num = task_nums[columns->name_ids[record_num - 1]];
+    if (task_num < task_count) {
+      tasks[task_num].actual_seconds += (intmax_t)
+        (columns->times[record_num] - columns->times[record_num - 1]);
+    }
+  }
+  free(task_nums);
+  error.code = ERROR_NONE;
+  return error;
+}
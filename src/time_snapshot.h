@@ -0,0 +1,68 @@
+#ifndef _ebs_time_snapshot_h_
+#define _ebs_time_snapshot_h_
+
+#include "task.h"
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+  /* Bytes of the time sheet past the snapshot that are parsed as text before
+   * the snapshot is written again. */
+  MAX_SNAPSHOT_TAIL = 65536
+};
+
+/* The records of a time sheet as columns: the time of each record and the id
+ * of its task name, in sheet order, with a dictionary of the names. */
+struct time_columns {
+  int64_t* times;
+  uint32_t* name_ids;
+  size_t record_count;
+  size_t max_record;
+  /* The names, each ending in a zero byte, and where each starts. */
+  char* pool;
+  size_t pool_size;
+  size_t max_pool;
+  uint32_t* name_starts;
+  size_t name_count;
+  size_t max_name;
+  /* Open addressing over the names. A slot holds the name id plus one, or
+   * zero if it is empty. */
+  size_t* slots;
+  size_t slot_count;
+  /* The sheet the columns were read from, and the bytes of it read. */
+  uint64_t sheet_inode;
+  uint64_t sheet_size;
+};
+
+/* Initialize empty columns. */
+void init_time_columns(struct time_columns*);
+
+/* Free the memory of the columns. */
+void free_time_columns(struct time_columns*);
+
+/* Add a record at the end of the columns. */
+struct error add_time_column(struct time_columns*, const struct time_record*);
+
+/* Get the name with the given id. */
+const char* get_time_column_name(const struct time_columns*, uint32_t name_id);
+
+/* Read the time sheet into empty columns. The records covered by the
+ * snapshot are taken from it, and only the lines appended to the sheet since
+ * are parsed. The snapshot is written again if it was missing, if the sheet
+ * was rewritten or edited, or if more than MAX_SNAPSHOT_TAIL bytes were
+ * appended. Malformed lines and a last line without a new line are left
+ * out. */
+struct error load_time_columns(const char* snapshot_file, const char*
+    time_sheet, struct time_columns*);
+
+/* Write the columns to the snapshot. The time sheet must still start with
+ * the lines they were read from. */
+struct error write_time_snapshot(const char* snapshot_file, const char*
+    time_sheet, const struct time_columns*);
+
+/* Add the time between each record and the next to the actual time of the
+ * task of the first, as read_time_sheet does. */
+struct error add_column_times(const struct time_columns*, struct task* tasks,
+    size_t task_count);
+
+#endif
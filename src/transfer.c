@@ -0,0 +1,720 @@
+#include "transfer.h"
+#include "error.h"
+#include "utility.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  MAX_LINE = 4096,
+  MAX_FIELD = 256,
+  MAX_SHEET_PATH = 4096,
+  MAX_LOOP = 100000000,
+  TASK_FIELD_COUNT = 5,
+  RECORD_FIELD_COUNT = 2
+};
+
+static const char* const format_names[] = {
+  "tsv",
+  "csv",
+  "jsonl"
+};
+
+/* The fields of tasks and time records in the order of the sheets. */
+static const char* const task_fields[] = {
+  "name",
+  "status",
+  "estimate",
+  "actual",
+  "owner"
+};
+
+static const char* const record_fields[] = {
+  "time",
+  "name"
+};
+
+/* Read the next line that holds a record into line. Blank lines are skipped,
+ * and so is a CSV header, recognized by its first field being header. */
+static struct error read_record_line(FILE* fp, enum transfer_format, const
+    char* header, size_t* line_num, char* line);
+
+/* Split a CSV line into at most max_field fields. Fields that are not in the
+ * line are left empty. */
+static struct error split_csv(const char* line, char (*fields)[MAX_FIELD],
+    size_t max_field);
+
+/* Read a JSON string from the opening quote at c into value. Set end past the
+ * closing quote. */
+static struct error parse_json_string(const char* c, char* value, const char**
+    end);
+
+/* Read the values of the given keys from a flat JSON object. Numbers are
+ * kept as text, null and missing keys are empty, and other keys are
+ * skipped. */
+static struct error parse_json_object(const char* line, const char* const*
+    keys, size_t key_count, char (*fields)[MAX_FIELD]);
+
+/* Read the fields of a CSV or JSON lines record. */
+static struct error split_record(const char* line, enum transfer_format, const
+    char* const* keys, size_t key_count, char (*fields)[MAX_FIELD]);
+
+/* Check that a field can go into a sheet, whose fields are separated by
+ * whitespace. */
+static bool is_sheet_field(const char* field);
+
+/* Write a field of a CSV row, quoting it if needed. */
+static void write_csv_field(FILE* fp, const char* field);
+
+/* Write a JSON string. */
+static void write_json_string(FILE* fp, const char* string);
+
+/* Order pointers to time records by time and then by position. */
+static int compare_records(const void*, const void*);
+
+/* Write the records from begin to end in TSV, skipping the ones set to NULL
+ * as duplicates, and count them in merged_count. */
+static struct error write_merged_records(FILE* fp, const struct time_record**
+    order, size_t begin, size_t end, size_t* merged_count);
+
+struct error parse_transfer_format(const char* const str, enum
+    transfer_format* const format) {
+  assert(MAX_FORMAT == sizeof(format_names) / sizeof(format_names[0]));
+  assert(NULL != str);
+  assert(NULL != format);
+
+  struct error error;
+  for (enum transfer_format format_num = 0; format_num < MAX_FORMAT;
+      format_num++) {
+    if (0 == strcmp(str, format_names[format_num])) {
+      *format = format_num;
+      error.code = ERROR_NONE;
+      return error;
+    }
+  }
+  error.code = ERROR_UNKNOWN_FORMAT;
+  return error;
+}
+
+void write_transfer_header(FILE* const fp, const enum transfer_format format,
+    const bool is_time) {
+  assert(NULL != fp);
+
+  if (FORMAT_CSV != format) {
+    return;
+  }
+  const char* const* const fields = is_time ? record_fields : task_fields;
+  const size_t field_count = is_time ? RECORD_FIELD_COUNT : TASK_FIELD_COUNT;
+  for (size_t field_num = 0; field_num < field_count; field_num++) {
+    fprintf(fp, "%s%s", (0 < field_num) ? "," : "", fields[field_num]);
+  }
+  fputc('\n', fp);
+}
+
+struct error read_record_line(FILE* const fp, const enum transfer_format
+    format, const char* const header, size_t* const line_num, char* const
+    line) {
+  struct error error;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    size_t bytes_read;
+    error = get_line(fp, line, MAX_LINE, &bytes_read);
+    if ((ERROR_END_OF_FILE == error.code) && (0 == bytes_read)) {
+      return error;
+    }
+    *line_num += 1;
+    if (ERROR_BUFFER_LIMIT == error.code) {
+      return error;
+    }
+    if ((0 < bytes_read) && ('\r' == line[bytes_read - 1])) {
+      line[bytes_read - 1] = '\0';
+    }
+    const char* c = line;
+    while (isspace((unsigned char) *c)) {
+      c++;
+    }
+    if ('\0' == *c) {
+      continue;
+    }
+    const size_t header_length = strlen(header);
+    if ((FORMAT_CSV == format) && (0 == strncmp(line, header, header_length))
+        && ((',' == line[header_length]) || ('\0' == line[header_length]))) {
+      continue;
+    }
+    error.code = ERROR_NONE;
+    return error;
+  }
+  error.code = ERROR_END_OF_FILE;
+  return error;
+}
+
+struct error split_csv(const char* const line, char (*fields)[MAX_FIELD],
+    const size_t max_field) {
+  struct error error;
+  for (size_t field_num = 0; field_num < max_field; field_num++) {
+    fields[field_num][0] = '\0';
+  }
+  error.code = ERROR_MALFORMED_RECORD;
+  const char* c = line;
+  for (size_t field_num = 0; field_num < max_field; field_num++) {
+    char* const field = fields[field_num];
+    size_t length = 0;
+    if ('"' == *c) {
+      c++;
+      while (true) {
+        if ('\0' == *c) {
+          return error;
+        }
+        if ('"' == *c) {
+          if ('"' != c[1]) {
+            c++;
+            break;
+          }
+          c++;
+        }
+        if (MAX_FIELD - 1 <= length) {
+          return error;
+        }
+        field[length] = *c;
+        length++;
+        c++;
+      }
+      if ((',' != *c) && ('\0' != *c)) {
+        return error;
+      }
+    } else {
+      while ((',' != *c) && ('\0' != *c)) {
+        if (MAX_FIELD - 1 <= length) {
+          return error;
+        }
+        field[length] = *c;
+        length++;
+        c++;
+      }
+    }
+    field[length] = '\0';
+    if ('\0' == *c) {
+      error.code = ERROR_NONE;
+      return error;
+    }
+    c++;
+  }
+  // There are more fields than expected.
+  return error;
+}
+
+struct error parse_json_string(const char* c, char* const value, const char**
+    const end) {
+  struct error error;
+  error.code = ERROR_MALFORMED_RECORD;
+  assert('"' == *c);
+  c++;
+  size_t length = 0;
+  while ('"' != *c) {
+    /* Room for a three byte character and the terminating null. */
+    if ((MAX_FIELD - 4 <= length) || ((unsigned char) *c < 0x20)) {
+      return error;
+    }
+    if ('\\' != *c) {
+      value[length] = *c;
+      length++;
+      c++;
+      continue;
+    }
+    c++;
+    switch (*c) {
+      case '"':
+      case '\\':
+      case '/':
+        value[length] = *c;
+        break;
+      case 'b':
+        value[length] = '\b';
+        break;
+      case 'f':
+        value[length] = '\f';
+        break;
+      case 'n':
+        value[length] = '\n';
+        break;
+      case 'r':
+        value[length] = '\r';
+        break;
+      case 't':
+        value[length] = '\t';
+        break;
+      case 'u': {
+        unsigned long code_point = 0;
+        for (int digit_num = 1; digit_num <= 4; digit_num++) {
+          if (!isxdigit((unsigned char) c[digit_num])) {
+            return error;
+          }
+          const char digit[2] = { c[digit_num], '\0' };
+          code_point = code_point * 16 + strtoul(digit, NULL, 16);
+        }
+        c += 4;
+        /* Surrogate pairs are not supported. */
+        if ((0xd800 <= code_point) && (code_point < 0xe000)) {
+          return error;
+        }
+        if (code_point < 0x80) {
+          value[length] = (char) code_point;
+        } else if (code_point < 0x800) {
+          value[length] = (char) (0xc0 | (code_point >> 6));
+          length++;
+          value[length] = (char) (0x80 | (code_point & 0x3f));
+        } else {
+          value[length] = (char) (0xe0 | (code_point >> 12));
+          length++;
+          value[length] = (char) (0x80 | ((code_point >> 6) & 0x3f));
+          length++;
+          value[length] = (char) (0x80 | (code_point & 0x3f));
+        }
+        break;
+      }
+      default:
+        return error;
+    }
+    length++;
+    c++;
+  }
+  value[length] = '\0';
+  *end = c + 1;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error parse_json_object(const char* const line, const char* const*
+    const keys, const size_t key_count, char (*fields)[MAX_FIELD]) {
+  struct error error;
+  for (size_t key_num = 0; key_num < key_count; key_num++) {
+    fields[key_num][0] = '\0';
+  }
+  error.code = ERROR_MALFORMED_RECORD;
+  const char* c = line;
+  while (isspace((unsigned char) *c)) {
+    c++;
+  }
+  if ('{' != *c) {
+    return error;
+  }
+  c++;
+  while (isspace((unsigned char) *c)) {
+    c++;
+  }
+  bool is_empty = ('}' == *c);
+  if (is_empty) {
+    c++;
+  }
+  while (!is_empty) {
+    char key[MAX_FIELD];
+    if ('"' != *c) {
+      return error;
+    }
+    error = parse_json_string(c, key, &c);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    error.code = ERROR_MALFORMED_RECORD;
+    while (isspace((unsigned char) *c)) {
+      c++;
+    }
+    if (':' != *c) {
+      return error;
+    }
+    c++;
+    while (isspace((unsigned char) *c)) {
+      c++;
+    }
+
+    char value[MAX_FIELD];
+    if ('"' == *c) {
+      error = parse_json_string(c, value, &c);
+      if (ERROR_NONE != error.code) {
+        return error;
+      }
+      error.code = ERROR_MALFORMED_RECORD;
+    } else if (0 == strncmp(c, "null", 4)) {
+      value[0] = '\0';
+      c += 4;
+    } else if (('-' == *c) || isdigit((unsigned char) *c)) {
+      size_t length = 0;
+      while (('-' == *c) || isdigit((unsigned char) *c)) {
+        if (MAX_FIELD - 1 <= length) {
+          return error;
+        }
+        value[length] = *c;
+        length++;
+        c++;
+      }
+      value[length] = '\0';
+    } else {
+      return error;
+    }
+    for (size_t key_num = 0; key_num < key_count; key_num++) {
+      if (0 == strcmp(key, keys[key_num])) {
+        strcpy(fields[key_num], value);
+      }
+    }
+
+    while (isspace((unsigned char) *c)) {
+      c++;
+    }
+    if ('}' == *c) {
+      c++;
+      break;
+    }
+    if (',' != *c) {
+      return error;
+    }
+    c++;
+    while (isspace((unsigned char) *c)) {
+      c++;
+    }
+  }
+  while (isspace((unsigned char) *c)) {
+    c++;
+  }
+  if ('\0' != *c) {
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error split_record(const char* const line, const enum transfer_format
+    format, const char* const* const keys, const size_t key_count, char
+    (*fields)[MAX_FIELD]) {
+  struct error error;
+  if (FORMAT_CSV == format) {
+    error = split_csv(line, fields, key_count);
+  } else {
+    error = parse_json_object(line, keys, key_count, fields);
+  }
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  for (size_t key_num = 0; key_num < key_count; key_num++) {
+    if (!is_sheet_field(fields[key_num])) {
+      error.code = ERROR_MALFORMED_RECORD;
+      return error;
+    }
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+bool is_sheet_field(const char* const field) {
+  for (const char* c = field; '\0' != *c; c++) {
+    if (isspace((unsigned char) *c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct error read_transfer_task(FILE* const fp, const enum transfer_format
+    format, size_t* const line_num, struct task* const task) {
+  assert(NULL != fp);
+  assert(NULL != line_num);
+  assert(NULL != task);
+
+  struct error error;
+  char line[MAX_LINE];
+  error = read_record_line(fp, format, task_fields[0], line_num, line);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  if (FORMAT_TSV == format) {
+    return parse_task(line, task);
+  }
+
+  /* Put the fields back together as a sheet row. */
+  char fields[TASK_FIELD_COUNT][MAX_FIELD];
+  error = split_record(line, format, task_fields, TASK_FIELD_COUNT, fields);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  for (size_t field_num = 0; field_num < TASK_FIELD_COUNT - 1; field_num++) {
+    if ('\0' == fields[field_num][0]) {
+      error.code = ERROR_TASK_MISSING_FIELDS;
+      return error;
+    }
+  }
+  char row[MAX_LINE];
+  snprintf(row, MAX_LINE, "%s\t%s\t%s\t%s\t%s", fields[0], fields[1],
+      fields[2], fields[3], fields[4]);
+  return parse_task(row, task);
+}
+
+struct error read_transfer_record(FILE* const fp, const enum transfer_format
+    format, size_t* const line_num, struct time_record* const record) {
+  assert(NULL != fp);
+  assert(NULL != line_num);
+  assert(NULL != record);
+
+  struct error error;
+  char line[MAX_LINE];
+  error = read_record_line(fp, format, record_fields[0], line_num, line);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  if (FORMAT_TSV == format) {
+    return parse_time_record(line, record);
+  }
+
+  char fields[RECORD_FIELD_COUNT][MAX_FIELD];
+  error = split_record(line, format, record_fields, RECORD_FIELD_COUNT,
+      fields);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  if (('\0' == fields[0][0]) || ('\0' == fields[1][0])) {
+    error.code = ERROR_TIME_RECORD_MISSING_FIELDS;
+    return error;
+  }
+  char row[MAX_LINE];
+  snprintf(row, MAX_LINE, "%s\t%s", fields[0], fields[1]);
+  return parse_time_record(row, record);
+}
+
+void write_csv_field(FILE* const fp, const char* const field) {
+  if (NULL == strpbrk(field, ",\"\r\n")) {
+    fputs(field, fp);
+    return;
+  }
+  fputc('"', fp);
+  for (const char* c = field; '\0' != *c; c++) {
+    if ('"' == *c) {
+      fputc('"', fp);
+    }
+    fputc(*c, fp);
+  }
+  fputc('"', fp);
+}
+
+void write_json_string(FILE* const fp, const char* const string) {
+  fputc('"', fp);
+  for (const char* c = string; '\0' != *c; c++) {
+    if (('"' == *c) || ('\\' == *c)) {
+      fprintf(fp, "\\%c", *c);
+    } else if ((unsigned char) *c < 0x20) {
+      fprintf(fp, "\\u%04x", (unsigned int) (unsigned char) *c);
+    } else {
+      fputc(*c, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+struct error write_transfer_task(FILE* const fp, const enum transfer_format
+    format, const struct task* const task) {
+  assert(NULL != fp);
+  assert(NULL != task);
+
+  struct error error;
+  if (FORMAT_TSV == format) {
+    return write_task(task, fp);
+  }
+  const char* const status = get_task_status(task->status);
+  if (FORMAT_CSV == format) {
+    write_csv_field(fp, task->name);
+    fprintf(fp, ",%s,%jd,%jd,", status, task->estimated_seconds / 60,
+        task->actual_seconds / 60);
+    write_csv_field(fp, task->owner);
+    fputc('\n', fp);
+  } else {
+    fputs("{\"name\":", fp);
+    write_json_string(fp, task->name);
+    fprintf(fp, ",\"status\":\"%s\",\"estimate\":%jd,\"actual\":%jd", status,
+        task->estimated_seconds / 60, task->actual_seconds / 60);
+    if ('\0' != task->owner[0]) {
+      fputs(",\"owner\":", fp);
+      write_json_string(fp, task->owner);
+    }
+    fputs("}\n", fp);
+  }
+  error.code = ferror(fp) ? ERROR_FILE : ERROR_NONE;
+  return error;
+}
+
+struct error write_transfer_record(FILE* const fp, const enum transfer_format
+    format, const struct time_record* const record) {
+  assert(NULL != fp);
+  assert(NULL != record);
+
+  struct error error;
+  char buffer[MAX_LINE];
+  error = format_time_record(record, buffer, MAX_LINE);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  if (FORMAT_TSV == format) {
+    fprintf(fp, "%s\n", buffer);
+  } else {
+    /* The time is the formatted record up to the tab. */
+    *strchr(buffer, '\t') = '\0';
+    if (FORMAT_CSV == format) {
+      fprintf(fp, "%s,", buffer);
+      write_csv_field(fp, record->name);
+      fputc('\n', fp);
+    } else {
+      fprintf(fp, "{\"time\":\"%s\",\"name\":", buffer);
+      write_json_string(fp, record->name);
+      fputs("}\n", fp);
+    }
+  }
+  error.code = ferror(fp) ? ERROR_FILE : ERROR_NONE;
+  return error;
+}
+
+int compare_records(const void* const a, const void* const b) {
+  const struct time_record* const first = *(const struct time_record* const*)
+    a;
+  const struct time_record* const second = *(const struct time_record*
+      const*) b;
+  if (first->time != second->time) {
+    return (first->time < second->time) ? -1 : 1;
+  }
+  if (first != second) {
+    return (first < second) ? -1 : 1;
+  }
+  return 0;
+}
+
+struct error write_merged_records(FILE* const fp, const struct time_record**
+    const order, const size_t begin, const size_t end, size_t* const
+    merged_count) {
+  struct error error;
+  error.code = ERROR_NONE;
+  for (size_t order_num = begin; order_num < end; order_num++) {
+    if (NULL == order[order_num]) {
+      continue;
+    }
+    error = write_transfer_record(fp, FORMAT_TSV, order[order_num]);
+    if (ERROR_NONE != error.code) {
+      return error;
+    }
+    *merged_count += 1;
+  }
+  return error;
+}
+
+struct error merge_time_records(const char* const time_sheet, struct
+    time_record* const records, const size_t record_count, size_t* const
+    merged_count) {
+  assert(NULL != time_sheet);
+  assert((NULL != records) || (0 == record_count));
+  assert(NULL != merged_count);
+
+  struct error error;
+  *merged_count = 0;
+  const struct time_record** const order = malloc((record_count + 1) *
+      sizeof(const struct time_record*));
+  if (NULL == order) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (size_t record_num = 0; record_num < record_count; record_num++) {
+    order[record_num] = &records[record_num];
+  }
+  qsort(order, record_count, sizeof(const struct time_record*),
+      compare_records);
+
+  char temp_sheet[MAX_SHEET_PATH + 8];
+  snprintf(temp_sheet, sizeof(temp_sheet), "%s.tmp", time_sheet);
+  FILE* const fin = fopen(time_sheet, "r");
+  FILE* const fout = (NULL == fin) ? NULL : fopen(temp_sheet, "w");
+  if (NULL == fout) {
+    if (NULL != fin) {
+      fclose(fin);
+    }
+    free(order);
+    error.code = ERROR_FILE;
+    return error;
+  }
+
+  /* Existing lines are copied as they are, with the new records that come
+   * before them written first. New records with the time of existing ones
+   * are held from tie_begin to tie_end until every existing record of that
+   * time has been read, and then written after them unless their name was
+   * among them. */
+  size_t order_num = 0;
+  size_t tie_begin = 0;
+  size_t tie_end = 0;
+  time_t tie_time = 0;
+  error.code = ERROR_NONE;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    char line[MAX_LINE];
+    size_t bytes_read;
+    error = get_line(fin, line, MAX_LINE, &bytes_read);
+    if ((ERROR_END_OF_FILE == error.code) && (0 == bytes_read)) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    if (ERROR_BUFFER_LIMIT == error.code) {
+      break;
+    }
+    error.code = ERROR_NONE;
+    struct time_record existing;
+    if (ERROR_NONE == parse_time_record(line, &existing).code) {
+      if ((tie_begin < tie_end) && (existing.time != tie_time)) {
+        error = write_merged_records(fout, order, tie_begin, tie_end,
+            merged_count);
+        tie_begin = tie_end;
+      }
+      size_t earlier_end = order_num;
+      while ((earlier_end < record_count) && (order[earlier_end]->time <
+            existing.time)) {
+        earlier_end++;
+      }
+      if (ERROR_NONE == error.code) {
+        error = write_merged_records(fout, order, order_num, earlier_end,
+            merged_count);
+      }
+      if (ERROR_NONE != error.code) {
+        break;
+      }
+      order_num = earlier_end;
+      if (tie_begin == tie_end) {
+        tie_begin = order_num;
+        while ((order_num < record_count) && (order[order_num]->time ==
+              existing.time)) {
+          order_num++;
+        }
+        tie_end = order_num;
+        tie_time = existing.time;
+      }
+      for (size_t tie_num = tie_begin; tie_num < tie_end; tie_num++) {
+        if ((NULL != order[tie_num]) && (0 == strcmp(existing.name,
+                order[tie_num]->name))) {
+          order[tie_num] = NULL;
+        }
+      }
+    }
+    fprintf(fout, "%s\n", line);
+  }
+  if (ERROR_NONE == error.code) {
+    error = write_merged_records(fout, order, tie_begin, record_count,
+        merged_count);
+  }
+  free(order);
+  fclose(fin);
+  if ((0 != fclose(fout)) && (ERROR_NONE == error.code)) {
+    error.code = ERROR_FILE;
+  }
+  if ((ERROR_NONE != error.code) || (0 != rename(temp_sheet, time_sheet))) {
+    remove(temp_sheet);
+    *merged_count = 0;
+    if (ERROR_NONE == error.code) {
+      error.code = ERROR_FILE;
+    }
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
@@ -0,0 +1,54 @@
+#ifndef _ebs_transfer_h_
+#define _ebs_transfer_h_
+
+#include "task.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* Formats for importing and exporting tasks and time records. TSV is the
+ * format of the sheets. CSV has a header row and quotes fields as in RFC
+ * 4180, except that quoted fields can't span lines. JSON lines has one flat
+ * object per line. */
+enum transfer_format {
+  FORMAT_TSV,
+  FORMAT_CSV,
+  FORMAT_JSONL,
+  MAX_FORMAT
+};
+
+/* Parse the name of a format. Return ERROR_UNKNOWN_FORMAT if there is no
+ * match. */
+struct error parse_transfer_format(const char* str, enum transfer_format*);
+
+/* Write the header of a table of tasks or time records, if the format has
+ * one. */
+void write_transfer_header(FILE* fp, enum transfer_format, bool is_time);
+
+/* Read the next task from the stream, skipping blank lines and CSV headers.
+ * line_num is advanced past the lines read. Return ERROR_END_OF_FILE at the
+ * end and ERROR_MALFORMED_RECORD if the line can't be read as a task. */
+struct error read_transfer_task(FILE* fp, enum transfer_format, size_t*
+    line_num, struct task*);
+
+/* Write a task to the stream. */
+struct error write_transfer_task(FILE* fp, enum transfer_format, const struct
+    task*);
+
+/* Read the next time record from the stream like read_transfer_task. */
+struct error read_transfer_record(FILE* fp, enum transfer_format, size_t*
+    line_num, struct time_record*);
+
+/* Write a time record to the stream. */
+struct error write_transfer_record(FILE* fp, enum transfer_format, const
+    struct time_record*);
+
+/* Sort the records by time, keeping the order of records with the same time,
+ * and merge them into the time sheet in one pass. The sheet is replaced
+ * through a temporary file. Records already in the sheet with the same time
+ * and name are skipped. merged_count is set to the number of records
+ * added. */
+struct error merge_time_records(const char* time_sheet, struct time_record*
+    records, size_t record_count, size_t* merged_count);
+
+#endif
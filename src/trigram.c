@@ -0,0 +1,669 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trigram.h"
+#include "error.h"
+#include "expression.h"
+#include "task.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+enum {
+  MAX_INDEX_PATH = 4096,
+  MAX_NAME_TRIGRAM = MAX_TASK_NAME,
+  MAX_LOOP = 1000000
+};
+
+static const char INDEX_MAGIC[8] = {'e', 'b', 's', 't', 'r', 'i', '1', '\n'};
+
+/* The header of the index file. It is followed by trigram_count + 1 table
+ * entries, posting_count row offsets, and delta_count postings appended since
+ * the index was built. */
+struct index_header {
+  char magic[8];
+  uint64_t sheet_size;
+  int64_t sheet_modified;
+  uint64_t trigram_count;
+  uint64_t posting_count;
+  uint64_t delta_count;
+};
+
+/* A trigram and a row offset. In the table, offset is the first posting of
+ * the trigram instead. */
+struct posting {
+  uint64_t trigram;
+  uint64_t offset;
+};
+
+/* A growable list of row offsets in sheet order. */
+struct offset_list {
+  uint64_t* offsets;
+  size_t length;
+  size_t capacity;
+};
+
+/* An open index. The postings of the main segment are read on demand. */
+struct index_reader {
+  FILE* fp;
+  struct index_header header;
+  struct posting* table;
+  struct posting* delta;
+};
+
+/* Get the distinct trigrams of a name, sorted. Return their number. */
+static size_t get_name_trigrams(const char* name, size_t name_length,
+    uint64_t* trigrams);
+
+/* Compare trigrams for qsort. */
+static int compare_trigrams(const void*, const void*);
+
+/* Compare postings by trigram then offset for qsort. */
+static int compare_postings(const void*, const void*);
+
+/* Add an offset to the end of a list. */
+static struct error add_offset(struct offset_list*, uint64_t offset);
+
+/* Keep the offsets of the first list that are also in the second. */
+static void intersect_offsets(struct offset_list*, const struct offset_list*);
+
+/* Merge the offsets of two lists into a third. */
+static struct error unite_offsets(const struct offset_list*, const struct
+    offset_list*, struct offset_list* result);
+
+/* Write the index of the postings to a temporary file and move it in place. */
+static struct error write_trigram_index(const char* index_file, const struct
+    sheet_stamp*, struct posting* postings, size_t posting_count);
+
+/* Open an index and check that it is up to date with the sheet. */
+static struct error open_index(const char* index_file, const char* sheet,
+    struct index_reader*);
+
+/* Close an open index. */
+static void close_index(struct index_reader*);
+
+/* Read the offsets of the rows containing a trigram. */
+static struct error read_postings(struct index_reader*, uint64_t trigram,
+    struct offset_list*);
+
+/* Find the rows whose names may contain a literal. */
+static struct error find_literal_rows(struct index_reader*, const char*
+    name, size_t name_length, struct offset_list*);
+
+/* Check if a disjunction only has positive substrings that are long enough to
+ * have trigrams. */
+static bool is_indexed_disjunction(const struct expression*, size_t
+    disjunction_num);
+
+struct error get_sheet_stamp(const char* const sheet, struct sheet_stamp*
+    const stamp) {
+  assert(NULL != sheet);
+  assert(NULL != stamp);
+
+  struct error error;
+  struct stat status;
+  if (0 != stat(sheet, &status)) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  stamp->size = (uint64_t) status.st_size;
+  stamp->modified = (int64_t) status.st_mtim.tv_sec * 1000000000 +
+    (int64_t) status.st_mtim.tv_nsec;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+int compare_trigrams(const void* const first, const void* const second) {
+  const uint64_t first_trigram = *(const uint64_t*) first;
+  const uint64_t second_trigram = *(const uint64_t*) second;
+  return (first_trigram > second_trigram) - (first_trigram < second_trigram);
+}
+
+int compare_postings(const void* const first, const void* const second) {
+  const struct posting* const first_posting = first;
+  const struct posting* const second_posting = second;
+  if (first_posting->trigram != second_posting->trigram) {
+    return (first_posting->trigram > second_posting->trigram) ? 1 : -1;
+  }
+  return (first_posting->offset > second_posting->offset) -
+    (first_posting->offset < second_posting->offset);
+}
+
+size_t get_name_trigrams(const char* const name, const size_t name_length,
+    uint64_t* const trigrams) {
+  if (name_length < 3) {
+    return 0;
+  }
+  size_t trigram_count = 0;
+  for (size_t char_num = 0; char_num + 2 < name_length; char_num++) {
+    trigrams[trigram_count] = ((uint64_t) (unsigned char) name[char_num] <<
+        16) | ((uint64_t) (unsigned char) name[char_num + 1] << 8) |
+      (uint64_t) (unsigned char) name[char_num + 2];
+    trigram_count++;
+  }
+  qsort(trigrams, trigram_count, sizeof(uint64_t), compare_trigrams);
+  size_t distinct_count = 1;
+  for (size_t trigram_num = 1; trigram_num < trigram_count; trigram_num++) {
+    if (trigrams[trigram_num] != trigrams[distinct_count - 1]) {
+      trigrams[distinct_count] = trigrams[trigram_num];
+      distinct_count++;
+    }
+  }
+  return distinct_count;
+}
+
+struct error add_offset(struct offset_list* const list, const uint64_t
+    offset) {
+  struct error error;
+  if (list->length == list->capacity) {
+    const size_t capacity = (0 == list->capacity) ? 16 : 2 * list->capacity;
+    uint64_t* const offsets = realloc(list->offsets, capacity *
+        sizeof(uint64_t));
+    if (NULL == offsets) {
+      error.code = ERROR_OUT_OF_MEMORY;
+      return error;
+    }
+    list->offsets = offsets;
+    list->capacity = capacity;
+  }
+  list->offsets[list->length] = offset;
+  list->length++;
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void intersect_offsets(struct offset_list* const list, const struct
+    offset_list* const other) {
+  size_t length = 0;
+  size_t other_num = 0;
+  for (size_t offset_num = 0; offset_num < list->length; offset_num++) {
+    const uint64_t offset = list->offsets[offset_num];
+    while ((other_num < other->length) && (other->offsets[other_num] <
+          offset)) {
+      other_num++;
+    }
+    if ((other_num < other->length) && (other->offsets[other_num] ==
+          offset)) {
+      list->offsets[length] = offset;
+      length++;
+    }
+  }
+  list->length = length;
+}
+
+struct error unite_offsets(const struct offset_list* const first, const
+    struct offset_list* const second, struct offset_list* const result) {
+  struct error error;
+  error.code = ERROR_NONE;
+  result->length = 0;
+  size_t first_num = 0;
+  size_t second_num = 0;
+  while ((ERROR_NONE == error.code) && ((first_num < first->length) ||
+        (second_num < second->length))) {
+    uint64_t offset;
+    if ((second->length <= second_num) || ((first_num < first->length) &&
+          (first->offsets[first_num] <= second->offsets[second_num]))) {
+      offset = first->offsets[first_num];
+      first_num++;
+    } else {
+      offset = second->offsets[second_num];
+      second_num++;
+    }
+    if ((0 == result->length) || (result->offsets[result->length - 1] !=
+          offset)) {
+      error = add_offset(result, offset);
+    }
+  }
+  return error;
+}
+
+struct error write_trigram_index(const char* const index_file, const struct
+    sheet_stamp* const stamp, struct posting* const postings, const size_t
+    posting_count) {
+  struct error error;
+  qsort(postings, posting_count, sizeof(struct posting), compare_postings);
+
+  /* The table has an entry for each trigram and one past the end. */
+  size_t trigram_count = 0;
+  for (size_t posting_num = 0; posting_num < posting_count; posting_num++) {
+    if ((0 == posting_num) || (postings[posting_num].trigram !=
+          postings[posting_num - 1].trigram)) {
+      trigram_count++;
+    }
+  }
+  struct posting* const table = malloc((trigram_count + 1) * sizeof(struct
+        posting));
+  uint64_t* const offsets = malloc((posting_count + 1) * sizeof(uint64_t));
+  if ((NULL == table) || (NULL == offsets)) {
+    free(table);
+    free(offsets);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  size_t trigram_num = 0;
+  for (size_t posting_num = 0; posting_num < posting_count; posting_num++) {
+    if ((0 == posting_num) || (postings[posting_num].trigram !=
+          postings[posting_num - 1].trigram)) {
+      table[trigram_num].trigram = postings[posting_num].trigram;
+      table[trigram_num].offset = posting_num;
+      trigram_num++;
+    }
+    offsets[posting_num] = postings[posting_num].offset;
+  }
+  table[trigram_count].trigram = UINT64_MAX;
+  table[trigram_count].offset = posting_count;
+
+  struct index_header header;
+  memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header.sheet_size = stamp->size;
+  header.sheet_modified = stamp->modified;
+  header.trigram_count = trigram_count;
+  header.posting_count = posting_count;
+  header.delta_count = 0;
+
+  char temp_file[MAX_INDEX_PATH];
+  snprintf(temp_file, MAX_INDEX_PATH, "%s.tmp", index_file);
+  FILE* const fp = fopen(temp_file, "wb");
+  if (NULL == fp) {
+    free(table);
+    free(offsets);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  bool is_written = (1 == fwrite(&header, sizeof(header), 1, fp)) &&
+    (trigram_count + 1 == fwrite(table, sizeof(struct posting), trigram_count
+      + 1, fp)) && (posting_count == fwrite(offsets, sizeof(uint64_t),
+        posting_count, fp));
+  is_written = (0 == fclose(fp)) && is_written;
+  free(table);
+  free(offsets);
+  if (!is_written || (0 != rename(temp_file, index_file))) {
+    remove(temp_file);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error build_trigram_index(const char* const index_file, const char*
+    const sheet) {
+  assert(NULL != index_file);
+  assert(NULL != sheet);
+
+  struct error error;
+  struct sheet_stamp stamp;
+  error = get_sheet_stamp(sheet, &stamp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  FILE* const fp = fopen(sheet, "r");
+  if (NULL == fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+
+  size_t posting_count = 0;
+  size_t posting_capacity = 256;
+  struct posting* postings = malloc(posting_capacity * sizeof(struct
+        posting));
+  error.code = (NULL == postings) ? ERROR_OUT_OF_MEMORY : ERROR_NONE;
+  for (size_t loop_num = 0; (ERROR_NONE == error.code) && (loop_num <
+        MAX_LOOP); loop_num++) {
+    const long offset = ftell(fp);
+    struct task task;
+    error = read_task(fp, &task);
+    if (ERROR_END_OF_FILE == error.code) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    if (ERROR_NONE != error.code) {
+      // Rows that don't parse are skipped by readers too.
+      error.code = ERROR_NONE;
+      continue;
+    }
+    uint64_t trigrams[MAX_NAME_TRIGRAM];
+    const size_t trigram_count = get_name_trigrams(task.name,
+        strlen(task.name), trigrams);
+    if (posting_capacity < posting_count + trigram_count) {
+      posting_capacity = 2 * posting_capacity + trigram_count;
+      struct posting* const grown = realloc(postings, posting_capacity *
+          sizeof(struct posting));
+      if (NULL == grown) {
+        error.code = ERROR_OUT_OF_MEMORY;
+        break;
+      }
+      postings = grown;
+    }
+    for (size_t trigram_num = 0; trigram_num < trigram_count; trigram_num++) {
+      postings[posting_count].trigram = trigrams[trigram_num];
+      postings[posting_count].offset = (uint64_t) offset;
+      posting_count++;
+    }
+  }
+  fclose(fp);
+
+  if (ERROR_NONE == error.code) {
+    error = write_trigram_index(index_file, &stamp, postings, posting_count);
+  }
+  free(postings);
+  return error;
+}
+
+struct error append_trigram_index(const char* const index_file, const char*
+    const sheet, const struct sheet_stamp* const previous, const char* const
+    name, const uint64_t offset) {
+  assert(NULL != index_file);
+  assert(NULL != sheet);
+  assert(NULL != previous);
+  assert(NULL != name);
+
+  struct error error;
+  error.code = ERROR_STALE_INDEX;
+  FILE* const fp = fopen(index_file, "r+b");
+  if (NULL == fp) {
+    return error;
+  }
+  struct index_header header;
+  uint64_t trigrams[MAX_NAME_TRIGRAM];
+  const size_t trigram_count = get_name_trigrams(name, strlen(name),
+      trigrams);
+  struct sheet_stamp stamp;
+  if ((1 != fread(&header, sizeof(header), 1, fp)) || (0 !=
+        memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC))) ||
+      (previous->size != header.sheet_size) || (previous->modified !=
+        header.sheet_modified) || (MAX_TRIGRAM_DELTA < header.delta_count +
+          trigram_count) || (ERROR_NONE != get_sheet_stamp(sheet,
+              &stamp).code)) {
+    fclose(fp);
+    return error;
+  }
+
+  /* Write the postings before the header that makes them count. */
+  bool is_written = (0 == fseek(fp, 0, SEEK_END));
+  for (size_t trigram_num = 0; is_written && (trigram_num < trigram_count);
+      trigram_num++) {
+    const struct posting posting = { trigrams[trigram_num], offset };
+    is_written = (1 == fwrite(&posting, sizeof(posting), 1, fp));
+  }
+  header.sheet_size = stamp.size;
+  header.sheet_modified = stamp.modified;
+  header.delta_count += trigram_count;
+  is_written = is_written && (0 == fflush(fp)) && (0 == fseek(fp, 0,
+        SEEK_SET)) && (1 == fwrite(&header, sizeof(header), 1, fp));
+  is_written = (0 == fclose(fp)) && is_written;
+  error.code = is_written ? ERROR_NONE : ERROR_STALE_INDEX;
+  return error;
+}
+
+struct error open_index(const char* const index_file, const char* const
+    sheet, struct index_reader* const reader) {
+  struct error error;
+  reader->table = NULL;
+  reader->delta = NULL;
+  struct sheet_stamp stamp;
+  error = get_sheet_stamp(sheet, &stamp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  error.code = ERROR_STALE_INDEX;
+  reader->fp = fopen(index_file, "rb");
+  if (NULL == reader->fp) {
+    return error;
+  }
+  struct index_header* const header = &reader->header;
+  if ((1 != fread(header, sizeof(*header), 1, reader->fp)) || (0 !=
+        memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC))) ||
+      (stamp.size != header->sheet_size) || (stamp.modified !=
+        header->sheet_modified) || (MAX_TRIGRAM_DELTA < header->delta_count)
+      || (stamp.size < header->posting_count) || (header->posting_count <
+        header->trigram_count)) {
+    close_index(reader);
+    return error;
+  }
+
+  /* The counts are bounded by the size of the sheet, so they are safe to
+   * allocate. */
+  const size_t trigram_count = (size_t) header->trigram_count;
+  const size_t delta_count = (size_t) header->delta_count;
+  reader->table = malloc((trigram_count + 1) * sizeof(struct posting));
+  reader->delta = malloc((delta_count + 1) * sizeof(struct posting));
+  if ((NULL == reader->table) || (NULL == reader->delta)) {
+    close_index(reader);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  bool is_valid = (trigram_count + 1 == fread(reader->table, sizeof(struct
+          posting), trigram_count + 1, reader->fp)) &&
+    (0 == reader->table[0].offset) && (header->posting_count ==
+        reader->table[trigram_count].offset);
+  for (size_t trigram_num = 0; is_valid && (trigram_num < trigram_count);
+      trigram_num++) {
+    is_valid = (reader->table[trigram_num].offset <
+        reader->table[trigram_num + 1].offset) &&
+      ((trigram_num + 1 == trigram_count) ||
+       (reader->table[trigram_num].trigram <
+        reader->table[trigram_num + 1].trigram));
+  }
+  const long delta_start = (long) (sizeof(struct index_header) +
+      (trigram_count + 1) * sizeof(struct posting) + header->posting_count *
+      sizeof(uint64_t));
+  is_valid = is_valid && (0 == fseek(reader->fp, delta_start, SEEK_SET)) &&
+    (delta_count == fread(reader->delta, sizeof(struct posting), delta_count,
+      reader->fp));
+  if (!is_valid) {
+    close_index(reader);
+    error.code = ERROR_STALE_INDEX;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void close_index(struct index_reader* const reader) {
+  if (NULL != reader->fp) {
+    fclose(reader->fp);
+  }
+  free(reader->table);
+  free(reader->delta);
+  reader->fp = NULL;
+  reader->table = NULL;
+  reader->delta = NULL;
+}
+
+struct error read_postings(struct index_reader* const reader, const uint64_t
+    trigram, struct offset_list* const list) {
+  struct error error;
+  error.code = ERROR_NONE;
+  list->length = 0;
+
+  size_t low = 0;
+  size_t high = (size_t) reader->header.trigram_count;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (reader->table[middle].trigram < trigram) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if ((low < reader->header.trigram_count) && (trigram ==
+        reader->table[low].trigram)) {
+    const uint64_t first = reader->table[low].offset;
+    const size_t count = (size_t) (reader->table[low + 1].offset - first);
+    if (list->capacity < count) {
+      uint64_t* const offsets = realloc(list->offsets, count *
+          sizeof(uint64_t));
+      if (NULL == offsets) {
+        error.code = ERROR_OUT_OF_MEMORY;
+        return error;
+      }
+      list->offsets = offsets;
+      list->capacity = count;
+    }
+    const long start = (long) (sizeof(struct index_header) +
+        (reader->header.trigram_count + 1) * sizeof(struct posting) + first *
+        sizeof(uint64_t));
+    if ((0 != fseek(reader->fp, start, SEEK_SET)) || (count !=
+          fread(list->offsets, sizeof(uint64_t), count, reader->fp))) {
+      error.code = ERROR_STALE_INDEX;
+      return error;
+    }
+    list->length = count;
+  }
+
+  /* Appended rows come after the rows of the main segment. */
+  for (size_t delta_num = 0; (ERROR_NONE == error.code) && (delta_num <
+        reader->header.delta_count); delta_num++) {
+    if (trigram == reader->delta[delta_num].trigram) {
+      error = add_offset(list, reader->delta[delta_num].offset);
+    }
+  }
+  return error;
+}
+
+struct error find_literal_rows(struct index_reader* const reader, const
+    char* const name, const size_t name_length, struct offset_list* const
+    rows) {
+  struct error error;
+  uint64_t trigrams[MAX_NAME_TRIGRAM];
+  uint64_t* const all_trigrams = (name_length <= MAX_NAME_TRIGRAM) ? trigrams
+    : malloc(name_length * sizeof(uint64_t));
+  if (NULL == all_trigrams) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  const size_t trigram_count = get_name_trigrams(name, name_length,
+      all_trigrams);
+  struct offset_list postings = { NULL, 0, 0 };
+  error = read_postings(reader, all_trigrams[0], rows);
+  for (size_t trigram_num = 1; (ERROR_NONE == error.code) && (0 <
+        rows->length) && (trigram_num < trigram_count); trigram_num++) {
+    error = read_postings(reader, all_trigrams[trigram_num], &postings);
+    intersect_offsets(rows, &postings);
+  }
+  free(postings.offsets);
+  if (trigrams != all_trigrams) {
+    free(all_trigrams);
+  }
+  return error;
+}
+
+bool is_indexed_disjunction(const struct expression* const filter, const
+    size_t disjunction_num) {
+  const size_t start = (0 == disjunction_num) ? 0 :
+    filter->disjunction_ends[disjunction_num - 1];
+  bool has_literal = false;
+  for (size_t literal_num = start; literal_num <
+      filter->disjunction_ends[disjunction_num]; literal_num++) {
+    const struct literal* const lit = &filter->literals[literal_num];
+    // Negative empty literals are ignored.
+    if (lit->is_negative && (0 == lit->name_length)) {
+      continue;
+    }
+    if (lit->is_negative || lit->is_regex || (lit->name_length < 3)) {
+      return false;
+    }
+    has_literal = true;
+  }
+  return has_literal;
+}
+
+struct error find_trigram_candidates(const char* const index_file, const
+    char* const sheet, const struct expression* const filter, uint64_t**
+    const offsets, size_t* const offset_count) {
+  assert(NULL != index_file);
+  assert(NULL != sheet);
+  assert(NULL != filter);
+  assert(NULL != offsets);
+  assert(NULL != offset_count);
+
+  struct error error;
+  *offsets = NULL;
+  *offset_count = 0;
+  bool is_indexed = false;
+  for (size_t disjunction_num = 0; disjunction_num <
+      filter->disjunction_count; disjunction_num++) {
+    is_indexed = is_indexed || is_indexed_disjunction(filter,
+        disjunction_num);
+  }
+  if (filter->is_unsatisfiable) {
+    *offsets = malloc(sizeof(uint64_t));
+    error.code = (NULL == *offsets) ? ERROR_OUT_OF_MEMORY : ERROR_NONE;
+    return error;
+  }
+  if (!is_indexed) {
+    error.code = ERROR_NONE;
+    return error;
+  }
+
+  struct index_reader reader;
+  error = open_index(index_file, sheet, &reader);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+
+  /* Intersect the disjunctions, each the union of its literals. */
+  struct offset_list rows = { NULL, 0, 0 };
+  struct offset_list literal_rows = { NULL, 0, 0 };
+  struct offset_list disjunction_rows = { NULL, 0, 0 };
+  struct offset_list united_rows = { NULL, 0, 0 };
+  bool is_first = true;
+  for (size_t disjunction_num = 0; (ERROR_NONE == error.code) &&
+      (disjunction_num < filter->disjunction_count); disjunction_num++) {
+    if (!is_indexed_disjunction(filter, disjunction_num)) {
+      continue;
+    }
+    if (!is_first && (0 == rows.length)) {
+      break;
+    }
+    disjunction_rows.length = 0;
+    const size_t start = (0 == disjunction_num) ? 0 :
+      filter->disjunction_ends[disjunction_num - 1];
+    for (size_t literal_num = start; (ERROR_NONE == error.code) &&
+        (literal_num < filter->disjunction_ends[disjunction_num]);
+        literal_num++) {
+      const struct literal* const lit = &filter->literals[literal_num];
+      if (0 == lit->name_length) {
+        continue;
+      }
+      error = find_literal_rows(&reader, get_literal_name(filter, lit),
+          lit->name_length, &literal_rows);
+      if (ERROR_NONE == error.code) {
+        error = unite_offsets(&disjunction_rows, &literal_rows,
+            &united_rows);
+      }
+      const struct offset_list swap = disjunction_rows;
+      disjunction_rows = united_rows;
+      united_rows = swap;
+    }
+    if (is_first) {
+      const struct offset_list swap = rows;
+      rows = disjunction_rows;
+      disjunction_rows = swap;
+      is_first = false;
+    } else {
+      intersect_offsets(&rows, &disjunction_rows);
+    }
+  }
+  close_index(&reader);
+  free(literal_rows.offsets);
+  free(disjunction_rows.offsets);
+  free(united_rows.offsets);
+
+  if ((ERROR_NONE == error.code) && (NULL == rows.offsets)) {
+    rows.offsets = malloc(sizeof(uint64_t));
+    error.code = (NULL == rows.offsets) ? ERROR_OUT_OF_MEMORY : ERROR_NONE;
+  }
+  if (ERROR_NONE != error.code) {
+    free(rows.offsets);
+    return error;
+  }
+  *offsets = rows.offsets;
+  *offset_count = rows.length;
+  return error;
+}
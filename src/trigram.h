@@ -0,0 +1,45 @@
+#ifndef _ebs_trigram_h_
+#define _ebs_trigram_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct expression;
+
+enum {
+  /* Appended postings allowed before the index is rebuilt. */
+  MAX_TRIGRAM_DELTA = 4096
+};
+
+/* Identify a version of the task sheet. The index is only used while the
+ * sheet has the stamp it was built for. */
+struct sheet_stamp {
+  uint64_t size;
+  int64_t modified;
+};
+
+/* Get the stamp of a sheet. */
+struct error get_sheet_stamp(const char* sheet, struct sheet_stamp*);
+
+/* Index the trigrams of the task names in the sheet. The index maps each
+ * trigram to the offsets of the rows whose names contain it, and is written
+ * whole. */
+struct error build_trigram_index(const char* index_file, const char* sheet);
+
+/* Add the row of a task appended to the sheet at the given offset. previous is
+ * the stamp of the sheet before the append. Return ERROR_STALE_INDEX if the
+ * index is missing, was not up to date or has too many appended postings, in
+ * which case it should be rebuilt. */
+struct error append_trigram_index(const char* index_file, const char* sheet,
+    const struct sheet_stamp* previous, const char* name, uint64_t offset);
+
+/* Find the offsets of the rows that may match the filter, in sheet order.
+ * Only disjunctions of positive substrings of three or more bytes narrow the
+ * rows down; if the filter has none, offsets is set to NULL. Otherwise the
+ * caller frees offsets. Return ERROR_STALE_INDEX if the index is missing or
+ * not up to date. */
+struct error find_trigram_candidates(const char* index_file, const char* sheet,
+    const struct expression* filter, uint64_t** offsets, size_t*
+    offset_count);
+
+#endif
@@ -1,11 +1,17 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "utility.h"
 #include "error.h"
+#include "profile.h"
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <sys/types.h>
 #include <time.h>
+#include <unistd.h>
 
 enum {
   MAX_BUFFER = 4095
@@ -44,6 +50,7 @@ struct error parse_iso_8601_time(const char* const string, struct tm* const
   result->tm_isdst = -1;
 
   /* Try to normalize the time. */
+  count_profile(COUNTER_MKTIME_CALLS, 1);
   if (((time_t) -1) == mktime(result)) {
     error.code = ERROR_INVALID_TIME;
     return error;
@@ -103,6 +110,36 @@ struct error get_line(FILE* const fp, char* const buffer, const size_t
   }
 
   buffer[*bytes_read] = '\0';
+  if ((ERROR_END_OF_FILE != error.code) || (0 < *bytes_read)) {
+    count_profile(COUNTER_LINES_READ, 1);
+  }
+  return error;
+}
+
+struct error append_file(const char* const path, const char* const bytes,
+    const size_t length, uint64_t* const end_offset) {
+  assert(NULL != path);
+  assert(NULL != bytes);
+
+  struct error error;
+  const int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0666);
+  if (fd < 0) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  const ssize_t written = write(fd, bytes, length);
+  /* The offset is past this write even if others appended since. */
+  const off_t end = lseek(fd, 0, SEEK_CUR);
+  const bool is_closed = (0 == close(fd));
+  if ((written < 0) || ((size_t) written != length) || (end < 0) ||
+      !is_closed) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  if (NULL != end_offset) {
+    *end_offset = (uint64_t) end;
+  }
+  error.code = ERROR_NONE;
   return error;
 }
 
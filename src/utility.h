@@ -34,6 +34,13 @@ format_iso_8601_time(const struct tm* time, char* result, size_t max_result);
 struct error get_line(FILE* fp, char* buffer, size_t max_buffer, size_t*
     bytes_read);
 
+/* Append the bytes to the file with a single write on a descriptor opened
+ * with O_APPEND, so that appends from other processes never land inside
+ * them. The file is created if needed. If end_offset is not NULL, it is set
+ * to the offset just past the bytes written. */
+struct error append_file(const char* path, const char* bytes, size_t length,
+    uint64_t* end_offset);
+
 /* Copy a file. This is used for backing up files. */
 struct error copy(const char* src, const char* dst);
 
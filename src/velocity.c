@@ -0,0 +1,307 @@
+#include "velocity.h"
+#include "error.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  ESTIMATE_BUCKET_COUNT = 5,
+  /* The bin of velocities from 1 to 2. */
+  UNIT_VELOCITY_BIN = 5
+};
+
+const double VELOCITY_QUANTILES[VELOCITY_QUANTILE_COUNT] = {
+  0.05, 0.25, 0.5, 0.75, 0.95
+};
+
+static const char* const velocity_bin_names[] = {
+  "<1/16",
+  "1/16-1/8",
+  "1/8-1/4",
+  "1/4-1/2",
+  "1/2-1",
+  "1-2",
+  "2-4",
+  "4-8",
+  "8-16",
+  ">=16"
+};
+
+/* Estimates below each limit in seconds, counting 8 hour days and 40 hour
+ * weeks. The last bucket has no limit. */
+static const intmax_t estimate_bucket_limits[ESTIMATE_BUCKET_COUNT - 1] = {
+  3600, 4 * 3600, 8 * 3600, 40 * 3600
+};
+
+static const char* const estimate_bucket_names[] = {
+  "<1h",
+  "1h-4h",
+  "4h-1d",
+  "1d-1w",
+  ">=1w"
+};
+
+/* A token of a task name and the sample of the task. */
+struct token_sample {
+  const char* token;
+  size_t length;
+  size_t sample_num;
+};
+
+/* Summarize the velocities, which are sorted in place. */
+static void summarize_velocities(double* velocities, size_t count, const
+    char* group, struct velocity_summary*);
+
+/* Get the bucket of an estimate in seconds. */
+static size_t get_estimate_bucket(intmax_t estimated_seconds);
+
+/* Order numbers for qsort. */
+static int compare_doubles(const void*, const void*);
+
+/* Order token samples by token and then by sample for qsort. */
+static int compare_token_samples(const void*, const void*);
+
+/* Order summaries by task count, most first, and then by group for qsort. */
+static int compare_summaries(const void*, const void*);
+
+int compare_doubles(const void* const a, const void* const b) {
+  const double value_a = *(const double*) a;
+  const double value_b = *(const double*) b;
+  return (value_a > value_b) - (value_a < value_b);
+}
+
+int compare_token_samples(const void* const a, const void* const b) {
+  const struct token_sample* const sample_a = a;
+  const struct token_sample* const sample_b = b;
+  const size_t length = (sample_a->length < sample_b->length) ?
+    sample_a->length : sample_b->length;
+  const int order = memcmp(sample_a->token, sample_b->token, length);
+  if (0 != order) {
+    return order;
+  }
+  if (sample_a->length != sample_b->length) {
+    return (sample_a->length < sample_b->length) ? -1 : 1;
+  }
+  return (sample_a->sample_num > sample_b->sample_num) -
+    (sample_a->sample_num < sample_b->sample_num);
+}
+
+int compare_summaries(const void* const a, const void* const b) {
+  const struct velocity_summary* const summary_a = a;
+  const struct velocity_summary* const summary_b = b;
+  if (summary_a->task_count != summary_b->task_count) {
+    return (summary_a->task_count > summary_b->task_count) ? -1 : 1;
+  }
+  return strcmp(summary_a->group, summary_b->group);
+}
+
+size_t get_estimate_bucket(const intmax_t estimated_seconds) {
+  size_t bucket_num = 0;
+  while ((bucket_num < ESTIMATE_BUCKET_COUNT - 1) && (estimated_seconds >=
+        estimate_bucket_limits[bucket_num])) {
+    bucket_num++;
+  }
+  return bucket_num;
+}
+
+const char* get_velocity_bin_name(const size_t bin_num) {
+  assert(VELOCITY_BIN_COUNT == sizeof(velocity_bin_names) /
+      sizeof(velocity_bin_names[0]));
+  assert(bin_num < VELOCITY_BIN_COUNT);
+
+  return velocity_bin_names[bin_num];
+}
+
+void summarize_velocities(double* const velocities, const size_t count,
+    const char* const group, struct velocity_summary* const summary) {
+  assert(0 < count);
+
+  memset(summary, 0, sizeof(*summary));
+  strncpy(summary->group, group, MAX_VELOCITY_GROUP);
+  summary->task_count = count;
+  qsort(velocities, count, sizeof(double), compare_doubles);
+
+  double log_sum = 0;
+  for (size_t velocity_num = 0; velocity_num < count; velocity_num++) {
+    const double log_velocity = log2(velocities[velocity_num]);
+    log_sum += log_velocity;
+    const double bin = floor(log_velocity) + UNIT_VELOCITY_BIN;
+    const size_t bin_num = (bin < 0) ? 0 : (bin >= VELOCITY_BIN_COUNT) ?
+      VELOCITY_BIN_COUNT - 1 : (size_t) bin;
+    summary->histogram[bin_num]++;
+  }
+  summary->geometric_mean = exp2(log_sum / (double) count);
+
+  /* Interpolate between the closest ranks. */
+  for (size_t quantile_num = 0; quantile_num < VELOCITY_QUANTILE_COUNT;
+      quantile_num++) {
+    const double rank = VELOCITY_QUANTILES[quantile_num] * (double) (count -
+        1);
+    const size_t below = (size_t) rank;
+    const size_t above = (below + 1 < count) ? below + 1 : below;
+    const double fraction = rank - (double) below;
+    summary->quantiles[quantile_num] = velocities[below] + fraction *
+      (velocities[above] - velocities[below]);
+  }
+}
+
+struct error compute_velocity_report(const struct task* const tasks, const
+    size_t task_count, struct velocity_report* const report) {
+  assert(NULL != tasks);
+  assert(NULL != report);
+
+  struct error error;
+  report->summaries = NULL;
+  report->summary_count = 0;
+
+  /* Keep the columns of the completed tasks, so that the velocities are
+   * computed in one loop without branches. */
+  intmax_t* const estimates = malloc((task_count + 1) * sizeof(intmax_t));
+  intmax_t* const actuals = malloc((task_count + 1) * sizeof(intmax_t));
+  size_t* const task_nums = malloc((task_count + 1) * sizeof(size_t));
+  double* const velocities = malloc((task_count + 1) * sizeof(double));
+  double* const scratch = malloc((task_count + 1) * sizeof(double));
+  if ((NULL == estimates) || (NULL == actuals) || (NULL == task_nums) ||
+      (NULL == velocities) || (NULL == scratch)) {
+    free(estimates);
+    free(actuals);
+    free(task_nums);
+    free(velocities);
+    free(scratch);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  size_t sample_count = 0;
+  size_t token_count = 0;
+  for (size_t task_num = 0; task_num < task_count; task_num++) {
+    const struct task* const task = &tasks[task_num];
+    if ((STATUS_DONE != task->status) || (task->estimated_seconds <= 0) ||
+        (task->actual_seconds <= 0)) {
+      continue;
+    }
+    estimates[sample_count] = task->estimated_seconds;
+    actuals[sample_count] = task->actual_seconds;
+    task_nums[sample_count] = task_num;
+    sample_count++;
+    for (const char* c = task->name; '\0' != *c; c++) {
+      token_count += (0 != isalnum((unsigned char) *c)) && ((c == task->name)
+          || (0 == isalnum((unsigned char) c[-1])));
+    }
+  }
+  for (size_t sample_num = 0; sample_num < sample_count; sample_num++) {
+    velocities[sample_num] = (double) estimates[sample_num] / (double)
+      actuals[sample_num];
+  }
+
+  struct token_sample* const tokens = malloc((token_count + 1) *
+      sizeof(struct token_sample));
+  report->summaries = malloc((1 + ESTIMATE_BUCKET_COUNT + token_count) *
+      sizeof(struct velocity_summary));
+  if ((NULL == tokens) || (NULL == report->summaries)) {
+    free(tokens);
+    free(estimates);
+    free(actuals);
+    free(task_nums);
+    free(velocities);
+    free(scratch);
+    free_velocity_report(report);
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+
+  if (0 < sample_count) {
+    memcpy(scratch, velocities, sample_count * sizeof(double));
+    summarize_velocities(scratch, sample_count, "all",
+        &report->summaries[report->summary_count]);
+    report->summary_count++;
+  }
+
+  for (size_t bucket_num = 0; bucket_num < ESTIMATE_BUCKET_COUNT;
+      bucket_num++) {
+    size_t count = 0;
+    for (size_t sample_num = 0; sample_num < sample_count; sample_num++) {
+      if (bucket_num == get_estimate_bucket(estimates[sample_num])) {
+        scratch[count] = velocities[sample_num];
+        count++;
+      }
+    }
+    if (0 == count) {
+      continue;
+    }
+    char group[MAX_VELOCITY_GROUP + 1];
+    snprintf(group, sizeof(group), "estimate %s",
+        estimate_bucket_names[bucket_num]);
+    summarize_velocities(scratch, count, group,
+        &report->summaries[report->summary_count]);
+    report->summary_count++;
+  }
+
+  /* Group the samples by token by sorting, counting a token once per
+   * task. */
+  size_t token_num = 0;
+  for (size_t sample_num = 0; sample_num < sample_count; sample_num++) {
+    const char* const name = tasks[task_nums[sample_num]].name;
+    for (const char* c = name; '\0' != *c; c++) {
+      if ((0 == isalnum((unsigned char) *c)) || ((c != name) && (0 !=
+              isalnum((unsigned char) c[-1])))) {
+        continue;
+      }
+      size_t length = 0;
+      while (0 != isalnum((unsigned char) c[length])) {
+        length++;
+      }
+      tokens[token_num].token = c;
+      tokens[token_num].length = length;
+      tokens[token_num].sample_num = sample_num;
+      token_num++;
+    }
+  }
+  qsort(tokens, token_count, sizeof(struct token_sample),
+      compare_token_samples);
+  const size_t first_token_summary = report->summary_count;
+  for (size_t run_start = 0; run_start < token_count;) {
+    size_t count = 0;
+    size_t run_end = run_start;
+    for (; (run_end < token_count) && (tokens[run_end].length ==
+          tokens[run_start].length) && (0 == memcmp(tokens[run_end].token,
+            tokens[run_start].token, tokens[run_start].length)); run_end++) {
+      if ((run_end == run_start) || (tokens[run_end].sample_num !=
+            tokens[run_end - 1].sample_num)) {
+        scratch[count] = velocities[tokens[run_end].sample_num];
+        count++;
+      }
+    }
+    char group[MAX_VELOCITY_GROUP + 1];
+    snprintf(group, sizeof(group), "token %.*s", (int)
+        tokens[run_start].length, tokens[run_start].token);
+    summarize_velocities(scratch, count, group,
+        &report->summaries[report->summary_count]);
+    report->summary_count++;
+    run_start = run_end;
+  }
+  qsort(&report->summaries[first_token_summary], report->summary_count -
+      first_token_summary, sizeof(struct velocity_summary),
+      compare_summaries);
+
+  free(tokens);
+  free(estimates);
+  free(actuals);
+  free(task_nums);
+  free(velocities);
+  free(scratch);
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void free_velocity_report(struct velocity_report* const report) {
+  assert(NULL != report);
+
+  free(report->summaries);
+  report->summaries = NULL;
+  report->summary_count = 0;
+}
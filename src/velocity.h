@@ -0,0 +1,47 @@
+#ifndef _ebs_velocity_h_
+#define _ebs_velocity_h_
+
+#include "task.h"
+#include <stddef.h>
+
+enum {
+  /* Histogram bins of velocities by powers of two, from below 1/16 to 16
+   * and above. */
+  VELOCITY_BIN_COUNT = 10,
+  VELOCITY_QUANTILE_COUNT = 5,
+  MAX_VELOCITY_GROUP = MAX_TASK_NAME + 16
+};
+
+/* The fractions that velocity_summary.quantiles are taken at. */
+extern const double VELOCITY_QUANTILES[VELOCITY_QUANTILE_COUNT];
+
+/* The distribution of the velocities of a group of completed tasks. A
+ * velocity is the estimate divided by the actual time, so a geometric mean
+ * below one means the tasks were underestimated. */
+struct velocity_summary {
+  char group[MAX_VELOCITY_GROUP + 1];
+  size_t task_count;
+  double geometric_mean;
+  double quantiles[VELOCITY_QUANTILE_COUNT];
+  size_t histogram[VELOCITY_BIN_COUNT];
+};
+
+/* The velocities of all completed tasks, then of each estimate size, then of
+ * each token of the task names, the most common tokens first. */
+struct velocity_report {
+  struct velocity_summary* summaries;
+  size_t summary_count;
+};
+
+/* Summarize the velocities of the completed tasks. Tasks without an
+ * estimate or without time spent on them are left out. */
+struct error compute_velocity_report(const struct task* tasks, size_t
+    task_count, struct velocity_report*);
+
+/* Free the memory of the report. */
+void free_velocity_report(struct velocity_report*);
+
+/* Get the range of velocities of a histogram bin, as in "1/2-1". */
+const char* get_velocity_bin_name(size_t bin_num);
+
+#endif
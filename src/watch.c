@@ -0,0 +1,329 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "watch.h"
+#include "error.h"
+#include "expression.h"
+#include "utility.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum {
+  MAX_LINE = 4096,
+  MAX_EVENT_BUFFER = 4096,
+  MAX_LOOP = 100000000
+};
+
+/* Open the sheet where the last read stopped. If the sheet was replaced or
+ * shrank since, it is opened at the start and is_reset is set. */
+static struct error open_sheet_at(const char* sheet, uint64_t* inode,
+    uint64_t* offset, bool* is_reset, FILE** fp);
+
+/* Read the complete lines from the stream, passing each to the sheet's
+ * reader, and advance offset past them. */
+static struct error read_task_lines(struct live_sheets*, FILE* fp);
+static struct error read_time_lines(struct live_sheets*, FILE* fp);
+
+/* Add the seconds to the time spent on the name. */
+static struct error add_time(struct task_table* times, const char* name,
+    intmax_t seconds);
+
+void init_live_sheets(struct live_sheets* const live) {
+  assert(NULL != live);
+
+  init_task_table(&live->tasks);
+  init_task_table(&live->times);
+  live->has_last_record = false;
+  live->task_inode = 0;
+  live->task_offset = 0;
+  live->time_inode = 0;
+  live->time_offset = 0;
+}
+
+void free_live_sheets(struct live_sheets* const live) {
+  assert(NULL != live);
+
+  free_task_table(&live->tasks);
+  free_task_table(&live->times);
+  init_live_sheets(live);
+}
+
+struct error open_sheet_at(const char* const sheet, uint64_t* const inode,
+    uint64_t* const offset, bool* const is_reset, FILE** const fp) {
+  struct error error;
+  *fp = fopen(sheet, "r");
+  if (NULL == *fp) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  /* Check the file that was opened, in case it was replaced meanwhile. */
+  struct stat status;
+  if (0 != fstat(fileno(*fp), &status)) {
+    fclose(*fp);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  *is_reset = ((uint64_t) status.st_ino != *inode) || ((uint64_t)
+      status.st_size < *offset);
+  if (*is_reset) {
+    *inode = (uint64_t) status.st_ino;
+    *offset = 0;
+  }
+  if (0 != fseek(*fp, (long) *offset, SEEK_SET)) {
+    fclose(*fp);
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error add_time(struct task_table* const times, const char* const
+    name, const intmax_t seconds) {
+  struct task* time;
+  struct error error = find_table_task(times, name, &time);
+  if (ERROR_NONE == error.code) {
+    time->actual_seconds += seconds;
+    return error;
+  }
+  struct task new_time;
+  memset(&new_time, 0, sizeof(new_time));
+  strncpy(new_time.name, name, MAX_TASK_NAME);
+  new_time.actual_seconds = seconds;
+  return add_table_task(times, &new_time);
+}
+
+struct error read_task_lines(struct live_sheets* const live, FILE* const fp)
+{
+  struct error error;
+  error.code = ERROR_NONE;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    char line[MAX_LINE];
+    size_t length;
+    error = get_line(fp, line, MAX_LINE, &length);
+    if (ERROR_END_OF_FILE == error.code) {
+      /* A line without its new line is still being written. */
+      error.code = ERROR_NONE;
+      break;
+    }
+    const long offset = ftell(fp);
+    if (offset < 0) {
+      error.code = ERROR_FILE;
+      break;
+    }
+    live->task_offset = (uint64_t) offset;
+    struct task task;
+    // Rows that don't parse are skipped by readers too.
+    if ((ERROR_NONE != error.code) || (ERROR_NONE != parse_task(line,
+            &task).code)) {
+      error.code = ERROR_NONE;
+      continue;
+    }
+    error = add_table_task(&live->tasks, &task);
+    if (ERROR_TASK_EXISTS == error.code) {
+      error.code = ERROR_NONE;
+    }
+    if (ERROR_NONE != error.code) {
+      break;
+    }
+  }
+  return error;
+}
+
+struct error read_time_lines(struct live_sheets* const live, FILE* const fp)
+{
+  struct error error;
+  error.code = ERROR_NONE;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    char line[MAX_LINE];
+    size_t length;
+    error = get_line(fp, line, MAX_LINE, &length);
+    if (ERROR_END_OF_FILE == error.code) {
+      error.code = ERROR_NONE;
+      break;
+    }
+    const long offset = ftell(fp);
+    if (offset < 0) {
+      error.code = ERROR_FILE;
+      break;
+    }
+    live->time_offset = (uint64_t) offset;
+    struct time_record record;
+    if ((ERROR_NONE != error.code) || (ERROR_NONE != parse_time_record(line,
+            &record).code)) {
+      error.code = ERROR_NONE;
+      continue;
+    }
+    /* The time up to this record goes to the task of the one before. */
+    if (live->has_last_record) {
+      error = add_time(&live->times, live->last_record.name, (intmax_t)
+          difftime(record.time, live->last_record.time));
+      if (ERROR_NONE != error.code) {
+        break;
+      }
+    }
+    live->last_record = record;
+    live->has_last_record = true;
+  }
+  return error;
+}
+
+struct error update_live_sheets(struct live_sheets* const live, const char*
+    const task_sheet, const char* const time_sheet) {
+  assert(NULL != live);
+  assert(NULL != task_sheet);
+  assert(NULL != time_sheet);
+
+  struct error error;
+  FILE* fp;
+  bool is_reset;
+  error = open_sheet_at(task_sheet, &live->task_inode, &live->task_offset,
+      &is_reset, &fp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  if (is_reset) {
+    free_task_table(&live->tasks);
+  }
+  error = read_task_lines(live, fp);
+  fclose(fp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+
+  error = open_sheet_at(time_sheet, &live->time_inode, &live->time_offset,
+      &is_reset, &fp);
+  if (ERROR_NONE != error.code) {
+    return error;
+  }
+  if (is_reset) {
+    free_task_table(&live->times);
+    live->has_last_record = false;
+  }
+  error = read_time_lines(live, fp);
+  fclose(fp);
+  return error;
+}
+
+struct error get_live_tasks(const struct live_sheets* const live, const
+    struct expression* const filter, struct task** const tasks, size_t* const
+    task_count) {
+  assert(NULL != live);
+  assert(NULL != filter);
+  assert(NULL != tasks);
+  assert(NULL != task_count);
+
+  struct error error;
+  *task_count = 0;
+  *tasks = malloc((live->tasks.task_count + 1) * sizeof(struct task));
+  if (NULL == *tasks) {
+    error.code = ERROR_OUT_OF_MEMORY;
+    return error;
+  }
+  for (size_t task_num = 0; task_num < live->tasks.task_count; task_num++) {
+    const struct task* const task = &live->tasks.tasks[task_num];
+    if (!string_matches(task->name, filter)) {
+      continue;
+    }
+    struct task* const live_task = &(*tasks)[*task_count];
+    *live_task = *task;
+    struct task* time;
+    if (ERROR_NONE == find_table_task(&live->times, task->name, &time).code) {
+      live_task->actual_seconds += time->actual_seconds;
+    }
+    (*task_count)++;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+struct error init_directory_watch(struct directory_watch* const watch, const
+    char* const directory) {
+  assert(NULL != watch);
+  assert(NULL != directory);
+
+  struct error error;
+  watch->fd = inotify_init();
+  if (watch->fd < 0) {
+    error.code = ERROR_FILE;
+    return error;
+  }
+  /* Sheets are appended to or renamed over, so watch the directory rather
+   * than the files. */
+  if (0 > inotify_add_watch(watch->fd, directory, IN_MODIFY | IN_CLOSE_WRITE
+        | IN_MOVED_TO | IN_CREATE | IN_DELETE)) {
+    close(watch->fd);
+    watch->fd = -1;
+    error.code = ERROR_FILE;
+    return error;
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void free_directory_watch(struct directory_watch* const watch) {
+  assert(NULL != watch);
+
+  if (0 <= watch->fd) {
+    close(watch->fd);
+  }
+  watch->fd = -1;
+}
+
+struct error wait_for_change(struct directory_watch* const watch, const
+    char* const* const names, const size_t name_count, const int
+    debounce_ms) {
+  assert(NULL != watch);
+  assert(NULL != names);
+
+  struct error error;
+  bool is_changed = false;
+  for (size_t loop_num = 0; loop_num < MAX_LOOP; loop_num++) {
+    struct pollfd poll_fd = { watch->fd, POLLIN, 0 };
+    const int ready = poll(&poll_fd, 1, is_changed ? debounce_ms : -1);
+    if ((ready < 0) && (EINTR == errno)) {
+      continue;
+    }
+    if (ready < 0) {
+      error.code = ERROR_FILE;
+      return error;
+    }
+    if (0 == ready) {
+      break;
+    }
+    /* Events are aligned for struct inotify_event. */
+    uint64_t buffer[MAX_EVENT_BUFFER / sizeof(uint64_t)];
+    const ssize_t length = read(watch->fd, buffer, sizeof(buffer));
+    if (length <= 0) {
+      error.code = ERROR_FILE;
+      return error;
+    }
+    const char* const bytes = (const char*) buffer;
+    for (size_t offset = 0; offset + sizeof(struct inotify_event) <= (size_t)
+        length;) {
+      struct inotify_event event;
+      memcpy(&event, &bytes[offset], sizeof(event));
+      const char* const name = &bytes[offset + sizeof(event)];
+      for (size_t name_num = 0; (0 < event.len) && (name_num < name_count);
+          name_num++) {
+        is_changed = is_changed || (0 == strcmp(names[name_num], name));
+      }
+      offset += sizeof(event) + event.len;
+    }
+  }
+  error.code = ERROR_NONE;
+  return error;
+}
+
+void clear_screen(void) {
+  if (isatty(STDOUT_FILENO)) {
+    fputs("\033[H\033[J", stdout);
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef _ebs_watch_h_
+#define _ebs_watch_h_
+
+#include "task.h"
+#include "task_table.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct expression;
+
+/* The task and time sheets as read so far. Each update reads only the lines
+ * appended since the last one. A sheet that was replaced, such as by a
+ * rewrite, or that shrank is read again from the start. */
+struct live_sheets {
+  struct task_table tasks;
+  /* The time spent on each name of the time sheet, in actual_seconds. */
+  struct task_table times;
+  struct time_record last_record;
+  bool has_last_record;
+  uint64_t task_inode;
+  uint64_t task_offset;
+  uint64_t time_inode;
+  uint64_t time_offset;
+};
+
+/* Watches files in a directory through inotify. */
+struct directory_watch {
+  int fd;
+};
+
+/* Initialize with nothing read. */
+void init_live_sheets(struct live_sheets*);
+
+/* Free the memory of the sheets. */
+void free_live_sheets(struct live_sheets*);
+
+/* Read what changed in the sheets since the last update. Lines that are not
+ * complete yet are left for the next update. */
+struct error update_live_sheets(struct live_sheets*, const char* task_sheet,
+    const char* time_sheet);
+
+/* Get the tasks whose names match the filter, with the time spent on them
+ * added to their actual time as read_time_sheet does. The caller frees
+ * tasks. */
+struct error get_live_tasks(const struct live_sheets*, const struct
+    expression* filter, struct task** tasks, size_t* task_count);
+
+/* Start watching the files of the directory. */
+struct error init_directory_watch(struct directory_watch*, const char*
+    directory);
+
+/* Stop watching. */
+void free_directory_watch(struct directory_watch*);
+
+/* Wait until one of the named files of the directory is written, replaced
+ * or created, and then until no change has come for debounce_ms
+ * milliseconds, so that a burst of changes is seen once. */
+struct error wait_for_change(struct directory_watch*, const char* const*
+    names, size_t name_count, int debounce_ms);
+
+/* Clear the screen before a redraw if stdout is a terminal. */
+void clear_screen(void);
+
+#endif
@@ -0,0 +1,191 @@
+#include "writer.h"
+#include "error.h"
+#include "profile.h"
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+  MAX_INT_DIGITS = 24,
+  MAX_FIXED_DIGITS = 64
+};
+
+static const char* const output_format_names[] = {
+  "text",
+  "tsv",
+  "json"
+};
+
+/* Add a number with at least the given count of digits, padding with
+ * zeros. */
+static void put_padded_int(struct writer*, intmax_t value, int digit_count);
+
+struct error parse_output_format(const char* const str, enum output_format*
+    const format) {
+  assert(MAX_OUTPUT == sizeof(output_format_names) /
+      sizeof(output_format_names[0]));
+  assert(NULL != str);
+  assert(NULL != format);
+
+  struct error error;
+  for (enum output_format format_num = 0; format_num < MAX_OUTPUT;
+      format_num++) {
+    if (0 == strcmp(str, output_format_names[format_num])) {
+      *format = format_num;
+      error.code = ERROR_NONE;
+      return error;
+    }
+  }
+  error.code = ERROR_UNKNOWN_FORMAT;
+  return error;
+}
+
+void init_writer(struct writer* const writer, FILE* const fp) {
+  assert(NULL != writer);
+  assert(NULL != fp);
+
+  writer->fp = fp;
+  writer->length = 0;
+  writer->has_failed = false;
+}
+
+struct error flush_writer(struct writer* const writer) {
+  assert(NULL != writer);
+
+  struct error error;
+  if ((0 < writer->length) && (writer->length != fwrite(writer->buffer, 1,
+          writer->length, writer->fp))) {
+    writer->has_failed = true;
+  }
+  writer->length = 0;
+  if (0 != fflush(writer->fp)) {
+    writer->has_failed = true;
+  }
+  error.code = writer->has_failed ? ERROR_FILE : ERROR_NONE;
+  return error;
+}
+
+void put_bytes(struct writer* const writer, const char* const bytes, const
+    size_t length) {
+  assert(NULL != writer);
+  assert(NULL != bytes);
+
+  if (WRITER_BUFFER_SIZE - writer->length < length) {
+    flush_writer(writer);
+    /* Bytes that don't fit an empty buffer go straight out. */
+    if (WRITER_BUFFER_SIZE < length) {
+      if (length != fwrite(bytes, 1, length, writer->fp)) {
+        writer->has_failed = true;
+      }
+      return;
+    }
+  }
+  memcpy(&writer->buffer[writer->length], bytes, length);
+  writer->length += length;
+}
+
+void put_string(struct writer* const writer, const char* const string) {
+  assert(NULL != string);
+
+  put_bytes(writer, string, strlen(string));
+}
+
+void put_char(struct writer* const writer, const char c) {
+  assert(NULL != writer);
+
+  if (WRITER_BUFFER_SIZE <= writer->length) {
+    flush_writer(writer);
+  }
+  writer->buffer[writer->length] = c;
+  writer->length++;
+}
+
+void put_padded_int(struct writer* const writer, const intmax_t value, const
+    int digit_count) {
+  char digits[MAX_INT_DIGITS];
+  size_t start = MAX_INT_DIGITS;
+  /* Work with the magnitude so that the most negative value works too. */
+  uintmax_t magnitude = (value < 0) ? (uintmax_t) 0 - (uintmax_t) value :
+    (uintmax_t) value;
+  int digit_num = 0;
+  do {
+    start--;
+    digits[start] = (char) ('0' + magnitude % 10);
+    magnitude /= 10;
+    digit_num++;
+  } while ((0 != magnitude) || (digit_num < digit_count));
+  if (value < 0) {
+    start--;
+    digits[start] = '-';
+  }
+  put_bytes(writer, &digits[start], MAX_INT_DIGITS - start);
+}
+
+void put_int(struct writer* const writer, const intmax_t value) {
+  put_padded_int(writer, value, 1);
+}
+
+void put_fixed(struct writer* const writer, const double value, const int
+    decimal_count) {
+  char digits[MAX_FIXED_DIGITS];
+  const int length = snprintf(digits, sizeof(digits), "%.*f", decimal_count,
+      value);
+  if (0 < length) {
+    put_bytes(writer, digits, ((size_t) length < sizeof(digits)) ? (size_t)
+        length : sizeof(digits) - 1);
+  }
+}
+
+void put_json_string(struct writer* const writer, const char* const string) {
+  assert(NULL != string);
+
+  static const char hex_digits[] = "0123456789abcdef";
+  put_char(writer, '"');
+  const char* run = string;
+  for (const char* c = string; '\0' != *c; c++) {
+    if (('"' != *c) && ('\\' != *c) && (0x20 <= (unsigned char) *c)) {
+      continue;
+    }
+    /* Copy the run of plain characters before the escape in one go. */
+    put_bytes(writer, run, (size_t) (c - run));
+    run = c + 1;
+    put_char(writer, '\\');
+    if (('"' == *c) || ('\\' == *c)) {
+      put_char(writer, *c);
+      continue;
+    }
+    put_string(writer, "u00");
+    put_char(writer, hex_digits[(unsigned char) *c >> 4]);
+    put_char(writer, hex_digits[(unsigned char) *c & 0xf]);
+  }
+  put_string(writer, run);
+  put_char(writer, '"');
+}
+
+void put_iso_8601_time(struct writer* const writer, const struct tm* const
+    time) {
+  assert(NULL != time);
+
+  put_padded_int(writer, (intmax_t) time->tm_year + 1900, 4);
+  put_char(writer, '-');
+  put_padded_int(writer, time->tm_mon + 1, 2);
+  put_char(writer, '-');
+  put_padded_int(writer, time->tm_mday, 2);
+  put_char(writer, 'T');
+  put_padded_int(writer, time->tm_hour, 2);
+  put_char(writer, ':');
+  put_padded_int(writer, time->tm_min, 2);
+  put_char(writer, ':');
+  put_padded_int(writer, time->tm_sec, 2);
+}
+
+void put_epoch_time(struct writer* const writer, const struct tm* const time)
+{
+  assert(NULL != time);
+
+  /* mktime normalizes its argument, so give it a copy. */
+  struct tm copy = *time;
+  count_profile(COUNTER_MKTIME_CALLS, 1);
+  put_int(writer, (intmax_t) mktime(&copy));
+}
@@ -0,0 +1,68 @@
+#ifndef _ebs_writer_h_
+#define _ebs_writer_h_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct tm;
+
+enum {
+  WRITER_BUFFER_SIZE = 65536
+};
+
+/* How commands print their results. TEXT is for people; TSV and JSON lines
+ * are for tools and give times as epoch seconds. */
+enum output_format {
+  OUTPUT_TEXT,
+  OUTPUT_TSV,
+  OUTPUT_JSON,
+  MAX_OUTPUT
+};
+
+/* Collects output and writes it to the stream in large blocks. */
+struct writer {
+  FILE* fp;
+  size_t length;
+  bool has_failed;
+  char buffer[WRITER_BUFFER_SIZE];
+};
+
+/* Parse the name of an output format. Return ERROR_UNKNOWN_FORMAT if there
+ * is no match. */
+struct error parse_output_format(const char* str, enum output_format*);
+
+/* Start writing to the stream. */
+void init_writer(struct writer*, FILE* fp);
+
+/* Write out what has been collected. Return ERROR_FILE if any write
+ * failed. */
+struct error flush_writer(struct writer*);
+
+/* Add bytes to the output. */
+void put_bytes(struct writer*, const char* bytes, size_t length);
+
+/* Add a string to the output. */
+void put_string(struct writer*, const char* string);
+
+/* Add a character to the output. */
+void put_char(struct writer*, char c);
+
+/* Add an integer in decimal to the output. */
+void put_int(struct writer*, intmax_t value);
+
+/* Add a number to the output in decimal with decimal_count digits after the
+ * point. */
+void put_fixed(struct writer*, double value, int decimal_count);
+
+/* Add a string to the output as a quoted and escaped JSON string. */
+void put_json_string(struct writer*, const char* string);
+
+/* Add a time to the output in ISO-8601, as in 2024-01-31T09:05:00. */
+void put_iso_8601_time(struct writer*, const struct tm* time);
+
+/* Add a local time to the output as seconds since the epoch. */
+void put_epoch_time(struct writer*, const struct tm* time);
+
+#endif
@@ -9,6 +9,9 @@ static int test_string_contains(void);
 static int test_parse_expression(void);
 static int test_string_matches(void);
 static int do_test_string_matches(const char*, const char*, bool);
+static int test_long_expression(void);
+static int test_bad_regex_literal(void);
+static int test_match_table(void);
 
 int test_string_contains(void) {
   char s1[] = "hello world";
@@ -18,6 +21,14 @@ int test_string_contains(void) {
   assert(true == string_contains(s1, s2));
   assert(false == string_contains(s2, s1));
   assert(false == string_contains(s1, s3));
+
+  /* Cross the vector block boundaries and the scalar tail. */
+  char long_haystack[] = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab";
+  assert(true == string_contains(long_haystack, "aab"));
+  assert(true == string_contains(long_haystack, "b"));
+  assert(true == string_contains(long_haystack, ""));
+  assert(false == string_contains(long_haystack, "ba"));
+  assert(false == string_contains(long_haystack, "abab"));
   return 0;
 }
 
@@ -26,6 +37,7 @@ int test_parse_expression(void) {
   struct expression e;
   struct error error = parse_expression(s, &e);
   assert(ERROR_NONE == error.code);
+  free_expression(&e);
   return 0;
 }
 
@@ -41,6 +53,7 @@ int do_test_string_matches(const char* const subject, const char* const
   }
   print_expression(&e);
   assert(expect_match == string_matches(subject, &e));
+  free_expression(&e);
   return 0;
 }
 
@@ -53,7 +66,20 @@ int test_string_matches(void) {
     "!hello,!world",
     "!hello,!world",
     "!hello/!world",
-    "!hello/!world"
+    "!hello/!world",
+    "",
+    "hello,",
+    "world,!",
+    "lo/hell,!world/!low",
+    "he/she/hers/his",
+    "she,his/hers",
+    "a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p/a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,q",
+    "~^infra-",
+    "~^infra-",
+    "!~q[34]-.*-migration",
+    "~^(web|api)-,db/!legacy",
+    "~^(web|api)-,db/!legacy",
+    "~^web,web"
   };
   char* subjects[] = {
     "hello world",
@@ -63,7 +89,20 @@ int test_string_matches(void) {
     "hello",
     "hello world",
     "hello",
-    "world"
+    "world",
+    "anything",
+    "anything",
+    "world",
+    "hello world",
+    "ushers",
+    "ushers",
+    "q",
+    "infra-dns",
+    "web-infra",
+    "q3-users-migration",
+    "users-db",
+    "api-legacy",
+    "my-web"
   };
   bool expected[] = {
     true,
@@ -73,7 +112,20 @@ int test_string_matches(void) {
     true,
     false,
     false,
-    false
+    false,
+    true,
+    true,
+    true,
+    true,
+    false,
+    true,
+    false,
+    true,
+    false,
+    false,
+    true,
+    false,
+    true
   };
   size_t max_test = sizeof(expressions) / sizeof(expressions[0]);
   for (size_t test_num = 0; test_num < max_test; test_num++) {
@@ -83,10 +135,74 @@ int test_string_matches(void) {
   return 0;
 }
 
+/* Expressions are not limited in length. */
+int test_long_expression(void) {
+  char s[1024] = "";
+  for (int disjunction_num = 0; disjunction_num < 40; disjunction_num++) {
+    char disjunction[32];
+    snprintf(disjunction, sizeof(disjunction), "x%d,!nope/", disjunction_num);
+    strcat(s, disjunction);
+  }
+  strcat(s, "a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q,r,s,t,u,v,w,y,z");
+  struct expression e;
+  struct error error = parse_expression(s, &e);
+  assert(ERROR_NONE == error.code);
+  assert(41 == e.disjunction_count);
+  assert(true == string_matches("z", &e));
+  assert(false == string_matches("nope-x", &e));
+  free_expression(&e);
+  return 0;
+}
+
+int test_bad_regex_literal(void) {
+  struct expression e;
+  struct error error = parse_expression("infra/~(web", &e);
+  assert(ERROR_BAD_REGEX == error.code);
+  free_expression(&e);
+  return 0;
+}
+
+/* Matching a table gives the same answers as matching row by row. */
+int test_match_table(void) {
+  const char* expressions[] = {
+    "", "api", "billing/api", "dns,-ui", "!billing", "billing,!api/~ui$",
+    "api/!api", "a,b,c/!x"
+  };
+  const char* words[] = { "billing", "api", "-ui", "dns", "x", "search" };
+  char rows[130][64];
+  const char* subjects[130];
+  for (size_t row_num = 0; row_num < 130; row_num++) {
+    snprintf(rows[row_num], sizeof(rows[row_num]), "%s%s%s",
+        words[row_num % 6], words[(row_num / 6) % 6], words[(row_num / 36) %
+        6]);
+    subjects[row_num] = rows[row_num];
+  }
+  for (size_t test_num = 0; test_num < sizeof(expressions) /
+      sizeof(expressions[0]); test_num++) {
+    struct expression e;
+    assert(ERROR_NONE == parse_expression(expressions[test_num], &e).code);
+    printf("testing table matches %s\n", expressions[test_num]);
+    uint64_t matches[3];
+    assert(ERROR_NONE == match_table(subjects, 130, &e, matches).code);
+    for (size_t row_num = 0; row_num < 130; row_num++) {
+      const bool is_match = 0 != (matches[row_num / 64] & ((uint64_t) 1 <<
+            (row_num % 64)));
+      assert(string_matches(subjects[row_num], &e) == is_match);
+    }
+    /* Bits past the last subject stay clear. */
+    assert(0 == (matches[2] >> 2));
+    free_expression(&e);
+  }
+  return 0;
+}
+
 int
 main(void) {
   test_string_contains();
   test_parse_expression();
   test_string_matches();
+  test_long_expression();
+  test_bad_regex_literal();
+  test_match_table();
   return 0;
 }
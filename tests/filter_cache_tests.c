@@ -0,0 +1,137 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "error.h"
+#include "filter_cache.h"
+#include "trigram.h"
+#include <assert.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static const char SHEET[] = "test-filter.tsv";
+static const char CACHE[] = "test-filter-cache";
+
+static int write_sheet(const char* contents);
+static int remove_cache(void);
+static size_t count_cache_files(void);
+static int test_filter_cache(void);
+static int test_filter_cache_prune(void);
+
+int write_sheet(const char* const contents) {
+  FILE* const fp = fopen(SHEET, "w");
+  assert(NULL != fp);
+  fputs(contents, fp);
+  fclose(fp);
+  return 0;
+}
+
+int remove_cache(void) {
+  DIR* const dir = opendir(CACHE);
+  if (NULL == dir) {
+    return 0;
+  }
+  for (struct dirent* entry = readdir(dir); NULL != entry; entry =
+      readdir(dir)) {
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s/%s", CACHE, entry->d_name);
+    remove(filename);
+  }
+  closedir(dir);
+  return rmdir(CACHE);
+}
+
+size_t count_cache_files(void) {
+  DIR* const dir = opendir(CACHE);
+  assert(NULL != dir);
+  size_t file_count = 0;
+  for (struct dirent* entry = readdir(dir); NULL != entry; entry =
+      readdir(dir)) {
+    if ('.' != entry->d_name[0]) {
+      file_count++;
+    }
+  }
+  closedir(dir);
+  return file_count;
+}
+
+int test_filter_cache(void) {
+  write_sheet("billing\tACTIVE\t60\t0\nsearch\tACTIVE\t60\t0\n");
+  uint64_t* offsets;
+  size_t offset_count;
+  assert(ERROR_STALE_INDEX == read_filter_cache(CACHE, "billing", SHEET,
+        &offsets, &offset_count).code);
+
+  struct sheet_stamp stamp;
+  assert(ERROR_NONE == get_sheet_stamp(SHEET, &stamp).code);
+  const uint64_t billing[] = { 0 };
+  assert(ERROR_NONE == write_filter_cache(CACHE, "billing", &stamp, billing,
+        1).code);
+  assert(ERROR_NONE == write_filter_cache(CACHE, "nothing", &stamp, NULL,
+        0).code);
+
+  assert(ERROR_NONE == read_filter_cache(CACHE, "billing", SHEET, &offsets,
+        &offset_count).code);
+  assert(1 == offset_count);
+  assert(0 == offsets[0]);
+  free(offsets);
+  assert(ERROR_NONE == read_filter_cache(CACHE, "nothing", SHEET, &offsets,
+        &offset_count).code);
+  assert(0 == offset_count);
+  free(offsets);
+  assert(ERROR_STALE_INDEX == read_filter_cache(CACHE, "billin", SHEET,
+        &offsets, &offset_count).code);
+
+  /* Any change to the sheet makes the results stale. */
+  write_sheet("billing\tDONE\t60\t0\nsearch\tACTIVE\t60\t0\n");
+  assert(ERROR_STALE_INDEX == read_filter_cache(CACHE, "billing", SHEET,
+        &offsets, &offset_count).code);
+  assert(NULL == offsets);
+
+  remove(SHEET);
+  remove_cache();
+  return 0;
+}
+
+int test_filter_cache_prune(void) {
+  write_sheet("billing\tACTIVE\t60\t0\n");
+  struct sheet_stamp stamp;
+  assert(ERROR_NONE == get_sheet_stamp(SHEET, &stamp).code);
+  assert(ERROR_NONE == write_filter_cache(CACHE, "billing", &stamp, NULL,
+        0).code);
+  assert(ERROR_NONE == write_filter_cache(CACHE, "search", &stamp, NULL,
+        0).code);
+  assert(2 == count_cache_files());
+
+  /* Writing for a new version of the sheet removes the stale results. */
+  write_sheet("billing\tDONE\t60\t0\n");
+  assert(ERROR_NONE == get_sheet_stamp(SHEET, &stamp).code);
+  assert(ERROR_NONE == write_filter_cache(CACHE, "search", &stamp, NULL,
+        0).code);
+  assert(1 == count_cache_files());
+
+  /* Many filters of the same version are capped. */
+  for (size_t filter_num = 0; filter_num < 100; filter_num++) {
+    char filter_text[32];
+    snprintf(filter_text, sizeof(filter_text), "filter-%zu", filter_num);
+    assert(ERROR_NONE == write_filter_cache(CACHE, filter_text, &stamp, NULL,
+          0).code);
+  }
+  assert(count_cache_files() <= 64);
+  uint64_t* offsets;
+  size_t offset_count;
+  assert(ERROR_NONE == read_filter_cache(CACHE, "filter-99", SHEET, &offsets,
+        &offset_count).code);
+  free(offsets);
+
+  remove(SHEET);
+  remove_cache();
+  return 0;
+}
+
+int
+main(void) {
+  test_filter_cache();
+  test_filter_cache_prune();
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include "error.h"
+#include "hash.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static int test_ebs_hash_find(void);
+static int test_ebs_hash_full(void);
+
+int test_ebs_hash_find(void) {
+  static struct ebs_hash hash;
+  ebs_hash_init(&hash);
+  size_t index;
+  assert(ERROR_HASH_NOT_FOUND == ebs_hash_find(&hash, "login", &index).code);
+  assert(ERROR_NONE == ebs_hash_add(&hash, "login").code);
+  assert(ERROR_NONE == ebs_hash_add(&hash, "login").code);
+  size_t login_index;
+  assert(ERROR_NONE == ebs_hash_find(&hash, "login", &login_index).code);
+  assert(login_index < MAX_HASH_ENTRY);
+  assert(ERROR_NONE == ebs_hash_add(&hash, "logout").code);
+  assert(ERROR_NONE == ebs_hash_find(&hash, "logout", &index).code);
+  assert(login_index != index);
+  return 0;
+}
+
+int test_ebs_hash_full(void) {
+  /* Filling every entry makes the probes of some keys wrap around to the
+   * start. */
+  static struct ebs_hash hash;
+  ebs_hash_init(&hash);
+  char key[32];
+  for (size_t key_num = 0; key_num < MAX_HASH_ENTRY; key_num++) {
+    snprintf(key, sizeof(key), "task-%zu", key_num);
+    assert(ERROR_NONE == ebs_hash_add(&hash, key).code);
+  }
+  for (size_t key_num = 0; key_num < MAX_HASH_ENTRY; key_num++) {
+    snprintf(key, sizeof(key), "task-%zu", key_num);
+    size_t index;
+    assert(ERROR_NONE == ebs_hash_find(&hash, key, &index).code);
+    assert(index < MAX_HASH_ENTRY);
+  }
+  assert(ERROR_HASH_FULL == ebs_hash_add(&hash, "one-too-many").code);
+  size_t index;
+  assert(ERROR_HASH_NOT_FOUND == ebs_hash_find(&hash, "one-too-many",
+        &index).code);
+  return 0;
+}
+
+int
+main(void) {
+  test_ebs_hash_find();
+  test_ebs_hash_full();
+  return 0;
+}
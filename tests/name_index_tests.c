@@ -0,0 +1,103 @@
+#include "error.h"
+#include "name_index.h"
+#include "task.h"
+#include "trigram.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char SHEET[] = "test-name-index.tsv";
+static const char INDEX[] = "test-name-index.idx";
+
+static int append_sheet(const char* name);
+static int do_test_completions(const char* prefix, bool active_only, const
+    char* const* expected, size_t expected_count);
+static int test_name_completions(void);
+static int test_stale_name_index(void);
+
+int append_sheet(const char* const name) {
+  struct sheet_stamp previous;
+  assert(ERROR_NONE == get_sheet_stamp(SHEET, &previous).code);
+  FILE* const fp = fopen(SHEET, "a");
+  assert(NULL != fp);
+  struct task task = { 60, 0, "", "", STATUS_ACTIVE };
+  strcpy(task.name, name);
+  assert(ERROR_NONE == write_task(&task, fp).code);
+  fclose(fp);
+  return append_name_index(INDEX, SHEET, &previous, &task).code;
+}
+
+int do_test_completions(const char* const prefix, const bool active_only,
+    const char* const* const expected, const size_t expected_count) {
+  char names[4][MAX_TASK_NAME + 1];
+  size_t name_count;
+  printf("testing completions of %s\n", prefix);
+  assert(ERROR_NONE == find_name_completions(INDEX, SHEET, prefix,
+        active_only, names, 4, &name_count).code);
+  assert(expected_count == name_count);
+  for (size_t name_num = 0; name_num < name_count; name_num++) {
+    assert(0 == strcmp(expected[name_num], names[name_num]));
+  }
+  return 0;
+}
+
+int test_name_completions(void) {
+  FILE* const fp = fopen(SHEET, "w");
+  assert(NULL != fp);
+  fputs("web-login\tACTIVE\t60\t0\n"
+      "infra-dns\tACTIVE\t60\t0\n"
+      "web-api\tDONE\t60\t0\n"
+      "web\tACTIVE\t60\t0\n"
+      "web-cache\tACTIVE\t60\t0\n"
+      "webhooks\tDONE\t60\t0\n", fp);
+  fclose(fp);
+  assert(ERROR_NONE == build_name_index(INDEX, SHEET).code);
+
+  const char* const web[] = { "web", "web-cache", "web-login" };
+  do_test_completions("web", true, web, 3);
+  const char* const all_web[] = { "web", "web-cache", "web-login", "web-api" };
+  do_test_completions("web", false, all_web, 4);
+  const char* const web_dash[] = { "web-cache", "web-login", "web-api" };
+  do_test_completions("web-", false, web_dash, 3);
+  const char* const everything[] = { "infra-dns", "web", "web-cache",
+    "web-login" };
+  do_test_completions("", true, everything, 4);
+  do_test_completions("x", false, web, 0);
+  do_test_completions("web-loginx", false, web, 0);
+
+  /* Appended names are ranked with the rest without a rebuild. */
+  assert(ERROR_NONE == append_sheet("web-auth"));
+  const char* const appended[] = { "web-auth", "web-cache", "web-login" };
+  do_test_completions("web-", true, appended, 3);
+  return 0;
+}
+
+/* A sheet changed behind the index's back makes it stale. */
+int test_stale_name_index(void) {
+  FILE* const fp = fopen(SHEET, "a");
+  assert(NULL != fp);
+  fputs("web-x\tACTIVE\t60\t0\n", fp);
+  fclose(fp);
+
+  char names[4][MAX_TASK_NAME + 1];
+  size_t name_count;
+  assert(ERROR_STALE_INDEX == find_name_completions(INDEX, SHEET, "web-x",
+        true, names, 4, &name_count).code);
+  assert(ERROR_STALE_INDEX == append_sheet("web-y"));
+  assert(ERROR_NONE == build_name_index(INDEX, SHEET).code);
+  assert(ERROR_NONE == find_name_completions(INDEX, SHEET, "web-x", true,
+        names, 4, &name_count).code);
+  assert(1 == name_count);
+
+  remove(SHEET);
+  remove(INDEX);
+  return 0;
+}
+
+int
+main(void) {
+  test_name_completions();
+  test_stale_name_index();
+  return 0;
+}
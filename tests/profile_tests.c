@@ -0,0 +1,107 @@
+#include "error.h"
+#include "profile.h"
+#include "utility.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char FILENAME[] = "test-profile.txt";
+
+static int test_profile_off(void);
+static int test_count_profile(void);
+static int test_set_profile_phase(void);
+static int test_put_profile(void);
+
+int test_profile_off(void) {
+  assert(!is_profiling());
+  assert(PHASE_OPEN == set_profile_phase(PHASE_SIMULATE));
+  assert(PHASE_OPEN == set_profile_phase(PHASE_OUTPUT));
+  count_profile(COUNTER_LINES_READ, 5);
+  assert(0 == get_profile_count(COUNTER_LINES_READ));
+  assert(0 == get_profile_seconds(PHASE_OPEN));
+  return 0;
+}
+
+int test_count_profile(void) {
+  start_profile();
+  assert(is_profiling());
+  count_profile(COUNTER_FIND_TASK_COMPARISONS, 3);
+  count_profile(COUNTER_FIND_TASK_COMPARISONS, 4);
+  assert(7 == get_profile_count(COUNTER_FIND_TASK_COMPARISONS));
+
+  /* The utilities count their own work. */
+  FILE* fp = fopen(FILENAME, "w");
+  assert(NULL != fp);
+  fputs("first\n\nlast", fp);
+  fclose(fp);
+  fp = fopen(FILENAME, "r");
+  assert(NULL != fp);
+  char buffer[16];
+  size_t bytes_read;
+  while (ERROR_NONE == get_line(fp, buffer, sizeof(buffer), &bytes_read).code)
+  {
+  }
+  fclose(fp);
+  remove(FILENAME);
+  assert(3 == get_profile_count(COUNTER_LINES_READ));
+  struct tm time;
+  assert(ERROR_NONE == parse_iso_8601_time("2024-02-29T12:00:00",
+        &time).code);
+  assert(1 == get_profile_count(COUNTER_MKTIME_CALLS));
+
+  /* Starting again starts from zero. */
+  start_profile();
+  assert(0 == get_profile_count(COUNTER_FIND_TASK_COMPARISONS));
+  assert(0 == get_profile_count(COUNTER_LINES_READ));
+  return 0;
+}
+
+int test_set_profile_phase(void) {
+  start_profile();
+  assert(PHASE_OPEN == set_profile_phase(PHASE_PARSE_TASKS));
+  const enum profile_phase phase = set_profile_phase(PHASE_FILTER);
+  assert(PHASE_PARSE_TASKS == phase);
+  volatile double sum = 0;
+  for (int loop_num = 0; loop_num < 1000000; loop_num++) {
+    sum += loop_num;
+  }
+  assert(PHASE_FILTER == set_profile_phase(phase));
+  assert(0 < get_profile_seconds(PHASE_FILTER));
+  assert(0 == get_profile_seconds(PHASE_SIMULATE));
+  assert(PHASE_PARSE_TASKS == set_profile_phase(PHASE_OUTPUT));
+  return 0;
+}
+
+int test_put_profile(void) {
+  start_profile();
+  count_profile(COUNTER_CALENDAR_DAYS, 42);
+  set_profile_phase(PHASE_SIMULATE);
+  FILE* fp = fopen(FILENAME, "w");
+  assert(NULL != fp);
+  put_profile(fp);
+  fclose(fp);
+
+  fp = fopen(FILENAME, "r");
+  assert(NULL != fp);
+  char buffer[1024];
+  const size_t length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+  fclose(fp);
+  remove(FILENAME);
+  buffer[length] = '\0';
+  assert(NULL != strstr(buffer, "profile total"));
+  assert(NULL != strstr(buffer, "profile simulate"));
+  assert(NULL == strstr(buffer, "profile output"));
+  assert(NULL != strstr(buffer, "calendar days visited"));
+  assert(NULL != strstr(buffer, " 42\n"));
+  return 0;
+}
+
+int
+main(void) {
+  test_profile_off();
+  test_count_profile();
+  test_set_profile_phase();
+  test_put_profile();
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include "error.h"
+#include "regex.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static int do_test_regex_matches(const char*, const char*, bool);
+static int test_regex_matches(void);
+static int test_bad_regex(void);
+static int test_regex_cache(void);
+
+int do_test_regex_matches(const char* const subject, const char* const
+    pattern, const bool expect_match) {
+  struct regex regex;
+  init_regex(&regex);
+  struct error error = compile_regex(pattern, strlen(pattern), &regex);
+  assert(ERROR_NONE == error.code);
+  printf("testing %s %s /%s/\n", subject, expect_match ? "matches" :
+      "does not match", pattern);
+  assert(expect_match == regex_matches(&regex, subject, strlen(subject)));
+  free_regex(&regex);
+  return 0;
+}
+
+int test_regex_matches(void) {
+  const char* patterns[] = {
+    "^infra-",
+    "^infra-",
+    "q[34]-.*-migration",
+    "q[34]-.*-migration",
+    "db$",
+    "db$",
+    "^(web|api)-[a-z]+$",
+    "^(web|api)-[a-z]+$",
+    "colou?r",
+    "ab+c",
+    "ab+c",
+    "[^a-z]",
+    "\\d\\d",
+    "a\\.b",
+    "a\\.b",
+    "",
+    "^$",
+    "^^a$$"
+  };
+  const char* subjects[] = {
+    "infra-dns",
+    "web-infra-dns",
+    "q3-users-migration",
+    "q2-users-migration",
+    "move-db",
+    "db-move",
+    "api-gateway",
+    "api-gateway2",
+    "color",
+    "ac",
+    "xabbbc",
+    "lowercase",
+    "v10",
+    "a.b",
+    "axb",
+    "anything",
+    "",
+    "a"
+  };
+  const bool expected[] = {
+    true,
+    false,
+    true,
+    false,
+    true,
+    false,
+    true,
+    false,
+    true,
+    false,
+    true,
+    false,
+    true,
+    true,
+    false,
+    true,
+    true,
+    true
+  };
+  const size_t max_test = sizeof(patterns) / sizeof(patterns[0]);
+  for (size_t test_num = 0; test_num < max_test; test_num++) {
+    do_test_regex_matches(subjects[test_num], patterns[test_num],
+        expected[test_num]);
+  }
+  return 0;
+}
+
+int test_bad_regex(void) {
+  const char* patterns[] = { "*a", "(ab", "ab)", "[ab", "a\\", "[z-a]" };
+  for (size_t test_num = 0; test_num < sizeof(patterns) /
+      sizeof(patterns[0]); test_num++) {
+    struct regex regex;
+    init_regex(&regex);
+    struct error error = compile_regex(patterns[test_num],
+        strlen(patterns[test_num]), &regex);
+    assert(ERROR_BAD_REGEX == error.code);
+    free_regex(&regex);
+  }
+
+  /* Each state of the DFA remembers which of the last n bytes were an 'a'. */
+  struct regex regex;
+  init_regex(&regex);
+  const char pattern[] = "a.............";
+  struct error error = compile_regex(pattern, strlen(pattern), &regex);
+  assert(ERROR_REGEX_TOO_COMPLEX == error.code);
+  free_regex(&regex);
+  return 0;
+}
+
+/* A cached regex matches like a freshly compiled one. */
+int test_regex_cache(void) {
+  const char pattern[] = "^q[34]-(.*)-migration$";
+  const char* subjects[] = { "q3-users-migration", "q3-users-migrations",
+    "q1-x-migration", "q4--migration" };
+  struct regex compiled;
+  init_regex(&compiled);
+  struct error error = compile_regex(pattern, strlen(pattern), &compiled);
+  assert(ERROR_NONE == error.code);
+  for (size_t load_num = 0; load_num < 2; load_num++) {
+    struct regex loaded;
+    init_regex(&loaded);
+    error = load_regex(pattern, strlen(pattern), "test-cache", &loaded);
+    assert(ERROR_NONE == error.code);
+    assert(compiled.state_count == loaded.state_count);
+    for (size_t subject_num = 0; subject_num < sizeof(subjects) /
+        sizeof(subjects[0]); subject_num++) {
+      const char* const subject = subjects[subject_num];
+      assert(regex_matches(&compiled, subject, strlen(subject)) ==
+          regex_matches(&loaded, subject, strlen(subject)));
+    }
+    free_regex(&loaded);
+  }
+  free_regex(&compiled);
+  return 0;
+}
+
+int
+main(void) {
+  test_regex_matches();
+  test_bad_regex();
+  test_regex_cache();
+  return 0;
+}
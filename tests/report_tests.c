@@ -0,0 +1,134 @@
+#include "error.h"
+#include "expression.h"
+#include "report.h"
+#include "time_snapshot.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char TIME_SHEET[] = "test-report-time.tsv";
+static const char TIME_SNAPSHOT[] = "test-report-time.col";
+
+static time_t get_local_time(int year, int month, int day, int hour);
+static int test_period_bounds(void);
+static int test_split_intervals(void);
+static int test_report_columns(void);
+
+time_t get_local_time(const int year, const int month, const int day, const
+    int hour) {
+  struct tm time;
+  memset(&time, 0, sizeof(time));
+  time.tm_year = year - 1900;
+  time.tm_mon = month - 1;
+  time.tm_mday = day;
+  time.tm_hour = hour;
+  time.tm_isdst = -1;
+  return mktime(&time);
+}
+
+int test_period_bounds(void) {
+  time_t start;
+  time_t end;
+  /* 2024-02-01 is a Thursday. */
+  const time_t time = get_local_time(2024, 2, 1, 13);
+  get_period_bounds(REPORT_DAY, time, &start, &end);
+  assert(get_local_time(2024, 2, 1, 0) == start);
+  assert(get_local_time(2024, 2, 2, 0) == end);
+  get_period_bounds(REPORT_WEEK, time, &start, &end);
+  assert(get_local_time(2024, 1, 29, 0) == start);
+  assert(get_local_time(2024, 2, 5, 0) == end);
+  get_period_bounds(REPORT_MONTH, time, &start, &end);
+  assert(get_local_time(2024, 2, 1, 0) == start);
+  assert(get_local_time(2024, 3, 1, 0) == end);
+  /* A Sunday belongs to the week before. */
+  get_period_bounds(REPORT_WEEK, get_local_time(2024, 2, 4, 23), &start,
+      &end);
+  assert(get_local_time(2024, 1, 29, 0) == start);
+
+  enum report_period period;
+  assert(ERROR_NONE == parse_report_period("month", &period).code);
+  assert(REPORT_MONTH == period);
+  assert(ERROR_UNKNOWN_PERIOD == parse_report_period("year", &period).code);
+  return 0;
+}
+
+int test_split_intervals(void) {
+  struct report report;
+  init_report(&report, REPORT_DAY);
+  assert(ERROR_NONE == add_report_time(&report, "a", get_local_time(2024, 1,
+          31, 22), get_local_time(2024, 2, 2, 1)).code);
+  assert(ERROR_NONE == add_report_time(&report, "b", get_local_time(2024, 2,
+          1, 8), get_local_time(2024, 2, 1, 9)).code);
+  struct expression filter;
+  assert(ERROR_NONE == parse_expression("", &filter).code);
+  assert(ERROR_NONE == finish_report(&report, &filter).code);
+  free_expression(&filter);
+
+  assert(4 == report.cells.entry_count);
+  assert(0 == strcmp("a", report.cells.entries[0].name));
+  assert(2 * 3600 == report.cells.entries[0].seconds);
+  assert(24 * 3600 == report.cells.entries[1].seconds);
+  assert(0 == strcmp("b", report.cells.entries[2].name));
+  assert(3600 == report.cells.entries[3].seconds);
+
+  assert(3 == report.periods.entry_count);
+  assert(get_local_time(2024, 2, 1, 0) ==
+      report.periods.entries[1].period_start);
+  assert(25 * 3600 == report.periods.entries[1].seconds);
+  assert(2 == report.tasks.entry_count);
+  assert(27 * 3600 == report.tasks.entries[0].seconds);
+  free_report(&report);
+  return 0;
+}
+
+int test_report_columns(void) {
+  FILE* const fp = fopen(TIME_SHEET, "w");
+  assert(NULL != fp);
+  fputs("2024-01-31T22:00:00\tweb-a\n"
+      "not a record\n"
+      "2024-02-01T01:00:00\tinfra\n"
+      "2024-02-01T02:30:00\tweb-b\n"
+      /* Time that goes back is left out. */
+      "2024-02-01T02:00:00\tweb-a\n"
+      "2024-02-05T09:00:00\tweb-b\n"
+      "2024-02-05T10:00:00\tweb-a\n", fp);
+  fclose(fp);
+
+  struct report report;
+  init_report(&report, REPORT_MONTH);
+  struct time_columns columns;
+  init_time_columns(&columns);
+  assert(ERROR_NONE == load_time_columns(TIME_SNAPSHOT, TIME_SHEET,
+        &columns).code);
+  assert(ERROR_NONE == add_report_columns(&report, &columns).code);
+  free_time_columns(&columns);
+  struct expression filter;
+  assert(ERROR_NONE == parse_expression("web", &filter).code);
+  assert(ERROR_NONE == finish_report(&report, &filter).code);
+  free_expression(&filter);
+
+  assert(3 == report.cells.entry_count);
+  assert(0 == strcmp("web-a", report.cells.entries[0].name));
+  assert(2 * 3600 == report.cells.entries[0].seconds);
+  assert(0 == strcmp("web-a", report.cells.entries[1].name));
+  assert((1 + 4 * 24 + 7) * 3600 == report.cells.entries[1].seconds);
+  assert(0 == strcmp("web-b", report.cells.entries[2].name));
+  assert(3600 == report.cells.entries[2].seconds);
+  assert(2 == report.periods.entry_count);
+  assert(2 == report.tasks.entry_count);
+  assert(report.cells.entries[0].seconds + report.cells.entries[1].seconds ==
+      report.tasks.entries[0].seconds);
+  free_report(&report);
+  remove(TIME_SHEET);
+  remove(TIME_SNAPSHOT);
+  return 0;
+}
+
+int
+main(void) {
+  test_period_bounds();
+  test_split_intervals();
+  test_report_columns();
+  return 0;
+}
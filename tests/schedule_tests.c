@@ -0,0 +1,69 @@
+#include "calendar.h"
+#include "error.h"
+#include "schedule.h"
+#include "task.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static int test_forecast_team(void);
+static int test_forecast_without_people(void);
+static void make_task(const char*, const char*, enum task_status, intmax_t,
+    intmax_t, struct task*);
+
+void make_task(const char* const name, const char* const owner, const enum
+    task_status status, const intmax_t estimated_hours, const intmax_t
+    actual_hours, struct task* const task) {
+  strcpy(task->name, name);
+  strcpy(task->owner, owner);
+  task->status = status;
+  task->estimated_seconds = estimated_hours * 60 * 60;
+  task->actual_seconds = actual_hours * 60 * 60;
+}
+
+int test_forecast_team(void) {
+  struct task tasks[5];
+  make_task("a", "alice", STATUS_ACTIVE, 80, 0, &tasks[0]);
+  make_task("b", "bob", STATUS_ACTIVE, 8, 0, &tasks[1]);
+  make_task("c", "", STATUS_ACTIVE, 40, 0, &tasks[2]);
+  make_task("d", "alice", STATUS_DONE, 8, 8, &tasks[3]);
+  make_task("e", "bob", STATUS_DONE, 8, 8, &tasks[4]);
+
+  struct team_forecast forecast;
+  struct error error = forecast_team(tasks, 5, NULL, &forecast);
+  assert(ERROR_NONE == error.code);
+  assert(2 == forecast.people_length);
+  assert(0 == strcmp("alice", forecast.people[0].name));
+  assert(1 == forecast.people[0].task_count);
+  assert(3 == forecast.team.task_count);
+
+  /* The unassigned task goes to bob, who is free first, so alice finishes
+   * last and the team finishes with her. */
+  const struct tm* const alice = &forecast.people[0].completion_dates[1];
+  const struct tm* const bob = &forecast.people[1].completion_dates[1];
+  const struct tm* const team = &forecast.team.completion_dates[1];
+  assert(COMPARISON_LESS_THAN == compare_time(bob, alice));
+  assert(is_same_date(alice, team));
+  return 0;
+}
+
+int test_forecast_without_people(void) {
+  struct task tasks[2];
+  make_task("a", "", STATUS_ACTIVE, 8, 0, &tasks[0]);
+  make_task("b", "", STATUS_ACTIVE, 8, 0, &tasks[1]);
+
+  struct team_forecast forecast;
+  struct error error = forecast_team(tasks, 2, NULL, &forecast);
+  assert(ERROR_NONE == error.code);
+  assert(1 == forecast.people_length);
+  assert(2 == forecast.people[0].task_count);
+  assert(is_same_date(&forecast.people[0].completion_dates[2],
+        &forecast.team.completion_dates[2]));
+  return 0;
+}
+
+int main(void) {
+  test_forecast_team();
+  test_forecast_without_people();
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include "error.h"
+#include "stats.h"
+#include "writer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char TASK_SHEET[] = "test-stats-task.tsv";
+static const char TIME_SHEET[] = "test-stats-time.tsv";
+static const char OUTPUT[] = "test-stats.json";
+
+static int test_scan_workspace_stats(void);
+static int test_put_workspace_stats(void);
+
+/* Write the sheets: a duplicate, a malformed row and a row longer than a
+ * line can be, then records out of order, for an unknown task, malformed
+ * and without a last new line. */
+static void write_sheets(void);
+
+void write_sheets(void) {
+  FILE* fp = fopen(TASK_SHEET, "w");
+  assert(NULL != fp);
+  fputs("login\tACTIVE\t10\t0\n", fp);
+  fputs("deploy-web\tDONE\t5\t7\tann\n", fp);
+  fputs("login\tACTIVE\t3\t0\n", fp);
+  fputs("garbage\n", fp);
+  for (size_t byte_num = 0; byte_num < MAX_STATS_LINE + 10; byte_num++) {
+    fputc('x', fp);
+  }
+  fputs("\tACTIVE\t1\t0\n", fp);
+  fclose(fp);
+
+  fp = fopen(TIME_SHEET, "w");
+  assert(NULL != fp);
+  fputs("2024-01-02T09:00:00\tlogin\n", fp);
+  fputs("2024-01-01T09:00:00\tdeploy-web\n", fp);
+  fputs("not a record\n", fp);
+  fputs("2024-01-03T09:00:00\tunknown\n", fp);
+  fputs("2024-01-04T09:00:00\tlogin", fp);
+  fclose(fp);
+}
+
+int test_scan_workspace_stats(void) {
+  write_sheets();
+  static struct workspace_stats stats;
+  assert(ERROR_NONE == scan_workspace_stats(TASK_SHEET, TIME_SHEET,
+        &stats).code);
+
+  assert(5 == stats.task_sheet.line_count);
+  assert(3 == stats.task_sheet.row_count);
+  assert(2 == stats.task_sheet.error_count);
+  assert(1 == stats.task_sheet.long_line_count);
+  assert(MAX_STATS_LINE + 10 + strlen("\tACTIVE\t1\t0") ==
+      stats.task_sheet.longest_line);
+  assert(1 == stats.done_count);
+  assert(1 == stats.duplicate_count);
+  assert(0 == strcmp("deploy-web", stats.longest_name));
+
+  assert(5 == stats.time_sheet.line_count);
+  assert(4 == stats.time_sheet.row_count);
+  assert(1 == stats.time_sheet.error_count);
+  assert(1 == stats.out_of_order_count);
+  assert(1 == stats.unknown_task_count);
+
+  /* The two names are each found in the first slot looked at, or one is
+   * found in the second. */
+  assert(0 < stats.slot_count);
+  assert(2 == stats.probe_histogram[0] + stats.probe_histogram[1]);
+  assert((1 == stats.max_probe) || (2 == stats.max_probe));
+
+  /* Without a time sheet, there are no records. */
+  remove(TIME_SHEET);
+  assert(ERROR_NONE == scan_workspace_stats(TASK_SHEET, TIME_SHEET,
+        &stats).code);
+  assert(0 == stats.time_sheet.line_count);
+  remove(TASK_SHEET);
+  assert(ERROR_FILE == scan_workspace_stats(TASK_SHEET, TIME_SHEET,
+        &stats).code);
+  return 0;
+}
+
+int test_put_workspace_stats(void) {
+  write_sheets();
+  static struct workspace_stats stats;
+  assert(ERROR_NONE == scan_workspace_stats(TASK_SHEET, TIME_SHEET,
+        &stats).code);
+  add_file_stats(&stats, "task.tsv", TASK_SHEET);
+  add_file_stats(&stats, "holiday.tsv", "test-stats-missing.tsv");
+  add_limit_stats(&stats, "max_task", 10, 9);
+  add_limit_stats(&stats, "max_loop", 10, 8);
+
+  FILE* fp = fopen(OUTPUT, "w");
+  assert(NULL != fp);
+  static struct writer writer;
+  init_writer(&writer, fp);
+  put_workspace_stats(&writer, &stats);
+  assert(ERROR_NONE == flush_writer(&writer).code);
+  fclose(fp);
+
+  static char buffer[4096];
+  fp = fopen(OUTPUT, "r");
+  assert(NULL != fp);
+  const size_t length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+  fclose(fp);
+  buffer[length] = '\0';
+  assert(NULL != strstr(buffer, "\"rows\":3,\"errors\":2,\"long_lines\":1"));
+  assert(NULL != strstr(buffer, "\"longest_name\":\"deploy-web\""));
+  assert(NULL != strstr(buffer, "\"out_of_order\":1,\"unknown_tasks\":1"));
+  assert(NULL != strstr(buffer, "\"holiday.tsv\":null"));
+  assert(NULL != strstr(buffer,
+        "\"max_task\":{\"limit\":10,\"used\":9,\"near\":true}"));
+  assert(NULL != strstr(buffer,
+        "\"max_loop\":{\"limit\":10,\"used\":8,\"near\":false}"));
+  assert('\n' == buffer[length - 1]);
+
+  remove(OUTPUT);
+  remove(TASK_SHEET);
+  remove(TIME_SHEET);
+  return 0;
+}
+
+int
+main(void) {
+  test_scan_workspace_stats();
+  test_put_workspace_stats();
+  return 0;
+}
@@ -0,0 +1,198 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "error.h"
+#include "expression.h"
+#include "task_load.h"
+#include <assert.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum {
+  TEST_MAX_TASK = 4
+};
+
+static char FIRST_WORKSPACE[] = "test-load-first";
+static char SECOND_WORKSPACE[] = "test-load-second";
+
+static int test_qualify_task_name(void);
+static int test_get_workspace_names(void);
+static int test_load_tasks(void);
+static int test_load_workspace_tasks(void);
+
+/* Make a workspace with a task sheet and an empty time sheet. */
+static void write_workspace(const char* directory, const char* tasks);
+
+/* Remove a workspace with what loading it left in it. */
+static void remove_workspace(const char* directory);
+
+/* Parse a filter and load the tasks of the config into tasks. */
+static struct error load_matching(const char* filter_text, struct config*,
+    struct task* tasks, size_t* task_count);
+
+void write_workspace(const char* const directory, const char* const tasks) {
+  mkdir(directory, 0777);
+  char filename[256];
+  snprintf(filename, sizeof(filename), "%s/%s", directory, TASK_SHEET);
+  FILE* fp = fopen(filename, "w");
+  assert(NULL != fp);
+  fputs(tasks, fp);
+  fclose(fp);
+  snprintf(filename, sizeof(filename), "%s/%s", directory, TIME_SHEET);
+  fp = fopen(filename, "w");
+  assert(NULL != fp);
+  fclose(fp);
+}
+
+void remove_workspace(const char* const directory) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", directory, CACHE_DIRECTORY);
+  DIR* const dir = opendir(path);
+  if (NULL != dir) {
+    for (struct dirent* entry = readdir(dir); NULL != entry; entry =
+        readdir(dir)) {
+      char filename[512];
+      snprintf(filename, sizeof(filename), "%s/%s", path, entry->d_name);
+      remove(filename);
+    }
+    closedir(dir);
+    rmdir(path);
+  }
+  const char* const files[] = { TASK_SHEET, TIME_SHEET, TASK_INDEX,
+    TIME_SNAPSHOT };
+  for (size_t file_num = 0; file_num < sizeof(files) / sizeof(files[0]);
+      file_num++) {
+    snprintf(path, sizeof(path), "%s/%s", directory, files[file_num]);
+    remove(path);
+  }
+  rmdir(directory);
+}
+
+struct error load_matching(const char* const filter_text, struct config* const
+    config, struct task* const tasks, size_t* const task_count) {
+  struct expression filter;
+  struct error error = parse_expression(filter_text, &filter);
+  assert(ERROR_NONE == error.code);
+  if (1 < config->path_count) {
+    error = load_workspace_tasks(&filter, true, config, tasks, TEST_MAX_TASK,
+        task_count);
+  } else {
+    error = load_tasks(filter_text, &filter, NULL, true, config, tasks,
+        TEST_MAX_TASK, task_count);
+  }
+  free_expression(&filter);
+  return error;
+}
+
+int test_qualify_task_name(void) {
+  char name[MAX_TASK_NAME + 1];
+  qualify_task_name("acme", "login", name);
+  assert(0 == strcmp("acme:login", name));
+
+  /* Long names are cut short. */
+  char long_name[MAX_TASK_NAME + 1];
+  memset(long_name, 'x', MAX_TASK_NAME);
+  long_name[MAX_TASK_NAME] = '\0';
+  qualify_task_name("acme", long_name, name);
+  assert(MAX_TASK_NAME == strlen(name));
+  assert(0 == strncmp("acme:xx", name, 7));
+  return 0;
+}
+
+int test_get_workspace_names(void) {
+  static char names[MAX_WORKSPACE][MAX_TASK_NAME + 1];
+  char acme[] = "/home/ann/work/acme/";
+  char globex[] = "globex";
+  struct config config;
+  config.base_paths[0] = acme;
+  config.base_paths[1] = globex;
+  config.path_count = 2;
+  assert(ERROR_NONE == get_workspace_names(&config, names).code);
+  assert(0 == strcmp("acme", names[0]));
+  assert(0 == strcmp("globex", names[1]));
+
+  /* Paths that end alike are told apart by more of them. */
+  char first[] = "/x/proj";
+  char second[] = "/y/proj";
+  char third[] = "/x/other";
+  config.base_paths[0] = first;
+  config.base_paths[1] = second;
+  config.base_paths[2] = third;
+  config.path_count = 3;
+  assert(ERROR_NONE == get_workspace_names(&config, names).code);
+  assert(0 == strcmp("x.proj", names[0]));
+  assert(0 == strcmp("y.proj", names[1]));
+  assert(0 == strcmp("other", names[2]));
+
+  /* The same directory can't be told apart from itself. */
+  char again[] = "/x/proj/";
+  config.base_paths[1] = again;
+  assert(ERROR_BAD_ARGUMENTS == get_workspace_names(&config, names).code);
+  return 0;
+}
+
+int test_load_tasks(void) {
+  write_workspace(FIRST_WORKSPACE, "login\tACTIVE\t60\t0\n"
+      "logout\tDONE\t30\t20\nsearch\tACTIVE\t90\t0\n");
+  struct config config;
+  config.base_path = FIRST_WORKSPACE;
+  config.base_paths[0] = FIRST_WORKSPACE;
+  config.path_count = 1;
+  struct task tasks[TEST_MAX_TASK + 1];
+  size_t task_count;
+  assert(ERROR_NONE == load_matching("log", &config, tasks,
+        &task_count).code);
+  assert(2 == task_count);
+  assert(0 == strcmp("login", tasks[0].name));
+  assert(0 == strcmp("logout", tasks[1].name));
+  assert(ERROR_NONE == load_matching("", &config, tasks, &task_count).code);
+  assert(3 == task_count);
+  remove_workspace(FIRST_WORKSPACE);
+  return 0;
+}
+
+int test_load_workspace_tasks(void) {
+  /* The first workspace alone has more tasks than fit, and the match is in
+   * the second. */
+  write_workspace(FIRST_WORKSPACE, "a\tACTIVE\t60\t0\nb\tACTIVE\t60\t0\n"
+      "c\tACTIVE\t60\t0\nd\tACTIVE\t60\t0\ne\tACTIVE\t60\t0\n");
+  write_workspace(SECOND_WORKSPACE, "f\tACTIVE\t60\t0\n"
+      "needle\tACTIVE\t60\t0\n");
+  struct config config;
+  config.base_path = FIRST_WORKSPACE;
+  config.base_paths[0] = FIRST_WORKSPACE;
+  config.base_paths[1] = SECOND_WORKSPACE;
+  config.path_count = 2;
+  struct task tasks[TEST_MAX_TASK + 1];
+  size_t task_count;
+  assert(ERROR_NONE == load_matching("needle", &config, tasks,
+        &task_count).code);
+  assert(1 == task_count);
+  assert(0 == strcmp("test-load-second:needle", tasks[0].name));
+
+  /* The filter sees the qualified names. */
+  assert(ERROR_NONE == load_matching("test-load-first:/!b", &config, tasks,
+        &task_count).code);
+  assert(4 == task_count);
+  assert(0 == strcmp("test-load-first:a", tasks[0].name));
+  assert(0 == strcmp("test-load-first:e", tasks[3].name));
+
+  /* More matches than fit are cut to the first ones. */
+  assert(ERROR_NONE == load_matching("", &config, tasks, &task_count).code);
+  assert(TEST_MAX_TASK == task_count);
+  remove_workspace(FIRST_WORKSPACE);
+  remove_workspace(SECOND_WORKSPACE);
+  return 0;
+}
+
+int
+main(void) {
+  test_qualify_task_name();
+  test_get_workspace_names();
+  test_load_tasks();
+  test_load_workspace_tasks();
+  return 0;
+}
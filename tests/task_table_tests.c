@@ -0,0 +1,148 @@
+#include "error.h"
+#include "task.h"
+#include "task_table.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char SHEET[] = "test-table.tsv";
+static const char TIME_SHEET[] = "test-table-time.tsv";
+
+static int test_add_and_find(void);
+static int test_read_and_write(void);
+static int test_remove_table_tasks(void);
+static int test_compact_time_sheet(void);
+
+int test_add_and_find(void) {
+  struct task_table table;
+  init_task_table(&table);
+  struct task* found;
+  assert(ERROR_NO_SUCH_TASK == find_table_task(&table, "x", &found).code);
+
+  /* Add enough tasks to grow the table a few times. */
+  for (int task_num = 0; task_num < 1000; task_num++) {
+    struct task task = { 60, 0, "", "", STATUS_ACTIVE };
+    snprintf(task.name, sizeof(task.name), "task-%d", task_num);
+    assert(ERROR_NONE == add_table_task(&table, &task).code);
+  }
+  struct task duplicate = { 60, 0, "task-7", "", STATUS_ACTIVE };
+  assert(ERROR_TASK_EXISTS == add_table_task(&table, &duplicate).code);
+  assert(1000 == table.task_count);
+
+  for (int task_num = 0; task_num < 1000; task_num++) {
+    char name[32];
+    snprintf(name, sizeof(name), "task-%d", task_num);
+    assert(ERROR_NONE == find_table_task(&table, name, &found).code);
+    assert(0 == strcmp(name, found->name));
+  }
+  assert(ERROR_NO_SUCH_TASK == find_table_task(&table, "task-1000",
+        &found).code);
+  free_task_table(&table);
+  return 0;
+}
+
+int test_read_and_write(void) {
+  FILE* const fp = fopen(SHEET, "w");
+  assert(NULL != fp);
+  fputs("b\tACTIVE\t60\t0\na\tDONE\t30\t0\tbob\n", fp);
+  fclose(fp);
+
+  struct task_table table;
+  init_task_table(&table);
+  assert(ERROR_NONE == read_task_table(SHEET, &table).code);
+  assert(2 == table.task_count);
+  struct task* found;
+  assert(ERROR_NONE == find_table_task(&table, "a", &found).code);
+  assert(STATUS_DONE == found->status);
+  assert(0 == strcmp("bob", found->owner));
+  found->status = STATUS_ACTIVE;
+  struct task task = { 600, 0, "c", "", STATUS_ACTIVE };
+  assert(ERROR_NONE == add_table_task(&table, &task).code);
+  assert(ERROR_NONE == write_task_table(&table, SHEET).code);
+  free_task_table(&table);
+
+  /* The sheet keeps its order and the changes. */
+  init_task_table(&table);
+  assert(ERROR_NONE == read_task_table(SHEET, &table).code);
+  assert(3 == table.task_count);
+  assert(0 == strcmp("b", table.tasks[0].name));
+  assert(0 == strcmp("a", table.tasks[1].name));
+  assert(STATUS_ACTIVE == table.tasks[1].status);
+  assert(0 == strcmp("c", table.tasks[2].name));
+  free_task_table(&table);
+  remove(SHEET);
+  return 0;
+}
+
+int test_remove_table_tasks(void) {
+  struct task_table table;
+  init_task_table(&table);
+  for (int task_num = 0; task_num < 5; task_num++) {
+    struct task task = { 60, 0, "", "", STATUS_ACTIVE };
+    snprintf(task.name, sizeof(task.name), "task-%d", task_num);
+    assert(ERROR_NONE == add_table_task(&table, &task).code);
+  }
+  const bool is_removed[] = { true, false, true, false, false };
+  remove_table_tasks(&table, is_removed);
+  assert(3 == table.task_count);
+  struct task* found;
+  assert(ERROR_NO_SUCH_TASK == find_table_task(&table, "task-2",
+        &found).code);
+  assert(ERROR_NONE == find_table_task(&table, "task-4", &found).code);
+  assert(&table.tasks[2] == found);
+  free_task_table(&table);
+  return 0;
+}
+
+/* Only records that change where the time goes are kept. */
+int test_compact_time_sheet(void) {
+  FILE* const fp = fopen(TIME_SHEET, "w");
+  assert(NULL != fp);
+  fputs("2020-01-01T08:00:00\tgone\n"
+      "2020-01-01T09:00:00\ta\n"
+      "2020-01-01T10:00:00\ta\n"
+      "2020-01-01T11:00:00\tgone\n"
+      "2020-01-01T11:30:00\trest\n"
+      "2020-01-01T12:00:00\ta\n"
+      "not a record\n"
+      "2020-01-01T13:00:00\tb", fp);
+  fclose(fp);
+
+  struct task_table table;
+  init_task_table(&table);
+  const struct task tasks[] = {
+    { 60, 0, "a", "", STATUS_ACTIVE },
+    { 60, 0, "b", "", STATUS_ACTIVE }
+  };
+  assert(ERROR_NONE == add_table_task(&table, &tasks[0]).code);
+  assert(ERROR_NONE == add_table_task(&table, &tasks[1]).code);
+  size_t removed_count;
+  assert(ERROR_NONE == compact_time_sheet(&table, TIME_SHEET,
+        &removed_count).code);
+  assert(3 == removed_count);
+  free_task_table(&table);
+
+  FILE* const compacted = fopen(TIME_SHEET, "r");
+  assert(NULL != compacted);
+  char buffer[256];
+  const size_t length = fread(buffer, 1, sizeof(buffer) - 1, compacted);
+  fclose(compacted);
+  buffer[length] = '\0';
+  assert(0 == strcmp("2020-01-01T09:00:00\ta\n"
+        "2020-01-01T11:00:00\tgone\n"
+        "2020-01-01T12:00:00\ta\n"
+        "not a record\n"
+        "2020-01-01T13:00:00\tb\n", buffer));
+  remove(TIME_SHEET);
+  return 0;
+}
+
+int
+main(void) {
+  test_add_and_find();
+  test_read_and_write();
+  test_remove_table_tasks();
+  test_compact_time_sheet();
+  return 0;
+}
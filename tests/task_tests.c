@@ -13,10 +13,15 @@ static int test_parse_and_format_task(void);
 
 static int test_parse_time_record(void);
 
+static int test_parse_and_format_task_with_owner(void);
+
+static int test_current_task(void);
+
 int test_add_time_sheet_entry(void) {
   char filename[] = "test.tsv";
   char task_name[] = "greet-world";
-  struct error error = append_time_sheet_entry(filename, task_name);
+  struct error error = append_time_sheet_entry(filename, NULL, NULL,
+      task_name);
   assert(ERROR_NONE == error.code);
   return 0;
 }
@@ -44,6 +49,21 @@ int test_parse_and_format_task(void) {
   return 0;
 }
 
+int test_parse_and_format_task_with_owner(void) {
+  char s[] = "hello-world\tDONE\t10\t20\talice";
+  struct task t;
+  struct error error = parse_task(s, &t);
+  assert(ERROR_NONE == error.code);
+  assert(STATUS_DONE == t.status);
+  assert(0 == strcmp("alice", t.owner));
+
+  char buffer[128];
+  error = format_task(&t, buffer, 128);
+  assert(ERROR_NONE == error.code);
+  assert(0 == strcmp(s, buffer));
+  return 0;
+}
+
 int test_parse_time_record(void) {
   char s[] = "1970-01-01T00:00:00\ttest_task";
   struct time_record t;
@@ -56,9 +76,56 @@ int test_parse_time_record(void) {
   return 0;
 }
 
+/* The current task comes from the state file while it is up to date, and
+ * from the end of the sheet otherwise. */
+int test_current_task(void) {
+  const char time_sheet[] = "test-current.tsv";
+  const char state_file[] = "test-current";
+  remove(time_sheet);
+  remove(state_file);
+  struct time_record record;
+  uint64_t sheet_size;
+  FILE* fp = fopen(time_sheet, "w");
+  assert(NULL != fp);
+  fputs("\n", fp);
+  fclose(fp);
+  assert(ERROR_END_OF_FILE == read_last_time_record(time_sheet, &record,
+        &sheet_size).code);
+  assert(ERROR_STALE_INDEX == read_current_task(state_file, time_sheet,
+        &record).code);
+
+  assert(ERROR_NONE == append_time_sheet_entry(time_sheet, state_file,
+        NULL, "first").code);
+  assert(ERROR_NONE == append_time_sheet_entry(time_sheet, state_file,
+        NULL, "second").code);
+  assert(ERROR_NONE == read_current_task(state_file, time_sheet,
+        &record).code);
+  assert(0 == strcmp("second", record.name));
+
+  fp = fopen(time_sheet, "a");
+  assert(NULL != fp);
+  fputs("2020-01-01T10:00:00\tthird\n\n", fp);
+  fclose(fp);
+  assert(ERROR_STALE_INDEX == read_current_task(state_file, time_sheet,
+        &record).code);
+  assert(ERROR_NONE == read_last_time_record(time_sheet, &record,
+        &sheet_size).code);
+  assert(0 == strcmp("third", record.name));
+  assert(ERROR_NONE == write_current_task(state_file, &record,
+        sheet_size).code);
+  assert(ERROR_NONE == read_current_task(state_file, time_sheet,
+        &record).code);
+  assert(0 == strcmp("third", record.name));
+  remove(time_sheet);
+  remove(state_file);
+  return 0;
+}
+
 int main(void) {
   test_add_time_sheet_entry();
   test_parse_and_format_task();
   test_parse_time_record();
+  test_parse_and_format_task_with_owner();
+  test_current_task();
   return 0;
 }
@@ -0,0 +1,144 @@
+#include "error.h"
+#include "time_index.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char TIME_SHEET[] = "test-index-time.tsv";
+static const char TIME_INDEX[] = "test-index-time.idx";
+
+static void write_sheet(const char* mode, const char* text);
+static long get_sheet_size(void);
+static void load_index(struct time_index*);
+static int test_sparse_entries(void);
+static int test_find_offset(void);
+static int test_append_time_index(void);
+static int test_unsorted_sheet(void);
+
+void write_sheet(const char* const mode, const char* const text) {
+  FILE* const fp = fopen(TIME_SHEET, mode);
+  assert(NULL != fp);
+  fputs(text, fp);
+  fclose(fp);
+}
+
+long get_sheet_size(void) {
+  FILE* const fp = fopen(TIME_SHEET, "rb");
+  assert(NULL != fp);
+  fseek(fp, 0, SEEK_END);
+  const long size = ftell(fp);
+  fclose(fp);
+  return size;
+}
+
+void load_index(struct time_index* const index) {
+  init_time_index(index);
+  assert(ERROR_NONE == load_time_index(TIME_INDEX, TIME_SHEET, index).code);
+}
+
+/* The first record and every TIME_INDEX_STRIDE-th after it get an entry. */
+int test_sparse_entries(void) {
+  remove(TIME_INDEX);
+  FILE* const fp = fopen(TIME_SHEET, "w");
+  assert(NULL != fp);
+  fputs("oops\n", fp);
+  for (int record_num = 0; record_num < 2 * TIME_INDEX_STRIDE + 1;
+      record_num++) {
+    fprintf(fp, "2024-01-01T%02d:%02d:00\ta\n", record_num / 60 % 24,
+        record_num % 60);
+  }
+  fclose(fp);
+  struct time_index built;
+  load_index(&built);
+  assert(2 * TIME_INDEX_STRIDE + 1 == built.record_count);
+  assert(3 == built.entry_count);
+  assert(5 == built.entries[0].offset);
+  assert(5 + 22 * TIME_INDEX_STRIDE == built.entries[1].offset);
+  assert(built.is_sorted);
+
+  /* The second load reads the same index from the file. */
+  struct time_index loaded;
+  load_index(&loaded);
+  assert(built.entry_count == loaded.entry_count);
+  assert(built.sheet_size == loaded.sheet_size);
+  assert(0 == memcmp(built.entries, loaded.entries, built.entry_count *
+        sizeof(struct time_index_entry)));
+  free_time_index(&built);
+  free_time_index(&loaded);
+  return 0;
+}
+
+int test_find_offset(void) {
+  struct time_index index;
+  init_time_index(&index);
+  for (int64_t record_num = 0; record_num < 3 * TIME_INDEX_STRIDE;
+      record_num++) {
+    assert(ERROR_NONE == add_time_index_record(&index, 10 * record_num,
+          (uint64_t) (100 * record_num)).code);
+  }
+  /* The search starts at the last entry before the time. */
+  assert(0 == find_time_index_offset(&index, 0));
+  assert(0 == find_time_index_offset(&index, 10 * TIME_INDEX_STRIDE));
+  assert(100 * TIME_INDEX_STRIDE == find_time_index_offset(&index, 10 *
+        TIME_INDEX_STRIDE + 1));
+  assert(200 * TIME_INDEX_STRIDE == find_time_index_offset(&index, 1000000));
+  free_time_index(&index);
+  return 0;
+}
+
+int test_append_time_index(void) {
+  remove(TIME_INDEX);
+  write_sheet("w", "2024-01-01T09:00:00\ta\n");
+  struct time_index index;
+  load_index(&index);
+  free_time_index(&index);
+
+  /* An append right after the index is added to it. */
+  const long start = get_sheet_size();
+  write_sheet("a", "2024-01-01T10:00:00\tb\n");
+  assert(ERROR_NONE == append_time_index(TIME_INDEX, TIME_SHEET, (uint64_t)
+        start, (uint64_t) get_sheet_size()).code);
+  load_index(&index);
+  assert(2 == index.record_count);
+  assert((uint64_t) get_sheet_size() == index.sheet_size);
+  free_time_index(&index);
+
+  /* An append after lines the index missed is left to the next load. */
+  write_sheet("a", "2024-01-01T11:00:00\tc\n");
+  const long missed = get_sheet_size();
+  write_sheet("a", "2024-01-01T12:00:00\td\n");
+  assert(ERROR_STALE_INDEX == append_time_index(TIME_INDEX, TIME_SHEET,
+        (uint64_t) missed, (uint64_t) get_sheet_size()).code);
+  load_index(&index);
+  assert(4 == index.record_count);
+  free_time_index(&index);
+
+  /* A sheet edited in place is indexed again. */
+  write_sheet("w", "2024-01-01T09:00:00\tx\n");
+  load_index(&index);
+  assert(1 == index.record_count);
+  free_time_index(&index);
+  return 0;
+}
+
+int test_unsorted_sheet(void) {
+  write_sheet("w", "2024-01-01T10:00:00\ta\n"
+      "2024-01-01T09:00:00\tb\n");
+  struct time_index index;
+  load_index(&index);
+  assert(!index.is_sorted);
+  assert(0 == find_time_index_offset(&index, 2000000000));
+  free_time_index(&index);
+  remove(TIME_SHEET);
+  remove(TIME_INDEX);
+  return 0;
+}
+
+int
+main(void) {
+  test_sparse_entries();
+  test_find_offset();
+  test_append_time_index();
+  test_unsorted_sheet();
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include "error.h"
+#include "task.h"
+#include "time_snapshot.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char TIME_SHEET[] = "test-snapshot-time.tsv";
+static const char TIME_SNAPSHOT[] = "test-snapshot-time.col";
+
+static void write_sheet(const char* mode, const char* text);
+static void load_columns(struct time_columns*);
+static int test_snapshot_round_trip(void);
+static int test_appended_records(void);
+static int test_rewritten_sheet(void);
+static int test_column_times(void);
+
+void write_sheet(const char* const mode, const char* const text) {
+  FILE* const fp = fopen(TIME_SHEET, mode);
+  assert(NULL != fp);
+  fputs(text, fp);
+  fclose(fp);
+}
+
+void load_columns(struct time_columns* const columns) {
+  init_time_columns(columns);
+  assert(ERROR_NONE == load_time_columns(TIME_SNAPSHOT, TIME_SHEET,
+        columns).code);
+}
+
+int test_snapshot_round_trip(void) {
+  remove(TIME_SNAPSHOT);
+  /* Times that go back and a malformed line are kept as they are read. */
+  write_sheet("w", "2024-01-01T09:00:00\ta\n"
+      "2024-01-01T10:00:00\tb\n"
+      "oops\n"
+      "2024-01-01T09:30:00\ta\n"
+      "2030-06-01T00:00:00\tc\n"
+      "2024-01-01T11:00:00");
+  struct time_columns built;
+  load_columns(&built);
+  assert(4 == built.record_count);
+  assert(3 == built.name_count);
+  assert(0 == strcmp("a", get_time_column_name(&built,
+          built.name_ids[2])));
+
+  /* The second load reads the snapshot and gets the same columns. */
+  FILE* const fp = fopen(TIME_SNAPSHOT, "rb");
+  assert(NULL != fp);
+  fclose(fp);
+  struct time_columns loaded;
+  load_columns(&loaded);
+  assert(built.record_count == loaded.record_count);
+  assert(built.sheet_size == loaded.sheet_size);
+  for (size_t record_num = 0; record_num < built.record_count; record_num++) {
+    assert(built.times[record_num] == loaded.times[record_num]);
+    assert(0 == strcmp(get_time_column_name(&built,
+            built.name_ids[record_num]), get_time_column_name(&loaded,
+              loaded.name_ids[record_num])));
+  }
+  free_time_columns(&built);
+  free_time_columns(&loaded);
+  return 0;
+}
+
+int test_appended_records(void) {
+  /* The last line is completed, and a record with a new name added. */
+  write_sheet("a", "\td\n2024-01-01T12:00:00\te\n");
+  struct time_columns columns;
+  load_columns(&columns);
+  assert(6 == columns.record_count);
+  assert(5 == columns.name_count);
+  assert(0 == strcmp("e", get_time_column_name(&columns,
+          columns.name_ids[5])));
+  free_time_columns(&columns);
+  return 0;
+}
+
+/* A sheet of the same size edited in place is read again. */
+int test_rewritten_sheet(void) {
+  write_sheet("w", "2024-01-01T09:00:00\tx\n");
+  struct time_columns columns;
+  load_columns(&columns);
+  write_sheet("w", "2024-01-01T09:00:00\ty\n");
+  free_time_columns(&columns);
+  load_columns(&columns);
+  assert(1 == columns.record_count);
+  assert(0 == strcmp("y", get_time_column_name(&columns,
+          columns.name_ids[0])));
+  free_time_columns(&columns);
+  return 0;
+}
+
+int test_column_times(void) {
+  write_sheet("w", "2024-01-01T09:00:00\ta\n"
+      "2024-01-01T10:00:00\tgone\n"
+      "2024-01-01T10:30:00\ta\n"
+      "2024-01-01T10:45:00\tb\n"
+      "2024-01-01T11:00:00\ta\n");
+  struct time_columns columns;
+  load_columns(&columns);
+  struct task tasks[] = {
+    { 3600, 60, "a", "", STATUS_ACTIVE },
+    { 3600, 0, "b", "", STATUS_ACTIVE },
+    { 3600, 0, "a", "", STATUS_ACTIVE },
+    { 3600, 0, "unused", "", STATUS_ACTIVE }
+  };
+  assert(ERROR_NONE == add_column_times(&columns, tasks, 4).code);
+  assert(60 + 4500 == tasks[0].actual_seconds);
+  assert(900 == tasks[1].actual_seconds);
+  assert(0 == tasks[2].actual_seconds);
+  assert(0 == tasks[3].actual_seconds);
+  free_time_columns(&columns);
+  remove(TIME_SHEET);
+  remove(TIME_SNAPSHOT);
+  return 0;
+}
+
+int
+main(void) {
+  test_snapshot_round_trip();
+  test_appended_records();
+  test_rewritten_sheet();
+  test_column_times();
+  return 0;
+}
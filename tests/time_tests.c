@@ -21,6 +21,12 @@ test_is_in_event(void);
 void
 test_completion_date(void);
 
+void
+test_date_set(void);
+
+void
+test_completion_date_with_holidays(void);
+
 /* Test correct error code is returned when parsing invalid string. */
 void
 test_parser_errors_for_invalid_input(void) {
@@ -132,6 +138,67 @@ test_completion_date(void) {
 	assert((2016 - 1900) == completion_date.tm_year);
 	assert((9 - 1) == completion_date.tm_mon);
 	assert(12 == completion_date.tm_mday);
+	free_calendar(&calendar);
+}
+
+/* Test dates can be added in any order and found again. */
+void
+test_date_set(void) {
+	struct tm epoch;
+	parse_iso_8601_time("1970-01-01T00:00:00", &epoch);
+	assert(0 == get_day_number(&epoch));
+
+	struct tm leap_day;
+	parse_iso_8601_time("2016-02-29T12:00:00", &leap_day);
+	assert(16860 == get_day_number(&leap_day));
+
+	struct date_set set;
+	init_date_set(&set);
+	const int32_t days[] = { 30, 10, 20, 10 };
+	assert(ERROR_NONE == add_dates(days, 4, &set).code);
+	assert(ERROR_NONE == add_date(15, &set).code);
+	assert(ERROR_NONE == add_date(40, &set).code);
+	assert(5 == set.length);
+	assert(is_in_date_set(10, &set));
+	assert(is_in_date_set(15, &set));
+	assert(is_in_date_set(40, &set));
+	assert(!is_in_date_set(11, &set));
+	for (size_t index = 1; index < set.length; index++) {
+		assert(set.days[index - 1] < set.days[index]);
+	}
+	free_date_set(&set);
+}
+
+/* Test one-off days off push the completion date back. */
+void
+test_completion_date_with_holidays(void) {
+	struct tm start;
+	parse_iso_8601_time("2016-09-08T12:12:12", &start);
+
+	struct event work = {
+		.start = start,
+		.period = DAY,
+		.repetition = 10
+	};
+
+	struct calendar calendar;
+	init_calendar(&calendar);
+	add_inclusion(&work, &calendar);
+
+	struct tm holiday;
+	parse_iso_8601_time("2016-09-09T00:00:00", &holiday);
+	add_excluded_date(&holiday, &calendar);
+	parse_iso_8601_time("2016-09-10T00:00:00", &holiday);
+	add_excluded_date(&holiday, &calendar);
+
+	struct tm completion_date;
+	struct error error = compute_completion_date(&start, &calendar, 100, 200,
+			&completion_date);
+
+	assert(ERROR_NONE == error.code);
+	assert((9 - 1) == completion_date.tm_mon);
+	assert(11 == completion_date.tm_mday);
+	free_calendar(&calendar);
 }
 
 int main(void) {
@@ -140,5 +207,7 @@ int main(void) {
   test_add_time();
 	test_is_in_event();
 	test_completion_date();
+	test_date_set();
+	test_completion_date_with_holidays();
 	return 0;
 }
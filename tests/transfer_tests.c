@@ -0,0 +1,187 @@
+#include "error.h"
+#include "task.h"
+#include "transfer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char FILENAME[] = "test-transfer.txt";
+static const char TIME_SHEET[] = "test-transfer.tsv";
+
+static int test_round_trip(void);
+static int test_read_tasks(void);
+static int test_merge_time_records(void);
+static int test_merge_tied_time_records(void);
+
+/* Tasks and time records come back the same in every format. */
+int test_round_trip(void) {
+  const struct task tasks[] = {
+    { 600, 60, "plain", "", STATUS_ACTIVE },
+    { 60, 0, "needs,\"quotes\"", "a,b", STATUS_DONE }
+  };
+  const struct time_record record = { "needs,\"quotes\"", 1000000000 };
+  for (enum transfer_format format = 0; format < MAX_FORMAT; format++) {
+    FILE* fp = fopen(FILENAME, "w");
+    assert(NULL != fp);
+    write_transfer_header(fp, format, false);
+    for (size_t task_num = 0; task_num < 2; task_num++) {
+      assert(ERROR_NONE == write_transfer_task(fp, format,
+            &tasks[task_num]).code);
+    }
+    fclose(fp);
+
+    fp = fopen(FILENAME, "r");
+    assert(NULL != fp);
+    size_t line_num = 0;
+    for (size_t task_num = 0; task_num < 2; task_num++) {
+      struct task task;
+      assert(ERROR_NONE == read_transfer_task(fp, format, &line_num,
+            &task).code);
+      assert(0 == strcmp(tasks[task_num].name, task.name));
+      assert(0 == strcmp(tasks[task_num].owner, task.owner));
+      assert(tasks[task_num].status == task.status);
+      assert(tasks[task_num].estimated_seconds == task.estimated_seconds);
+      assert(tasks[task_num].actual_seconds == task.actual_seconds);
+    }
+    struct task task;
+    assert(ERROR_END_OF_FILE == read_transfer_task(fp, format, &line_num,
+          &task).code);
+    fclose(fp);
+
+    fp = fopen(FILENAME, "w");
+    assert(NULL != fp);
+    write_transfer_header(fp, format, true);
+    assert(ERROR_NONE == write_transfer_record(fp, format, &record).code);
+    fclose(fp);
+    fp = fopen(FILENAME, "r");
+    assert(NULL != fp);
+    struct time_record read_record;
+    line_num = 0;
+    assert(ERROR_NONE == read_transfer_record(fp, format, &line_num,
+          &read_record).code);
+    assert(0 == strcmp(record.name, read_record.name));
+    assert(record.time == read_record.time);
+    fclose(fp);
+  }
+  remove(FILENAME);
+  return 0;
+}
+
+/* Bad lines are reported with their line numbers. */
+int test_read_tasks(void) {
+  FILE* fp = fopen(FILENAME, "w");
+  assert(NULL != fp);
+  fputs("{\"name\": \"a\\u00e9\", \"status\": \"DONE\", \"estimate\": 5,\n"
+      "\n"
+      "{\"estimate\": 5, \"actual\": 0, \"name\": \"b\", \"status\": "
+      "\"ACTIVE\", \"other\": \"x\"}\r\n"
+      "{\"name\": \"has space\", \"status\": \"ACTIVE\", \"estimate\": 5, "
+      "\"actual\": 0}\n", fp);
+  fclose(fp);
+
+  fp = fopen(FILENAME, "r");
+  assert(NULL != fp);
+  size_t line_num = 0;
+  struct task task;
+  assert(ERROR_MALFORMED_RECORD == read_transfer_task(fp, FORMAT_JSONL,
+        &line_num, &task).code);
+  assert(1 == line_num);
+  assert(ERROR_NONE == read_transfer_task(fp, FORMAT_JSONL, &line_num,
+        &task).code);
+  assert(3 == line_num);
+  assert(0 == strcmp("b", task.name));
+  assert(300 == task.estimated_seconds);
+  assert(ERROR_MALFORMED_RECORD == read_transfer_task(fp, FORMAT_JSONL,
+        &line_num, &task).code);
+  assert(4 == line_num);
+  fclose(fp);
+
+  enum transfer_format format;
+  assert(ERROR_UNKNOWN_FORMAT == parse_transfer_format("xml", &format).code);
+  assert(ERROR_NONE == parse_transfer_format("csv", &format).code);
+  assert(FORMAT_CSV == format);
+  remove(FILENAME);
+  return 0;
+}
+
+int test_merge_time_records(void) {
+  FILE* const fp = fopen(TIME_SHEET, "w");
+  assert(NULL != fp);
+  fputs("2020-01-01T10:00:00\ta\n2020-01-01T12:00:00\tb\n", fp);
+  fclose(fp);
+
+  struct time_record records[4];
+  size_t line_num = 0;
+  assert(ERROR_NONE == parse_time_record("2020-01-01T13:00:00\te",
+        &records[0]).code);
+  assert(ERROR_NONE == parse_time_record("2020-01-01T11:00:00\tc",
+        &records[1]).code);
+  assert(ERROR_NONE == parse_time_record("2020-01-01T10:00:00\ta",
+        &records[2]).code);
+  assert(ERROR_NONE == parse_time_record("2020-01-01T11:00:00\td",
+        &records[3]).code);
+  size_t merged_count;
+  assert(ERROR_NONE == merge_time_records(TIME_SHEET, records, 4,
+        &merged_count).code);
+  assert(3 == merged_count);
+
+  FILE* const merged = fopen(TIME_SHEET, "r");
+  assert(NULL != merged);
+  const char* const expected[] = { "a", "c", "d", "b", "e" };
+  for (size_t record_num = 0; record_num < 5; record_num++) {
+    struct time_record record;
+    assert(ERROR_NONE == read_transfer_record(merged, FORMAT_TSV, &line_num,
+          &record).code);
+    assert(0 == strcmp(expected[record_num], record.name));
+  }
+  fclose(merged);
+  remove(TIME_SHEET);
+  return 0;
+}
+
+int test_merge_tied_time_records(void) {
+  /* Every existing record of a time is a duplicate, not only the first. */
+  FILE* const fp = fopen(TIME_SHEET, "w");
+  assert(NULL != fp);
+  fputs("2020-01-01T10:00:00\tb\n2020-01-01T10:00:00\ta\n"
+      "2020-01-01T12:00:00\tc", fp);
+  fclose(fp);
+
+  struct time_record records[3];
+  assert(ERROR_NONE == parse_time_record("2020-01-01T10:00:00\ta",
+        &records[0]).code);
+  assert(ERROR_NONE == parse_time_record("2020-01-01T10:00:00\tb",
+        &records[1]).code);
+  assert(ERROR_NONE == parse_time_record("2020-01-01T10:00:00\td",
+        &records[2]).code);
+  size_t merged_count;
+  assert(ERROR_NONE == merge_time_records(TIME_SHEET, records, 3,
+        &merged_count).code);
+  assert(1 == merged_count);
+
+  FILE* const merged = fopen(TIME_SHEET, "r");
+  assert(NULL != merged);
+  const char* const expected[] = { "b", "a", "d", "c" };
+  size_t line_num = 0;
+  for (size_t record_num = 0; record_num < 4; record_num++) {
+    struct time_record record;
+    assert(ERROR_NONE == read_transfer_record(merged, FORMAT_TSV, &line_num,
+          &record).code);
+    assert(0 == strcmp(expected[record_num], record.name));
+  }
+  struct time_record record;
+  assert(ERROR_END_OF_FILE == read_transfer_record(merged, FORMAT_TSV,
+        &line_num, &record).code);
+  fclose(merged);
+  remove(TIME_SHEET);
+  return 0;
+}
+
+int
+main(void) {
+  test_round_trip();
+  test_read_tasks();
+  test_merge_time_records();
+  test_merge_tied_time_records();
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include "error.h"
+#include "expression.h"
+#include "task.h"
+#include "trigram.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char SHEET[] = "test-trigram.tsv";
+static const char INDEX[] = "test-trigram.idx";
+
+static int write_sheet(const char* const* names, size_t name_count, uint64_t*
+    offsets);
+static int append_sheet(const char* name, uint64_t* offset);
+static int do_test_candidates(const char* filter, const uint64_t* expected,
+    size_t expected_count);
+static int test_trigram_candidates(void);
+static int test_stale_index(void);
+
+int write_sheet(const char* const* const names, const size_t name_count,
+    uint64_t* const offsets) {
+  FILE* const fp = fopen(SHEET, "w");
+  assert(NULL != fp);
+  for (size_t name_num = 0; name_num < name_count; name_num++) {
+    struct task task = { 60, 0, "", "", STATUS_ACTIVE };
+    strcpy(task.name, names[name_num]);
+    offsets[name_num] = (uint64_t) ftell(fp);
+    assert(ERROR_NONE == write_task(&task, fp).code);
+  }
+  fclose(fp);
+  return 0;
+}
+
+int append_sheet(const char* const name, uint64_t* const offset) {
+  struct sheet_stamp previous;
+  assert(ERROR_NONE == get_sheet_stamp(SHEET, &previous).code);
+  FILE* const fp = fopen(SHEET, "a");
+  assert(NULL != fp);
+  fseek(fp, 0, SEEK_END);
+  *offset = (uint64_t) ftell(fp);
+  struct task task = { 60, 0, "", "", STATUS_ACTIVE };
+  strcpy(task.name, name);
+  assert(ERROR_NONE == write_task(&task, fp).code);
+  fclose(fp);
+  return append_trigram_index(INDEX, SHEET, &previous, name, *offset).code;
+}
+
+int do_test_candidates(const char* const filter, const uint64_t* const
+    expected, const size_t expected_count) {
+  struct expression e;
+  assert(ERROR_NONE == parse_expression(filter, &e).code);
+  uint64_t* offsets;
+  size_t offset_count;
+  struct error error = find_trigram_candidates(INDEX, SHEET, &e, &offsets,
+      &offset_count);
+  assert(ERROR_NONE == error.code);
+  printf("testing candidates of %s\n", filter);
+  if (NULL == expected) {
+    assert(NULL == offsets);
+  } else {
+    assert(NULL != offsets);
+    assert(expected_count == offset_count);
+    for (size_t offset_num = 0; offset_num < offset_count; offset_num++) {
+      assert(expected[offset_num] == offsets[offset_num]);
+    }
+  }
+  free(offsets);
+  free_expression(&e);
+  return 0;
+}
+
+int test_trigram_candidates(void) {
+  const char* names[] = { "billing-api", "billing-ui", "search-api",
+    "search-ui", "infra-dns" };
+  uint64_t rows[6];
+  write_sheet(names, 5, rows);
+  assert(ERROR_NONE == build_trigram_index(INDEX, SHEET).code);
+
+  const uint64_t billing[] = { rows[0], rows[1] };
+  do_test_candidates("billing", billing, 2);
+  const uint64_t api[] = { rows[0], rows[2] };
+  do_test_candidates("api", api, 2);
+  const uint64_t billing_api[] = { rows[0] };
+  do_test_candidates("billing/api", billing_api, 1);
+  const uint64_t dns_or_ui[] = { rows[1], rows[3], rows[4] };
+  do_test_candidates("dns,-ui", dns_or_ui, 3);
+  do_test_candidates("nothing", rows, 0);
+  // Short, negative and regex literals can't use the index.
+  do_test_candidates("ui", NULL, 0);
+  do_test_candidates("!billing", NULL, 0);
+  do_test_candidates("~^infra", NULL, 0);
+  do_test_candidates("billing,!api", NULL, 0);
+  // Other disjunctions are checked by string_matches later.
+  do_test_candidates("billing/!api", billing, 2);
+
+  /* Appended rows are found without a rebuild. */
+  assert(ERROR_NONE == append_sheet("billing-batch", &rows[5]));
+  const uint64_t appended[] = { rows[0], rows[1], rows[5] };
+  do_test_candidates("billing", appended, 3);
+  return 0;
+}
+
+/* A sheet changed behind the index's back makes it stale. */
+int test_stale_index(void) {
+  FILE* const fp = fopen(SHEET, "a");
+  assert(NULL != fp);
+  fputs("billing-x\tACTIVE\t60\t0\n", fp);
+  fclose(fp);
+
+  struct expression e;
+  assert(ERROR_NONE == parse_expression("billing", &e).code);
+  uint64_t* offsets;
+  size_t offset_count;
+  assert(ERROR_STALE_INDEX == find_trigram_candidates(INDEX, SHEET, &e,
+        &offsets, &offset_count).code);
+  uint64_t offset;
+  assert(ERROR_STALE_INDEX == append_sheet("billing-y", &offset));
+  assert(ERROR_NONE == build_trigram_index(INDEX, SHEET).code);
+  assert(ERROR_NONE == find_trigram_candidates(INDEX, SHEET, &e, &offsets,
+        &offset_count).code);
+  assert(5 == offset_count);
+  free(offsets);
+  free_expression(&e);
+
+  remove(SHEET);
+  remove(INDEX);
+  return 0;
+}
+
+int
+main(void) {
+  test_trigram_candidates();
+  test_stale_index();
+  return 0;
+}
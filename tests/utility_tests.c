@@ -2,9 +2,14 @@
 #include "utility.h"
 #include <assert.h>
 #include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char FILENAME[] = "test-utility.txt";
 
 static int test_oarse_int(void);
 static int test_parse_int_overflow(void);
+static int test_append_file(void);
 
 int test_oarse_int(void) {
   char s[] = "1023";
@@ -26,8 +31,30 @@ int test_parse_int_overflow(void) {
   return 0;
 }
 
+/* Appends create the file and report where they end. */
+int test_append_file(void) {
+  remove(FILENAME);
+  uint64_t end_offset;
+  assert(ERROR_NONE == append_file(FILENAME, "one\n", 4, &end_offset).code);
+  assert(4 == end_offset);
+  assert(ERROR_NONE == append_file(FILENAME, "two\n", 4, &end_offset).code);
+  assert(8 == end_offset);
+  assert(ERROR_NONE == append_file(FILENAME, "", 0, NULL).code);
+
+  char buffer[16];
+  FILE* const fp = fopen(FILENAME, "r");
+  assert(NULL != fp);
+  const size_t length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+  fclose(fp);
+  buffer[length] = '\0';
+  assert(0 == strcmp("one\ntwo\n", buffer));
+  remove(FILENAME);
+  return 0;
+}
+
 int main(void) {
   test_oarse_int();
   test_parse_int_overflow();
+  test_append_file();
   return 0;
 }
@@ -0,0 +1,88 @@
+#include "error.h"
+#include "task.h"
+#include "velocity.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const struct velocity_summary* find_summary(const struct
+    velocity_report*, const char* group);
+static int test_velocity_report(void);
+static int test_empty_velocity_report(void);
+
+const struct velocity_summary* find_summary(const struct velocity_report*
+    const report, const char* const group) {
+  for (size_t summary_num = 0; summary_num < report->summary_count;
+      summary_num++) {
+    if (0 == strcmp(group, report->summaries[summary_num].group)) {
+      return &report->summaries[summary_num];
+    }
+  }
+  return NULL;
+}
+
+int test_velocity_report(void) {
+  const struct task tasks[] = {
+    { 3600, 7200, "web-login", "", STATUS_DONE },
+    { 4 * 3600, 2 * 3600, "web-api", "", STATUS_DONE },
+    { 1800, 1800, "infra-dns", "", STATUS_DONE },
+    { 10 * 3600, 40 * 3600, "web-web-infra", "", STATUS_DONE },
+    /* Active tasks and tasks without times are left out. */
+    { 3600, 60, "web-active", "", STATUS_ACTIVE },
+    { 3600, 0, "web-untimed", "", STATUS_DONE },
+    { 0, 3600, "web-unestimated", "", STATUS_DONE }
+  };
+  struct velocity_report report;
+  assert(ERROR_NONE == compute_velocity_report(tasks, sizeof(tasks) /
+        sizeof(tasks[0]), &report).code);
+
+  /* The velocities are 1/4, 1/2, 1 and 2. */
+  const struct velocity_summary* const all = &report.summaries[0];
+  assert(0 == strcmp("all", all->group));
+  assert(4 == all->task_count);
+  assert(fabs(all->geometric_mean - sqrt(0.5)) < 1e-9);
+  assert(fabs(all->quantiles[2] - 0.75) < 1e-9);
+  assert(fabs(all->quantiles[0] - (0.25 + 0.15 * 0.25)) < 1e-9);
+  assert(1 == all->histogram[3]);
+  assert(1 == all->histogram[4]);
+  assert(1 == all->histogram[5]);
+  assert(1 == all->histogram[6]);
+  assert(0 == strcmp("1/4-1/2", get_velocity_bin_name(3)));
+
+  /* Estimates are bucketed from their lower limit. */
+  assert(0 == strcmp("estimate <1h", report.summaries[1].group));
+  assert(1 == report.summaries[1].task_count);
+  assert(fabs(find_summary(&report, "estimate 1h-4h")->geometric_mean - 0.5)
+      < 1e-9);
+  assert(1 == find_summary(&report, "estimate 4h-1d")->task_count);
+  assert(1 == find_summary(&report, "estimate 1d-1w")->task_count);
+  assert(NULL == find_summary(&report, "estimate >=1w"));
+
+  /* A token is counted once per task, and the most common come first. */
+  assert(0 == strcmp("token web", report.summaries[5].group));
+  assert(3 == report.summaries[5].task_count);
+  assert(0 == strcmp("token infra", report.summaries[6].group));
+  assert(2 == report.summaries[6].task_count);
+  assert(0 == strcmp("token api", report.summaries[7].group));
+  assert(1 == find_summary(&report, "token dns")->task_count);
+  assert(10 == report.summary_count);
+  free_velocity_report(&report);
+  return 0;
+}
+
+int test_empty_velocity_report(void) {
+  const struct task task = { 3600, 0, "a", "", STATUS_DONE };
+  struct velocity_report report;
+  assert(ERROR_NONE == compute_velocity_report(&task, 1, &report).code);
+  assert(0 == report.summary_count);
+  free_velocity_report(&report);
+  return 0;
+}
+
+int
+main(void) {
+  test_velocity_report();
+  test_empty_velocity_report();
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include "error.h"
+#include "expression.h"
+#include "task.h"
+#include "watch.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char SHEET[] = "test-watch.tsv";
+static const char TIME_SHEET[] = "test-watch-time.tsv";
+
+static void append(const char* file, const char* text);
+static intmax_t get_actual_seconds(const struct live_sheets*, const char*
+    name, size_t* task_count);
+static int test_appended_lines(void);
+static int test_rewritten_sheet(void);
+
+void append(const char* const file, const char* const text) {
+  FILE* const fp = fopen(file, "a");
+  assert(NULL != fp);
+  fputs(text, fp);
+  fclose(fp);
+}
+
+/* Get the actual time of the task, or -1 if it is not there. */
+intmax_t get_actual_seconds(const struct live_sheets* const live, const char*
+    const name, size_t* const task_count) {
+  struct expression filter;
+  assert(ERROR_NONE == parse_expression("", &filter).code);
+  struct task* tasks;
+  assert(ERROR_NONE == get_live_tasks(live, &filter, &tasks,
+        task_count).code);
+  free_expression(&filter);
+  intmax_t actual_seconds = -1;
+  for (size_t task_num = 0; task_num < *task_count; task_num++) {
+    if (0 == strcmp(name, tasks[task_num].name)) {
+      actual_seconds = tasks[task_num].actual_seconds;
+    }
+  }
+  free(tasks);
+  return actual_seconds;
+}
+
+int test_appended_lines(void) {
+  remove(SHEET);
+  remove(TIME_SHEET);
+  append(SHEET, "a\tACTIVE\t60\t30\nb\tACTIVE\t60\t0\n");
+  append(TIME_SHEET, "2020-01-01T09:00:00\ta\n");
+  struct live_sheets live;
+  init_live_sheets(&live);
+  assert(ERROR_NONE == update_live_sheets(&live, SHEET, TIME_SHEET).code);
+  size_t task_count;
+  assert(1800 == get_actual_seconds(&live, "a", &task_count));
+  assert(2 == task_count);
+
+  /* Only the new lines are read, and the time up to a record goes to the
+   * task before it. */
+  append(TIME_SHEET, "2020-01-01T09:10:00\tb\n2020-01-01T09:15:00\ta\n");
+  append(SHEET, "c\tACTIVE\t60\t0\n");
+  assert(ERROR_NONE == update_live_sheets(&live, SHEET, TIME_SHEET).code);
+  assert(2400 == get_actual_seconds(&live, "a", &task_count));
+  assert(300 == get_actual_seconds(&live, "b", &task_count));
+  assert(3 == task_count);
+
+  /* A line still being written waits for its new line. */
+  append(SHEET, "d\tACTIVE\t60");
+  append(TIME_SHEET, "2020-01-01T09:20");
+  assert(ERROR_NONE == update_live_sheets(&live, SHEET, TIME_SHEET).code);
+  assert(-1 == get_actual_seconds(&live, "d", &task_count));
+  assert(2400 == get_actual_seconds(&live, "a", &task_count));
+  append(SHEET, "\t0\n");
+  append(TIME_SHEET, ":00\tc\n");
+  assert(ERROR_NONE == update_live_sheets(&live, SHEET, TIME_SHEET).code);
+  assert(0 == get_actual_seconds(&live, "d", &task_count));
+  assert(2700 == get_actual_seconds(&live, "a", &task_count));
+  assert(4 == task_count);
+  free_live_sheets(&live);
+  return 0;
+}
+
+/* A sheet renamed over, as by a rewrite, is read again from the start. */
+int test_rewritten_sheet(void) {
+  struct live_sheets live;
+  init_live_sheets(&live);
+  assert(ERROR_NONE == update_live_sheets(&live, SHEET, TIME_SHEET).code);
+
+  char tmp[] = "test-watch.tsv.tmp";
+  append(tmp, "a\tDONE\t60\t30\n");
+  assert(0 == rename(tmp, SHEET));
+  assert(ERROR_NONE == update_live_sheets(&live, SHEET, TIME_SHEET).code);
+  size_t task_count;
+  assert(2700 == get_actual_seconds(&live, "a", &task_count));
+  assert(1 == task_count);
+  assert(STATUS_DONE == live.tasks.tasks[0].status);
+  free_live_sheets(&live);
+
+  remove(SHEET);
+  remove(TIME_SHEET);
+  return 0;
+}
+
+int
+main(void) {
+  test_appended_lines();
+  test_rewritten_sheet();
+  return 0;
+}
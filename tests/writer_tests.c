@@ -0,0 +1,127 @@
+#include "error.h"
+#include "writer.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char FILENAME[] = "test-writer.txt";
+
+static int test_put_int(void);
+static int test_put_json_string(void);
+static int test_put_iso_8601_time(void);
+static int test_flush_writer(void);
+
+/* Flush the writer and check that the file holds the expected text. */
+static void expect_output(struct writer*, FILE* fp, const char* expected);
+
+void expect_output(struct writer* const writer, FILE* const fp, const char*
+    const expected) {
+  assert(ERROR_NONE == flush_writer(writer).code);
+  fclose(fp);
+  char buffer[256];
+  FILE* const read_fp = fopen(FILENAME, "r");
+  assert(NULL != read_fp);
+  const size_t length = fread(buffer, 1, sizeof(buffer) - 1, read_fp);
+  fclose(read_fp);
+  buffer[length] = '\0';
+  assert(0 == strcmp(expected, buffer));
+}
+
+int test_put_int(void) {
+  FILE* const fp = fopen(FILENAME, "w");
+  assert(NULL != fp);
+  static struct writer writer;
+  init_writer(&writer, fp);
+  put_int(&writer, 0);
+  put_char(&writer, ' ');
+  put_int(&writer, -42);
+  put_char(&writer, ' ');
+  put_int(&writer, 1234567890);
+  put_char(&writer, ' ');
+  put_int(&writer, INTMAX_MIN);
+  put_char(&writer, ' ');
+  put_fixed(&writer, 0.8125, 2);
+  put_char(&writer, ' ');
+  put_fixed(&writer, -3.0, 1);
+  char expected[64];
+  snprintf(expected, sizeof(expected), "0 -42 1234567890 %jd 0.81 -3.0",
+      INTMAX_MIN);
+  expect_output(&writer, fp, expected);
+  remove(FILENAME);
+  return 0;
+}
+
+int test_put_json_string(void) {
+  FILE* const fp = fopen(FILENAME, "w");
+  assert(NULL != fp);
+  static struct writer writer;
+  init_writer(&writer, fp);
+  put_json_string(&writer, "a\"b\\c\td\n\xc3\xa9");
+  put_json_string(&writer, "");
+  expect_output(&writer, fp, "\"a\\\"b\\\\c\\u0009d\\u000a\xc3\xa9\"\"\"");
+  remove(FILENAME);
+  return 0;
+}
+
+int test_put_iso_8601_time(void) {
+  FILE* const fp = fopen(FILENAME, "w");
+  assert(NULL != fp);
+  static struct writer writer;
+  init_writer(&writer, fp);
+  struct tm time;
+  memset(&time, 0, sizeof(time));
+  time.tm_year = 24;
+  time.tm_mon = 0;
+  time.tm_mday = 3;
+  time.tm_hour = 9;
+  time.tm_min = 5;
+  put_iso_8601_time(&writer, &time);
+  expect_output(&writer, fp, "1924-01-03T09:05:00");
+  remove(FILENAME);
+  return 0;
+}
+
+/* Output larger than the buffer comes out whole and in order. */
+int test_flush_writer(void) {
+  FILE* fp = fopen(FILENAME, "w");
+  assert(NULL != fp);
+  static struct writer writer;
+  init_writer(&writer, fp);
+  static char block[WRITER_BUFFER_SIZE + 1];
+  memset(block, 'x', WRITER_BUFFER_SIZE);
+  const size_t line_count = 3 * WRITER_BUFFER_SIZE / 8;
+  for (size_t line_num = 0; line_num < line_count; line_num++) {
+    put_int(&writer, (intmax_t) line_num);
+    put_char(&writer, '\n');
+  }
+  put_string(&writer, block);
+  assert(ERROR_NONE == flush_writer(&writer).code);
+  fclose(fp);
+
+  fp = fopen(FILENAME, "r");
+  assert(NULL != fp);
+  for (size_t line_num = 0; line_num < line_count; line_num++) {
+    long value;
+    assert(1 == fscanf(fp, "%ld\n", &value));
+    assert((size_t) value == line_num);
+  }
+  size_t block_length = 0;
+  for (int c = fgetc(fp); EOF != c; c = fgetc(fp)) {
+    assert('x' == c);
+    block_length++;
+  }
+  assert(WRITER_BUFFER_SIZE == block_length);
+  fclose(fp);
+  remove(FILENAME);
+  return 0;
+}
+
+int main(void) {
+  test_put_int();
+  test_put_json_string();
+  test_put_iso_8601_time();
+  test_flush_writer();
+  return 0;
+}